@@ -0,0 +1,1471 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <thread>
+
+#include <spdlog/spdlog.h>
+
+#include "CommandLine.h"
+#include "ExternalImage.h"
+#include "FrameCodec.h"
+#include "FrameContext.h"
+#include "FrameStream.h"
+#include "ImportCache.h"
+#include "InteropBackend.h"
+#include "JpegEncoder.h"
+#include "PixelConversion.h"
+#include "Statistics.h"
+#include "ThreadPool.h"
+#include "VideoFile.h"
+
+// Sweeps shared image resolutions, formats and readback depths over one interop backend and reports
+// percentiles of every stage of the pipeline (bind, clear, readback copy, map, convert, encode, streaming) as JSON or CSV,
+// along with the CPU cost of submitting a frame with transient, recycled and pre-recorded command buffers, the
+// frame interval of readback copies on the graphics queue versus the transfer queue, readbacks into an application
+// buffer through the staging buffer versus imported as host memory, the bind time and device memory objects of
+// many small shared images with dedicated allocations versus the memory arena, and the submits and CPU cost of a
+// batch of surfaces shared one image each versus as a single array image, and the ratio and throughput of the
+// frame transport codec on synthetic and recorded sequences, encoding streamed frames on delivery versus in a
+// pipeline stage.
+
+constexpr uint32_t kBenchmarkMaxListLength = 16u;
+constexpr uint32_t kBenchmarkJpegQuality   = 90u;
+
+// Samples taken before the measured ones, so that lazy driver allocations do not end up in the percentiles.
+constexpr uint32_t kBenchmarkWarmupFrames = 5u;
+
+// Side of the square each frame declares dirty when measuring damage-tracked readbacks.
+constexpr uint32_t kBenchmarkDirtyRectSize = 256u;
+
+// Small shared images created at once to compare dedicated allocations with the memory arena.
+constexpr uint32_t kBenchmarkThumbnailCount = 64u;
+constexpr uint32_t kBenchmarkThumbnailSize  = 256u;
+
+// Surfaces rendered and read back together every frame, as separate shared images or as the layers of one.
+constexpr uint32_t kBenchmarkBatchSurfaceCount = 8u;
+constexpr uint32_t kBenchmarkBatchSurfaceSize  = 512u;
+
+// Side of the window that moves over the synthetic desktop sequence of the frame codec, redrawn every frame.
+constexpr uint32_t kBenchmarkCodecWindowSize = 256u;
+
+// Frames of the pipeline that encodes streamed frames off the render loop.
+constexpr uint32_t kBenchmarkPipelineDepth = 4u;
+
+struct BenchmarkResolution
+{
+    uint32_t width;
+    uint32_t height;
+};
+
+struct BenchmarkRecord
+{
+    BenchmarkResolution resolution;
+    const char*         pFormatName;
+
+    // Zero for the stages measured with one readback at a time.
+    uint32_t            readbackDepth;
+
+    const char*         pMetric;
+    SampleSummary       summary;
+};
+
+// Parsing
+// ------------------------------------------------
+
+// Parses a comma separated list, calling parseFunc on every item.
+template <typename ParseFunc>
+static bool ParseList(const char* pList, ParseFunc parseFunc)
+{
+    std::string list = pList;
+
+    size_t itemStart = 0u;
+    while (itemStart <= list.size())
+    {
+        size_t itemEnd = list.find(',', itemStart);
+        if (itemEnd == std::string::npos)
+            itemEnd = list.size();
+
+        if (!parseFunc(list.substr(itemStart, itemEnd - itemStart)))
+            return false;
+
+        itemStart = itemEnd + 1u;
+    }
+
+    return true;
+}
+
+static bool ParseResolutions(const char* pList, std::vector<BenchmarkResolution>& resolutions)
+{
+    resolutions.clear();
+
+    return ParseList(pList, [&](const std::string& item)
+    {
+        BenchmarkResolution resolution;
+        char                separator;
+
+        if (sscanf(item.c_str(), "%u%c%u", &resolution.width, &separator, &resolution.height) != 3 || separator != 'x' ||
+            resolution.width == 0u || resolution.height == 0u || resolutions.size() == kBenchmarkMaxListLength)
+            return false;
+
+        resolutions.push_back(resolution);
+        return true;
+    });
+}
+
+// Only formats a shared image can be created with.
+static bool ParseFormats(const char* pList, std::vector<const PixelFormatTraits*>& formats)
+{
+    formats.clear();
+
+    return ParseList(pList, [&](const std::string& item)
+    {
+        const PixelFormatTraits* pTraits = FindPixelFormatTraits(item.c_str());
+
+        if (pTraits == nullptr || !pTraits->IsShareable())
+            return false;
+
+        formats.push_back(pTraits);
+        return true;
+    });
+}
+
+static bool ParseDepths(const char* pList, std::vector<uint32_t>& depths)
+{
+    depths.clear();
+
+    return ParseList(pList, [&](const std::string& item)
+    {
+        char*               pEnd;
+        const unsigned long depth = strtoul(item.c_str(), &pEnd, 10);
+
+        if (pEnd == item.c_str() || *pEnd != '\0' || depth == 0u || depths.size() == kBenchmarkMaxListLength)
+            return false;
+
+        depths.push_back((uint32_t)depth);
+        return true;
+    });
+}
+
+// Output
+// ------------------------------------------------
+
+static bool WriteBenchmarkCsv(FILE* pFile, const char* pBackendName, const std::vector<BenchmarkRecord>& records)
+{
+    fprintf(pFile, "backend,width,height,format,readback_depth,metric,count,mean,min,p50,p95,p99,max\n");
+
+    for (const auto& record : records)
+    {
+        fprintf(pFile, "%s,%u,%u,%s,%u,%s,%zu,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f\n",
+            pBackendName,
+            record.resolution.width,
+            record.resolution.height,
+            record.pFormatName,
+            record.readbackDepth,
+            record.pMetric,
+            record.summary.count,
+            record.summary.mean,
+            record.summary.min,
+            record.summary.p50,
+            record.summary.p95,
+            record.summary.p99,
+            record.summary.max
+        );
+    }
+
+    return !ferror(pFile);
+}
+
+static bool WriteBenchmarkJson(FILE* pFile, const char* pBackendName, const std::vector<BenchmarkRecord>& records)
+{
+    fprintf(pFile, "{\n  \"backend\": \"%s\",\n  \"results\": [\n", pBackendName);
+
+    for (size_t recordIndex = 0u; recordIndex < records.size(); recordIndex++)
+    {
+        const auto& record = records[recordIndex];
+
+        fprintf(pFile, "    { \"width\": %u, \"height\": %u, \"format\": \"%s\", \"readback_depth\": %u, \"metric\": \"%s\", "
+                       "\"count\": %zu, \"mean\": %.6f, \"min\": %.6f, \"p50\": %.6f, \"p95\": %.6f, \"p99\": %.6f, \"max\": %.6f }%s\n",
+            record.resolution.width,
+            record.resolution.height,
+            record.pFormatName,
+            record.readbackDepth,
+            record.pMetric,
+            record.summary.count,
+            record.summary.mean,
+            record.summary.min,
+            record.summary.p50,
+            record.summary.p95,
+            record.summary.p99,
+            record.summary.max,
+            recordIndex + 1u < records.size() ? "," : ""
+        );
+    }
+
+    fprintf(pFile, "  ]\n}\n");
+
+    return !ferror(pFile);
+}
+
+// Writes CSV when the file name ends in .csv, JSON otherwise.
+static bool WriteBenchmarkResults(const char* pFileName, const char* pBackendName, const std::vector<BenchmarkRecord>& records)
+{
+    FILE* pFile = fopen(pFileName, "w");
+    if (pFile == nullptr)
+        return false;
+
+    const size_t nameLength = strlen(pFileName);
+    const bool   writeCsv   = nameLength >= 4u && !strcmp(pFileName + nameLength - 4u, ".csv");
+
+    const bool written = writeCsv ? WriteBenchmarkCsv(pFile, pBackendName, records) : WriteBenchmarkJson(pFile, pBackendName, records);
+
+    return fclose(pFile) == 0 && written;
+}
+
+// Measurements
+// ------------------------------------------------
+
+struct StageSamples
+{
+    std::vector<double> clearSubmitMs;
+    std::vector<double> readbackCopyMs;
+    std::vector<double> mapMs;
+
+    // Only for formats the encoder cannot read directly.
+    std::vector<double> convertMs;
+    std::vector<double> encodeMs;
+};
+
+// Renders and reads back frameCount frames one at a time, timing each stage separately.
+static bool MeasureStages(InteropBackend* pBackend, const VulkanDevice& device, FrameContextPool& frameContexts, const SharedImage& sharedImage, ThreadPool& encoderThreadPool, uint32_t frameCount, StageSamples& samples)
+{
+    bool succeeded = true;
+
+    std::vector<uint8_t> jpegData;
+
+    const PixelFormat    imageFormat  = GetSharedImageFormatTraits(sharedImage.desc).format;
+    const uint32_t       packedPitch  = sharedImage.desc.width * 4u;
+    std::vector<uint8_t> convertedPixels(imageFormat != PixelFormat::RGBA8 ? (size_t)packedPitch * sharedImage.desc.height : 0u);
+
+    for (uint64_t frameIndex = 0u; succeeded && frameIndex < kBenchmarkWarmupFrames + frameCount; frameIndex++)
+    {
+        const bool warmup = frameIndex < kBenchmarkWarmupFrames;
+
+        VkCommandBuffer vkCommandBuffer;
+        succeeded = frameContexts.AcquireFrameContext(vkCommandBuffer);
+
+        if (!succeeded)
+            break;
+
+        RecordFrame(device, sharedImage, frameIndex, vkCommandBuffer);
+
+        // Clear: from the submit until the CPU sees the fence.
+        const auto submitStart = std::chrono::steady_clock::now();
+
+        succeeded = frameContexts.SubmitFrameContext(vkCommandBuffer, GetFrameTimelineSubmit(sharedImage, frameIndex)) &&
+                    frameContexts.WaitIdle();
+
+        const double clearSubmitMs = GetElapsedMilliseconds(submitStart);
+
+        // Readback copy: from the exporter submit until its copy retired.
+        const auto copyStart = std::chrono::steady_clock::now();
+
+        succeeded = succeeded && pBackend->SubmitReadback(sharedImage, frameIndex, 0u);
+
+        while (succeeded && !pBackend->IsReadbackComplete(sharedImage, 0u))
+            std::this_thread::yield();
+
+        const double readbackCopyMs = GetElapsedMilliseconds(copyStart);
+
+        // Map: the copy already completed, so this is the cost of making the staging memory visible.
+        const auto mapStart = std::chrono::steady_clock::now();
+
+        MappedImage mappedImage;
+        succeeded = succeeded && pBackend->MapReadback(sharedImage, 0u, mappedImage);
+
+        const double mapMs = GetElapsedMilliseconds(mapStart);
+
+        if (!succeeded)
+            break;
+
+        // Convert: the encoder reads RGBA8.
+        const auto convertStart = std::chrono::steady_clock::now();
+
+        MappedImage encoderImage = mappedImage;
+
+        if (!convertedPixels.empty())
+        {
+            succeeded = ConvertPixels(imageFormat, mappedImage.pData, mappedImage.rowPitch, PixelFormat::RGBA8, convertedPixels.data(), packedPitch, sharedImage.desc.width, sharedImage.desc.height);
+
+            encoderImage.pData    = convertedPixels.data();
+            encoderImage.rowPitch = packedPitch;
+        }
+
+        const double convertMs = GetElapsedMilliseconds(convertStart);
+
+        // Encode
+        const auto encodeStart = std::chrono::steady_clock::now();
+
+        succeeded = succeeded && EncodeJpeg(encoderThreadPool, encoderImage.pData, sharedImage.desc.width, sharedImage.desc.height, encoderImage.rowPitch, kBenchmarkJpegQuality, jpegData);
+
+        const double encodeMs = GetElapsedMilliseconds(encodeStart);
+
+        pBackend->UnmapReadback(sharedImage, 0u);
+
+        if (warmup)
+            continue;
+
+        if (!convertedPixels.empty())
+            samples.convertMs.push_back(convertMs);
+
+        samples.clearSubmitMs.push_back(clearSubmitMs);
+        samples.readbackCopyMs.push_back(readbackCopyMs);
+        samples.mapMs.push_back(mapMs);
+        samples.encodeMs.push_back(encodeMs);
+    }
+
+    return succeeded;
+}
+
+// Ways of getting a frame's commands onto the queue, compared by MeasureSubmitCost.
+enum class SubmitMode
+{
+    // A command pool created, allocated from and destroyed for every frame.
+    Transient,
+
+    // Frame contexts recycled through their fences, recorded every frame.
+    Recycled,
+
+    // Frame contexts replaying command buffers recorded once.
+    Prerecorded,
+
+    Count,
+};
+
+constexpr const char* kSubmitMetrics[] = { "submit_transient_ms", "submit_recycled_ms", "submit_prerecorded_ms" };
+
+static_assert(sizeof(kSubmitMetrics) / sizeof(kSubmitMetrics[0]) == (size_t)SubmitMode::Count);
+
+// Per-frame CPU cost of recording and submitting the clear of each mode, GPU and readback time excluded.
+// Frames are read back one at a time from frame index firstFrameIndex on, frameIndex is advanced past them.
+static bool MeasureSubmitCost(InteropBackend* pBackend, const VulkanDevice& device, FrameContextPool& frameContexts, const SharedImage& sharedImage,
+                              uint64_t& frameIndex, uint32_t frameCount, std::vector<double> (&submitMs)[(size_t)SubmitMode::Count])
+{
+    std::vector<VkCommandBuffer> vkStaticCommandBuffers;
+    if (!RecordStaticFrames(frameContexts, device, sharedImage, vkStaticCommandBuffers))
+        return false;
+
+    bool succeeded = true;
+
+    for (uint32_t modeIndex = 0u; succeeded && modeIndex < (uint32_t)SubmitMode::Count; modeIndex++)
+    {
+        const auto mode = (SubmitMode)modeIndex;
+
+        for (uint32_t sampleIndex = 0u; succeeded && sampleIndex < kBenchmarkWarmupFrames + frameCount; sampleIndex++, frameIndex++)
+        {
+            const VulkanTimelineSubmit timelineSubmit = GetFrameTimelineSubmit(sharedImage, frameIndex);
+
+            const auto submitStart = std::chrono::steady_clock::now();
+
+            VkCommandPool   vkTransientCommandPool = VK_NULL_HANDLE;
+            VkCommandBuffer vkCommandBuffer;
+
+            if (mode == SubmitMode::Transient)
+            {
+                succeeded = BeginVulkanImmediateCommands(device, device.graphicsQueueIndex, vkTransientCommandPool, vkCommandBuffer);
+
+                if (succeeded)
+                {
+                    RecordFrameCommands(device, sharedImage, frameIndex, vkCommandBuffer);
+                    vkEndCommandBuffer(vkCommandBuffer);
+
+                    succeeded = SubmitVulkanCommandBuffer(device.vkGraphicsQueue, vkCommandBuffer, timelineSubmit, VK_NULL_HANDLE);
+                }
+            }
+            else
+            {
+                succeeded = frameContexts.AcquireFrameContext(vkCommandBuffer);
+
+                if (succeeded && mode == SubmitMode::Recycled)
+                    RecordFrame(device, sharedImage, frameIndex, vkCommandBuffer);
+                else if (succeeded)
+                    vkCommandBuffer = vkStaticCommandBuffers[frameIndex % kDistinctFrameCount];
+
+                succeeded = succeeded && frameContexts.SubmitFrameContext(vkCommandBuffer, timelineSubmit);
+            }
+
+            double cpuMs = GetElapsedMilliseconds(submitStart);
+
+            // The readback waits for the render signal value, so once it completed the clear has as well.
+            MappedImage mappedImage;
+            succeeded = succeeded && pBackend->MapSharedImage(sharedImage, frameIndex, mappedImage);
+
+            if (succeeded)
+                pBackend->UnmapSharedImage(sharedImage);
+
+            // Tearing the transient pool down is part of its cost.
+            if (vkTransientCommandPool != VK_NULL_HANDLE)
+            {
+                const auto destroyStart = std::chrono::steady_clock::now();
+
+                vkDestroyCommandPool(device.vkLogicalDevice, vkTransientCommandPool, nullptr);
+
+                cpuMs += GetElapsedMilliseconds(destroyStart);
+            }
+
+            if (sampleIndex >= kBenchmarkWarmupFrames)
+                submitMs[modeIndex].push_back(cpuMs);
+        }
+    }
+
+    succeeded = frameContexts.WaitIdle() && succeeded;
+
+    frameContexts.FreeStaticCommandBuffers(vkStaticCommandBuffers);
+
+    return succeeded;
+}
+
+// Frames delivered into an application buffer: copied out of the readback slot once mapped, or written there by the
+// GPU through ImportReadbackHostMemory. From the exporter submit until the frame is in the buffer. zeroCopyMs stays
+// empty when the backend cannot import host memory. Continues the timeline at frameIndex.
+static bool MeasureHostReadback(InteropBackend* pBackend, const VulkanDevice& device, FrameContextPool& frameContexts, const SharedImage& sharedImage,
+                                uint64_t& frameIndex, uint32_t frameCount, std::vector<double>& stagingCopyMs, std::vector<double>& zeroCopyMs)
+{
+    const uint64_t frameSize = GetSharedImageSize(sharedImage.desc);
+    const uint64_t alignment = std::max<uint64_t>(pBackend->GetReadbackHostMemoryAlignment(), 1u);
+    const uint64_t importSize = (frameSize + alignment - 1u) / alignment * alignment;
+
+    // Stands in for an encoder's input buffer.
+    std::vector<uint8_t> applicationBuffer(importSize + alignment);
+    uint8_t*             pFrameBuffer = applicationBuffer.data() + (alignment - (uintptr_t)applicationBuffer.data() % alignment) % alignment;
+
+    const bool zeroCopy = pBackend->GetReadbackHostMemoryAlignment() > 0u && pBackend->ImportReadbackHostMemory(sharedImage, pFrameBuffer, importSize);
+
+    bool succeeded = true;
+
+    for (int pass = 0; succeeded && pass < (zeroCopy ? 2 : 1); pass++)
+    {
+        const bool inPlace = pass == 1;
+
+        for (uint32_t sampleIndex = 0u; succeeded && sampleIndex < kBenchmarkWarmupFrames + frameCount; sampleIndex++, frameIndex++)
+        {
+            VkCommandBuffer vkCommandBuffer;
+            succeeded = frameContexts.AcquireFrameContext(vkCommandBuffer);
+
+            if (!succeeded)
+                break;
+
+            RecordFrame(device, sharedImage, frameIndex, vkCommandBuffer);
+
+            succeeded = frameContexts.SubmitFrameContext(vkCommandBuffer, GetFrameTimelineSubmit(sharedImage, frameIndex)) &&
+                        frameContexts.WaitIdle();
+
+            const auto copyStart = std::chrono::steady_clock::now();
+
+            MappedImage mappedImage;
+            succeeded = succeeded && pBackend->SubmitReadback(sharedImage, frameIndex, 0u, nullptr, inPlace ? 0u : kReadbackToSlot) &&
+                        pBackend->MapReadback(sharedImage, 0u, mappedImage);
+
+            if (!succeeded)
+                break;
+
+            if (!inPlace)
+                memcpy(pFrameBuffer, mappedImage.pData, (size_t)frameSize);
+
+            const double deliveryMs = GetElapsedMilliseconds(copyStart);
+
+            pBackend->UnmapReadback(sharedImage, 0u);
+
+            if (sampleIndex >= kBenchmarkWarmupFrames)
+                (inPlace ? zeroCopyMs : stagingCopyMs).push_back(deliveryMs);
+        }
+    }
+
+    if (zeroCopy)
+        pBackend->ImportReadbackHostMemory(sharedImage, nullptr, 0u);
+
+    return succeeded;
+}
+
+// Readback copy of a kBenchmarkDirtyRectSize square moving across the image, against readback_copy_ms of whole
+// frames: from the exporter submit until its copy retired, and the bytes it copied. Continues the timeline at frameIndex.
+static bool MeasureDirtyReadback(InteropBackend* pBackend, const VulkanDevice& device, FrameContextPool& frameContexts, const SharedImage& sharedImage,
+                                 uint64_t& frameIndex, uint32_t frameCount, std::vector<double>& copyMs, std::vector<double>& copiedBytes)
+{
+    const SharedImageDesc& desc = sharedImage.desc;
+
+    DirtyTileMap dirtyTiles;
+    dirtyTiles.Resize(desc.width, desc.height);
+
+    bool succeeded = true;
+
+    for (uint32_t sampleIndex = 0u; succeeded && sampleIndex < kBenchmarkWarmupFrames + frameCount; sampleIndex++, frameIndex++)
+    {
+        VkCommandBuffer vkCommandBuffer;
+        succeeded = frameContexts.AcquireFrameContext(vkCommandBuffer);
+
+        if (!succeeded)
+            break;
+
+        RecordFrame(device, sharedImage, frameIndex, vkCommandBuffer);
+
+        succeeded = frameContexts.SubmitFrameContext(vkCommandBuffer, GetFrameTimelineSubmit(sharedImage, frameIndex)) &&
+                    frameContexts.WaitIdle();
+
+        DirtyRect dirtyRect;
+        dirtyRect.x      = (uint32_t)((sampleIndex * kDirtyTileSize) % desc.width);
+        dirtyRect.y      = (uint32_t)((sampleIndex * kDirtyTileSize) % desc.height);
+        dirtyRect.width  = kBenchmarkDirtyRectSize;
+        dirtyRect.height = kBenchmarkDirtyRectSize;
+
+        dirtyTiles.Clear();
+        dirtyTiles.AddRect(dirtyRect);
+
+        const auto copyStart = std::chrono::steady_clock::now();
+
+        succeeded = succeeded && pBackend->SubmitReadback(sharedImage, frameIndex, 0u, &dirtyTiles);
+
+        while (succeeded && !pBackend->IsReadbackComplete(sharedImage, 0u))
+            std::this_thread::yield();
+
+        const double readbackCopyMs = GetElapsedMilliseconds(copyStart);
+
+        MappedImage mappedImage;
+        succeeded = succeeded && pBackend->MapReadback(sharedImage, 0u, mappedImage);
+
+        if (!succeeded)
+            break;
+
+        const uint64_t regionBytes = GetDirtyRegionPixelCount(mappedImage.pRegions, mappedImage.regionCount) * GetSharedImageBytesPerPixel(desc);
+
+        pBackend->UnmapReadback(sharedImage, 0u);
+
+        if (sampleIndex >= kBenchmarkWarmupFrames)
+        {
+            copyMs.push_back(readbackCopyMs);
+            copiedBytes.push_back((double)regionBytes);
+        }
+    }
+
+    return succeeded;
+}
+
+// Queue layouts compared by MeasureQueueOverlap.
+enum class OverlapMode
+{
+    // Clear and readback copy recorded back to back on the graphics queue.
+    Serial,
+
+    // Clear on the graphics queue, ownership transferred to the transfer queue for the copy.
+    Async,
+
+    Count,
+};
+
+constexpr const char* kOverlapMetrics[] = { "overlap_serial_ms", "overlap_async_ms" };
+
+static_assert(sizeof(kOverlapMetrics) / sizeof(kOverlapMetrics[0]) == (size_t)OverlapMode::Count);
+
+// Images rendered and read back in turn by MeasureQueueOverlap. While frame N is copied out of one image the
+// graphics queue clears frame N + 1 into the other.
+constexpr uint32_t kOverlapImageCount = 2u;
+
+struct OverlapImage
+{
+    VkImage             vkImage       = VK_NULL_HANDLE;
+    VkDeviceMemory      vkImageMemory = VK_NULL_HANDLE;
+    VulkanStagingBuffer buffer;
+
+    // Indexed by OverlapMode, the async mode also records a transfer command buffer.
+    VkCommandBuffer     vkGraphicsCommandBuffers[(size_t)OverlapMode::Count] = {};
+    VkCommandBuffer     vkTransferCommandBuffer = VK_NULL_HANDLE;
+};
+
+// Records the command buffers of both modes for one image.
+static void RecordOverlapImage(const VulkanDevice& device, const SharedImageDesc& desc, const OverlapImage& image)
+{
+    const bool dedicatedTransfer = device.HasDedicatedTransferQueue();
+
+    VkCommandBufferBeginInfo vkCommandBeginInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+
+    VkImageSubresourceRange vkImageClearRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0u, 1u, 0u, 1u };
+    VkClearColorValue       clearColor        = { { 1.0f, 0.5f, 0.25f, 1.0f } };
+
+    for (uint32_t modeIndex = 0u; modeIndex < (uint32_t)OverlapMode::Count; modeIndex++)
+    {
+        VkCommandBuffer vkCommandBuffer = image.vkGraphicsCommandBuffers[modeIndex];
+
+        vkBeginCommandBuffer(vkCommandBuffer, &vkCommandBeginInfo);
+
+        // The previous contents are discarded, so the image needs no ownership transfer back to graphics.
+        RecordVulkanImageBarrier(vkCommandBuffer, image.vkImage, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL, 0u, VK_ACCESS_TRANSFER_WRITE_BIT);
+        vkCmdClearColorImage(vkCommandBuffer, image.vkImage, VK_IMAGE_LAYOUT_GENERAL, &clearColor, 1u, &vkImageClearRange);
+
+        if ((OverlapMode)modeIndex == OverlapMode::Serial)
+        {
+            RecordVulkanImageBarrier(vkCommandBuffer, image.vkImage, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+            RecordVulkanImageToBufferCopy(vkCommandBuffer, image.vkImage, VK_IMAGE_LAYOUT_GENERAL, image.buffer.vkBuffer, desc);
+        }
+        else if (dedicatedTransfer)
+        {
+            // Release half of the ownership transfer to the transfer queue.
+            RecordVulkanImageBarrier(vkCommandBuffer, image.vkImage, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL, VK_ACCESS_TRANSFER_WRITE_BIT, 0u, device.graphicsQueueIndex, device.transferQueueIndex);
+        }
+
+        vkEndCommandBuffer(vkCommandBuffer);
+    }
+
+    vkBeginCommandBuffer(image.vkTransferCommandBuffer, &vkCommandBeginInfo);
+
+    // Acquire half of the ownership transfer, or a plain barrier when both submissions share the graphics queue.
+    if (dedicatedTransfer)
+        RecordVulkanImageBarrier(image.vkTransferCommandBuffer, image.vkImage, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL, 0u, VK_ACCESS_TRANSFER_READ_BIT, device.graphicsQueueIndex, device.transferQueueIndex);
+    else
+        RecordVulkanImageBarrier(image.vkTransferCommandBuffer, image.vkImage, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+
+    RecordVulkanImageToBufferCopy(image.vkTransferCommandBuffer, image.vkImage, VK_IMAGE_LAYOUT_GENERAL, image.buffer.vkBuffer, desc);
+
+    vkEndCommandBuffer(image.vkTransferCommandBuffer);
+}
+
+// Frame interval of clearing an image and copying it into a host-visible buffer, with both on the graphics queue
+// and with the copies moved to the transfer queue. Uses private images of the importer: the shared image's timeline
+// hands a single image back and forth, which serializes rendering and readback by design.
+// Without a transfer-only queue family both modes run on the graphics queue and should measure the same.
+static bool MeasureQueueOverlap(const VulkanDevice& device, const SharedImageDesc& desc, uint32_t frameCount, std::vector<double> (&overlapMs)[(size_t)OverlapMode::Count])
+{
+    OverlapImage  images[kOverlapImageCount];
+    VkCommandPool vkGraphicsCommandPool = VK_NULL_HANDLE;
+    VkCommandPool vkTransferCommandPool = VK_NULL_HANDLE;
+    VkSemaphore   vkRenderTimeline      = VK_NULL_HANDLE;
+    VkSemaphore   vkCopyTimeline        = VK_NULL_HANDLE;
+
+    auto createCommandPool = [&](uint32_t queueFamilyIndex, VkCommandPool& vkCommandPool)
+    {
+        VkCommandPoolCreateInfo vkCommandPoolCreateInfo = { VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO };
+        vkCommandPoolCreateInfo.queueFamilyIndex = queueFamilyIndex;
+
+        return vkCreateCommandPool(device.vkLogicalDevice, &vkCommandPoolCreateInfo, nullptr, &vkCommandPool) == VK_SUCCESS;
+    };
+
+    auto allocateCommandBuffers = [&](VkCommandPool vkCommandPool, uint32_t commandBufferCount, VkCommandBuffer* pCommandBuffers)
+    {
+        VkCommandBufferAllocateInfo vkCommandAllocateInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
+        vkCommandAllocateInfo.commandBufferCount = commandBufferCount;
+        vkCommandAllocateInfo.commandPool        = vkCommandPool;
+        vkCommandAllocateInfo.level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+
+        return vkAllocateCommandBuffers(device.vkLogicalDevice, &vkCommandAllocateInfo, pCommandBuffers) == VK_SUCCESS;
+    };
+
+    bool succeeded = createCommandPool(device.graphicsQueueIndex, vkGraphicsCommandPool) &&
+                     createCommandPool(device.transferQueueIndex, vkTransferCommandPool) &&
+                     CreateVulkanTimelineSemaphore(device, 0u, vkRenderTimeline) &&
+                     CreateVulkanTimelineSemaphore(device, 0u, vkCopyTimeline);
+
+    for (auto& image : images)
+    {
+        VkDeviceSize allocationSize;
+
+        succeeded = succeeded &&
+                    CreateVulkanImage2D(device, desc, 0u, image.vkImage) &&
+                    AllocateVulkanImageMemory(device, image.vkImage, 0u, image.vkImageMemory, allocationSize) &&
+                    CreateVulkanStagingBuffer(device, GetSharedImageSize(desc), VK_BUFFER_USAGE_TRANSFER_DST_BIT, image.buffer) &&
+                    allocateCommandBuffers(vkGraphicsCommandPool, (uint32_t)OverlapMode::Count, image.vkGraphicsCommandBuffers) &&
+                    allocateCommandBuffers(vkTransferCommandPool, 1u, &image.vkTransferCommandBuffer);
+
+        if (succeeded)
+            RecordOverlapImage(device, desc, image);
+    }
+
+    // Frame N signals N + 1 on the timelines it uses, the frame index keeps counting across modes so that the
+    // values only ever increase.
+    uint64_t frameIndex = 0u;
+
+    for (uint32_t modeIndex = 0u; succeeded && modeIndex < (uint32_t)OverlapMode::Count; modeIndex++)
+    {
+        const auto mode = (OverlapMode)modeIndex;
+
+        auto frameStart = std::chrono::steady_clock::now();
+
+        for (uint32_t sampleIndex = 0u; succeeded && sampleIndex < kBenchmarkWarmupFrames + frameCount; sampleIndex++, frameIndex++)
+        {
+            const OverlapImage& image = images[frameIndex % kOverlapImageCount];
+
+            // The copy of the frame that last used this image must have finished before its command buffers are
+            // submitted again and its image is cleared.
+            if (frameIndex >= kOverlapImageCount)
+                succeeded = WaitVulkanTimelineSemaphore(device, vkCopyTimeline, frameIndex + 1u - kOverlapImageCount);
+
+            if (sampleIndex >= kBenchmarkWarmupFrames)
+                overlapMs[modeIndex].push_back(GetElapsedMilliseconds(frameStart));
+
+            frameStart = std::chrono::steady_clock::now();
+
+            if (mode == OverlapMode::Serial)
+            {
+                VulkanTimelineSubmit copySubmit;
+                copySubmit.vkSignalSemaphore = vkCopyTimeline;
+                copySubmit.signalValue       = frameIndex + 1u;
+
+                succeeded = succeeded && SubmitVulkanCommandBuffer(device.vkGraphicsQueue, image.vkGraphicsCommandBuffers[modeIndex], copySubmit, VK_NULL_HANDLE);
+            }
+            else
+            {
+                VulkanTimelineSubmit renderSubmit;
+                renderSubmit.vkSignalSemaphore = vkRenderTimeline;
+                renderSubmit.signalValue       = frameIndex + 1u;
+
+                VulkanTimelineSubmit copySubmit;
+                copySubmit.vkWaitSemaphore   = vkRenderTimeline;
+                copySubmit.waitValue         = frameIndex + 1u;
+                copySubmit.vkSignalSemaphore = vkCopyTimeline;
+                copySubmit.signalValue       = frameIndex + 1u;
+
+                succeeded = succeeded &&
+                            SubmitVulkanCommandBuffer(device.vkGraphicsQueue, image.vkGraphicsCommandBuffers[modeIndex], renderSubmit, VK_NULL_HANDLE) &&
+                            SubmitVulkanCommandBuffer(device.vkTransferQueue, image.vkTransferCommandBuffer, copySubmit, VK_NULL_HANDLE);
+            }
+        }
+
+        // Drain the mode, so that the next one starts from idle queues.
+        succeeded = succeeded && WaitVulkanTimelineSemaphore(device, vkCopyTimeline, frameIndex);
+    }
+
+    vkDeviceWaitIdle(device.vkLogicalDevice);
+
+    for (auto& image : images)
+    {
+        DestroyVulkanStagingBuffer(device, image.buffer);
+        vkDestroyImage(device.vkLogicalDevice, image.vkImage, nullptr);
+        vkFreeMemory(device.vkLogicalDevice, image.vkImageMemory, nullptr);
+    }
+
+    // Destroying the pools frees their command buffers.
+    vkDestroyCommandPool(device.vkLogicalDevice, vkGraphicsCommandPool, nullptr);
+    vkDestroyCommandPool(device.vkLogicalDevice, vkTransferCommandPool, nullptr);
+    vkDestroySemaphore(device.vkLogicalDevice, vkRenderTimeline, nullptr);
+    vkDestroySemaphore(device.vkLogicalDevice, vkCopyTimeline, nullptr);
+
+    return succeeded;
+}
+
+// Creates kBenchmarkThumbnailCount small shared images with a dedicated allocation each, then suballocated from the
+// memory arena (backends without one only measure the former), and records the bind time of each image, the
+// device memory objects they took and the arena fragmentation once every other image was destroyed.
+static bool MeasureThumbnailBinds(InteropBackend* pBackend, const VulkanDevice& device, std::vector<BenchmarkRecord>& records)
+{
+    SharedImageDesc thumbnailDesc;
+    thumbnailDesc.width  = kBenchmarkThumbnailSize;
+    thumbnailDesc.height = kBenchmarkThumbnailSize;
+    thumbnailDesc.format = GetPixelFormatTraits(PixelFormat::RGBA8).vkFormat;
+
+    const BenchmarkResolution resolution  = { kBenchmarkThumbnailSize, kBenchmarkThumbnailSize };
+    const char*               pFormatName = GetPixelFormatTraits(PixelFormat::RGBA8).pName;
+
+    auto addValue = [&](const char* pMetric, double value)
+    {
+        SampleSummary summary;
+        summary.count = 1u;
+        summary.mean  = summary.min = summary.p50 = summary.p95 = summary.p99 = summary.max = value;
+
+        records.push_back({ resolution, pFormatName, 0u, pMetric, summary });
+    };
+
+    // Every destroyed image is evicted right away, so that images never come from the cache.
+    ImportCache& importCache = pBackend->GetImportCache();
+    importCache.SetBudget(0u);
+
+    std::vector<SharedImage> thumbnails(kBenchmarkThumbnailCount);
+
+    auto destroyThumbnails = [&](uint32_t firstIndex, uint32_t step)
+    {
+        for (uint32_t thumbnailIndex = firstIndex; thumbnailIndex < kBenchmarkThumbnailCount; thumbnailIndex += step)
+        {
+            if (thumbnails[thumbnailIndex].vkImage != VK_NULL_HANDLE)
+                pBackend->DestroySharedImage(device, thumbnails[thumbnailIndex]);
+        }
+    };
+
+    auto measureMode = [&](bool useArena, const char* pBindMetric, const char* pMemoryMetric, const char* pFragmentationMetric)
+    {
+        if (!pBackend->EnableMemoryArena(useArena))
+            return true;
+
+        std::vector<double> bindMs;
+
+        for (auto& thumbnail : thumbnails)
+        {
+            const auto bindStart = std::chrono::steady_clock::now();
+
+            if (!pBackend->CreateSharedImage(device, thumbnailDesc, thumbnail))
+            {
+                spdlog::error("Failed to create a {}x{} thumbnail shared image.", kBenchmarkThumbnailSize, kBenchmarkThumbnailSize);
+
+                destroyThumbnails(0u, 1u);
+                return false;
+            }
+
+            bindMs.push_back(GetElapsedMilliseconds(bindStart));
+        }
+
+        records.push_back({ resolution, pFormatName, 0u, pBindMetric, SummarizeSamples(bindMs) });
+
+        addValue(pMemoryMetric, pBackend->GetMemoryArenaStats().deviceMemoryCount);
+
+        destroyThumbnails(1u, 2u);
+
+        if (pFragmentationMetric != nullptr)
+            addValue(pFragmentationMetric, pBackend->GetMemoryArenaStats().fragmentation);
+
+        destroyThumbnails(0u, 2u);
+
+        return true;
+    };
+
+    const bool succeeded = measureMode(false, "thumbnail_bind_dedicated_ms", "thumbnail_device_memory_dedicated", nullptr) &&
+                           measureMode(true,  "thumbnail_bind_arena_ms",     "thumbnail_device_memory_arena",     "thumbnail_arena_fragmentation");
+
+    // Restore the defaults for the sweep.
+    pBackend->EnableMemoryArena(true);
+    importCache.SetBudget(kImportCacheDefaultBudget);
+
+    return succeeded;
+}
+
+// A batch of kBenchmarkBatchSurfaceCount surfaces per frame, shared as that many images with a render and a readback
+// submit each, against one array image with a single render and readback submit for all of its layers: the CPU time
+// of the submits, the frame time until every surface is mapped, and the queue submissions each frame made (render
+// submits of the frame contexts plus the backend's readback submits).
+static bool MeasureSurfaceBatch(InteropBackend* pBackend, const VulkanDevice& device, FrameContextPool& frameContexts, uint32_t frameCount, std::vector<BenchmarkRecord>& records)
+{
+    SharedImageDesc surfaceDesc;
+    surfaceDesc.width  = kBenchmarkBatchSurfaceSize;
+    surfaceDesc.height = kBenchmarkBatchSurfaceSize;
+    surfaceDesc.format = GetPixelFormatTraits(PixelFormat::RGBA8).vkFormat;
+
+    SharedImageDesc batchDesc = surfaceDesc;
+    batchDesc.arrayLayers = kBenchmarkBatchSurfaceCount;
+
+    const BenchmarkResolution resolution  = { kBenchmarkBatchSurfaceSize, kBenchmarkBatchSurfaceSize };
+    const char*               pFormatName = GetPixelFormatTraits(PixelFormat::RGBA8).pName;
+
+    // Every surface of a frame is in flight at once.
+    if (!frameContexts.Reserve(kBenchmarkBatchSurfaceCount))
+        return false;
+
+    auto measureMode = [&](const SharedImageDesc& desc, uint32_t imageCount, const char* pSubmitMetric, const char* pFrameMetric, const char* pSubmitCountMetric)
+    {
+        std::vector<SharedImage> images(imageCount);
+
+        bool succeeded = true;
+
+        for (uint32_t imageIndex = 0u; succeeded && imageIndex < imageCount; imageIndex++)
+            succeeded = pBackend->CreateSharedImage(device, desc, images[imageIndex]);
+
+        std::vector<double> submitMs;
+        std::vector<double> frameMs;
+        std::vector<double> submitCounts;
+
+        for (uint64_t frameIndex = 0u; succeeded && frameIndex < kBenchmarkWarmupFrames + frameCount; frameIndex++)
+        {
+            const uint64_t firstSubmit = frameContexts.GetSubmitCount() + pBackend->GetReadbackSubmitCount();
+            const auto     frameStart  = std::chrono::steady_clock::now();
+
+            for (const SharedImage& image : images)
+            {
+                VkCommandBuffer vkCommandBuffer;
+                succeeded = succeeded && frameContexts.AcquireFrameContext(vkCommandBuffer);
+
+                if (!succeeded)
+                    break;
+
+                RecordFrame(device, image, frameIndex, vkCommandBuffer);
+
+                succeeded = frameContexts.SubmitFrameContext(vkCommandBuffer, GetFrameTimelineSubmit(image, frameIndex)) &&
+                            pBackend->SubmitReadback(image, frameIndex, 0u);
+            }
+
+            const double cpuMs = GetElapsedMilliseconds(frameStart);
+
+            for (const SharedImage& image : images)
+            {
+                MappedImage mappedImage;
+                succeeded = succeeded && pBackend->MapReadback(image, 0u, mappedImage);
+
+                if (succeeded)
+                    pBackend->UnmapReadback(image, 0u);
+            }
+
+            if (succeeded && frameIndex >= kBenchmarkWarmupFrames)
+            {
+                submitMs.push_back(cpuMs);
+                frameMs.push_back(GetElapsedMilliseconds(frameStart));
+                submitCounts.push_back((double)(frameContexts.GetSubmitCount() + pBackend->GetReadbackSubmitCount() - firstSubmit));
+            }
+        }
+
+        succeeded = frameContexts.WaitIdle() && succeeded;
+
+        for (SharedImage& image : images)
+        {
+            if (image.vkImage != VK_NULL_HANDLE)
+                pBackend->DestroySharedImage(device, image);
+        }
+
+        if (!succeeded)
+        {
+            spdlog::error("Failed to stream {} {}x{} surfaces as {} shared images.", kBenchmarkBatchSurfaceCount, kBenchmarkBatchSurfaceSize, kBenchmarkBatchSurfaceSize, imageCount);
+            return false;
+        }
+
+        records.push_back({ resolution, pFormatName, 0u, pSubmitMetric,      SummarizeSamples(submitMs) });
+        records.push_back({ resolution, pFormatName, 0u, pFrameMetric,       SummarizeSamples(frameMs) });
+        records.push_back({ resolution, pFormatName, 0u, pSubmitCountMetric, SummarizeSamples(submitCounts) });
+
+        return true;
+    };
+
+    return measureMode(surfaceDesc, kBenchmarkBatchSurfaceCount, "batch_submit_separate_ms", "batch_frame_separate_ms", "batch_submits_separate") &&
+           measureMode(batchDesc,   1u,                          "batch_submit_array_ms",    "batch_frame_array_ms",    "batch_submits_array");
+}
+
+// Fills frame with frame frameIndex of a sequence, returns false at its end.
+using CodecFrameFunc = std::function<bool(uint32_t frameIndex, std::vector<uint8_t>& frame)>;
+
+// Encodes and decodes frames through the transport codec, with a key frame every kFrameCodecKeyFrameInterval, and
+// records the size of the input against the encoded frames and the encode and decode throughput of each frame.
+static bool MeasureCodecSequence(ThreadPool& threadPool, BenchmarkResolution resolution, const char* pFormatName, uint32_t rowSize, uint32_t rowCount,
+                                 const CodecFrameFunc& getFrame, const char* pRatioMetric, const char* pEncodeMetric, const char* pDecodeMetric, std::vector<BenchmarkRecord>& records)
+{
+    const size_t frameSize = (size_t)rowSize * rowCount;
+
+    std::vector<uint8_t> frame(frameSize);
+    std::vector<uint8_t> encodedFrame;
+
+    FrameEncoder encoder;
+    FrameDecoder decoder;
+
+    std::vector<double> encodeGbps;
+    std::vector<double> decodeGbps;
+
+    uint64_t inputBytes   = 0u;
+    uint64_t encodedBytes = 0u;
+
+    for (uint32_t frameIndex = 0u; getFrame(frameIndex, frame); frameIndex++)
+    {
+        const bool keyFrame = frameIndex % kFrameCodecKeyFrameInterval == 0u;
+
+        const auto encodeStart = std::chrono::steady_clock::now();
+
+        if (!encoder.EncodeFrame(threadPool, frame.data(), rowSize, rowSize, rowCount, keyFrame, encodedFrame))
+            return false;
+
+        const double encodeMs = GetElapsedMilliseconds(encodeStart);
+
+        const auto decodeStart = std::chrono::steady_clock::now();
+
+        if (!decoder.DecodeFrame(threadPool, encodedFrame.data(), encodedFrame.size()))
+            return false;
+
+        const double decodeMs = GetElapsedMilliseconds(decodeStart);
+
+        if (memcmp(decoder.GetFrame(), frame.data(), frameSize) != 0)
+        {
+            spdlog::error("Frame {} of {} does not decode to its source.", frameIndex, pRatioMetric);
+            return false;
+        }
+
+        inputBytes   += frameSize;
+        encodedBytes += encodedFrame.size();
+
+        encodeGbps.push_back((double)frameSize / (std::max(encodeMs, 1e-6) * 1e6));
+        decodeGbps.push_back((double)frameSize / (std::max(decodeMs, 1e-6) * 1e6));
+    }
+
+    if (encodedBytes == 0u)
+        return false;
+
+    SampleSummary ratio;
+    ratio.count = 1u;
+    ratio.mean  = ratio.min = ratio.p50 = ratio.p95 = ratio.p99 = ratio.max = (double)inputBytes / (double)encodedBytes;
+
+    records.push_back({ resolution, pFormatName, 0u, pRatioMetric,  ratio });
+    records.push_back({ resolution, pFormatName, 0u, pEncodeMetric, SummarizeSamples(encodeGbps) });
+    records.push_back({ resolution, pFormatName, 0u, pDecodeMetric, SummarizeSamples(decodeGbps) });
+
+    return true;
+}
+
+// Synthetic sequences of the frame codec: a desktop, random content where only a window moving along the diagonal is
+// redrawn each frame, and noise, random content every frame, the worst case of the codec.
+static bool MeasureFrameCodec(ThreadPool& threadPool, BenchmarkResolution resolution, const PixelFormatTraits& format, uint32_t frameCount, std::vector<BenchmarkRecord>& records)
+{
+    const uint32_t rowSize  = GetPixelPlaneRowPitch(format, 0u, resolution.width);
+    const uint32_t rowCount = resolution.height;
+
+    std::mt19937 random(5489u);
+
+    auto fillRandom = [&](uint8_t* pBytes, size_t size)
+    {
+        for (size_t offset = 0u; offset < size; offset += sizeof(uint32_t))
+        {
+            const uint32_t value = random();
+            memcpy(pBytes + offset, &value, std::min(sizeof(uint32_t), size - offset));
+        }
+    };
+
+    auto getDesktopFrame = [&](uint32_t frameIndex, std::vector<uint8_t>& frame)
+    {
+        if (frameIndex == frameCount)
+            return false;
+
+        if (frameIndex == 0u)
+        {
+            fillRandom(frame.data(), frame.size());
+            return true;
+        }
+
+        const uint32_t windowWidth  = std::min(kBenchmarkCodecWindowSize, resolution.width);
+        const uint32_t windowHeight = std::min(kBenchmarkCodecWindowSize, resolution.height);
+        const uint32_t windowX      = (frameIndex * 8u) % (resolution.width  - windowWidth  + 1u);
+        const uint32_t windowY      = (frameIndex * 8u) % (resolution.height - windowHeight + 1u);
+        const uint32_t windowPitch  = GetPixelPlaneRowPitch(format, 0u, windowWidth);
+        const uint32_t windowOffset = GetPixelPlaneRowPitch(format, 0u, windowX);
+
+        for (uint32_t row = windowY; row < windowY + windowHeight; row++)
+            fillRandom(frame.data() + (size_t)row * rowSize + windowOffset, windowPitch);
+
+        return true;
+    };
+
+    auto getNoiseFrame = [&](uint32_t frameIndex, std::vector<uint8_t>& frame)
+    {
+        if (frameIndex == frameCount)
+            return false;
+
+        fillRandom(frame.data(), frame.size());
+        return true;
+    };
+
+    if (!MeasureCodecSequence(threadPool, resolution, format.pName, rowSize, rowCount, getDesktopFrame, "codec_desktop_ratio", "codec_desktop_encode_gbps", "codec_desktop_decode_gbps", records) ||
+        !MeasureCodecSequence(threadPool, resolution, format.pName, rowSize, rowCount, getNoiseFrame,   "codec_noise_ratio",   "codec_noise_encode_gbps",   "codec_noise_decode_gbps",   records))
+    {
+        spdlog::error("Failed to encode {}x{} {} frames with the frame codec.", resolution.width, resolution.height, format.pName);
+        return false;
+    }
+
+    return true;
+}
+
+// A capture of the interop sample (--stream=FILE), its frames as rows of the first plane.
+static bool MeasureRecordedFrameCodec(ThreadPool& threadPool, const char* pFileName, std::vector<BenchmarkRecord>& records)
+{
+    FILE* pFile = fopen(pFileName, "rb");
+    if (pFile == nullptr)
+    {
+        spdlog::error("Failed to open the capture {}.", pFileName);
+        return false;
+    }
+
+    VideoFileHeader header;
+    const bool readHeader = fread(&header, sizeof(header), 1u, pFile) == 1u && memcmp(header.magic, kVideoFileMagic, sizeof(kVideoFileMagic)) == 0 &&
+                            header.version == kVideoFileVersion;
+
+    const PixelFormatTraits* pTraits = readHeader ? FindPixelFormatTraits(header.format) : nullptr;
+
+    const uint32_t rowSize  = pTraits != nullptr ? GetPixelPlaneRowPitch(*pTraits, 0u, header.width) : 0u;
+    const uint32_t rowCount = rowSize > 0u ? (uint32_t)(header.frameSize / rowSize) : 0u;
+
+    if (rowCount == 0u || (uint64_t)rowSize * rowCount != header.frameSize || header.frameCount == 0u)
+    {
+        spdlog::error("{} is not a capture of the interop sample.", pFileName);
+        fclose(pFile);
+        return false;
+    }
+
+    // Frames are read in order one at a time, captures may not fit in memory. The frame index lies between the
+    // header and the frames, it is read past.
+    std::vector<uint8_t> frameIndexData(header.dataOffset > sizeof(header) ? (size_t)(header.dataOffset - sizeof(header)) : 0u);
+
+    const bool readFrames = frameIndexData.empty() || fread(frameIndexData.data(), frameIndexData.size(), 1u, pFile) == 1u;
+
+    auto getRecordedFrame = [&](uint32_t frameIndex, std::vector<uint8_t>& frame)
+    {
+        return readFrames && frameIndex < header.frameCount && fread(frame.data(), frame.size(), 1u, pFile) == 1u;
+    };
+
+    const BenchmarkResolution resolution = { header.width, header.height };
+
+    const bool measured = MeasureCodecSequence(threadPool, resolution, pTraits->pName, rowSize, rowCount, getRecordedFrame,
+                                               "codec_recorded_ratio", "codec_recorded_encode_gbps", "codec_recorded_decode_gbps", records);
+
+    fclose(pFile);
+
+    if (!measured)
+        spdlog::error("Failed to encode the frames of {} with the frame codec.", pFileName);
+
+    return measured;
+}
+
+// Runs every stage and readback depth for one resolution and format.
+static bool RunBenchmarkCase(InteropBackend* pBackend, const VulkanDevice& device, FrameContextPool& frameContexts, ThreadPool& encoderThreadPool, BenchmarkResolution resolution, const PixelFormatTraits& format,
+                             const std::vector<uint32_t>& readbackDepths, uint32_t frameCount, uint32_t bindCount, std::vector<BenchmarkRecord>& records)
+{
+    SharedImageDesc sharedImageDesc;
+    sharedImageDesc.width  = resolution.width;
+    sharedImageDesc.height = resolution.height;
+    sharedImageDesc.format = format.vkFormat;
+
+    auto addRecord = [&](const char* pMetric, std::vector<double>& samples)
+    {
+        records.push_back({ resolution, format.pName, 0u, pMetric, SummarizeSamples(samples) });
+    };
+
+    // Import/bind, first with the import cache disabled so that every bind exports and imports again, then
+    // recycling the previous import. The first bind of each pass is warmup, the last image is kept.
+    std::vector<double> bindMs;
+    std::vector<double> cachedBindMs;
+
+    SharedImage sharedImage;
+    bool        sharedImageCreated = false;
+
+    auto measureBinds = [&](std::vector<double>& samples)
+    {
+        for (uint32_t bindIndex = 0u; bindIndex <= bindCount; bindIndex++)
+        {
+            if (sharedImageCreated)
+                pBackend->DestroySharedImage(device, sharedImage);
+
+            sharedImageCreated = false;
+
+            const auto bindStart = std::chrono::steady_clock::now();
+
+            if (!pBackend->CreateSharedImage(device, sharedImageDesc, sharedImage))
+            {
+                spdlog::error("Failed to create a {}x{} {} shared image.", resolution.width, resolution.height, format.pName);
+                return false;
+            }
+
+            sharedImageCreated = true;
+
+            if (bindIndex > 0u)
+                samples.push_back(GetElapsedMilliseconds(bindStart));
+        }
+
+        return true;
+    };
+
+    ImportCache& importCache = pBackend->GetImportCache();
+
+    importCache.SetBudget(0u);
+    const bool bound = measureBinds(bindMs);
+    importCache.SetBudget(kImportCacheDefaultBudget);
+
+    if (!bound || !measureBinds(cachedBindMs))
+        return false;
+
+    StageSamples stageSamples;
+    bool succeeded = MeasureStages(pBackend, device, frameContexts, sharedImage, encoderThreadPool, frameCount, stageSamples);
+
+    // The submit measurements continue the timeline where the stage measurements stopped, the streams after them.
+    uint64_t nextFrameIndex = kBenchmarkWarmupFrames + frameCount;
+
+    std::vector<double> submitMs[(size_t)SubmitMode::Count];
+    succeeded = succeeded && MeasureSubmitCost(pBackend, device, frameContexts, sharedImage, nextFrameIndex, frameCount, submitMs);
+
+    std::vector<double> dirtyCopyMs;
+    std::vector<double> dirtyCopiedBytes;
+    succeeded = succeeded && MeasureDirtyReadback(pBackend, device, frameContexts, sharedImage, nextFrameIndex, frameCount, dirtyCopyMs, dirtyCopiedBytes);
+
+    std::vector<double> stagingCopyMs;
+    std::vector<double> zeroCopyMs;
+    succeeded = succeeded && MeasureHostReadback(pBackend, device, frameContexts, sharedImage, nextFrameIndex, frameCount, stagingCopyMs, zeroCopyMs);
+
+    std::vector<double> overlapMs[(size_t)OverlapMode::Count];
+    succeeded = succeeded && MeasureQueueOverlap(device, sharedImageDesc, frameCount, overlapMs);
+
+    if (succeeded)
+    {
+        addRecord("bind_ms",          bindMs);
+        addRecord("bind_cached_ms",   cachedBindMs);
+        addRecord("clear_submit_ms",  stageSamples.clearSubmitMs);
+        addRecord("readback_copy_ms", stageSamples.readbackCopyMs);
+        addRecord("map_ms",           stageSamples.mapMs);
+
+        addRecord("readback_copy_dirty_ms",    dirtyCopyMs);
+        addRecord("readback_copy_dirty_bytes", dirtyCopiedBytes);
+
+        addRecord("readback_to_buffer_staging_ms", stagingCopyMs);
+
+        if (!zeroCopyMs.empty())
+            addRecord("readback_to_buffer_zero_copy_ms", zeroCopyMs);
+
+        if (!stageSamples.convertMs.empty())
+            addRecord("convert_ms", stageSamples.convertMs);
+
+        addRecord("encode_ms",        stageSamples.encodeMs);
+
+        for (uint32_t modeIndex = 0u; modeIndex < (uint32_t)SubmitMode::Count; modeIndex++)
+            addRecord(kSubmitMetrics[modeIndex], submitMs[modeIndex]);
+
+        for (uint32_t modeIndex = 0u; modeIndex < (uint32_t)OverlapMode::Count; modeIndex++)
+            addRecord(kOverlapMetrics[modeIndex], overlapMs[modeIndex]);
+    }
+
+    succeeded = succeeded && MeasureFrameCodec(encoderThreadPool, resolution, format, frameCount, records);
+
+    for (uint32_t readbackDepth : readbackDepths)
+    {
+        if (!succeeded)
+            break;
+
+        FrameStreamDesc streamDesc;
+        streamDesc.firstFrameIndex = nextFrameIndex;
+        streamDesc.frameCount      = frameCount;
+        streamDesc.readbackDepth   = readbackDepth;
+
+        FrameStreamResult streamResult;
+        succeeded = RunFrameStream(pBackend, device, frameContexts, sharedImage, streamDesc, streamResult);
+
+        nextFrameIndex += frameCount;
+
+        if (!succeeded)
+            break;
+
+        if (streamResult.corruptFrames > 0u)
+            spdlog::warn("{}x{} {} depth {}: {} corrupt frames.", resolution.width, resolution.height, format.pName, readbackDepth, streamResult.corruptFrames);
+
+        SampleSummary throughput;
+        throughput.count = 1u;
+        throughput.mean  = throughput.min = throughput.p50 = throughput.p95 = throughput.p99 = throughput.max = streamResult.framesPerSecond;
+
+        records.push_back({ resolution, format.pName, readbackDepth, "stream_latency_ms", streamResult.latencyMs });
+        records.push_back({ resolution, format.pName, readbackDepth, "stream_fps",        throughput });
+    }
+
+    // Streams with the transport codec at the deepest readback depth, encoding each frame on delivery against
+    // encoding in a pipeline stage, with the stage's occupancy and queue depth.
+    const uint32_t codecReadbackDepth = readbackDepths.empty() ? 1u : *std::max_element(readbackDepths.begin(), readbackDepths.end());
+
+    for (uint32_t pipelineDepth : { 0u, kBenchmarkPipelineDepth })
+    {
+        if (!succeeded)
+            break;
+
+        FrameStreamDesc streamDesc;
+        streamDesc.firstFrameIndex  = nextFrameIndex;
+        streamDesc.frameCount       = frameCount;
+        streamDesc.readbackDepth    = codecReadbackDepth;
+        streamDesc.pCodecThreadPool = &encoderThreadPool;
+        streamDesc.pipelineDepth    = pipelineDepth;
+
+        FrameStreamResult streamResult;
+        succeeded = RunFrameStream(pBackend, device, frameContexts, sharedImage, streamDesc, streamResult);
+
+        nextFrameIndex += frameCount;
+
+        if (!succeeded)
+            break;
+
+        auto addStreamValue = [&](const char* pMetric, double value)
+        {
+            SampleSummary summary;
+            summary.count = 1u;
+            summary.mean  = summary.min = summary.p50 = summary.p95 = summary.p99 = summary.max = value;
+
+            records.push_back({ resolution, format.pName, codecReadbackDepth, pMetric, summary });
+        };
+
+        addStreamValue(pipelineDepth > 0u ? "stream_codec_pipelined_fps" : "stream_codec_serial_fps", streamResult.framesPerSecond);
+
+        if (streamResult.pipelined)
+        {
+            const PipelineStageStats& encodeStats = streamResult.pipelineStats.stages.front();
+
+            addStreamValue("pipeline_encode_occupancy", encodeStats.occupancy);
+            addStreamValue("pipeline_producer_stall_ms", 1000.0 * streamResult.pipelineStats.producerStallSeconds);
+
+            records.push_back({ resolution, format.pName, codecReadbackDepth, "pipeline_encode_queue_depth", encodeStats.queueDepth });
+        }
+    }
+
+    pBackend->DestroySharedImage(device, sharedImage);
+
+    if (!succeeded)
+    {
+        spdlog::error("Failed to benchmark a {}x{} {} shared image.", resolution.width, resolution.height, format.pName);
+        return false;
+    }
+
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    InteropBackendType backendType = GetDefaultInteropBackendType();
+    uint32_t           frameCount  = 60u;
+    uint32_t           bindCount   = 8u;
+    const char*        pOutputFile = "Benchmark.json";
+    const char*        pCodecInput = nullptr;
+
+    std::vector<BenchmarkResolution> resolutions = { { 1280u, 720u }, { 1920u, 1080u }, { 3840u, 2160u } };
+    std::vector<const PixelFormatTraits*> formats = { &GetPixelFormatTraits(PixelFormat::RGBA8), &GetPixelFormatTraits(PixelFormat::BGRA8) };
+    std::vector<uint32_t>            depths      = { 1u, 2u, 4u };
+
+    for (int argIndex = 1; argIndex < argc; argIndex++)
+    {
+        const char* pArgument = argv[argIndex];
+        const char* pValue;
+
+        if (ParseStringArgument(pArgument, "--backend=", pValue) && ParseInteropBackendType(pValue, backendType))
+            continue;
+
+        if ((ParseStringArgument(pArgument, "--resolutions=", pValue) && ParseResolutions(pValue, resolutions)) ||
+            (ParseStringArgument(pArgument, "--formats=",     pValue) && ParseFormats(pValue, formats))         ||
+            (ParseStringArgument(pArgument, "--depths=",      pValue) && ParseDepths(pValue, depths)))
+            continue;
+
+        if (ParseUIntArgument  (pArgument, "--frames=",      frameCount)  ||
+            ParseUIntArgument  (pArgument, "--binds=",       bindCount)   ||
+            ParseStringArgument(pArgument, "--output=",      pOutputFile) ||
+            ParseStringArgument(pArgument, "--codec-input=", pCodecInput))
+            continue;
+
+        spdlog::critical("Unknown argument: {} (usage: --backend=d3d11|opaque-fd|host-copy --resolutions=WxH,... --formats=rgba8,bgra8,rgb10a2,rgba16f --depths=K,... --frames=N --binds=N --output=FILE.json|FILE.csv --codec-input=CAPTURE)", pArgument);
+        return 1;
+    }
+
+    if (frameCount == 0u || bindCount == 0u)
+    {
+        spdlog::critical("Frame and bind counts must be at least 1.");
+        return 1;
+    }
+
+    // Initialize Vulkan
+    // ------------------------------------------------
+
+    VkInstance vkInstance;
+    if (!CreateVulkanInstance(vkInstance))
+    {
+        spdlog::critical("Failed to create the Vulkan Instance.");
+        return 1;
+    }
+
+    auto pBackend = CreateInteropBackend(backendType);
+    if (!pBackend)
+    {
+        spdlog::critical("The requested interop backend is not available on this platform.");
+        return 1;
+    }
+
+    if (!pBackend->CreateExporter(vkInstance))
+    {
+        spdlog::critical("Failed to create the exporter for the {} interop backend.", pBackend->GetName());
+        return 1;
+    }
+
+    std::vector<const char*> requiredDeviceExtensions;
+    pBackend->GetRequiredDeviceExtensions(requiredDeviceExtensions);
+
+    VkPhysicalDevice vkPhysicalDevice;
+    if (!pBackend->SelectPhysicalDevice(vkInstance, requiredDeviceExtensions, vkPhysicalDevice))
+    {
+        spdlog::critical("Failed to select a Vulkan Physical Device.");
+        return 1;
+    }
+
+    VulkanDevice device;
+    if (!CreateVulkanDevice(vkPhysicalDevice, requiredDeviceExtensions, device))
+    {
+        spdlog::critical("Failed to create the Vulkan Logical Device");
+        return 1;
+    }
+
+    if (!device.HasDedicatedTransferQueue())
+        spdlog::warn("No transfer-only queue family, overlap_async_ms runs on the graphics queue.");
+
+    // Sweep
+    // ------------------------------------------------
+
+    ThreadPool encoderThreadPool;
+
+    FrameContextPool frameContexts;
+    if (!frameContexts.Create(device, 2u))
+        return 1;
+
+    std::vector<BenchmarkRecord> records;
+
+    if (!MeasureThumbnailBinds(pBackend.get(), device, records))
+        return 1;
+
+    for (const auto& record : records)
+        spdlog::info("Thumbnails {}: p50 {:.3f}, p95 {:.3f}", record.pMetric, record.summary.p50, record.summary.p95);
+
+    const size_t firstBatchRecord = records.size();
+
+    if (!MeasureSurfaceBatch(pBackend.get(), device, frameContexts, frameCount, records))
+        return 1;
+
+    for (size_t recordIndex = firstBatchRecord; recordIndex < records.size(); recordIndex++)
+        spdlog::info("Surface batch {}: p50 {:.3f}, p95 {:.3f}", records[recordIndex].pMetric, records[recordIndex].summary.p50, records[recordIndex].summary.p95);
+
+    if (pCodecInput != nullptr)
+    {
+        const size_t firstCodecRecord = records.size();
+
+        if (!MeasureRecordedFrameCodec(encoderThreadPool, pCodecInput, records))
+            return 1;
+
+        for (size_t recordIndex = firstCodecRecord; recordIndex < records.size(); recordIndex++)
+            spdlog::info("Recorded {}: p50 {:.3f}, p95 {:.3f}", records[recordIndex].pMetric, records[recordIndex].summary.p50, records[recordIndex].summary.p95);
+    }
+
+    for (const auto& resolution : resolutions)
+    {
+        for (const PixelFormatTraits* pFormat : formats)
+        {
+            const size_t firstRecord = records.size();
+
+            if (!RunBenchmarkCase(pBackend.get(), device, frameContexts, encoderThreadPool, resolution, *pFormat, depths, frameCount, bindCount, records))
+                return 1;
+
+            for (size_t recordIndex = firstRecord; recordIndex < records.size(); recordIndex++)
+            {
+                const auto& record = records[recordIndex];
+
+                spdlog::info("{}x{} {} depth {} {}: p50 {:.3f}, p95 {:.3f}, p99 {:.3f}",
+                    resolution.width,
+                    resolution.height,
+                    pFormat->pName,
+                    record.readbackDepth,
+                    record.pMetric,
+                    record.summary.p50,
+                    record.summary.p95,
+                    record.summary.p99
+                );
+            }
+        }
+    }
+
+    const char* pBackendName = pBackend->GetName();
+
+    frameContexts.Destroy();
+
+    pBackend->Release();
+
+    DestroyVulkanDevice(device);
+    vkDestroyInstance(vkInstance, nullptr);
+
+    if (!WriteBenchmarkResults(pOutputFile, pBackendName, records))
+    {
+        spdlog::critical("Failed to write the benchmark results to {}.", pOutputFile);
+        return 1;
+    }
+
+    spdlog::info("Wrote {} benchmark results to: {}", records.size(), pOutputFile);
+
+    return 0;
+}
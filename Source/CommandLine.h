@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+// Matches "--name=value" arguments. pName includes the leading dashes and the trailing '='.
+inline bool ParseStringArgument(const char* pArgument, const char* pName, const char*& pValue)
+{
+    const size_t nameLength = strlen(pName);
+
+    if (strncmp(pArgument, pName, nameLength))
+        return false;
+
+    pValue = pArgument + nameLength;
+
+    return true;
+}
+
+inline bool ParseUIntArgument(const char* pArgument, const char* pName, uint32_t& value)
+{
+    const char* pValue;
+    if (!ParseStringArgument(pArgument, pName, pValue))
+        return false;
+
+    char* pEnd;
+    const unsigned long parsedValue = strtoul(pValue, &pEnd, 10);
+
+    if (pEnd == pValue || *pEnd != '\0')
+        return false;
+
+    value = (uint32_t)parsedValue;
+
+    return true;
+}
@@ -0,0 +1,246 @@
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#include <spdlog/spdlog.h>
+
+#include "CommandLine.h"
+#include "ExternalImage.h"
+#include "SharedFrameRing.h"
+#include "Statistics.h"
+
+// Attaches to a producer's shared frame ring, imports its images and reads the newest frame back each
+// iteration. Reports steady-state throughput and the latency from publish to acquire (handoff) and from
+// publish to pixels on the CPU (end to end).
+
+struct ConsumerSlot
+{
+    VkImage        vkImage       = VK_NULL_HANDLE;
+    VkDeviceMemory vkImageMemory = VK_NULL_HANDLE;
+};
+
+int main(int argc, char** argv)
+{
+    const char* pRingName  = kSharedFrameRingDefaultName;
+    uint32_t    frameCount = 1000u;
+    uint32_t    timeoutMs  = 10000u;
+
+    for (int argIndex = 1; argIndex < argc; argIndex++)
+    {
+        const char* pArgument = argv[argIndex];
+
+        if (ParseStringArgument(pArgument, "--name=",    pRingName)  ||
+            ParseUIntArgument  (pArgument, "--frames=",  frameCount) ||
+            ParseUIntArgument  (pArgument, "--timeout=", timeoutMs))
+            continue;
+
+        spdlog::critical("Unknown argument: {} (usage: --name=<ring> --frames=N --timeout=<ms>)", pArgument);
+        return 1;
+    }
+
+    SharedFrameRing ring;
+    if (!ring.Open(pRingName, timeoutMs))
+    {
+        spdlog::critical("Failed to open the shared frame ring '{}'.", pRingName);
+        return 1;
+    }
+
+    const auto& ringHeader = ring.GetHeader();
+
+    ExternalMemoryHandle    memoryHandles[kSharedFrameRingMaxSlots];
+    ExternalSemaphoreHandle frameTimelineHandle;
+    if (!ring.ReceiveMemoryHandles(memoryHandles, frameTimelineHandle))
+    {
+        spdlog::critical("Failed to receive the memory handles from the producer.");
+        return 1;
+    }
+
+    VkInstance vkInstance;
+    if (!CreateVulkanInstance(vkInstance))
+    {
+        spdlog::critical("Failed to create the Vulkan Instance.");
+        return 1;
+    }
+
+    const std::vector<const char*> requiredDeviceExtensions = { kVulkanExternalMemoryExtensionName, kVulkanExternalSemaphoreExtensionName };
+
+    // Exported memory can only be imported on the producer's physical device.
+    VkPhysicalDevice vkPhysicalDevice;
+    if (!SelectVulkanPhysicalDevice(vkInstance, requiredDeviceExtensions, ringHeader.deviceUUID, vkPhysicalDevice))
+    {
+        spdlog::critical("The producer's Vulkan Physical Device is not available to this process.");
+        return 1;
+    }
+
+    VulkanDevice device;
+    if (!CreateVulkanDevice(vkPhysicalDevice, requiredDeviceExtensions, device))
+        return 1;
+
+    // Import the producer's image pool.
+    // ------------------------------------------------
+
+    SharedImageDesc imageDesc;
+    imageDesc.width  = ringHeader.width;
+    imageDesc.height = ringHeader.height;
+    imageDesc.format = ringHeader.format;
+
+    ConsumerSlot slots[kSharedFrameRingMaxSlots];
+
+    for (uint32_t slotIndex = 0u; slotIndex < ringHeader.slotCount; slotIndex++)
+    {
+        auto& slot = slots[slotIndex];
+
+        if (!CreateVulkanImage2D(device, imageDesc, kVulkanExternalMemoryHandleType, slot.vkImage) ||
+            !ImportVulkanImageMemory(device, slot.vkImage, memoryHandles[slotIndex], ringHeader.allocationSize, slot.vkImageMemory))
+        {
+            spdlog::critical("Failed to import the image of slot {}.", slotIndex);
+            return 1;
+        }
+    }
+
+    VkSemaphore vkFrameTimeline;
+    if (!CreateVulkanTimelineSemaphore(device, 0u, vkFrameTimeline) ||
+        !ImportVulkanSemaphoreHandle(device, vkFrameTimeline, kVulkanExternalSemaphoreHandleType, frameTimelineHandle))
+    {
+        spdlog::critical("Failed to import the producer's frame timeline semaphore.");
+        return 1;
+    }
+
+    VulkanStagingBuffer readbackBuffer;
+    if (!CreateVulkanStagingBuffer(device, GetSharedImageSize(imageDesc), VK_BUFFER_USAGE_TRANSFER_DST_BIT, readbackBuffer))
+        return 1;
+
+    VkCommandPoolCreateInfo vkCommandPoolCreateInfo = { VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO };
+    vkCommandPoolCreateInfo.flags            = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    vkCommandPoolCreateInfo.queueFamilyIndex = device.transferQueueIndex;
+
+    VkCommandPool vkCommandPool;
+    if (vkCreateCommandPool(device.vkLogicalDevice, &vkCommandPoolCreateInfo, nullptr, &vkCommandPool) != VK_SUCCESS)
+        return 1;
+
+    VkCommandBufferAllocateInfo vkCommandAllocateInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
+    vkCommandAllocateInfo.commandBufferCount = 1u;
+    vkCommandAllocateInfo.commandPool        = vkCommandPool;
+    vkCommandAllocateInfo.level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+
+    VkCommandBuffer vkCommandBuffer;
+    if (vkAllocateCommandBuffers(device.vkLogicalDevice, &vkCommandAllocateInfo, &vkCommandBuffer) != VK_SUCCESS)
+        return 1;
+
+    VkFenceCreateInfo vkFenceCreateInfo = { VK_STRUCTURE_TYPE_FENCE_CREATE_INFO };
+
+    VkFence vkFence;
+    if (vkCreateFence(device.vkLogicalDevice, &vkFenceCreateInfo, nullptr, &vkFence) != VK_SUCCESS)
+        return 1;
+
+    spdlog::info("Consuming {} frames of {}x{} from {} slots of ring '{}'.", frameCount, imageDesc.width, imageDesc.height, ringHeader.slotCount, pRingName);
+
+    // Consume frames.
+    // ------------------------------------------------
+
+    std::vector<double> handoffLatenciesMs;
+    std::vector<double> endToEndLatenciesMs;
+
+    uint64_t consumedFrames   = 0u;
+    uint64_t skippedFrames    = 0u;
+    uint64_t tornFrames       = 0u;
+    uint64_t previousSequence = 0u;
+
+    auto consumeStart = std::chrono::steady_clock::now();
+    auto lastFrameAt  = consumeStart;
+
+    while (consumedFrames < frameCount)
+    {
+        uint32_t slotIndex;
+        uint64_t frameSequence;
+        uint64_t publishTimeNs;
+        if (!ring.AcquireReadSlot(slotIndex, frameSequence, publishTimeNs))
+        {
+            if (std::chrono::steady_clock::now() - lastFrameAt > std::chrono::milliseconds(timeoutMs))
+            {
+                spdlog::warn("The producer stopped publishing frames.");
+                break;
+            }
+
+            std::this_thread::yield();
+            continue;
+        }
+
+        const uint64_t acquireTimeNs = GetMonotonicTimeNs();
+
+        if (consumedFrames == 0u)
+            consumeStart = std::chrono::steady_clock::now();
+
+        VkCommandBufferBeginInfo vkCommandBeginInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+        vkCommandBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+        vkResetCommandBuffer(vkCommandBuffer, 0u);
+        vkBeginCommandBuffer(vkCommandBuffer, &vkCommandBeginInfo);
+
+        // Acquire the image released by the producer process onto the transfer queue doing the copy.
+        RecordVulkanImageBarrier(vkCommandBuffer, slots[slotIndex].vkImage, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL, 0u, VK_ACCESS_TRANSFER_READ_BIT, VK_QUEUE_FAMILY_EXTERNAL, device.transferQueueIndex);
+        RecordVulkanImageToBufferCopy(vkCommandBuffer, slots[slotIndex].vkImage, VK_IMAGE_LAYOUT_GENERAL, readbackBuffer.vkBuffer, imageDesc);
+
+        vkEndCommandBuffer(vkCommandBuffer);
+
+        // Frames are published before the producer's GPU finished them.
+        VulkanTimelineSubmit timelineSubmit;
+        timelineSubmit.vkWaitSemaphore = vkFrameTimeline;
+        timelineSubmit.waitValue       = frameSequence;
+
+        if (!SubmitVulkanCommandBuffer(device.vkTransferQueue, vkCommandBuffer, timelineSubmit, vkFence))
+        {
+            spdlog::critical("Failed to submit the readback of frame {}.", frameSequence);
+            return 1;
+        }
+
+        vkWaitForFences(device.vkLogicalDevice, 1u, &vkFence, VK_TRUE, UINT64_MAX);
+        vkResetFences(device.vkLogicalDevice, 1u, &vkFence);
+
+        // The copy is complete, the producer may reuse the slot.
+        ring.ReleaseReadSlot(slotIndex);
+
+        const uint64_t readbackTimeNs = GetMonotonicTimeNs();
+
+        if (((const uint8_t*)readbackBuffer.pMappedData)[0] != (uint8_t)(frameSequence & 0xFFu))
+            tornFrames++;
+
+        if (previousSequence != 0u)
+            skippedFrames += frameSequence - previousSequence - 1u;
+
+        handoffLatenciesMs.push_back((double)(acquireTimeNs - publishTimeNs) / 1e6);
+        endToEndLatenciesMs.push_back((double)(readbackTimeNs - publishTimeNs) / 1e6);
+
+        previousSequence = frameSequence;
+        lastFrameAt      = std::chrono::steady_clock::now();
+
+        consumedFrames++;
+    }
+
+    const double consumeSeconds = std::chrono::duration<double>(lastFrameAt - consumeStart).count();
+
+    const auto handoff   = SummarizeSamples(handoffLatenciesMs);
+    const auto endToEnd  = SummarizeSamples(endToEndLatenciesMs);
+
+    spdlog::info("Consumed {} frames in {:.3f} s ({:.1f} fps), skipped {}, torn {}.", consumedFrames, consumeSeconds, consumedFrames / std::max(consumeSeconds, 1e-9), skippedFrames, tornFrames);
+    spdlog::info("Handoff latency    (ms): p50 {:.3f}, p95 {:.3f}, p99 {:.3f}, max {:.3f}", handoff.p50,  handoff.p95,  handoff.p99,  handoff.max);
+    spdlog::info("End to end latency (ms): p50 {:.3f}, p95 {:.3f}, p99 {:.3f}, max {:.3f}", endToEnd.p50, endToEnd.p95, endToEnd.p99, endToEnd.max);
+
+    // Release Vulkan Primitives.
+    vkDestroyFence(device.vkLogicalDevice, vkFence, nullptr);
+    vkDestroySemaphore(device.vkLogicalDevice, vkFrameTimeline, nullptr);
+    vkDestroyCommandPool(device.vkLogicalDevice, vkCommandPool, nullptr);
+
+    DestroyVulkanStagingBuffer(device, readbackBuffer);
+
+    for (uint32_t slotIndex = 0u; slotIndex < ringHeader.slotCount; slotIndex++)
+    {
+        vkDestroyImage (device.vkLogicalDevice, slots[slotIndex].vkImage,       nullptr);
+        vkFreeMemory   (device.vkLogicalDevice, slots[slotIndex].vkImageMemory, nullptr);
+    }
+
+    DestroyVulkanDevice(device);
+    vkDestroyInstance(vkInstance, nullptr);
+
+    return 0;
+}
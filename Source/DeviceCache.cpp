@@ -0,0 +1,321 @@
+#include "DeviceCache.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <list>
+#include <mutex>
+
+#include <spdlog/spdlog.h>
+
+// Device capability cache file: header, then entryCount entries of
+//   deviceUUID, driverVersion, extension count, (name length, name) per extension,
+//   queue family count, VkQueueFamilyProperties per family.
+constexpr uint32_t kDeviceCacheMagic   = 0x43445653u; // "SVDC"
+constexpr uint32_t kDeviceCacheVersion = 1u;
+
+// Sanity limits for loaded files.
+constexpr uint32_t kDeviceCacheMaxEntries       = 64u;
+constexpr uint32_t kDeviceCacheMaxListLength    = 4096u;
+constexpr uint32_t kDeviceCacheMaxNameLength    = VK_MAX_EXTENSION_NAME_SIZE;
+
+struct DeviceCacheEntry
+{
+    uint8_t  deviceUUID[VK_UUID_SIZE] = {};
+    uint32_t driverVersion            = 0u;
+
+    // Set once a device of this process resolved to the entry.
+    VkPhysicalDevice vkPhysicalDevice = VK_NULL_HANDLE;
+
+    VulkanDeviceCapabilities capabilities;
+};
+
+// A list, so that references to the capabilities of an entry stay valid as entries are added.
+static std::mutex                  s_deviceCacheMutex;
+static std::list<DeviceCacheEntry> s_deviceCacheEntries;
+
+static void QueryVulkanDeviceCapabilities(const VkPhysicalDevice& vkPhysicalDevice, VulkanDeviceCapabilities& capabilities)
+{
+    uint32_t extensionCount = 0u;
+    vkEnumerateDeviceExtensionProperties(vkPhysicalDevice, nullptr, &extensionCount, nullptr);
+
+    std::vector<VkExtensionProperties> extensions(extensionCount);
+    vkEnumerateDeviceExtensionProperties(vkPhysicalDevice, nullptr, &extensionCount, extensions.data());
+
+    capabilities.extensionNames.clear();
+
+    for (uint32_t extensionIndex = 0u; extensionIndex < extensionCount; extensionIndex++)
+        capabilities.extensionNames.push_back(extensions[extensionIndex].extensionName);
+
+    std::sort(capabilities.extensionNames.begin(), capabilities.extensionNames.end());
+
+    uint32_t queueFamilyCount = 0u;
+    vkGetPhysicalDeviceQueueFamilyProperties(vkPhysicalDevice, &queueFamilyCount, nullptr);
+
+    capabilities.queueFamilies.resize(queueFamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(vkPhysicalDevice, &queueFamilyCount, capabilities.queueFamilies.data());
+}
+
+const VulkanDeviceCapabilities& GetVulkanDeviceCapabilities(const VkPhysicalDevice& vkPhysicalDevice)
+{
+    std::lock_guard<std::mutex> cacheLock(s_deviceCacheMutex);
+
+    for (const auto& entry : s_deviceCacheEntries)
+    {
+        if (entry.vkPhysicalDevice == vkPhysicalDevice)
+            return entry.capabilities;
+    }
+
+    VkPhysicalDeviceIDProperties vkIDProperties = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES };
+
+    VkPhysicalDeviceProperties2 vkProperties = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2 };
+    vkProperties.pNext = &vkIDProperties;
+
+    vkGetPhysicalDeviceProperties2(vkPhysicalDevice, &vkProperties);
+
+    // An entry of an earlier launch, as long as the driver was not updated since.
+    for (auto& entry : s_deviceCacheEntries)
+    {
+        if (entry.vkPhysicalDevice != VK_NULL_HANDLE || entry.driverVersion != vkProperties.properties.driverVersion ||
+            memcmp(entry.deviceUUID, vkIDProperties.deviceUUID, VK_UUID_SIZE))
+            continue;
+
+        entry.vkPhysicalDevice = vkPhysicalDevice;
+
+        return entry.capabilities;
+    }
+
+    // Drop a stale entry of the same device rather than saving it again.
+    s_deviceCacheEntries.remove_if([&](const DeviceCacheEntry& entry)
+    {
+        return entry.vkPhysicalDevice == VK_NULL_HANDLE && !memcmp(entry.deviceUUID, vkIDProperties.deviceUUID, VK_UUID_SIZE);
+    });
+
+    DeviceCacheEntry& entry = s_deviceCacheEntries.emplace_back();
+    memcpy(entry.deviceUUID, vkIDProperties.deviceUUID, VK_UUID_SIZE);
+    entry.driverVersion    = vkProperties.properties.driverVersion;
+    entry.vkPhysicalDevice = vkPhysicalDevice;
+
+    QueryVulkanDeviceCapabilities(vkPhysicalDevice, entry.capabilities);
+
+    return entry.capabilities;
+}
+
+// Device Cache File
+// ------------------------------------------------
+
+template <typename T>
+static bool ReadValue(FILE* pFile, T& value)
+{
+    return fread(&value, sizeof(T), 1u, pFile) == 1u;
+}
+
+template <typename T>
+static bool WriteValue(FILE* pFile, const T& value)
+{
+    return fwrite(&value, sizeof(T), 1u, pFile) == 1u;
+}
+
+static bool ReadDeviceCacheEntry(FILE* pFile, DeviceCacheEntry& entry)
+{
+    uint32_t extensionCount;
+    if (fread(entry.deviceUUID, 1u, VK_UUID_SIZE, pFile) != VK_UUID_SIZE || !ReadValue(pFile, entry.driverVersion) ||
+        !ReadValue(pFile, extensionCount) || extensionCount > kDeviceCacheMaxListLength)
+        return false;
+
+    entry.capabilities.extensionNames.resize(extensionCount);
+
+    for (auto& extensionName : entry.capabilities.extensionNames)
+    {
+        uint32_t nameLength;
+        if (!ReadValue(pFile, nameLength) || nameLength > kDeviceCacheMaxNameLength)
+            return false;
+
+        extensionName.resize(nameLength);
+
+        if (fread(extensionName.data(), 1u, nameLength, pFile) != nameLength)
+            return false;
+    }
+
+    uint32_t queueFamilyCount;
+    if (!ReadValue(pFile, queueFamilyCount) || queueFamilyCount > kDeviceCacheMaxListLength)
+        return false;
+
+    entry.capabilities.queueFamilies.resize(queueFamilyCount);
+
+    return fread(entry.capabilities.queueFamilies.data(), sizeof(VkQueueFamilyProperties), queueFamilyCount, pFile) == queueFamilyCount;
+}
+
+static bool WriteDeviceCacheEntry(FILE* pFile, const DeviceCacheEntry& entry)
+{
+    const auto& capabilities = entry.capabilities;
+
+    bool written = fwrite(entry.deviceUUID, 1u, VK_UUID_SIZE, pFile) == VK_UUID_SIZE &&
+                   WriteValue(pFile, entry.driverVersion) &&
+                   WriteValue(pFile, (uint32_t)capabilities.extensionNames.size());
+
+    for (const auto& extensionName : capabilities.extensionNames)
+    {
+        written = written &&
+                  WriteValue(pFile, (uint32_t)extensionName.size()) &&
+                  fwrite(extensionName.data(), 1u, extensionName.size(), pFile) == extensionName.size();
+    }
+
+    return written &&
+           WriteValue(pFile, (uint32_t)capabilities.queueFamilies.size()) &&
+           fwrite(capabilities.queueFamilies.data(), sizeof(VkQueueFamilyProperties), capabilities.queueFamilies.size(), pFile) == capabilities.queueFamilies.size();
+}
+
+bool LoadVulkanDeviceCache(const char* pFileName)
+{
+    FILE* pFile = fopen(pFileName, "rb");
+    if (pFile == nullptr)
+        return false;
+
+    uint32_t magic, version, entryCount;
+    bool loaded = ReadValue(pFile, magic) && magic == kDeviceCacheMagic &&
+                  ReadValue(pFile, version) && version == kDeviceCacheVersion &&
+                  ReadValue(pFile, entryCount) && entryCount <= kDeviceCacheMaxEntries;
+
+    std::list<DeviceCacheEntry> entries;
+
+    for (uint32_t entryIndex = 0u; loaded && entryIndex < entryCount; entryIndex++)
+        loaded = ReadDeviceCacheEntry(pFile, entries.emplace_back());
+
+    fclose(pFile);
+
+    if (!loaded)
+    {
+        spdlog::warn("Ignoring the invalid device cache {}.", pFileName);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> cacheLock(s_deviceCacheMutex);
+
+    s_deviceCacheEntries.splice(s_deviceCacheEntries.end(), entries);
+
+    return true;
+}
+
+bool SaveVulkanDeviceCache(const char* pFileName)
+{
+    FILE* pFile = fopen(pFileName, "wb");
+    if (pFile == nullptr)
+    {
+        spdlog::error("Failed to open {} for writing.", pFileName);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> cacheLock(s_deviceCacheMutex);
+
+    const uint32_t entryCount = (uint32_t)std::min<size_t>(s_deviceCacheEntries.size(), kDeviceCacheMaxEntries);
+
+    bool written = WriteValue(pFile, kDeviceCacheMagic) &&
+                   WriteValue(pFile, kDeviceCacheVersion) &&
+                   WriteValue(pFile, entryCount);
+
+    auto entryIterator = s_deviceCacheEntries.begin();
+    for (uint32_t entryIndex = 0u; written && entryIndex < entryCount; entryIndex++, entryIterator++)
+        written = WriteDeviceCacheEntry(pFile, *entryIterator);
+
+    written = fclose(pFile) == 0 && written;
+
+    if (!written)
+        spdlog::error("Failed to write the device cache {}.", pFileName);
+
+    return written;
+}
+
+// Pipeline Cache
+// ------------------------------------------------
+
+// Whether data saved from a pipeline cache was created by this device and driver.
+static bool IsVulkanPipelineCacheCompatible(const VkPhysicalDevice& vkPhysicalDevice, const std::vector<uint8_t>& cacheData)
+{
+    VkPipelineCacheHeaderVersionOne header;
+    if (cacheData.size() < sizeof(header))
+        return false;
+
+    memcpy(&header, cacheData.data(), sizeof(header));
+
+    VkPhysicalDeviceProperties physicalDeviceProperties;
+    vkGetPhysicalDeviceProperties(vkPhysicalDevice, &physicalDeviceProperties);
+
+    return header.headerSize    >= sizeof(header) &&
+           header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+           header.vendorID      == physicalDeviceProperties.vendorID &&
+           header.deviceID      == physicalDeviceProperties.deviceID &&
+           !memcmp(header.pipelineCacheUUID, physicalDeviceProperties.pipelineCacheUUID, VK_UUID_SIZE);
+}
+
+bool CreateVulkanPipelineCache(VulkanDevice& device, const char* pFileName)
+{
+    std::vector<uint8_t> cacheData;
+
+    FILE* pFile = pFileName != nullptr ? fopen(pFileName, "rb") : nullptr;
+
+    if (pFile != nullptr)
+    {
+        fseek(pFile, 0, SEEK_END);
+        const long fileSize = ftell(pFile);
+        fseek(pFile, 0, SEEK_SET);
+
+        if (fileSize > 0)
+        {
+            cacheData.resize((size_t)fileSize);
+
+            if (fread(cacheData.data(), 1u, cacheData.size(), pFile) != cacheData.size())
+                cacheData.clear();
+        }
+
+        fclose(pFile);
+    }
+
+    // Data of another device or driver version would be rejected (or worse) by the driver.
+    if (!cacheData.empty() && !IsVulkanPipelineCacheCompatible(device.vkPhysicalDevice, cacheData))
+    {
+        spdlog::info("Discarding the pipeline cache {} of another device or driver.", pFileName);
+        cacheData.clear();
+    }
+
+    VkPipelineCacheCreateInfo vkPipelineCacheCreateInfo = { VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO };
+    vkPipelineCacheCreateInfo.initialDataSize = cacheData.size();
+    vkPipelineCacheCreateInfo.pInitialData    = cacheData.data();
+
+    if (vkCreatePipelineCache(device.vkLogicalDevice, &vkPipelineCacheCreateInfo, nullptr, &device.vkPipelineCache) != VK_SUCCESS)
+    {
+        spdlog::error("Failed to create the Vulkan pipeline cache.");
+        return false;
+    }
+
+    return true;
+}
+
+bool SaveVulkanPipelineCache(const VulkanDevice& device, const char* pFileName)
+{
+    if (device.vkPipelineCache == VK_NULL_HANDLE)
+        return false;
+
+    size_t cacheSize = 0u;
+    if (vkGetPipelineCacheData(device.vkLogicalDevice, device.vkPipelineCache, &cacheSize, nullptr) != VK_SUCCESS)
+        return false;
+
+    std::vector<uint8_t> cacheData(cacheSize);
+    if (vkGetPipelineCacheData(device.vkLogicalDevice, device.vkPipelineCache, &cacheSize, cacheData.data()) != VK_SUCCESS)
+        return false;
+
+    FILE* pFile = fopen(pFileName, "wb");
+    if (pFile == nullptr)
+    {
+        spdlog::error("Failed to open {} for writing.", pFileName);
+        return false;
+    }
+
+    bool written = fwrite(cacheData.data(), 1u, cacheSize, pFile) == cacheSize;
+    written = fclose(pFile) == 0 && written;
+
+    if (!written)
+        spdlog::error("Failed to write the pipeline cache {}.", pFileName);
+
+    return written;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <string>
+
+#include "Vulkan.h"
+
+// Physical device properties that startup queries several times (device selection on both sides of the interop,
+// queue family discovery, transfer granularity), kept in memory for the process and on disk across launches.
+struct VulkanDeviceCapabilities
+{
+    // Sorted.
+    std::vector<std::string>             extensionNames;
+    std::vector<VkQueueFamilyProperties> queueFamilies;
+};
+
+// Capabilities of a physical device, queried from the driver only the first time a device UUID and driver version
+// is seen. The reference stays valid for the lifetime of the process. Thread-safe.
+const VulkanDeviceCapabilities& GetVulkanDeviceCapabilities(const VkPhysicalDevice& vkPhysicalDevice);
+
+// Loads the capabilities saved by an earlier launch. A missing or invalid file leaves the cache empty and returns false.
+bool LoadVulkanDeviceCache(const char* pFileName);
+
+// Saves the capabilities of every device seen so far, including those loaded.
+bool SaveVulkanDeviceCache(const char* pFileName);
+
+// Creates device.vkPipelineCache, with the data of an earlier SaveVulkanPipelineCache when pFileName holds data of
+// the same device and driver (the header's vendor, device and pipelineCacheUUID). Otherwise, or with a null
+// pFileName, the cache starts empty.
+bool CreateVulkanPipelineCache(VulkanDevice& device, const char* pFileName);
+
+bool SaveVulkanPipelineCache(const VulkanDevice& device, const char* pFileName);
@@ -0,0 +1,116 @@
+#include "DirtyTiles.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+void DirtyTileMap::Resize(uint32_t width, uint32_t height)
+{
+    m_width       = width;
+    m_height      = height;
+    m_columnCount = (width  + kDirtyTileSize - 1u) / kDirtyTileSize;
+    m_rowCount    = (height + kDirtyTileSize - 1u) / kDirtyTileSize;
+
+    m_tileBits.assign((GetTileCount() + 63u) / 64u, 0u);
+
+    MarkAll();
+}
+
+void DirtyTileMap::AddRect(const DirtyRect& rect)
+{
+    if (rect.x >= m_width || rect.y >= m_height || rect.width == 0u || rect.height == 0u)
+        return;
+
+    const uint32_t right  = std::min(m_width,  rect.x + std::min(rect.width,  m_width));
+    const uint32_t bottom = std::min(m_height, rect.y + std::min(rect.height, m_height));
+
+    const uint32_t firstColumn = rect.x / kDirtyTileSize;
+    const uint32_t lastColumn  = (right - 1u) / kDirtyTileSize;
+
+    for (uint32_t row = rect.y / kDirtyTileSize; row <= (bottom - 1u) / kDirtyTileSize; row++)
+    {
+        for (uint32_t column = firstColumn; column <= lastColumn; column++)
+        {
+            const uint32_t tileIndex = row * m_columnCount + column;
+
+            m_tileBits[tileIndex / 64u] |= 1ull << (tileIndex % 64u);
+        }
+    }
+}
+
+void DirtyTileMap::MarkAll()
+{
+    std::fill(m_tileBits.begin(), m_tileBits.end(), ~0ull);
+
+    // Keep the bits past the last tile clear, so that they are not counted.
+    if (GetTileCount() % 64u != 0u)
+        m_tileBits.back() = (1ull << (GetTileCount() % 64u)) - 1u;
+}
+
+void DirtyTileMap::Clear()
+{
+    std::fill(m_tileBits.begin(), m_tileBits.end(), 0u);
+}
+
+uint32_t DirtyTileMap::GetDirtyTileCount() const
+{
+    uint32_t dirtyTileCount = 0u;
+
+    for (uint64_t tileBits : m_tileBits)
+        dirtyTileCount += (uint32_t)std::popcount(tileBits);
+
+    return dirtyTileCount;
+}
+
+void DirtyTileMap::GetDirtyRegions(std::vector<DirtyRect>& regions) const
+{
+    regions.clear();
+
+    for (uint32_t row = 0u; row < m_rowCount; row++)
+    {
+        const uint32_t y      = row * kDirtyTileSize;
+        const uint32_t height = std::min(kDirtyTileSize, m_height - y);
+
+        uint32_t column = 0u;
+        while (column < m_columnCount)
+        {
+            if (!IsTileDirty(column, row))
+            {
+                column++;
+                continue;
+            }
+
+            const uint32_t firstColumn = column;
+            while (column < m_columnCount && IsTileDirty(column, row))
+                column++;
+
+            const uint32_t x = firstColumn * kDirtyTileSize;
+
+            regions.push_back({ x, y, std::min(column * kDirtyTileSize, m_width) - x, height });
+        }
+    }
+}
+
+uint64_t GetDirtyRegionPixelCount(const DirtyRect* pRegions, uint32_t regionCount)
+{
+    uint64_t pixelCount = 0u;
+
+    for (uint32_t regionIndex = 0u; regionIndex < regionCount; regionIndex++)
+        pixelCount += (uint64_t)pRegions[regionIndex].width * pRegions[regionIndex].height;
+
+    return pixelCount;
+}
+
+void CopyDirtyRegions(const DirtyRect* pRegions, uint32_t regionCount, uint32_t bytesPerPixel, const void* pSrc, uint32_t srcPitch, void* pDst, uint32_t dstPitch)
+{
+    for (uint32_t regionIndex = 0u; regionIndex < regionCount; regionIndex++)
+    {
+        const DirtyRect& region = pRegions[regionIndex];
+
+        const size_t rowOffset = (size_t)region.x * bytesPerPixel;
+        const size_t rowSize   = (size_t)region.width * bytesPerPixel;
+
+        for (uint32_t y = region.y; y < region.y + region.height; y++)
+            memcpy((uint8_t*)pDst + (size_t)y * dstPitch + rowOffset, (const uint8_t*)pSrc + (size_t)y * srcPitch + rowOffset, rowSize);
+    }
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Side length in pixels of the tiles damage is tracked in.
+constexpr uint32_t kDirtyTileSize = 64u;
+
+struct DirtyRect
+{
+    uint32_t x      = 0u;
+    uint32_t y      = 0u;
+    uint32_t width  = 0u;
+    uint32_t height = 0u;
+};
+
+// One bit per kDirtyTileSize x kDirtyTileSize tile of an image, set for the tiles changed since the last readback.
+// Producers add the rectangles they drew to, the readback copies the dirty tiles only.
+class DirtyTileMap
+{
+public:
+    // Every tile starts dirty, as nothing was read back yet.
+    void Resize(uint32_t width, uint32_t height);
+
+    // Marks the tiles overlapping rect, clipped to the image.
+    void AddRect(const DirtyRect& rect);
+
+    void MarkAll();
+
+    void Clear();
+
+    uint32_t GetTileCount() const { return m_columnCount * m_rowCount; }
+
+    uint32_t GetDirtyTileCount() const;
+
+    // Replaces regions with one rectangle per run of adjacent dirty tiles in a tile row, in pixels and clipped
+    // to the image. These are the copy regions of a readback, and what consumers update incrementally.
+    void GetDirtyRegions(std::vector<DirtyRect>& regions) const;
+
+private:
+    bool IsTileDirty(uint32_t column, uint32_t row) const
+    {
+        const uint32_t tileIndex = row * m_columnCount + column;
+
+        return (m_tileBits[tileIndex / 64u] >> (tileIndex % 64u)) & 1u;
+    }
+
+    uint32_t              m_width       = 0u;
+    uint32_t              m_height      = 0u;
+    uint32_t              m_columnCount = 0u;
+    uint32_t              m_rowCount    = 0u;
+
+    // Row-major tile bits.
+    std::vector<uint64_t> m_tileBits;
+};
+
+// Number of pixels covered by regions, which must not overlap.
+uint64_t GetDirtyRegionPixelCount(const DirtyRect* pRegions, uint32_t regionCount);
+
+// Copies the regions of an image of bytesPerPixel pixels from one CPU copy of it to another, e.g. from a readback
+// slot that only holds the changed tiles into the consumer's full frame.
+void CopyDirtyRegions(const DirtyRect* pRegions, uint32_t regionCount, uint32_t bytesPerPixel, const void* pSrc, uint32_t srcPitch, void* pDst, uint32_t dstPitch);
@@ -0,0 +1,384 @@
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "ExternalImage.h"
+
+bool CreateVulkanImage2D(const VulkanDevice& device, const SharedImageDesc& desc, VkExternalMemoryHandleTypeFlags handleTypes, VkImage& vkImage)
+{
+    VkExternalMemoryImageCreateInfo vkExternalMemoryImageCreateInfo = { VK_STRUCTURE_TYPE_EXTERNAL_MEMORY_IMAGE_CREATE_INFO };
+    vkExternalMemoryImageCreateInfo.handleTypes = handleTypes;
+
+    VkImageCreateInfo vkImageCreateInfo = { VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
+    {
+        vkImageCreateInfo.pNext         = handleTypes ? &vkExternalMemoryImageCreateInfo : nullptr;
+        vkImageCreateInfo.format        = desc.format;
+        vkImageCreateInfo.imageType     = VK_IMAGE_TYPE_2D;
+        vkImageCreateInfo.arrayLayers   = desc.arrayLayers;
+        vkImageCreateInfo.mipLevels     = 1u;
+        vkImageCreateInfo.extent        = { desc.width, desc.height, 1 };
+        vkImageCreateInfo.tiling        = VK_IMAGE_TILING_OPTIMAL;
+        vkImageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        vkImageCreateInfo.sharingMode   = VK_SHARING_MODE_EXCLUSIVE;
+        vkImageCreateInfo.samples       = VK_SAMPLE_COUNT_1_BIT;
+        vkImageCreateInfo.usage         = kVulkanSharedImageUsage;
+    }
+
+    return vkCreateImage(device.vkLogicalDevice, &vkImageCreateInfo, nullptr, &vkImage) == VK_SUCCESS;
+}
+
+bool AllocateVulkanImageMemory(const VulkanDevice& device, VkImage vkImage, VkExternalMemoryHandleTypeFlags handleTypes, VkDeviceMemory& vkImageMemory, VkDeviceSize& allocationSize)
+{
+    VkMemoryRequirements vkMemoryRequirements;
+    vkGetImageMemoryRequirements(device.vkLogicalDevice, vkImage, &vkMemoryRequirements);
+
+    uint32_t memoryTypeIndex;
+    if (!FindVulkanMemoryTypeIndex(device.vkPhysicalDevice, vkMemoryRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, memoryTypeIndex))
+        return false;
+
+    VkMemoryDedicatedAllocateInfo vkDedicatedAllocateInfo = { VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO };
+    vkDedicatedAllocateInfo.image = vkImage;
+
+    VkExportMemoryAllocateInfo vkExportAllocateInfo = { VK_STRUCTURE_TYPE_EXPORT_MEMORY_ALLOCATE_INFO };
+    vkExportAllocateInfo.handleTypes = handleTypes;
+    vkExportAllocateInfo.pNext       = &vkDedicatedAllocateInfo;
+
+    VkMemoryAllocateInfo vkAllocateInfo = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
+    vkAllocateInfo.pNext           = handleTypes ? (const void*)&vkExportAllocateInfo : (const void*)&vkDedicatedAllocateInfo;
+    vkAllocateInfo.allocationSize  = vkMemoryRequirements.size;
+    vkAllocateInfo.memoryTypeIndex = memoryTypeIndex;
+
+    if (vkAllocateMemory(device.vkLogicalDevice, &vkAllocateInfo, nullptr, &vkImageMemory) != VK_SUCCESS)
+        return false;
+
+    vkBindImageMemory(device.vkLogicalDevice, vkImage, vkImageMemory, 0u);
+
+    allocationSize = vkMemoryRequirements.size;
+
+    return true;
+}
+
+bool ExportVulkanMemoryHandle(const VulkanDevice& device, VkDeviceMemory vkMemory, ExternalMemoryHandle& memoryHandle)
+{
+#if defined(_WIN32)
+    VkMemoryGetWin32HandleInfoKHR vkGetHandleInfo = { VK_STRUCTURE_TYPE_MEMORY_GET_WIN32_HANDLE_INFO_KHR };
+    vkGetHandleInfo.memory     = vkMemory;
+    vkGetHandleInfo.handleType = kVulkanExternalMemoryHandleType;
+
+    return vkGetMemoryWin32HandleKHR(device.vkLogicalDevice, &vkGetHandleInfo, &memoryHandle) == VK_SUCCESS;
+#else
+    VkMemoryGetFdInfoKHR vkGetFdInfo = { VK_STRUCTURE_TYPE_MEMORY_GET_FD_INFO_KHR };
+    vkGetFdInfo.memory     = vkMemory;
+    vkGetFdInfo.handleType = kVulkanExternalMemoryHandleType;
+
+    return vkGetMemoryFdKHR(device.vkLogicalDevice, &vkGetFdInfo, &memoryHandle) == VK_SUCCESS;
+#endif
+}
+
+// Imports an exported allocation, dedicated to vkDedicatedImage unless it is null. Consumes memoryHandle.
+static bool ImportVulkanMemoryHandle(const VulkanDevice& device, ExternalMemoryHandle memoryHandle, VkDeviceSize allocationSize, uint32_t memoryTypeIndex, VkImage vkDedicatedImage, VkDeviceMemory& vkMemory)
+{
+    VkMemoryDedicatedAllocateInfo vkDedicatedAllocateInfo = { VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO };
+    vkDedicatedAllocateInfo.image = vkDedicatedImage;
+
+#if defined(_WIN32)
+    VkImportMemoryWin32HandleInfoKHR vkImportedHandleInfo = { VK_STRUCTURE_TYPE_IMPORT_MEMORY_WIN32_HANDLE_INFO_KHR };
+    vkImportedHandleInfo.handleType = kVulkanExternalMemoryHandleType;
+    vkImportedHandleInfo.handle     = memoryHandle;
+    vkImportedHandleInfo.pNext      = vkDedicatedImage != VK_NULL_HANDLE ? &vkDedicatedAllocateInfo : nullptr;
+#else
+    VkImportMemoryFdInfoKHR vkImportedHandleInfo = { VK_STRUCTURE_TYPE_IMPORT_MEMORY_FD_INFO_KHR };
+    vkImportedHandleInfo.handleType = kVulkanExternalMemoryHandleType;
+    vkImportedHandleInfo.fd         = memoryHandle;
+    vkImportedHandleInfo.pNext      = vkDedicatedImage != VK_NULL_HANDLE ? &vkDedicatedAllocateInfo : nullptr;
+#endif
+
+    VkMemoryAllocateInfo vkImportAllocateInfo = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
+    vkImportAllocateInfo.pNext           = &vkImportedHandleInfo;
+    vkImportAllocateInfo.allocationSize  = allocationSize;
+    vkImportAllocateInfo.memoryTypeIndex = memoryTypeIndex;
+
+    if (vkAllocateMemory(device.vkLogicalDevice, &vkImportAllocateInfo, nullptr, &vkMemory) != VK_SUCCESS)
+    {
+        CloseExternalMemoryHandle(memoryHandle);
+        return false;
+    }
+
+#if defined(_WIN32)
+    // Win32 imports do not transfer ownership of the handle.
+    CloseExternalMemoryHandle(memoryHandle);
+#endif
+
+    return true;
+}
+
+bool ImportVulkanImageMemory(const VulkanDevice& device, VkImage vkImage, ExternalMemoryHandle memoryHandle, VkDeviceSize allocationSize, VkDeviceMemory& vkImageMemory)
+{
+    VkMemoryRequirements vkMemoryRequirements;
+    vkGetImageMemoryRequirements(device.vkLogicalDevice, vkImage, &vkMemoryRequirements);
+
+    uint32_t memoryTypeIndex;
+    if (!FindVulkanMemoryTypeIndex(device.vkPhysicalDevice, vkMemoryRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, memoryTypeIndex))
+    {
+        CloseExternalMemoryHandle(memoryHandle);
+        return false;
+    }
+
+    // The exporter made a dedicated allocation, so the import must be dedicated as well.
+    if (!ImportVulkanMemoryHandle(device, memoryHandle, allocationSize, memoryTypeIndex, vkImage, vkImageMemory))
+        return false;
+
+    vkBindImageMemory(device.vkLogicalDevice, vkImage, vkImageMemory, 0u);
+
+    return true;
+}
+
+bool GetVulkanImageMemoryRequirements(const VulkanDevice& device, VkImage vkImage, VkMemoryRequirements& vkMemoryRequirements, bool& prefersDedicated)
+{
+    VkImageMemoryRequirementsInfo2 vkRequirementsInfo = { VK_STRUCTURE_TYPE_IMAGE_MEMORY_REQUIREMENTS_INFO_2 };
+    vkRequirementsInfo.image = vkImage;
+
+    VkMemoryDedicatedRequirements vkDedicatedRequirements = { VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS };
+
+    VkMemoryRequirements2 vkMemoryRequirements2 = { VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2 };
+    vkMemoryRequirements2.pNext = &vkDedicatedRequirements;
+
+    vkGetImageMemoryRequirements2(device.vkLogicalDevice, &vkRequirementsInfo, &vkMemoryRequirements2);
+
+    vkMemoryRequirements = vkMemoryRequirements2.memoryRequirements;
+    prefersDedicated     = vkDedicatedRequirements.prefersDedicatedAllocation || vkDedicatedRequirements.requiresDedicatedAllocation;
+
+    return true;
+}
+
+bool IsVulkanExternalImageDedicatedOnly(const VulkanDevice& device, const SharedImageDesc& desc, VkExternalMemoryHandleTypeFlagBits handleType)
+{
+    VkPhysicalDeviceExternalImageFormatInfo vkExternalFormatInfo = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTERNAL_IMAGE_FORMAT_INFO };
+    vkExternalFormatInfo.handleType = handleType;
+
+    // Same parameters as CreateVulkanImage2D.
+    VkPhysicalDeviceImageFormatInfo2 vkFormatInfo = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_IMAGE_FORMAT_INFO_2 };
+    vkFormatInfo.pNext  = &vkExternalFormatInfo;
+    vkFormatInfo.format = desc.format;
+    vkFormatInfo.type   = VK_IMAGE_TYPE_2D;
+    vkFormatInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    vkFormatInfo.usage  = kVulkanSharedImageUsage;
+
+    VkExternalImageFormatProperties vkExternalFormatProperties = { VK_STRUCTURE_TYPE_EXTERNAL_IMAGE_FORMAT_PROPERTIES };
+
+    VkImageFormatProperties2 vkFormatProperties = { VK_STRUCTURE_TYPE_IMAGE_FORMAT_PROPERTIES_2 };
+    vkFormatProperties.pNext = &vkExternalFormatProperties;
+
+    if (vkGetPhysicalDeviceImageFormatProperties2(device.vkPhysicalDevice, &vkFormatInfo, &vkFormatProperties) != VK_SUCCESS)
+        return true;
+
+    return (vkExternalFormatProperties.externalMemoryProperties.externalMemoryFeatures & VK_EXTERNAL_MEMORY_FEATURE_DEDICATED_ONLY_BIT) != 0u;
+}
+
+bool AllocateVulkanExportableMemory(const VulkanDevice& device, VkDeviceSize size, uint32_t memoryTypeIndex, VkExternalMemoryHandleTypeFlags handleTypes, VkDeviceMemory& vkMemory)
+{
+    VkExportMemoryAllocateInfo vkExportAllocateInfo = { VK_STRUCTURE_TYPE_EXPORT_MEMORY_ALLOCATE_INFO };
+    vkExportAllocateInfo.handleTypes = handleTypes;
+
+    VkMemoryAllocateInfo vkAllocateInfo = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
+    vkAllocateInfo.pNext           = &vkExportAllocateInfo;
+    vkAllocateInfo.allocationSize  = size;
+    vkAllocateInfo.memoryTypeIndex = memoryTypeIndex;
+
+    return vkAllocateMemory(device.vkLogicalDevice, &vkAllocateInfo, nullptr, &vkMemory) == VK_SUCCESS;
+}
+
+bool ImportVulkanMemory(const VulkanDevice& device, ExternalMemoryHandle memoryHandle, VkDeviceSize allocationSize, uint32_t memoryTypeIndex, VkDeviceMemory& vkMemory)
+{
+    return ImportVulkanMemoryHandle(device, memoryHandle, allocationSize, memoryTypeIndex, VK_NULL_HANDLE, vkMemory);
+}
+
+void CloseExternalMemoryHandle(ExternalMemoryHandle memoryHandle)
+{
+    if (memoryHandle == kInvalidExternalMemoryHandle)
+        return;
+
+#if defined(_WIN32)
+    CloseHandle(memoryHandle);
+#else
+    close(memoryHandle);
+#endif
+}
+
+bool ImportVulkanHostMemoryBuffer(const VulkanDevice& device, void* pHostMemory, VkDeviceSize size, VulkanStagingBuffer& buffer)
+{
+    constexpr VkExternalMemoryHandleTypeFlagBits kHandleType = VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT;
+
+    // Memory types the pointer can be imported as, which depends on how the application allocated it.
+    VkMemoryHostPointerPropertiesEXT vkHostPointerProperties = { VK_STRUCTURE_TYPE_MEMORY_HOST_POINTER_PROPERTIES_EXT };
+    if (vkGetMemoryHostPointerPropertiesEXT(device.vkLogicalDevice, kHandleType, pHostMemory, &vkHostPointerProperties) != VK_SUCCESS)
+        return false;
+
+    VkExternalMemoryBufferCreateInfo vkExternalMemoryBufferCreateInfo = { VK_STRUCTURE_TYPE_EXTERNAL_MEMORY_BUFFER_CREATE_INFO };
+    vkExternalMemoryBufferCreateInfo.handleTypes = kHandleType;
+
+    VkBufferCreateInfo vkBufferCreateInfo = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+    vkBufferCreateInfo.pNext       = &vkExternalMemoryBufferCreateInfo;
+    vkBufferCreateInfo.size        = size;
+    vkBufferCreateInfo.usage       = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    vkBufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    if (vkCreateBuffer(device.vkLogicalDevice, &vkBufferCreateInfo, nullptr, &buffer.vkBuffer) != VK_SUCCESS)
+        return false;
+
+    VkMemoryRequirements vkMemoryRequirements;
+    vkGetBufferMemoryRequirements(device.vkLogicalDevice, buffer.vkBuffer, &vkMemoryRequirements);
+
+    // The CPU reads the frames once the readback fence signaled, without invalidating.
+    uint32_t memoryTypeIndex;
+    if (vkMemoryRequirements.size > size ||
+        !FindVulkanMemoryTypeIndex(device.vkPhysicalDevice, vkMemoryRequirements.memoryTypeBits & vkHostPointerProperties.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, memoryTypeIndex))
+    {
+        DestroyVulkanStagingBuffer(device, buffer);
+        return false;
+    }
+
+    VkImportMemoryHostPointerInfoEXT vkImportMemoryHostPointerInfo = { VK_STRUCTURE_TYPE_IMPORT_MEMORY_HOST_POINTER_INFO_EXT };
+    vkImportMemoryHostPointerInfo.handleType   = kHandleType;
+    vkImportMemoryHostPointerInfo.pHostPointer = pHostMemory;
+
+    VkMemoryAllocateInfo vkAllocateInfo = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
+    vkAllocateInfo.pNext           = &vkImportMemoryHostPointerInfo;
+    vkAllocateInfo.allocationSize  = size;
+    vkAllocateInfo.memoryTypeIndex = memoryTypeIndex;
+
+    if (vkAllocateMemory(device.vkLogicalDevice, &vkAllocateInfo, nullptr, &buffer.vkBufferMemory) != VK_SUCCESS ||
+        vkBindBufferMemory(device.vkLogicalDevice, buffer.vkBuffer, buffer.vkBufferMemory, 0u) != VK_SUCCESS)
+    {
+        DestroyVulkanStagingBuffer(device, buffer);
+        return false;
+    }
+
+    buffer.size        = size;
+    buffer.pMappedData = pHostMemory;
+
+    return true;
+}
+
+bool CreateVulkanTimelineSemaphore(const VulkanDevice& device, VkExternalSemaphoreHandleTypeFlags handleTypes, VkSemaphore& vkSemaphore)
+{
+    VkExportSemaphoreCreateInfo vkExportSemaphoreCreateInfo = { VK_STRUCTURE_TYPE_EXPORT_SEMAPHORE_CREATE_INFO };
+    vkExportSemaphoreCreateInfo.handleTypes = handleTypes;
+
+    VkSemaphoreTypeCreateInfo vkSemaphoreTypeCreateInfo = { VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO };
+    vkSemaphoreTypeCreateInfo.pNext         = handleTypes ? &vkExportSemaphoreCreateInfo : nullptr;
+    vkSemaphoreTypeCreateInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    vkSemaphoreTypeCreateInfo.initialValue  = 0u;
+
+    VkSemaphoreCreateInfo vkSemaphoreCreateInfo = { VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO };
+    vkSemaphoreCreateInfo.pNext = &vkSemaphoreTypeCreateInfo;
+
+    return vkCreateSemaphore(device.vkLogicalDevice, &vkSemaphoreCreateInfo, nullptr, &vkSemaphore) == VK_SUCCESS;
+}
+
+bool ExportVulkanSemaphoreHandle(const VulkanDevice& device, VkSemaphore vkSemaphore, ExternalSemaphoreHandle& semaphoreHandle)
+{
+#if defined(_WIN32)
+    VkSemaphoreGetWin32HandleInfoKHR vkGetHandleInfo = { VK_STRUCTURE_TYPE_SEMAPHORE_GET_WIN32_HANDLE_INFO_KHR };
+    vkGetHandleInfo.semaphore  = vkSemaphore;
+    vkGetHandleInfo.handleType = kVulkanExternalSemaphoreHandleType;
+
+    return vkGetSemaphoreWin32HandleKHR(device.vkLogicalDevice, &vkGetHandleInfo, &semaphoreHandle) == VK_SUCCESS;
+#else
+    VkSemaphoreGetFdInfoKHR vkGetFdInfo = { VK_STRUCTURE_TYPE_SEMAPHORE_GET_FD_INFO_KHR };
+    vkGetFdInfo.semaphore  = vkSemaphore;
+    vkGetFdInfo.handleType = kVulkanExternalSemaphoreHandleType;
+
+    return vkGetSemaphoreFdKHR(device.vkLogicalDevice, &vkGetFdInfo, &semaphoreHandle) == VK_SUCCESS;
+#endif
+}
+
+bool ImportVulkanSemaphoreHandle(const VulkanDevice& device, VkSemaphore vkSemaphore, VkExternalSemaphoreHandleTypeFlagBits handleType, ExternalSemaphoreHandle semaphoreHandle)
+{
+#if defined(_WIN32)
+    VkImportSemaphoreWin32HandleInfoKHR vkImportInfo = { VK_STRUCTURE_TYPE_IMPORT_SEMAPHORE_WIN32_HANDLE_INFO_KHR };
+    vkImportInfo.semaphore  = vkSemaphore;
+    vkImportInfo.handleType = handleType;
+    vkImportInfo.handle     = semaphoreHandle;
+
+    return vkImportSemaphoreWin32HandleKHR(device.vkLogicalDevice, &vkImportInfo) == VK_SUCCESS;
+#else
+    VkImportSemaphoreFdInfoKHR vkImportInfo = { VK_STRUCTURE_TYPE_IMPORT_SEMAPHORE_FD_INFO_KHR };
+    vkImportInfo.semaphore  = vkSemaphore;
+    vkImportInfo.handleType = handleType;
+    vkImportInfo.fd         = semaphoreHandle;
+
+    if (vkImportSemaphoreFdKHR(device.vkLogicalDevice, &vkImportInfo) == VK_SUCCESS)
+        return true;
+
+    CloseExternalMemoryHandle(semaphoreHandle);
+    return false;
+#endif
+}
+
+void RecordVulkanImageBarrier(VkCommandBuffer vkCommandBuffer, VkImage vkImage, VkImageLayout oldLayout, VkImageLayout newLayout, VkAccessFlags srcAccessMask, VkAccessFlags dstAccessMask, uint32_t srcQueueFamilyIndex, uint32_t dstQueueFamilyIndex)
+{
+    VkImageMemoryBarrier barrier{ VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
+    barrier.oldLayout           = oldLayout;
+    barrier.newLayout           = newLayout;
+    barrier.srcQueueFamilyIndex = srcQueueFamilyIndex;
+    barrier.dstQueueFamilyIndex = dstQueueFamilyIndex;
+    barrier.image               = vkImage;
+
+    barrier.subresourceRange.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel   = 0;
+    barrier.subresourceRange.levelCount     = 1;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount     = VK_REMAINING_ARRAY_LAYERS;
+
+    barrier.srcAccessMask = srcAccessMask;
+    barrier.dstAccessMask = dstAccessMask;
+
+    vkCmdPipelineBarrier(vkCommandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
+void RecordVulkanImageToBufferCopy(VkCommandBuffer vkCommandBuffer, VkImage vkImage, VkImageLayout vkImageLayout, VkBuffer vkBuffer, const SharedImageDesc& desc)
+{
+    VkBufferImageCopy vkCopyRegion = {};
+    vkCopyRegion.bufferOffset                    = 0u;
+    vkCopyRegion.bufferRowLength                 = 0u;
+    vkCopyRegion.bufferImageHeight               = 0u;
+    vkCopyRegion.imageSubresource.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+    vkCopyRegion.imageSubresource.mipLevel       = 0u;
+    vkCopyRegion.imageSubresource.baseArrayLayer = 0u;
+    vkCopyRegion.imageSubresource.layerCount     = desc.arrayLayers;
+    vkCopyRegion.imageExtent                     = { desc.width, desc.height, 1u };
+
+    vkCmdCopyImageToBuffer(vkCommandBuffer, vkImage, vkImageLayout, vkBuffer, 1u, &vkCopyRegion);
+}
+
+void RecordVulkanImageRegionsToBufferCopy(VkCommandBuffer vkCommandBuffer, VkImage vkImage, VkImageLayout vkImageLayout, VkBuffer vkBuffer, const SharedImageDesc& desc, const std::vector<DirtyRect>& regions, VkDeviceSize bufferOffset, uint32_t firstLayer, uint32_t layerCount)
+{
+    if (regions.empty())
+        return;
+
+    const uint32_t rowPitch      = GetSharedImageRowPitch(desc);
+    const uint32_t bytesPerPixel = GetSharedImageBytesPerPixel(desc);
+
+    std::vector<VkBufferImageCopy> vkCopyRegions(regions.size());
+
+    for (size_t regionIndex = 0u; regionIndex < regions.size(); regionIndex++)
+    {
+        const DirtyRect& region = regions[regionIndex];
+
+        VkBufferImageCopy& vkCopyRegion = vkCopyRegions[regionIndex];
+        vkCopyRegion = {};
+        vkCopyRegion.bufferOffset                    = bufferOffset + (VkDeviceSize)region.y * rowPitch + (VkDeviceSize)region.x * bytesPerPixel;
+        vkCopyRegion.bufferRowLength                 = desc.width;
+        vkCopyRegion.bufferImageHeight               = desc.height;
+        vkCopyRegion.imageSubresource.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+        vkCopyRegion.imageSubresource.baseArrayLayer = firstLayer;
+        vkCopyRegion.imageSubresource.layerCount     = layerCount;
+        vkCopyRegion.imageOffset                     = { (int32_t)region.x, (int32_t)region.y, 0 };
+        vkCopyRegion.imageExtent                     = { region.width, region.height, 1u };
+    }
+
+    vkCmdCopyImageToBuffer(vkCommandBuffer, vkImage, vkImageLayout, vkBuffer, (uint32_t)vkCopyRegions.size(), vkCopyRegions.data());
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "InteropBackend.h"
+
+// Handle type used to share memory between Vulkan devices (and processes) on this platform.
+#if defined(_WIN32)
+constexpr VkExternalMemoryHandleTypeFlagBits kVulkanExternalMemoryHandleType = VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_WIN32_BIT;
+#else
+constexpr VkExternalMemoryHandleTypeFlagBits kVulkanExternalMemoryHandleType = VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_FD_BIT;
+#endif
+
+// Device extension required on both sides to export or import kVulkanExternalMemoryHandleType.
+#if defined(_WIN32)
+constexpr const char* kVulkanExternalMemoryExtensionName = VK_KHR_EXTERNAL_MEMORY_WIN32_EXTENSION_NAME;
+#else
+constexpr const char* kVulkanExternalMemoryExtensionName = VK_KHR_EXTERNAL_MEMORY_FD_EXTENSION_NAME;
+#endif
+
+// Handle type and extension used to share timeline semaphores between Vulkan devices (and processes).
+#if defined(_WIN32)
+constexpr VkExternalSemaphoreHandleTypeFlagBits kVulkanExternalSemaphoreHandleType    = VK_EXTERNAL_SEMAPHORE_HANDLE_TYPE_OPAQUE_WIN32_BIT;
+constexpr const char*                           kVulkanExternalSemaphoreExtensionName = VK_KHR_EXTERNAL_SEMAPHORE_WIN32_EXTENSION_NAME;
+#else
+constexpr VkExternalSemaphoreHandleTypeFlagBits kVulkanExternalSemaphoreHandleType    = VK_EXTERNAL_SEMAPHORE_HANDLE_TYPE_OPAQUE_FD_BIT;
+constexpr const char*                           kVulkanExternalSemaphoreExtensionName = VK_KHR_EXTERNAL_SEMAPHORE_FD_EXTENSION_NAME;
+#endif
+
+// Usage of shared images on both sides: rendered to and cleared by the importer, copied from or sampled by the
+// readback compute stage on the exporter.
+constexpr VkImageUsageFlags kVulkanSharedImageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+
+// Creates a 2D (array) image with kVulkanSharedImageUsage, optionally backed by external memory.
+bool CreateVulkanImage2D(const VulkanDevice& device, const SharedImageDesc& desc, VkExternalMemoryHandleTypeFlags handleTypes, VkImage& vkImage);
+
+// Allocates dedicated device-local memory for an image and binds it. The allocation is exportable when handleTypes is non-zero.
+bool AllocateVulkanImageMemory(const VulkanDevice& device, VkImage vkImage, VkExternalMemoryHandleTypeFlags handleTypes, VkDeviceMemory& vkImageMemory, VkDeviceSize& allocationSize);
+
+// Returns a new handle referencing exportable memory. The caller owns the handle.
+bool ExportVulkanMemoryHandle(const VulkanDevice& device, VkDeviceMemory vkMemory, ExternalMemoryHandle& memoryHandle);
+
+// Imports an exported allocation as dedicated memory of vkImage and binds it. Ownership of the handle is
+// always consumed: it passes to the driver on success and is closed on failure.
+bool ImportVulkanImageMemory(const VulkanDevice& device, VkImage vkImage, ExternalMemoryHandle memoryHandle, VkDeviceSize allocationSize, VkDeviceMemory& vkImageMemory);
+
+// Memory requirements of an image, and whether the driver prefers (or requires) a dedicated allocation for it.
+bool GetVulkanImageMemoryRequirements(const VulkanDevice& device, VkImage vkImage, VkMemoryRequirements& vkMemoryRequirements, bool& prefersDedicated);
+
+// Whether images created by CreateVulkanImage2D for desc can only be exported or imported with dedicated memory,
+// which rules out suballocating them. Unsupported combinations report true.
+bool IsVulkanExternalImageDedicatedOnly(const VulkanDevice& device, const SharedImageDesc& desc, VkExternalMemoryHandleTypeFlagBits handleType);
+
+// Allocates exportable memory that resources are bound to at an offset, for suballocation.
+bool AllocateVulkanExportableMemory(const VulkanDevice& device, VkDeviceSize size, uint32_t memoryTypeIndex, VkExternalMemoryHandleTypeFlags handleTypes, VkDeviceMemory& vkMemory);
+
+// Imports memory allocated by AllocateVulkanExportableMemory. The memory type must be compatible with the
+// exporter's, which holds for devices of the same physical device. Ownership of the handle is always consumed.
+bool ImportVulkanMemory(const VulkanDevice& device, ExternalMemoryHandle memoryHandle, VkDeviceSize allocationSize, uint32_t memoryTypeIndex, VkDeviceMemory& vkMemory);
+
+void CloseExternalMemoryHandle(ExternalMemoryHandle memoryHandle);
+
+// Wraps size bytes of host memory at pHostMemory, both aligned to minImportedHostPointerAlignment, in a transfer
+// destination buffer (VK_EXT_external_memory_host). The buffer's pMappedData is pHostMemory, which must outlive it.
+bool ImportVulkanHostMemoryBuffer(const VulkanDevice& device, void* pHostMemory, VkDeviceSize size, VulkanStagingBuffer& buffer);
+
+// Creates a timeline semaphore starting at value 0, exportable when handleTypes is non-zero.
+bool CreateVulkanTimelineSemaphore(const VulkanDevice& device, VkExternalSemaphoreHandleTypeFlags handleTypes, VkSemaphore& vkSemaphore);
+
+// Returns a new handle referencing an exportable semaphore. The caller owns the handle.
+bool ExportVulkanSemaphoreHandle(const VulkanDevice& device, VkSemaphore vkSemaphore, ExternalSemaphoreHandle& semaphoreHandle);
+
+// Makes vkSemaphore share the payload of an exported semaphore. Ownership of POSIX handles is always consumed,
+// Win32 handles stay owned by the caller.
+bool ImportVulkanSemaphoreHandle(const VulkanDevice& device, VkSemaphore vkSemaphore, VkExternalSemaphoreHandleTypeFlagBits handleType, ExternalSemaphoreHandle semaphoreHandle);
+
+// A single barrier over every array layer of the image.
+void RecordVulkanImageBarrier(VkCommandBuffer vkCommandBuffer, VkImage vkImage, VkImageLayout oldLayout, VkImageLayout newLayout, VkAccessFlags srcAccessMask, VkAccessFlags dstAccessMask, uint32_t srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED, uint32_t dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED);
+
+// Copies every layer of the image, tightly packed one after the other.
+void RecordVulkanImageToBufferCopy(VkCommandBuffer vkCommandBuffer, VkImage vkImage, VkImageLayout vkImageLayout, VkBuffer vkBuffer, const SharedImageDesc& desc);
+
+// Copies regions of layerCount layers from firstLayer on to the same place they would have in a full, tightly packed
+// copy of those layers starting at bufferOffset.
+void RecordVulkanImageRegionsToBufferCopy(VkCommandBuffer vkCommandBuffer, VkImage vkImage, VkImageLayout vkImageLayout, VkBuffer vkBuffer, const SharedImageDesc& desc, const std::vector<DirtyRect>& regions, VkDeviceSize bufferOffset = 0u, uint32_t firstLayer = 0u, uint32_t layerCount = 1u);
@@ -0,0 +1,619 @@
+#include "FrameCodec.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <random>
+
+#include <spdlog/spdlog.h>
+
+#include "Simd.h"
+#include "ThreadPool.h"
+#include "Trace.h"
+
+// A few stripes per thread balance the load, stripes below the minimum size leave too little to find matches in.
+constexpr uint32_t kFrameCodecStripesPerThread = 4u;
+constexpr uint32_t kFrameCodecMinStripeSize    = 64u * 1024u;
+
+// Matches are at least kFrameCodecMinMatch bytes and at most kFrameCodecMaxOffset bytes back, found through a hash
+// table of the last position of each 4-byte sequence.
+constexpr uint32_t kFrameCodecMinMatch   = 4u;
+constexpr uint32_t kFrameCodecMaxOffset  = 0xFFFFu;
+constexpr uint32_t kFrameCodecHashBits   = 14u;
+
+// Sequence tokens hold the literal count in the high nibble and the match length minus kFrameCodecMinMatch in the
+// low nibble, a nibble of 15 continues with bytes of 255 and a final byte below it.
+constexpr uint32_t kFrameCodecNibbleMax = 15u;
+
+// Each length extension byte adds 255 bytes of output, so compressed stripes grow at most this much when decoded.
+constexpr uint64_t kFrameCodecMaxExpansion = 255u;
+
+// Misses before the match search moves forward two bytes at a time, then three..., through incompressible data.
+constexpr uint32_t kFrameCodecSkipShift = 6u;
+
+static uint32_t Load32(const uint8_t* pBytes)
+{
+    uint32_t value;
+    memcpy(&value, pBytes, sizeof(value));
+    return value;
+}
+
+static uint64_t Load64(const uint8_t* pBytes)
+{
+    uint64_t value;
+    memcpy(&value, pBytes, sizeof(value));
+    return value;
+}
+
+// pDestination = pA ^ pB, any of them may alias.
+static void XorBytes(const uint8_t* pA, const uint8_t* pB, uint8_t* pDestination, size_t size)
+{
+    size_t offset = 0u;
+
+    for (; offset + 16u <= size; offset += 16u)
+        XorBytes16(pA + offset, pB + offset, pDestination + offset);
+
+    for (; offset < size; offset++)
+        pDestination[offset] = pA[offset] ^ pB[offset];
+}
+
+// Block Coder
+// ------------------------------------------------
+
+static uint8_t* WriteLengthExtension(uint8_t* pOutput, uint32_t length)
+{
+    for (length -= kFrameCodecNibbleMax; length >= 255u; length -= 255u)
+        *pOutput++ = 255u;
+
+    *pOutput++ = (uint8_t)length;
+    return pOutput;
+}
+
+// Bytes a sequence takes at most besides its literals.
+static size_t GetSequenceOverhead(uint32_t literalCount, uint32_t matchLength)
+{
+    return 1u + (literalCount / 255u + 1u) + 2u + (matchLength / 255u + 1u);
+}
+
+// Compresses source into at most capacity bytes. Returns the compressed size, or 0 when it does not fit.
+static size_t CompressBlock(const uint8_t* pSource, size_t size, uint32_t* pHashTable, uint8_t* pDestination, size_t capacity)
+{
+    std::fill(pHashTable, pHashTable + (1u << kFrameCodecHashBits), 0u);
+
+    uint8_t*       pOutput    = pDestination;
+    uint8_t* const pOutputEnd = pDestination + capacity;
+
+    size_t   anchor   = 0u;
+    size_t   position = 0u;
+    uint32_t misses   = 0u;
+
+    auto writeSequence = [&](size_t literalEnd, uint32_t offset, uint32_t matchLength)
+    {
+        const uint32_t literalCount = (uint32_t)(literalEnd - anchor);
+
+        if ((size_t)(pOutputEnd - pOutput) < literalCount + GetSequenceOverhead(literalCount, matchLength))
+            return false;
+
+        const uint32_t matchNibble = matchLength > 0u ? std::min(matchLength - kFrameCodecMinMatch, kFrameCodecNibbleMax) : 0u;
+
+        *pOutput++ = (uint8_t)((std::min(literalCount, kFrameCodecNibbleMax) << 4) | matchNibble);
+
+        if (literalCount >= kFrameCodecNibbleMax)
+            pOutput = WriteLengthExtension(pOutput, literalCount);
+
+        memcpy(pOutput, pSource + anchor, literalCount);
+        pOutput += literalCount;
+
+        // The last sequence ends the block with its literals.
+        if (matchLength == 0u)
+            return true;
+
+        *pOutput++ = (uint8_t)(offset & 0xFFu);
+        *pOutput++ = (uint8_t)(offset >> 8);
+
+        if (matchLength - kFrameCodecMinMatch >= kFrameCodecNibbleMax)
+            pOutput = WriteLengthExtension(pOutput, matchLength - kFrameCodecMinMatch);
+
+        return true;
+    };
+
+    while (position + kFrameCodecMinMatch <= size)
+    {
+        const uint32_t sequence  = Load32(pSource + position);
+        const uint32_t hash      = (sequence * 2654435761u) >> (32u - kFrameCodecHashBits);
+        size_t         candidate = pHashTable[hash];
+
+        pHashTable[hash] = (uint32_t)position;
+
+        if (candidate >= position || position - candidate > kFrameCodecMaxOffset || Load32(pSource + candidate) != sequence)
+        {
+            position += 1u + (misses++ >> kFrameCodecSkipShift);
+            continue;
+        }
+
+        // Extend the match forward 8 bytes at a time, then backward into the pending literals.
+        size_t matchLength = kFrameCodecMinMatch;
+
+        while (position + matchLength + 8u <= size)
+        {
+            const uint64_t difference = Load64(pSource + position + matchLength) ^ Load64(pSource + candidate + matchLength);
+
+            if (difference != 0u)
+            {
+                matchLength += (size_t)std::countr_zero(difference) / 8u;
+                break;
+            }
+
+            matchLength += 8u;
+        }
+
+        if (position + matchLength + 8u > size)
+        {
+            while (position + matchLength < size && pSource[position + matchLength] == pSource[candidate + matchLength])
+                matchLength++;
+        }
+
+        while (position > anchor && candidate > 0u && pSource[position - 1u] == pSource[candidate - 1u])
+        {
+            position--;
+            candidate--;
+            matchLength++;
+        }
+
+        if (!writeSequence(position, (uint32_t)(position - candidate), (uint32_t)matchLength))
+            return 0u;
+
+        position += matchLength;
+        anchor    = position;
+        misses    = 0u;
+    }
+
+    if (anchor < size && !writeSequence(size, 0u, 0u))
+        return 0u;
+
+    return (size_t)(pOutput - pDestination);
+}
+
+static bool ReadLengthExtension(const uint8_t*& pInput, const uint8_t* pInputEnd, size_t& length)
+{
+    uint8_t value;
+
+    do
+    {
+        if (pInput == pInputEnd)
+            return false;
+
+        value   = *pInput++;
+        length += value;
+    } while (value == 255u);
+
+    return true;
+}
+
+// Decompresses a block of exactly size bytes. Every read and write is bounds checked.
+static bool DecompressBlock(const uint8_t* pSource, size_t sourceSize, uint8_t* pDestination, size_t size)
+{
+    const uint8_t*       pInput     = pSource;
+    const uint8_t* const pInputEnd  = pSource + sourceSize;
+    uint8_t*             pOutput    = pDestination;
+    uint8_t* const       pOutputEnd = pDestination + size;
+
+    while (pOutput < pOutputEnd)
+    {
+        if (pInput == pInputEnd)
+            return false;
+
+        const uint8_t token = *pInput++;
+
+        size_t literalCount = token >> 4;
+        if (literalCount == kFrameCodecNibbleMax && !ReadLengthExtension(pInput, pInputEnd, literalCount))
+            return false;
+
+        if (literalCount > (size_t)(pInputEnd - pInput) || literalCount > (size_t)(pOutputEnd - pOutput))
+            return false;
+
+        memcpy(pOutput, pInput, literalCount);
+        pInput  += literalCount;
+        pOutput += literalCount;
+
+        if (pOutput == pOutputEnd)
+            break;
+
+        if (pInputEnd - pInput < 2)
+            return false;
+
+        const size_t offset = (size_t)pInput[0] | ((size_t)pInput[1] << 8);
+        pInput += 2;
+
+        size_t matchLength = token & 0xFu;
+        if (matchLength == kFrameCodecNibbleMax && !ReadLengthExtension(pInput, pInputEnd, matchLength))
+            return false;
+
+        matchLength += kFrameCodecMinMatch;
+
+        if (offset == 0u || offset > (size_t)(pOutput - pDestination) || matchLength > (size_t)(pOutputEnd - pOutput))
+            return false;
+
+        // Matches closer than their length repeat the bytes since their start: copy in chunks that double, so that
+        // runs of a repeated pixel take a few copies rather than one per byte.
+        const uint8_t* pMatch = pOutput - offset;
+
+        while (matchLength > 0u)
+        {
+            const size_t chunk = std::min(matchLength, (size_t)(pOutput - pMatch));
+
+            memcpy(pOutput, pMatch, chunk);
+            pOutput     += chunk;
+            matchLength -= chunk;
+        }
+    }
+
+    return pInput == pInputEnd;
+}
+
+// Encoder
+// ------------------------------------------------
+
+bool FrameEncoder::EncodeFrame(ThreadPool& threadPool, const void* pFrame, uint32_t rowPitch, uint32_t rowSize, uint32_t rowCount, bool keyFrame, std::vector<uint8_t>& encodedFrame)
+{
+    TRACE_ZONE("Encode frame delta");
+
+    if (rowSize == 0u || rowCount == 0u || (uint64_t)rowSize * rowCount > kFrameCodecMaxFrameSize)
+        return false;
+
+    const size_t frameSize = (size_t)rowSize * rowCount;
+
+    if (m_rowSize != rowSize || m_rowCount != rowCount || m_previousFrame.size() != frameSize)
+    {
+        m_previousFrame.resize(frameSize);
+        m_rowSize  = rowSize;
+        m_rowCount = rowCount;
+
+        keyFrame = true;
+    }
+
+    // Whole rows per stripe, a few stripes per thread but none below the minimum size, and none that the 31 bits of
+    // a stripe size cannot describe.
+    const uint32_t targetStripes  = threadPool.GetThreadCount() * kFrameCodecStripesPerThread;
+    const uint32_t minStripeRows  = (kFrameCodecMinStripeSize + rowSize - 1u) / rowSize;
+    const uint32_t maxStripeRows  = std::max(1u, (kEncodedStripeStored - 1u) / rowSize);
+    const uint32_t rowsPerStripe  = std::clamp(std::max((rowCount + targetStripes - 1u) / targetStripes, minStripeRows), 1u, maxStripeRows);
+    const uint32_t stripeCount    = (rowCount + rowsPerStripe - 1u) / rowsPerStripe;
+
+    if (m_stripes.size() < stripeCount)
+        m_stripes.resize(stripeCount);
+
+    const uint8_t* pSource = (const uint8_t*)pFrame;
+
+    threadPool.ParallelFor(stripeCount, [&](uint32_t stripeIndex)
+    {
+        TRACE_ZONE("Encode frame stripe");
+
+        Stripe& stripe = m_stripes[stripeIndex];
+
+        const uint32_t firstRow    = stripeIndex * rowsPerStripe;
+        const uint32_t stripeRows  = std::min(rowsPerStripe, rowCount - firstRow);
+        const size_t   stripeBytes = (size_t)stripeRows * rowSize;
+
+        stripe.delta.resize(stripeBytes);
+        stripe.output.resize(stripeBytes);
+        stripe.hashTable.resize(1u << kFrameCodecHashBits);
+
+        // Unchanged bytes turn into zeros, then the current rows become the reference of the next frame.
+        for (uint32_t row = 0u; row < stripeRows; row++)
+        {
+            const uint8_t* pRow      = pSource + (size_t)(firstRow + row) * rowPitch;
+            uint8_t*       pPrevious = m_previousFrame.data() + (size_t)(firstRow + row) * rowSize;
+            uint8_t*       pDelta    = stripe.delta.data() + (size_t)row * rowSize;
+
+            if (keyFrame)
+                memcpy(pDelta, pRow, rowSize);
+            else
+                XorBytes(pRow, pPrevious, pDelta, rowSize);
+
+            memcpy(pPrevious, pRow, rowSize);
+        }
+
+        // Stripes that do not shrink are stored as they are.
+        const size_t compressedSize = CompressBlock(stripe.delta.data(), stripeBytes, stripe.hashTable.data(), stripe.output.data(), stripeBytes - 1u);
+
+        if (compressedSize == 0u)
+        {
+            stripe.output.swap(stripe.delta);
+            stripe.outputSize = (uint32_t)stripeBytes | kEncodedStripeStored;
+        }
+        else
+        {
+            stripe.outputSize = (uint32_t)compressedSize;
+        }
+    });
+
+    EncodedFrameHeader header;
+    memcpy(header.magic, kFrameCodecMagic, sizeof(kFrameCodecMagic));
+    header.version       = kFrameCodecVersion;
+    header.flags         = keyFrame ? kEncodedFrameKey : 0u;
+    header.rowSize       = rowSize;
+    header.rowCount      = rowCount;
+    header.rowsPerStripe = rowsPerStripe;
+    header.stripeCount   = stripeCount;
+
+    size_t encodedSize = sizeof(header) + sizeof(uint32_t) * stripeCount;
+
+    for (uint32_t stripeIndex = 0u; stripeIndex < stripeCount; stripeIndex++)
+        encodedSize += m_stripes[stripeIndex].outputSize & ~kEncodedStripeStored;
+
+    encodedFrame.resize(encodedSize);
+
+    uint8_t* pOutput = encodedFrame.data();
+
+    memcpy(pOutput, &header, sizeof(header));
+    pOutput += sizeof(header);
+
+    for (uint32_t stripeIndex = 0u; stripeIndex < stripeCount; stripeIndex++)
+    {
+        memcpy(pOutput, &m_stripes[stripeIndex].outputSize, sizeof(uint32_t));
+        pOutput += sizeof(uint32_t);
+    }
+
+    for (uint32_t stripeIndex = 0u; stripeIndex < stripeCount; stripeIndex++)
+    {
+        const Stripe& stripe = m_stripes[stripeIndex];
+        const size_t  size   = stripe.outputSize & ~kEncodedStripeStored;
+
+        memcpy(pOutput, stripe.output.data(), size);
+        pOutput += size;
+    }
+
+    return true;
+}
+
+// Decoder
+// ------------------------------------------------
+
+bool FrameDecoder::DecodeFrame(ThreadPool& threadPool, const void* pEncodedFrame, size_t encodedSize)
+{
+    TRACE_ZONE("Decode frame delta");
+
+    const uint8_t* pInput = (const uint8_t*)pEncodedFrame;
+
+    EncodedFrameHeader header;
+    if (encodedSize < sizeof(header))
+        return false;
+
+    memcpy(&header, pInput, sizeof(header));
+
+    if (memcmp(header.magic, kFrameCodecMagic, sizeof(kFrameCodecMagic)) != 0 || header.version != kFrameCodecVersion ||
+        header.rowSize == 0u || header.rowCount == 0u || header.rowsPerStripe == 0u ||
+        (uint64_t)header.rowSize * header.rowCount > kFrameCodecMaxFrameSize ||
+        header.stripeCount != ((uint64_t)header.rowCount + header.rowsPerStripe - 1u) / header.rowsPerStripe ||
+        (uint64_t)header.rowsPerStripe * header.rowSize >= kEncodedStripeStored)
+        return false;
+
+    const bool keyFrame = (header.flags & kEncodedFrameKey) != 0u;
+
+    if (!keyFrame && (header.rowSize != m_rowSize || header.rowCount != m_rowCount))
+        return false;
+
+    const size_t tableSize = sizeof(header) + sizeof(uint32_t) * (size_t)header.stripeCount;
+    if (encodedSize < tableSize)
+        return false;
+
+    // Stripe offsets, checked against the encoded size before any stripe is decoded, and stripe sizes against the
+    // bytes they decode to: a header cannot claim more frame than its stripes can hold, which bounds the frame
+    // allocation by the encoded size.
+    std::vector<size_t> stripeOffsets(header.stripeCount + 1u);
+    stripeOffsets[0] = tableSize;
+
+    for (uint32_t stripeIndex = 0u; stripeIndex < header.stripeCount; stripeIndex++)
+    {
+        const uint32_t stripeEntry = Load32(pInput + sizeof(header) + sizeof(uint32_t) * stripeIndex);
+        const uint32_t stripeSize  = stripeEntry & ~kEncodedStripeStored;
+        const uint32_t firstRow    = stripeIndex * header.rowsPerStripe;
+        const uint64_t stripeBytes = (uint64_t)std::min(header.rowsPerStripe, header.rowCount - firstRow) * header.rowSize;
+
+        if ((stripeEntry & kEncodedStripeStored) != 0u ? stripeSize != stripeBytes : stripeBytes > stripeSize * kFrameCodecMaxExpansion)
+            return false;
+
+        stripeOffsets[stripeIndex + 1u] = stripeOffsets[stripeIndex] + stripeSize;
+
+        if (stripeOffsets[stripeIndex + 1u] > encodedSize)
+            return false;
+    }
+
+    if (stripeOffsets[header.stripeCount] != encodedSize)
+        return false;
+
+    if (keyFrame)
+    {
+        m_frame.resize((size_t)header.rowSize * header.rowCount);
+        m_rowSize  = header.rowSize;
+        m_rowCount = header.rowCount;
+    }
+
+    if (m_stripeDeltas.size() < header.stripeCount)
+        m_stripeDeltas.resize(header.stripeCount);
+
+    std::vector<uint8_t> stripeDecoded(header.stripeCount, 0u);
+
+    threadPool.ParallelFor(header.stripeCount, [&](uint32_t stripeIndex)
+    {
+        TRACE_ZONE("Decode frame stripe");
+
+        const uint32_t firstRow    = stripeIndex * header.rowsPerStripe;
+        const size_t   stripeBytes = (size_t)std::min(header.rowsPerStripe, header.rowCount - firstRow) * header.rowSize;
+        uint8_t*       pFrameRows  = m_frame.data() + (size_t)firstRow * header.rowSize;
+
+        const bool     stored      = (Load32(pInput + sizeof(header) + sizeof(uint32_t) * stripeIndex) & kEncodedStripeStored) != 0u;
+        const uint8_t* pStripe     = pInput + stripeOffsets[stripeIndex];
+        const size_t   stripeSize  = stripeOffsets[stripeIndex + 1u] - stripeOffsets[stripeIndex];
+
+        // Key frames decode in place, delta frames through a scratch buffer that is then XORed into the previous frame.
+        const uint8_t* pDelta = pStripe;
+
+        if (stored)
+        {
+            if (stripeSize != stripeBytes)
+                return;
+        }
+        else
+        {
+            std::vector<uint8_t>& stripeDelta = m_stripeDeltas[stripeIndex];
+            stripeDelta.resize(stripeBytes);
+
+            if (!DecompressBlock(pStripe, stripeSize, keyFrame ? pFrameRows : stripeDelta.data(), stripeBytes))
+                return;
+
+            pDelta = stripeDelta.data();
+        }
+
+        if (!keyFrame)
+            XorBytes(pFrameRows, pDelta, pFrameRows, stripeBytes);
+        else if (stored)
+            memcpy(pFrameRows, pDelta, stripeBytes);
+
+        stripeDecoded[stripeIndex] = 1u;
+    });
+
+    // Stripes that failed left the frame partly updated, only a key frame can restore it.
+    if (std::find(stripeDecoded.begin(), stripeDecoded.end(), 0u) != stripeDecoded.end())
+    {
+        m_frame.clear();
+        m_rowSize  = 0u;
+        m_rowCount = 0u;
+
+        return false;
+    }
+
+    return true;
+}
+
+// Self Check
+// ------------------------------------------------
+
+bool CheckFrameCodec(ThreadPool& threadPool)
+{
+    struct CheckSize { uint32_t rowSize, rowCount, rowPadding; };
+
+    // A frame split into many stripes, rows that leave tails for the scalar XOR, and a frame smaller than a match.
+    constexpr CheckSize kCheckSizes[] = { { 1920u * 4u, 270u, 0u }, { 1021u, 77u, 13u }, { 3u, 1u, 5u } };
+
+    constexpr uint32_t kCheckFrameCount = 8u;
+
+    std::mt19937 random(1234u);
+
+    bool passed = true;
+
+    for (const auto& size : kCheckSizes)
+    {
+        const uint32_t rowPitch = size.rowSize + size.rowPadding;
+
+        // Content: 0 keeps the first frame, 1 changes a small block of bytes per frame, 2 is random every frame.
+        for (int content = 0; content < 3; content++)
+        {
+            std::vector<uint8_t> frame((size_t)rowPitch * size.rowCount);
+            std::vector<uint8_t> packedFrame((size_t)size.rowSize * size.rowCount);
+            std::vector<uint8_t> encodedFrame;
+
+            for (auto& value : frame)
+                value = (uint8_t)random();
+
+            FrameEncoder encoder;
+            FrameDecoder decoder;
+
+            size_t sourceBytes  = 0u;
+            size_t encodedBytes = 0u;
+
+            for (uint32_t frameIndex = 0u; frameIndex < kCheckFrameCount; frameIndex++)
+            {
+                if (content == 1)
+                {
+                    const size_t blockStart = random() % frame.size();
+
+                    for (size_t offset = blockStart; offset < std::min(frame.size(), blockStart + 64u); offset++)
+                        frame[offset] = (uint8_t)random();
+                }
+                else if (content == 2)
+                {
+                    for (auto& value : frame)
+                        value = (uint8_t)random();
+                }
+
+                for (uint32_t row = 0u; row < size.rowCount; row++)
+                    memcpy(packedFrame.data() + (size_t)row * size.rowSize, frame.data() + (size_t)row * rowPitch, size.rowSize);
+
+                const bool keyFrame = frameIndex % 4u == 0u;
+
+                if (!encoder.EncodeFrame(threadPool, frame.data(), rowPitch, size.rowSize, size.rowCount, keyFrame, encodedFrame) ||
+                    !decoder.DecodeFrame(threadPool, encodedFrame.data(), encodedFrame.size()) ||
+                    memcmp(decoder.GetFrame(), packedFrame.data(), packedFrame.size()) != 0)
+                {
+                    spdlog::error("Frame codec: frame {} of content {} ({}x{} bytes) does not round trip.", frameIndex, content, size.rowSize, size.rowCount);
+                    passed = false;
+                    break;
+                }
+
+                sourceBytes  += packedFrame.size();
+                encodedBytes += encodedFrame.size();
+
+                // Truncated frames are rejected, and leave the decoder waiting for the next key frame.
+                FrameDecoder truncatedDecoder;
+                if (truncatedDecoder.DecodeFrame(threadPool, encodedFrame.data(), encodedFrame.size() - 1u))
+                {
+                    spdlog::error("Frame codec: accepted a truncated frame.");
+                    passed = false;
+                }
+
+                // Corrupted frames either fail or decode to something, but must not crash. Debug builds with
+                // INTEROP_ENABLE_SANITIZERS also catch reads and writes out of bounds.
+                std::vector<uint8_t> corruptedFrame = encodedFrame;
+                for (int flip = 0; flip < 4; flip++)
+                    corruptedFrame[sizeof(EncodedFrameHeader) + random() % (corruptedFrame.size() - sizeof(EncodedFrameHeader))] ^= (uint8_t)(1u + random() % 255u);
+
+                FrameDecoder corruptedDecoder;
+                corruptedDecoder.DecodeFrame(threadPool, corruptedFrame.data(), corruptedFrame.size());
+            }
+
+            // Delta frames need their predecessor.
+            FrameDecoder lateDecoder;
+            encoder.EncodeFrame(threadPool, frame.data(), rowPitch, size.rowSize, size.rowCount, false, encodedFrame);
+
+            if (lateDecoder.DecodeFrame(threadPool, encodedFrame.data(), encodedFrame.size()))
+            {
+                spdlog::error("Frame codec: decoded a delta frame without its previous frame.");
+                passed = false;
+            }
+
+            spdlog::info("Frame codec {}x{} bytes, content {}: {:.2f}x smaller.", size.rowSize, size.rowCount, content, (double)sourceBytes / std::max<size_t>(encodedBytes, 1u));
+        }
+    }
+
+    // Key frames claiming more rows than their stripes can decode to are rejected before the frame is allocated:
+    // one compressed stripe of a few bytes cannot hold a gigabyte.
+    {
+        EncodedFrameHeader header;
+        memcpy(header.magic, kFrameCodecMagic, sizeof(kFrameCodecMagic));
+        header.version       = kFrameCodecVersion;
+        header.flags         = kEncodedFrameKey;
+        header.rowSize       = 1u << 16;
+        header.rowCount      = 1u << 14;
+        header.rowsPerStripe = 1u << 14;
+        header.stripeCount   = 1u;
+
+        const uint32_t stripeSize     = 3u;
+        const uint8_t  stripeBytes[3] = { 0x10u, 0u, 0u };
+
+        std::vector<uint8_t> oversizedFrame(sizeof(header) + sizeof(stripeSize) + sizeof(stripeBytes));
+        memcpy(oversizedFrame.data(), &header, sizeof(header));
+        memcpy(oversizedFrame.data() + sizeof(header), &stripeSize, sizeof(stripeSize));
+        memcpy(oversizedFrame.data() + sizeof(header) + sizeof(stripeSize), stripeBytes, sizeof(stripeBytes));
+
+        FrameDecoder oversizedDecoder;
+        if (oversizedDecoder.DecodeFrame(threadPool, oversizedFrame.data(), oversizedFrame.size()))
+        {
+            spdlog::error("Frame codec: accepted a frame larger than its stripes.");
+            passed = false;
+        }
+    }
+
+    return passed;
+}
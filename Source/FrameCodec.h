@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class ThreadPool;
+
+// Lossless transport codec for frames leaving GPU memory, towards another process or the disk. Each frame is XORed
+// with the previous one, so unchanged pixels become zero bytes, then compressed with an LZ77 block coder in the
+// spirit of LZ4 (byte-aligned sequences of literals and matches within 64 KiB) that turns the zero runs and repeated
+// pixels into a few bytes. Frames are split into stripes of whole rows that are encoded and decoded in parallel.
+//
+// Encoded frame: EncodedFrameHeader, the stripe sizes (uint32_t each, kEncodedStripeStored set when the stripe is
+// kept uncompressed) and the stripes one after the other.
+constexpr char     kFrameCodecMagic[4] = { 'F', 'D', 'L', 'Z' };
+constexpr uint16_t kFrameCodecVersion  = 1u;
+
+// Key frames are encoded on their own, so a consumer joining a stream or a reader seeking in a file decodes at most
+// this many frames.
+constexpr uint32_t kFrameCodecKeyFrameInterval = 60u;
+
+// Largest frame the codec encodes, and the decoder accepts: 8K RGBA16F frames are a quarter of it.
+constexpr uint64_t kFrameCodecMaxFrameSize = 1ull << 30;
+
+constexpr uint16_t kEncodedFrameKey     = 1u;
+constexpr uint32_t kEncodedStripeStored = 0x80000000u;
+
+struct EncodedFrameHeader
+{
+    char     magic[4];
+    uint16_t version;
+    uint16_t flags;
+
+    // The frame is rowCount rows of rowSize bytes, tightly packed once decoded.
+    uint32_t rowSize;
+    uint32_t rowCount;
+
+    uint32_t rowsPerStripe;
+    uint32_t stripeCount;
+};
+
+// Keeps the previous frame of one stream.
+class FrameEncoder
+{
+public:
+    // Encodes rowCount rows of rowSize bytes, rowPitch bytes apart, into encodedFrame. Frames are delta encoded against
+    // the previous one unless keyFrame is set, or the previous frame had another size. Returns false for empty frames
+    // and frames above kFrameCodecMaxFrameSize.
+    bool EncodeFrame(ThreadPool& threadPool, const void* pFrame, uint32_t rowPitch, uint32_t rowSize, uint32_t rowCount, bool keyFrame, std::vector<uint8_t>& encodedFrame);
+
+    // The next frame is encoded as a key frame.
+    void Reset() { m_previousFrame.clear(); }
+
+private:
+    struct Stripe
+    {
+        std::vector<uint8_t>  delta;
+        std::vector<uint8_t>  output;
+        std::vector<uint32_t> hashTable;
+        uint32_t              outputSize = 0u;
+    };
+
+    std::vector<uint8_t> m_previousFrame;
+    uint32_t             m_rowSize  = 0u;
+    uint32_t             m_rowCount = 0u;
+
+    std::vector<Stripe>  m_stripes;
+};
+
+// Reconstructs the frames of one stream. Encoded frames are validated, as they come from another process or a file.
+class FrameDecoder
+{
+public:
+    // Decodes the next frame of the stream. Returns false for malformed frames and for delta frames that do not
+    // follow a decoded frame of the same size; the stream then resumes at the next key frame.
+    bool DecodeFrame(ThreadPool& threadPool, const void* pEncodedFrame, size_t encodedSize);
+
+    // Last decoded frame, rows tightly packed.
+    const uint8_t* GetFrame() const { return m_frame.data(); }
+
+    uint32_t GetRowSize() const { return m_rowSize; }
+
+    uint32_t GetRowCount() const { return m_rowCount; }
+
+private:
+    std::vector<uint8_t>              m_frame;
+    uint32_t                          m_rowSize  = 0u;
+    uint32_t                          m_rowCount = 0u;
+
+    std::vector<std::vector<uint8_t>> m_stripeDeltas;
+};
+
+// Round trips key and delta frames of static, sparsely changing and random content through the encoder and the
+// decoder, with rows that are not a multiple of the vector width and padded row pitches. Also feeds the decoder
+// truncated and mislabeled frames, which must be rejected, and randomly corrupted ones, which must at least stay within
+// bounds. Returns false if any frame does not decode to its source or bad input is accepted.
+bool CheckFrameCodec(ThreadPool& threadPool);
@@ -0,0 +1,197 @@
+#include "FrameContext.h"
+
+#include <spdlog/spdlog.h>
+
+#include "Trace.h"
+
+bool FrameContextPool::Create(const VulkanDevice& device, uint32_t frameContextCount, std::mutex* pQueueMutex)
+{
+    m_device      = device;
+    m_pQueueMutex = pQueueMutex;
+
+    // Command buffers are reset one at a time when begun again.
+    VkCommandPoolCreateInfo vkCommandPoolCreateInfo = { VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO };
+    vkCommandPoolCreateInfo.flags            = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    vkCommandPoolCreateInfo.queueFamilyIndex = device.graphicsQueueIndex;
+
+    if (vkCreateCommandPool(device.vkLogicalDevice, &vkCommandPoolCreateInfo, nullptr, &m_vkCommandPool) != VK_SUCCESS)
+    {
+        spdlog::error("Failed to create the frame context command pool.");
+        return false;
+    }
+
+    return Reserve(frameContextCount);
+}
+
+void FrameContextPool::Destroy()
+{
+    if (m_vkCommandPool == VK_NULL_HANDLE)
+        return;
+
+    WaitIdle();
+
+    for (auto& frameContext : m_frameContexts)
+        vkDestroyFence(m_device.vkLogicalDevice, frameContext.vkFence, nullptr);
+
+    // Frees the command buffers of the contexts and the static ones.
+    vkDestroyCommandPool(m_device.vkLogicalDevice, m_vkCommandPool, nullptr);
+
+    m_frameContexts.clear();
+    m_vkCommandPool = VK_NULL_HANDLE;
+    m_nextContext   = 0u;
+}
+
+bool FrameContextPool::Reserve(uint32_t frameContextCount)
+{
+    if (frameContextCount <= m_frameContexts.size())
+        return true;
+
+    std::vector<VkCommandBuffer> vkCommandBuffers;
+    if (!AllocateCommandBuffers(frameContextCount - (uint32_t)m_frameContexts.size(), vkCommandBuffers))
+        return false;
+
+    // Signaled, so that the first acquire of a context does not wait.
+    VkFenceCreateInfo vkFenceCreateInfo = { VK_STRUCTURE_TYPE_FENCE_CREATE_INFO };
+    vkFenceCreateInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+    for (VkCommandBuffer vkCommandBuffer : vkCommandBuffers)
+    {
+        FrameContext frameContext;
+        frameContext.vkCommandBuffer = vkCommandBuffer;
+
+        if (vkCreateFence(m_device.vkLogicalDevice, &vkFenceCreateInfo, nullptr, &frameContext.vkFence) != VK_SUCCESS)
+        {
+            vkFreeCommandBuffers(m_device.vkLogicalDevice, m_vkCommandPool, 1u, &vkCommandBuffer);
+            return false;
+        }
+
+        m_frameContexts.push_back(frameContext);
+    }
+
+    return true;
+}
+
+bool FrameContextPool::AcquireFrameContext(VkCommandBuffer& vkCommandBuffer)
+{
+    TRACE_ZONE("Acquire frame context");
+
+    const FrameContext& frameContext = m_frameContexts[m_nextContext];
+
+    if (vkWaitForFences(m_device.vkLogicalDevice, 1u, &frameContext.vkFence, VK_TRUE, UINT64_MAX) != VK_SUCCESS)
+        return false;
+
+    vkCommandBuffer = frameContext.vkCommandBuffer;
+
+    return true;
+}
+
+bool FrameContextPool::SubmitFrameContext(VkCommandBuffer vkCommandBuffer, const VulkanTimelineSubmit& timelineSubmit)
+{
+    TRACE_ZONE("Submit frame");
+
+    FrameContext& frameContext = m_frameContexts[m_nextContext];
+
+    // Reset only now: an acquired context that is never submitted stays signaled.
+    vkResetFences(m_device.vkLogicalDevice, 1u, &frameContext.vkFence);
+
+    bool submitted;
+    if (m_pQueueMutex != nullptr)
+    {
+        std::lock_guard<std::mutex> queueLock(*m_pQueueMutex);
+        submitted = SubmitVulkanCommandBuffer(m_device.vkGraphicsQueue, vkCommandBuffer, timelineSubmit, frameContext.vkFence);
+    }
+    else
+    {
+        submitted = SubmitVulkanCommandBuffer(m_device.vkGraphicsQueue, vkCommandBuffer, timelineSubmit, frameContext.vkFence);
+    }
+
+    if (!submitted)
+    {
+        // Nothing will signal the fence, replace it with a signaled one so that waits on the context return.
+        VkFenceCreateInfo vkFenceCreateInfo = { VK_STRUCTURE_TYPE_FENCE_CREATE_INFO };
+        vkFenceCreateInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+        vkDestroyFence(m_device.vkLogicalDevice, frameContext.vkFence, nullptr);
+        vkCreateFence(m_device.vkLogicalDevice, &vkFenceCreateInfo, nullptr, &frameContext.vkFence);
+        return false;
+    }
+
+    m_nextContext = (m_nextContext + 1u) % (uint32_t)m_frameContexts.size();
+    m_submitCount++;
+
+    return true;
+}
+
+void FrameContextPool::FreeStaticCommandBuffers(std::vector<VkCommandBuffer>& vkCommandBuffers)
+{
+    if (!vkCommandBuffers.empty())
+        vkFreeCommandBuffers(m_device.vkLogicalDevice, m_vkCommandPool, (uint32_t)vkCommandBuffers.size(), vkCommandBuffers.data());
+
+    vkCommandBuffers.clear();
+}
+
+bool FrameContextPool::WaitIdle()
+{
+    std::vector<VkFence> vkFences;
+    vkFences.reserve(m_frameContexts.size());
+
+    for (const auto& frameContext : m_frameContexts)
+        vkFences.push_back(frameContext.vkFence);
+
+    return vkFences.empty() || vkWaitForFences(m_device.vkLogicalDevice, (uint32_t)vkFences.size(), vkFences.data(), VK_TRUE, UINT64_MAX) == VK_SUCCESS;
+}
+
+bool FrameContextPool::AllocateCommandBuffers(uint32_t commandBufferCount, std::vector<VkCommandBuffer>& vkCommandBuffers)
+{
+    VkCommandBufferAllocateInfo vkCommandAllocateInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
+    vkCommandAllocateInfo.commandBufferCount = commandBufferCount;
+    vkCommandAllocateInfo.commandPool        = m_vkCommandPool;
+    vkCommandAllocateInfo.level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+
+    vkCommandBuffers.resize(commandBufferCount);
+
+    if (vkAllocateCommandBuffers(m_device.vkLogicalDevice, &vkCommandAllocateInfo, vkCommandBuffers.data()) != VK_SUCCESS)
+    {
+        spdlog::error("Failed to allocate {} command buffers.", commandBufferCount);
+        vkCommandBuffers.clear();
+        return false;
+    }
+
+    return true;
+}
+
+// Per-Thread Pools
+// ------------------------------------------------
+
+bool FrameContextPools::Create(const VulkanDevice& device, uint32_t frameContextCount)
+{
+    m_device            = device;
+    m_frameContextCount = frameContextCount;
+
+    return true;
+}
+
+FrameContextPool* FrameContextPools::GetForCurrentThread()
+{
+    std::lock_guard<std::mutex> poolsLock(m_poolsMutex);
+
+    auto& pPool = m_pools[std::this_thread::get_id()];
+
+    if (!pPool)
+    {
+        auto pNewPool = std::make_unique<FrameContextPool>();
+        if (!pNewPool->Create(m_device, m_frameContextCount, &m_queueMutex))
+            return nullptr;
+
+        pPool = std::move(pNewPool);
+    }
+
+    return pPool.get();
+}
+
+void FrameContextPools::Destroy()
+{
+    std::lock_guard<std::mutex> poolsLock(m_poolsMutex);
+
+    m_pools.clear();
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "Vulkan.h"
+
+// A command buffer together with the fence of its last submission. Once the fence signaled the command buffer is
+// recorded again instead of freed, and the fence is reset instead of destroyed.
+struct FrameContext
+{
+    VkCommandBuffer vkCommandBuffer = VK_NULL_HANDLE;
+    VkFence         vkFence         = VK_NULL_HANDLE;
+};
+
+// Ring of frame contexts allocated from a single command pool, so that submitting a frame costs a fence wait, a
+// record and a submit rather than a pool creation and destruction. Command pools are externally synchronized:
+// a FrameContextPool must only be used by one thread, see FrameContextPools.
+class FrameContextPool
+{
+public:
+    ~FrameContextPool() { Destroy(); }
+
+    // pQueueMutex serializes submissions of pools sharing the queue, it may be null.
+    bool Create(const VulkanDevice& device, uint32_t frameContextCount, std::mutex* pQueueMutex = nullptr);
+
+    // Waits for every submission, then destroys the contexts and the static command buffers.
+    void Destroy();
+
+    // Adds frame contexts until there are at least frameContextCount of them.
+    bool Reserve(uint32_t frameContextCount);
+
+    uint32_t GetFrameContextCount() const { return (uint32_t)m_frameContexts.size(); }
+
+    // Waits until the next context of the ring is no longer in flight and returns its command buffer, which is
+    // reset when begun.
+    bool AcquireFrameContext(VkCommandBuffer& vkCommandBuffer);
+
+    // Submits either the acquired command buffer or a static one, tracked by the fence of the acquired context.
+    bool SubmitFrameContext(VkCommandBuffer vkCommandBuffer, const VulkanTimelineSubmit& timelineSubmit);
+
+    // Submissions made through SubmitFrameContext so far.
+    uint64_t GetSubmitCount() const { return m_submitCount; }
+
+    // Records commandBufferCount command buffers once for replay, recordCommands(index, vkCommandBuffer) records
+    // the commands of each between begin and end. A static command buffer may be submitted any number of times
+    // but not while it is in flight: replaying them in a cycle at least GetFrameContextCount() long is safe.
+    template <typename RecordFunc>
+    bool RecordStaticCommandBuffers(uint32_t commandBufferCount, RecordFunc&& recordCommands, std::vector<VkCommandBuffer>& vkCommandBuffers)
+    {
+        if (!AllocateCommandBuffers(commandBufferCount, vkCommandBuffers))
+            return false;
+
+        VkCommandBufferBeginInfo vkCommandBeginInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+
+        for (uint32_t commandBufferIndex = 0u; commandBufferIndex < commandBufferCount; commandBufferIndex++)
+        {
+            if (vkBeginCommandBuffer(vkCommandBuffers[commandBufferIndex], &vkCommandBeginInfo) != VK_SUCCESS)
+                return false;
+
+            recordCommands(commandBufferIndex, vkCommandBuffers[commandBufferIndex]);
+
+            if (vkEndCommandBuffer(vkCommandBuffers[commandBufferIndex]) != VK_SUCCESS)
+                return false;
+        }
+
+        return true;
+    }
+
+    // The command buffers must not be in flight.
+    void FreeStaticCommandBuffers(std::vector<VkCommandBuffer>& vkCommandBuffers);
+
+    // Blocks until every submitted context completed.
+    bool WaitIdle();
+
+private:
+    bool AllocateCommandBuffers(uint32_t commandBufferCount, std::vector<VkCommandBuffer>& vkCommandBuffers);
+
+    VulkanDevice              m_device;
+    VkCommandPool             m_vkCommandPool = VK_NULL_HANDLE;
+    std::mutex*               m_pQueueMutex   = nullptr;
+
+    std::vector<FrameContext> m_frameContexts;
+    uint32_t                  m_nextContext   = 0u;
+    uint64_t                  m_submitCount   = 0u;
+};
+
+// One FrameContextPool per recording thread, created on the first request of each thread. Submissions of all
+// pools are serialized, as they share the device's graphics queue.
+class FrameContextPools
+{
+public:
+    bool Create(const VulkanDevice& device, uint32_t frameContextCount);
+
+    // Pool of the calling thread, null if it could not be created.
+    FrameContextPool* GetForCurrentThread();
+
+    // No thread may use its pool anymore.
+    void Destroy();
+
+private:
+    VulkanDevice m_device;
+    uint32_t     m_frameContextCount = 0u;
+
+    std::mutex   m_poolsMutex;
+    std::mutex   m_queueMutex;
+
+    std::unordered_map<std::thread::id, std::unique_ptr<FrameContextPool>> m_pools;
+};
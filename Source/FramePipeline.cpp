@@ -0,0 +1,143 @@
+#include "FramePipeline.h"
+
+#include <spdlog/spdlog.h>
+
+#include "Trace.h"
+
+bool FramePipeline::Start(uint32_t frameCount, size_t frameSize, const std::vector<PipelineStageDesc>& stages)
+{
+    if (IsStarted() || frameCount == 0u || stages.empty())
+    {
+        spdlog::error("A frame pipeline needs at least one frame and one stage.");
+        return false;
+    }
+
+    m_frames.assign(frameCount, {});
+    m_stages.assign(stages.size(), {});
+    m_queues.clear();
+
+    for (PipelineFrame& frame : m_frames)
+        frame.pixels.resize(frameSize);
+
+    for (size_t stageIndex = 0u; stageIndex < stages.size(); stageIndex++)
+        m_stages[stageIndex].desc = stages[stageIndex];
+
+    for (size_t queueIndex = 0u; queueIndex <= stages.size(); queueIndex++)
+        m_queues.push_back(std::make_unique<FrameQueue<PipelineFrame*>>(frameCount));
+
+    // Every frame starts with the producer.
+    for (PipelineFrame& frame : m_frames)
+        m_queues.back()->Push(&frame);
+
+    m_failed               = false;
+    m_producerStallSeconds = 0.0;
+    m_startTime            = std::chrono::steady_clock::now();
+
+    for (uint32_t stageIndex = 0u; stageIndex < (uint32_t)m_stages.size(); stageIndex++)
+        m_threads.emplace_back(&FramePipeline::StageLoop, this, stageIndex);
+
+    return true;
+}
+
+PipelineFrame* FramePipeline::AcquireFrame()
+{
+    PipelineFrame* pFrame = nullptr;
+
+    if (m_queues.back()->TryPop(pFrame))
+        return pFrame;
+
+    TRACE_ZONE("Wait for pipeline frame");
+
+    const auto stallStart = std::chrono::steady_clock::now();
+
+    // The last stage only closes its queue once the producer closed the first one.
+    const bool popped = m_queues.back()->Pop(pFrame);
+
+    m_producerStallSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - stallStart).count();
+
+    if (!popped)
+    {
+        spdlog::error("The frame pipeline was finished before acquiring a frame.");
+        return nullptr;
+    }
+
+    return pFrame;
+}
+
+void FramePipeline::SubmitFrame(PipelineFrame* pFrame)
+{
+    m_stages.front().queueDepthSamples.push_back(m_queues.front()->GetDepth() + 1u);
+    m_queues.front()->Push(pFrame);
+}
+
+void FramePipeline::StageLoop(uint32_t stageIndex)
+{
+    Stage& stage = m_stages[stageIndex];
+
+    TRACE_THREAD_NAME(stage.desc.pName);
+
+    FrameQueue<PipelineFrame*>& input  = *m_queues[stageIndex];
+    FrameQueue<PipelineFrame*>& output = *m_queues[stageIndex + 1u];
+
+    std::vector<double>* pOutputDepthSamples = stageIndex + 1u < m_stages.size() ? &m_stages[stageIndex + 1u].queueDepthSamples : nullptr;
+
+    PipelineFrame* pFrame = nullptr;
+
+    while (input.Pop(pFrame))
+    {
+        if (!m_failed.load(std::memory_order_relaxed))
+        {
+            TRACE_ZONE(stage.desc.pName);
+
+            const auto stageStart = std::chrono::steady_clock::now();
+
+            if (!stage.desc.stageFunc(*pFrame))
+                m_failed.store(true, std::memory_order_relaxed);
+
+            stage.busySeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - stageStart).count();
+            stage.frames++;
+        }
+
+        if (pOutputDepthSamples != nullptr)
+            pOutputDepthSamples->push_back(output.GetDepth() + 1u);
+
+        output.Push(pFrame);
+    }
+
+    output.Close();
+}
+
+bool FramePipeline::Finish()
+{
+    if (!IsStarted())
+        return !m_failed;
+
+    m_queues.front()->Close();
+
+    for (std::thread& thread : m_threads)
+        thread.join();
+
+    m_threads.clear();
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_startTime).count();
+
+    m_stats.stages.clear();
+    m_stats.producerStallSeconds = m_producerStallSeconds;
+
+    for (Stage& stage : m_stages)
+    {
+        PipelineStageStats stageStats;
+        stageStats.pName       = stage.desc.pName;
+        stageStats.frames      = stage.frames;
+        stageStats.busySeconds = stage.busySeconds;
+        stageStats.occupancy   = seconds > 0.0 ? stage.busySeconds / seconds : 0.0;
+        stageStats.queueDepth  = SummarizeSamples(stage.queueDepthSamples);
+
+        m_stats.stages.push_back(stageStats);
+    }
+
+    if (m_failed)
+        spdlog::error("A stage of the frame pipeline failed, its remaining frames were dropped.");
+
+    return !m_failed;
+}
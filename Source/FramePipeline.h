@@ -0,0 +1,105 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "FrameQueue.h"
+#include "Statistics.h"
+
+// Frame moving through the pipeline: pixels copied out of a readback slot and, once encoded, their transport encoding.
+struct PipelineFrame
+{
+    uint64_t             frameIndex  = 0u;
+    uint64_t             timestampNs = 0u;
+    std::vector<uint8_t> pixels;
+    std::vector<uint8_t> encodedFrame;
+};
+
+// Work of a stage on one frame. Returning false fails the pipeline, frames still queued then go through the
+// remaining stages without being worked on.
+using PipelineStageFunc = std::function<bool(PipelineFrame& frame)>;
+
+struct PipelineStageDesc
+{
+    const char*       pName = nullptr;
+    PipelineStageFunc stageFunc;
+};
+
+struct PipelineStageStats
+{
+    const char*   pName       = nullptr;
+    uint32_t      frames      = 0u;
+
+    // Time spent in the stage function, and its share of the pipeline's lifetime.
+    double        busySeconds = 0.0;
+    double        occupancy   = 0.0;
+
+    // Frames waiting in front of the stage, sampled each time one is queued.
+    SampleSummary queueDepth;
+};
+
+struct FramePipelineStats
+{
+    std::vector<PipelineStageStats> stages;
+
+    // Time the producer waited in AcquireFrame for a frame to come back from the last stage.
+    double                          producerStallSeconds = 0.0;
+};
+
+// Linear graph of stages on dedicated threads, fed by a producer thread. A fixed set of frames circulates from the
+// producer through every stage in order and back, over single-producer single-consumer FrameQueues: queues never
+// hold more than every frame, so stages never block on their output, and a slow stage holds frames until the
+// producer runs out of them and waits for one in AcquireFrame (backpressure).
+class FramePipeline
+{
+public:
+    ~FramePipeline() { Finish(); }
+
+    // frameCount frames of frameSize bytes each, and one thread per stage.
+    bool Start(uint32_t frameCount, size_t frameSize, const std::vector<PipelineStageDesc>& stages);
+
+    bool IsStarted() const { return !m_threads.empty(); }
+
+    // Producer side: blocks while every frame is in the stages. Returns nullptr once the pipeline is finished.
+    PipelineFrame* AcquireFrame();
+
+    // Queues an acquired frame for the first stage.
+    void SubmitFrame(PipelineFrame* pFrame);
+
+    // Waits for the submitted frames to leave the last stage and joins the stage threads. Returns false if a stage
+    // failed.
+    bool Finish();
+
+    // Valid after Finish.
+    const FramePipelineStats& GetStats() const { return m_stats; }
+
+private:
+    struct Stage
+    {
+        PipelineStageDesc   desc;
+        uint32_t            frames      = 0u;
+        double              busySeconds = 0.0;
+
+        // Written by the thread feeding the stage.
+        std::vector<double> queueDepthSamples;
+    };
+
+    void StageLoop(uint32_t stageIndex);
+
+    std::vector<PipelineFrame>                               m_frames;
+    std::vector<Stage>                                       m_stages;
+    std::vector<std::thread>                                 m_threads;
+
+    // Queue N feeds stage N, the last one returns frames to the producer.
+    std::vector<std::unique_ptr<FrameQueue<PipelineFrame*>>> m_queues;
+
+    std::atomic<bool>                                        m_failed = false;
+    std::chrono::steady_clock::time_point                    m_startTime;
+    double                                                   m_producerStallSeconds = 0.0;
+
+    FramePipelineStats                                       m_stats;
+};
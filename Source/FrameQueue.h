@@ -0,0 +1,91 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+// Bounded lock-free queue between one producer thread and one consumer thread. Each side only writes its own index,
+// so Push and Pop are a load, a store and a notify; a full or empty queue blocks on the other side's index (atomic
+// wait) rather than spinning. The producer closes the queue after its last Push, which ends the consumer's Pop loop.
+template <typename T>
+class FrameQueue
+{
+public:
+    explicit FrameQueue(uint32_t capacity) : m_items(capacity) {}
+
+    FrameQueue(const FrameQueue&)            = delete;
+    FrameQueue& operator=(const FrameQueue&) = delete;
+
+    uint32_t GetCapacity() const { return (uint32_t)m_items.size(); }
+
+    // Items queued, as seen from either side.
+    uint32_t GetDepth() const { return (uint32_t)((m_tail.load(std::memory_order_acquire) & ~kClosedBit) - m_head.load(std::memory_order_acquire)); }
+
+    // Blocks while the queue is full.
+    void Push(T item)
+    {
+        const uint64_t tail = m_tail.load(std::memory_order_relaxed);
+
+        for (uint64_t head = m_head.load(std::memory_order_acquire); tail - head == m_items.size(); head = m_head.load(std::memory_order_acquire))
+            m_head.wait(head, std::memory_order_acquire);
+
+        m_items[tail % m_items.size()] = std::move(item);
+
+        m_tail.store(tail + 1u, std::memory_order_release);
+        m_tail.notify_one();
+    }
+
+    // Returns false right away when the queue is empty.
+    bool TryPop(T& item)
+    {
+        const uint64_t head = m_head.load(std::memory_order_relaxed);
+
+        if ((m_tail.load(std::memory_order_acquire) & ~kClosedBit) == head)
+            return false;
+
+        PopAt(head, item);
+        return true;
+    }
+
+    // Blocks until an item is queued. Returns false once the queue is closed and empty.
+    bool Pop(T& item)
+    {
+        const uint64_t head = m_head.load(std::memory_order_relaxed);
+
+        for (uint64_t tail = m_tail.load(std::memory_order_acquire); (tail & ~kClosedBit) == head; tail = m_tail.load(std::memory_order_acquire))
+        {
+            if ((tail & kClosedBit) != 0u)
+                return false;
+
+            m_tail.wait(tail, std::memory_order_acquire);
+        }
+
+        PopAt(head, item);
+        return true;
+    }
+
+    // Producer side, no Push may follow.
+    void Close()
+    {
+        m_tail.fetch_or(kClosedBit, std::memory_order_release);
+        m_tail.notify_all();
+    }
+
+private:
+    static constexpr uint64_t kClosedBit = 1ull << 63;
+
+    void PopAt(uint64_t head, T& item)
+    {
+        item = std::move(m_items[head % m_items.size()]);
+
+        m_head.store(head + 1u, std::memory_order_release);
+        m_head.notify_one();
+    }
+
+    std::vector<T> m_items;
+
+    // Next item to pop, written by the consumer, and next item to push, written by the producer, each on its own
+    // cache line so that the two sides do not share one.
+    alignas(64) std::atomic<uint64_t> m_head = 0u;
+    alignas(64) std::atomic<uint64_t> m_tail = 0u;
+};
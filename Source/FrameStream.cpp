@@ -0,0 +1,479 @@
+#include "FrameStream.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+
+#include <spdlog/spdlog.h>
+
+#include "ExternalImage.h"
+#include "FrameCodec.h"
+#include "FrameContext.h"
+#include "PixelConversion.h"
+#include "ReadbackRing.h"
+#include "Trace.h"
+#include "VideoFile.h"
+
+void RecordFrameCommands(const VulkanDevice& device, const SharedImage& sharedImage, uint64_t frameIndex, VkCommandBuffer vkCommandBuffer, VulkanTraceQueries* pTraceQueries)
+{
+    {
+        TRACE_GPU_ZONE(pTraceQueries, vkCommandBuffer, "Barrier");
+        RecordVulkanImageBarrier(vkCommandBuffer, sharedImage.vkImage, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL, 0u, VK_ACCESS_TRANSFER_WRITE_BIT);
+    }
+
+    // Every layer of an array image is cleared by the same command buffer, between the same two barriers.
+    {
+        TRACE_GPU_ZONE(pTraceQueries, vkCommandBuffer, "Clear");
+
+        for (uint32_t layer = 0u; layer < sharedImage.desc.arrayLayers; layer++)
+        {
+            VkImageSubresourceRange vkImageClearRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0u, 1u, layer, 1u };
+
+            VkClearColorValue clearColor = { { (float)((frameIndex + layer) & 0xFFu) / 255.0f, 0.5f, 1.0f, 1.0f } };
+            vkCmdClearColorImage(vkCommandBuffer, sharedImage.vkImage, VK_IMAGE_LAYOUT_GENERAL, &clearColor, 1u, &vkImageClearRange);
+        }
+    }
+
+    // Release the image to the exporting API.
+    TRACE_GPU_ZONE(pTraceQueries, vkCommandBuffer, "Release");
+    RecordVulkanImageBarrier(vkCommandBuffer, sharedImage.vkImage, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL, VK_ACCESS_TRANSFER_WRITE_BIT, 0u, device.graphicsQueueIndex, VK_QUEUE_FAMILY_EXTERNAL);
+}
+
+void RecordFrame(const VulkanDevice& device, const SharedImage& sharedImage, uint64_t frameIndex, VkCommandBuffer vkCommandBuffer, VulkanTraceQueries* pTraceQueries)
+{
+    TRACE_ZONE("Record frame");
+
+    // Command buffers come from pools with VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT, begin resets them.
+    VkCommandBufferBeginInfo vkCommandBeginInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+    vkCommandBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    vkBeginCommandBuffer(vkCommandBuffer, &vkCommandBeginInfo);
+
+    RecordFrameCommands(device, sharedImage, frameIndex, vkCommandBuffer, pTraceQueries);
+
+    vkEndCommandBuffer(vkCommandBuffer);
+}
+
+bool RecordStaticFrames(FrameContextPool& frameContexts, const VulkanDevice& device, const SharedImage& sharedImage, std::vector<VkCommandBuffer>& vkCommandBuffers)
+{
+    // Replaying a command buffer every kDistinctFrameCount frames is only safe with fewer contexts in flight.
+    if (frameContexts.GetFrameContextCount() > kDistinctFrameCount)
+        return false;
+
+    // Replays would write the same timestamp queries again before they are collected, so static frames have no GPU zones.
+    return frameContexts.RecordStaticCommandBuffers(kDistinctFrameCount, [&](uint32_t frameIndex, VkCommandBuffer vkCommandBuffer)
+    {
+        RecordFrameCommands(device, sharedImage, frameIndex, vkCommandBuffer);
+    }, vkCommandBuffers);
+}
+
+VulkanTimelineSubmit GetFrameTimelineSubmit(const SharedImage& sharedImage, uint64_t frameIndex)
+{
+    VulkanTimelineSubmit timelineSubmit;
+    timelineSubmit.vkWaitSemaphore   = sharedImage.vkTimelineSemaphore;
+    timelineSubmit.waitValue         = GetSharedImageRenderWaitValue(frameIndex);
+    timelineSubmit.vkSignalSemaphore = sharedImage.vkTimelineSemaphore;
+    timelineSubmit.signalValue       = GetSharedImageRenderSignalValue(frameIndex);
+
+    return timelineSubmit;
+}
+
+// Dirty rectangle of frameIndex, moving one tile per frame left to right, then top to bottom.
+static DirtyRect GetFrameDirtyRect(const SharedImageDesc& imageDesc, const FrameStreamDesc& desc, uint64_t frameIndex)
+{
+    DirtyRect dirtyRect;
+    dirtyRect.width  = std::min(desc.dirtyRectWidth,  imageDesc.width);
+    dirtyRect.height = std::min(desc.dirtyRectHeight, imageDesc.height);
+
+    const uint32_t columnCount = (imageDesc.width  - dirtyRect.width)  / kDirtyTileSize + 1u;
+    const uint32_t rowCount    = (imageDesc.height - dirtyRect.height) / kDirtyTileSize + 1u;
+    const uint64_t position    = frameIndex % ((uint64_t)columnCount * rowCount);
+
+    dirtyRect.x = (uint32_t)(position % columnCount) * kDirtyTileSize;
+    dirtyRect.y = (uint32_t)(position / columnCount) * kDirtyTileSize;
+
+    return dirtyRect;
+}
+
+void LogFrameStreamResult(uint32_t readbackDepth, const FrameStreamResult& result)
+{
+    spdlog::info("Readback depth {}: {} frames, {:.1f} fps, latency (ms) p50 {:.3f}, p95 {:.3f}, p99 {:.3f}, {} corrupt frames.",
+        readbackDepth,
+        result.deliveredFrames,
+        result.framesPerSecond,
+        result.latencyMs.p50,
+        result.latencyMs.p95,
+        result.latencyMs.p99,
+        result.corruptFrames
+    );
+
+    if (result.deliveredFrames > 0u && result.fullFrameBytes > 0u)
+    {
+        spdlog::info("Readback depth {}: copied {:.2f} MiB per frame, {:.1f}% of full-frame copies.",
+            readbackDepth,
+            (double)result.copiedBytes / result.deliveredFrames / (1024.0 * 1024.0),
+            100.0 * (double)result.copiedBytes / (double)result.fullFrameBytes
+        );
+    }
+
+    if (result.zeroCopy)
+        spdlog::info("Readback depth {}: frames were read back in place into the video file.", readbackDepth);
+
+    if (result.codecInputBytes > 0u && result.codecOutputBytes > 0u && result.codecSeconds > 0.0)
+    {
+        spdlog::info("Readback depth {}: transport codec {:.2f}x smaller, {:.2f} KiB per frame, encoded at {:.2f} GB/s.",
+            readbackDepth,
+            (double)result.codecInputBytes / (double)result.codecOutputBytes,
+            (double)result.codecOutputBytes / result.deliveredFrames / 1024.0,
+            (double)result.codecInputBytes / result.codecSeconds / 1e9
+        );
+    }
+
+    if (result.pipelined)
+    {
+        for (const PipelineStageStats& stageStats : result.pipelineStats.stages)
+        {
+            spdlog::info("Readback depth {}: {} stage {:.1f}% busy, {:.3f} ms per frame, queue depth p50 {:.0f}, max {:.0f}.",
+                readbackDepth,
+                stageStats.pName,
+                100.0 * stageStats.occupancy,
+                stageStats.frames > 0u ? 1000.0 * stageStats.busySeconds / stageStats.frames : 0.0,
+                stageStats.queueDepth.p50,
+                stageStats.queueDepth.max
+            );
+        }
+
+        spdlog::info("Readback depth {}: the render loop waited {:.3f} ms for pipeline frames.", readbackDepth, 1000.0 * result.pipelineStats.producerStallSeconds);
+    }
+}
+
+bool RunFrameStream(InteropBackend* pBackend, const VulkanDevice& device, FrameContextPool& frameContexts, const SharedImage& sharedImage, const FrameStreamDesc& desc, FrameStreamResult& result)
+{
+    const uint64_t firstFrameIndex = desc.firstFrameIndex;
+    const uint32_t frameCount      = desc.frameCount;
+
+    // Rendering frame N waits for the readback of N - 1 on the GPU, so one more frame context than readbacks is enough.
+    bool succeeded = frameContexts.Reserve(desc.readbackDepth + 1u);
+
+    std::vector<VkCommandBuffer> vkStaticCommandBuffers;
+    if (succeeded && desc.prerecordFrames)
+        succeeded = RecordStaticFrames(frameContexts, device, sharedImage, vkStaticCommandBuffers);
+
+    std::vector<std::chrono::steady_clock::time_point> renderSubmitTimes(frameCount);
+    std::vector<double>                                latenciesMs;
+
+    latenciesMs.reserve(frameCount);
+    result.corruptFrames    = 0u;
+    result.copiedBytes      = 0u;
+    result.fullFrameBytes   = 0u;
+    result.codecInputBytes  = 0u;
+    result.codecOutputBytes = 0u;
+    result.codecSeconds     = 0.0;
+
+    const auto streamStart = std::chrono::steady_clock::now();
+
+    bool videoFileFull = false;
+
+    // Tone mapped formats don't round trip the clear color.
+    const PixelFormat imageFormat  = GetSharedImageFormatTraits(sharedImage.desc).format;
+    const bool        checkCleared = imageFormat != PixelFormat::RGBA16F;
+
+    const uint32_t bytesPerPixel = GetSharedImageBytesPerPixel(sharedImage.desc);
+    const uint32_t packedPitch   = GetSharedImageRowPitch(sharedImage.desc);
+
+    // The compute stage converts whole frames, readbacks then copy its NV12 output.
+    const bool useCompute = desc.readbackCompute.enabled;
+
+    uint32_t computeWidth  = 0u;
+    uint32_t computeHeight = 0u;
+
+    if (useCompute)
+    {
+        if (!GetReadbackComputeExtent(sharedImage.desc, desc.readbackCompute, computeWidth, computeHeight))
+        {
+            spdlog::error("Readback compute downscale {} does not fit a {}x{} image.", desc.readbackCompute.downscale, sharedImage.desc.width, sharedImage.desc.height);
+            succeeded = false;
+        }
+        else if (!pBackend->SetReadbackCompute(sharedImage, desc.readbackCompute))
+        {
+            spdlog::error("The interop backend has no readback compute stage.");
+            succeeded = false;
+        }
+    }
+
+    // Every tile starts dirty, so the first frame is read back whole.
+    const bool   trackDamage = !useCompute && desc.dirtyRectWidth > 0u && desc.dirtyRectHeight > 0u;
+    DirtyTileMap dirtyTiles;
+    dirtyTiles.Resize(sharedImage.desc.width, sharedImage.desc.height);
+
+    // Consumer-side copy of the frame, updated with the changed tiles of each readback.
+    std::vector<uint8_t> composedFrame(trackDamage ? (size_t)GetSharedImageSize(sharedImage.desc) : 0u);
+
+    const VkDeviceSize layerSize = GetSharedImageLayerSize(sharedImage.desc);
+
+    // Zero-copy readbacks write each frame to the file slot it is committed to: frames are delivered in order and
+    // every one of them is committed, so frame N of the stream goes to slot firstSlot + N.
+    result.zeroCopy = false;
+
+    // Pipelined frames are copied out of the readback slots, the file slots are written by the write stage.
+    const bool pipelined = desc.pipelineDepth > 0u && (desc.pVideoFile != nullptr || desc.pCodecThreadPool != nullptr);
+
+    if (succeeded && desc.zeroCopy && !pipelined && desc.pVideoFile != nullptr && desc.pVideoFile->IsPassthrough() && !trackDamage && sharedImage.desc.arrayLayers == 1u)
+    {
+        uint64_t storageSize;
+        void*    pFrameStorage = desc.pVideoFile->GetFrameStorage(storageSize);
+
+        const uint64_t alignment = pBackend->GetReadbackHostMemoryAlignment();
+
+        result.zeroCopy = alignment > 0u && (uintptr_t)pFrameStorage % alignment == 0u && storageSize % alignment == 0u &&
+                          pBackend->ImportReadbackHostMemory(sharedImage, pFrameStorage, storageSize);
+
+        if (!result.zeroCopy)
+            spdlog::warn("The {} backend cannot read back into the video file, frames are copied there instead.", pBackend->GetName());
+    }
+
+    // Transport codec rows: the NV12 planes of compute readbacks follow each other, one byte per pixel and row.
+    const uint32_t codecRowSize  = useCompute ? computeWidth : packedPitch;
+    const uint32_t codecRowCount = useCompute ? computeHeight * 3u / 2u : sharedImage.desc.height;
+
+    FrameEncoder         frameEncoder;
+    std::vector<uint8_t> encodedFrame;
+
+    // Pipelined streams encode and write frames in stages on their own threads, in delivery order.
+    FramePipeline                  framePipeline;
+    std::vector<PipelineStageDesc> pipelineStages;
+    uint32_t                       encodedFrameCount = 0u;
+
+    if (pipelined && desc.pCodecThreadPool != nullptr)
+    {
+        pipelineStages.push_back({ "Encode", [&](PipelineFrame& frame)
+        {
+            const auto encodeStart = std::chrono::steady_clock::now();
+            const bool keyFrame    = encodedFrameCount++ % kFrameCodecKeyFrameInterval == 0u;
+
+            if (!frameEncoder.EncodeFrame(*desc.pCodecThreadPool, frame.pixels.data(), codecRowSize, codecRowSize, codecRowCount, keyFrame, frame.encodedFrame))
+                return false;
+
+            result.codecInputBytes  += frame.pixels.size();
+            result.codecOutputBytes += frame.encodedFrame.size();
+            result.codecSeconds     += std::chrono::duration<double>(std::chrono::steady_clock::now() - encodeStart).count();
+
+            return true;
+        } });
+    }
+
+    if (pipelined && desc.pVideoFile != nullptr)
+    {
+        pipelineStages.push_back({ "Write", [&](PipelineFrame& frame)
+        {
+            MappedImage frameImage;
+            frameImage.pData    = frame.pixels.data();
+            frameImage.rowPitch = codecRowSize;
+
+            return desc.pVideoFile->AppendFrame(frameImage, frame.frameIndex, frame.timestampNs);
+        } });
+    }
+
+    if (pipelined)
+        succeeded = succeeded && framePipeline.Start(desc.pipelineDepth, (size_t)codecRowSize * codecRowCount, pipelineStages);
+
+    result.pipelined = pipelined;
+
+    // Each delivered frame takes a slot of the video file, counted on delivery as the write stage may not have
+    // appended it yet.
+    const uint32_t firstFileFrame = desc.pVideoFile != nullptr ? desc.pVideoFile->GetFrameCount() : 0u;
+
+    ReadbackRing readbackRing;
+    succeeded = succeeded && readbackRing.Create(pBackend, sharedImage, desc.readbackDepth, [&](uint64_t frameIndex, const MappedImage& mappedImage)
+    {
+        TRACE_FRAME(frameIndex);
+        TRACE_ZONE("Deliver frame");
+
+        const auto renderSubmitTime = renderSubmitTimes[frameIndex - firstFrameIndex];
+
+        latenciesMs.push_back(GetElapsedMilliseconds(renderSubmitTime));
+
+        if (useCompute)
+            result.copiedBytes += GetPixelImageSize(GetPixelFormatTraits(PixelFormat::NV12), computeWidth, computeHeight);
+        else
+            result.copiedBytes += GetDirtyRegionPixelCount(mappedImage.pRegions, mappedImage.regionCount) * bytesPerPixel * mappedImage.layerCount;
+
+        result.fullFrameBytes += layerSize * mappedImage.layerCount;
+
+        MappedImage frameImage = mappedImage;
+
+        if (trackDamage)
+        {
+            TRACE_ZONE("Compose dirty tiles");
+
+            for (uint32_t layer = mappedImage.firstLayer; layer < mappedImage.firstLayer + mappedImage.layerCount; layer++)
+                CopyDirtyRegions(mappedImage.pRegions, mappedImage.regionCount, bytesPerPixel, GetMappedImageLayer(mappedImage, layer), mappedImage.rowPitch, composedFrame.data() + layer * layerSize, packedPitch);
+
+            frameImage.pData      = composedFrame.data() + mappedImage.firstLayer * layerSize;
+            frameImage.rowPitch   = packedPitch;
+            frameImage.layerPitch = layerSize;
+        }
+
+        // Frames are stamped with their render submit time, relative to the start of the stream.
+        const auto timestampNs = std::chrono::duration_cast<std::chrono::nanoseconds>(renderSubmitTime - streamStart).count();
+
+        if (pipelined)
+        {
+            PipelineFrame* pFrame = framePipeline.AcquireFrame();
+
+            // Ends the frame loop, which checks succeeded.
+            if (pFrame == nullptr)
+            {
+                succeeded = false;
+                return;
+            }
+
+            {
+                TRACE_ZONE("Copy pipeline frame");
+
+                for (uint32_t row = 0u; row < codecRowCount; row++)
+                    memcpy(pFrame->pixels.data() + (size_t)row * codecRowSize, (const uint8_t*)frameImage.pData + (size_t)row * frameImage.rowPitch, codecRowSize);
+            }
+
+            pFrame->frameIndex  = frameIndex;
+            pFrame->timestampNs = (uint64_t)timestampNs;
+
+            framePipeline.SubmitFrame(pFrame);
+        }
+        else if (desc.pVideoFile != nullptr)
+        {
+            TRACE_ZONE("Append video frame");
+
+            const bool appended = result.zeroCopy ? desc.pVideoFile->CommitFrame(frameIndex, (uint64_t)timestampNs) :
+                                                    desc.pVideoFile->AppendFrame(frameImage, frameIndex, (uint64_t)timestampNs);
+
+            if (!appended)
+                videoFileFull = true;
+        }
+
+        if (!pipelined && desc.pCodecThreadPool != nullptr)
+        {
+            const auto encodeStart = std::chrono::steady_clock::now();
+            const bool keyFrame    = (latenciesMs.size() - 1u) % kFrameCodecKeyFrameInterval == 0u;
+
+            if (frameEncoder.EncodeFrame(*desc.pCodecThreadPool, frameImage.pData, frameImage.rowPitch, codecRowSize, codecRowCount, keyFrame, encodedFrame))
+            {
+                result.codecInputBytes  += (uint64_t)codecRowSize * codecRowCount;
+                result.codecOutputBytes += encodedFrame.size();
+                result.codecSeconds     += std::chrono::duration<double>(std::chrono::steady_clock::now() - encodeStart).count();
+            }
+        }
+
+        // Each frame clears every layer to its own red value, checked on the first pixel the readback copied.
+        if (mappedImage.regionCount == 0u)
+            return;
+
+        // NV12 only keeps a quarter step of luma per red step, so compute readbacks are checked against the luma
+        // of the clear color within one step: this catches garbage, not a frame off by one.
+        if (useCompute)
+        {
+            const uint8_t red = (uint8_t)(frameIndex & 0xFFu);
+
+            // A 2x2 block of the clear color, the smallest NV12 image.
+            const uint8_t clearPixels[16] = { red, 128u, 255u, 255u, red, 128u, 255u, 255u, red, 128u, 255u, 255u, red, 128u, 255u, 255u };
+            uint8_t       clearBlock[6];
+
+            if (checkCleared && ConvertPixels(PixelFormat::RGBA8, clearPixels, 8u, PixelFormat::NV12, clearBlock, 2u, 2u, 2u) &&
+                std::abs((int)*(const uint8_t*)mappedImage.pData - (int)clearBlock[0]) > 1)
+                result.corruptFrames++;
+
+            return;
+        }
+
+        const DirtyRect& firstRegion = mappedImage.pRegions[0];
+
+        for (uint32_t layer = mappedImage.firstLayer; checkCleared && layer < mappedImage.firstLayer + mappedImage.layerCount; layer++)
+        {
+            const uint8_t* pFirstPixel = (const uint8_t*)GetMappedImageLayer(mappedImage, layer) + (size_t)firstRegion.y * mappedImage.rowPitch + (size_t)firstRegion.x * bytesPerPixel;
+
+            uint8_t firstPixel[4];
+            if (ConvertPixels(imageFormat, pFirstPixel, mappedImage.rowPitch, PixelFormat::RGBA8, firstPixel, 4u, 1u, 1u) &&
+                firstPixel[0] != (uint8_t)((frameIndex + layer) & 0xFFu))
+            {
+                result.corruptFrames++;
+                break;
+            }
+        }
+    });
+
+    for (uint64_t frameIndex = firstFrameIndex; succeeded && !videoFileFull && frameIndex < firstFrameIndex + frameCount; frameIndex++)
+    {
+        if (desc.durationSeconds > 0.0 && GetElapsedMilliseconds(streamStart) >= desc.durationSeconds * 1000.0)
+            break;
+
+        // Frames still in flight need a free slot in the file as well.
+        if (desc.pVideoFile != nullptr && firstFileFrame + (uint32_t)latenciesMs.size() + readbackRing.GetInFlightCount() >= desc.pVideoFile->GetFrameCapacity())
+            break;
+
+        TRACE_FRAME(frameIndex);
+        TRACE_ZONE("Frame");
+
+        VkCommandBuffer vkCommandBuffer;
+        if (!frameContexts.AcquireFrameContext(vkCommandBuffer))
+        {
+            succeeded = false;
+            break;
+        }
+
+        if (desc.prerecordFrames)
+            vkCommandBuffer = vkStaticCommandBuffers[frameIndex % kDistinctFrameCount];
+        else
+            RecordFrame(device, sharedImage, frameIndex, vkCommandBuffer, desc.pTraceQueries);
+
+        const VulkanTimelineSubmit timelineSubmit = GetFrameTimelineSubmit(sharedImage, frameIndex);
+
+        renderSubmitTimes[frameIndex - firstFrameIndex] = std::chrono::steady_clock::now();
+
+        // The tile map is turned into copy regions at submit, so it can be reused for the next frame right away.
+        if (trackDamage && frameIndex != firstFrameIndex)
+        {
+            dirtyTiles.Clear();
+            dirtyTiles.AddRect(GetFrameDirtyRect(sharedImage.desc, desc, frameIndex));
+        }
+
+        // Frames in flight are committed before this one, see above.
+        const uint64_t hostOffset = result.zeroCopy ? (uint64_t)(desc.pVideoFile->GetFrameCount() + readbackRing.GetInFlightCount()) * desc.pVideoFile->GetFrameSize() : kReadbackToSlot;
+
+        succeeded = frameContexts.SubmitFrameContext(vkCommandBuffer, timelineSubmit) &&
+                    readbackRing.Submit(frameIndex, trackDamage ? &dirtyTiles : nullptr, hostOffset) &&
+                    readbackRing.Poll();
+
+        // Frees the timestamp queries of the frames that executed.
+        TRACE_GPU_COLLECT();
+    }
+
+    succeeded = succeeded && readbackRing.Flush();
+
+    if (pipelined)
+    {
+        succeeded = framePipeline.Finish() && succeeded;
+
+        result.pipelineStats = framePipeline.GetStats();
+    }
+
+    const double streamSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - streamStart).count();
+
+    result.deliveredFrames = (uint32_t)latenciesMs.size();
+    result.framesPerSecond = latenciesMs.size() / streamSeconds;
+    result.latencyMs       = SummarizeSamples(latenciesMs);
+
+    // The static command buffers may still be in flight.
+    succeeded = frameContexts.WaitIdle() && succeeded;
+
+    if (useCompute)
+        pBackend->SetReadbackCompute(sharedImage, {});
+
+    if (result.zeroCopy)
+        pBackend->ImportReadbackHostMemory(sharedImage, nullptr, 0u);
+
+    frameContexts.FreeStaticCommandBuffers(vkStaticCommandBuffers);
+
+    return succeeded;
+}
+
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "FramePipeline.h"
+#include "InteropBackend.h"
+#include "Statistics.h"
+
+class FrameContextPool;
+class MappedVideoFile;
+class ThreadPool;
+class VulkanTraceQueries;
+
+// Test frames differ only by their red value, (frameIndex + layer) & 0xFF.
+constexpr uint32_t kDistinctFrameCount = 256u;
+
+struct FrameStreamDesc
+{
+    uint64_t firstFrameIndex = 0u;
+
+    // Upper bound on the frames rendered, the stream also ends after durationSeconds (when non-zero)
+    // or once the video file is full.
+    uint32_t frameCount      = 0u;
+    double   durationSeconds = 0.0;
+
+    uint32_t readbackDepth = 1u;
+
+    // Replay command buffers recorded once per distinct frame instead of recording every frame.
+    bool prerecordFrames = false;
+
+    // When non-zero, every frame after the first declares only a rectangle of this size dirty, sweeping the image
+    // one tile per frame, and reads back its tiles alone. Test frames still clear the whole image.
+    uint32_t dirtyRectWidth  = 0u;
+    uint32_t dirtyRectHeight = 0u;
+
+    // Optional readback compute stage, set on the shared image for the stream and disabled after it. Frames then
+    // reach the video file as NV12 of GetReadbackComputeExtent, and damage tracking is not used.
+    ReadbackComputeDesc readbackCompute;
+
+    // Optional sink, each delivered frame is appended to it (the first layer it read back, for array images).
+    MappedVideoFile* pVideoFile = nullptr;
+
+    // Read frames back straight into their slot of the video file, imported as host memory, instead of copying them
+    // there on delivery. Only applies to files storing frames unconverted, single layer images and streams without
+    // damage tracking, and falls back to copies where the backend cannot import the file's mapping.
+    bool zeroCopy = false;
+
+    // Optional transport codec: each delivered frame (the first layer it read back) is delta encoded on these
+    // threads, as before leaving for another process or the disk, with a key frame every kFrameCodecKeyFrameInterval.
+    // Encoded frames are measured, then dropped.
+    ThreadPool* pCodecThreadPool = nullptr;
+
+    // When non-zero, delivered frames are copied out of their readback slot into one of pipelineDepth frames of a
+    // FramePipeline, whose encode (transport codec) and write (video file) stages run on their own threads. Rendering
+    // and readbacks then only wait for them once every frame is taken. Zero runs both on delivery, on the calling
+    // thread. Applies when there is a codec or a video file, and not to zero-copy readbacks.
+    uint32_t pipelineDepth = 0u;
+
+    // Optional GPU zones of the frame commands, on the graphics queue. Pre-recorded frames are not traced.
+    VulkanTraceQueries* pTraceQueries = nullptr;
+};
+
+struct FrameStreamResult
+{
+    uint32_t      deliveredFrames  = 0u;
+    double        framesPerSecond  = 0.0;
+    SampleSummary latencyMs;
+    uint32_t      corruptFrames    = 0u;
+
+    // Bytes the readbacks copied, against the bytes of copying every frame whole.
+    uint64_t      copiedBytes      = 0u;
+    uint64_t      fullFrameBytes   = 0u;
+
+    // Whether frames were read back in place into the video file.
+    bool          zeroCopy         = false;
+
+    // Bytes into and out of the transport codec, and the time it spent encoding.
+    uint64_t      codecInputBytes  = 0u;
+    uint64_t      codecOutputBytes = 0u;
+    double        codecSeconds     = 0.0;
+
+    // Stage occupancy and queue depths, when frames went through a pipeline.
+    bool               pipelined = false;
+    FramePipelineStats pipelineStats;
+};
+
+// Records the commands of test frame frameIndex: clears each layer of the shared image to a red value of
+// (frameIndex + layer) & 0xFF and releases the image to the exporter. pTraceQueries, if not null, times the barrier,
+// clears and release on the GPU.
+void RecordFrameCommands(const VulkanDevice& device, const SharedImage& sharedImage, uint64_t frameIndex, VkCommandBuffer vkCommandBuffer, VulkanTraceQueries* pTraceQueries = nullptr);
+
+// Begins vkCommandBuffer for a single submission, records the frame and ends it.
+void RecordFrame(const VulkanDevice& device, const SharedImage& sharedImage, uint64_t frameIndex, VkCommandBuffer vkCommandBuffer, VulkanTraceQueries* pTraceQueries = nullptr);
+
+// Records every distinct test frame once into static command buffers of the pool, indexed by frameIndex % kDistinctFrameCount.
+bool RecordStaticFrames(FrameContextPool& frameContexts, const VulkanDevice& device, const SharedImage& sharedImage, std::vector<VkCommandBuffer>& vkCommandBuffers);
+
+// Render wait and signal values of frameIndex on the shared image timeline.
+VulkanTimelineSubmit GetFrameTimelineSubmit(const SharedImage& sharedImage, uint64_t frameIndex);
+
+// Renders frames into the shared image and reads each of them back through a ring of readbackDepth slots.
+// With damage tracking the frames are composed on the CPU from their changed tiles before reaching the video file.
+// Latency is measured from the render submit to the pixels on the CPU. Frames are submitted through the frame
+// contexts of the calling thread, which are grown to readbackDepth + 1 if needed.
+bool RunFrameStream(InteropBackend* pBackend, const VulkanDevice& device, FrameContextPool& frameContexts, const SharedImage& sharedImage, const FrameStreamDesc& desc, FrameStreamResult& result);
+
+void LogFrameStreamResult(uint32_t readbackDepth, const FrameStreamResult& result);
@@ -0,0 +1,128 @@
+#include "ImportCache.h"
+
+static bool operator==(const SharedImageDesc& a, const SharedImageDesc& b)
+{
+    return a.width == b.width && a.height == b.height && a.format == b.format && a.arrayLayers == b.arrayLayers;
+}
+
+void ImportCache::SetBudget(VkDeviceSize budget)
+{
+    m_budget = budget;
+
+    Trim();
+}
+
+bool ImportCache::Acquire(const SharedImageDesc& desc, uint64_t& resourceId, ImportedImage& importedImage)
+{
+    for (auto entry = m_entries.begin(); entry != m_entries.end(); entry++)
+    {
+        if (entry->inUse || !(entry->key.desc == desc))
+            continue;
+
+        entry->inUse = true;
+
+        resourceId    = entry->key.resourceId;
+        importedImage = entry->importedImage;
+
+        m_entries.splice(m_entries.begin(), m_entries, entry);
+        m_hits++;
+
+        return true;
+    }
+
+    m_misses++;
+
+    return false;
+}
+
+void ImportCache::Insert(const ImportCacheKey& key, const ImportedImage& importedImage)
+{
+    Entry entry;
+    entry.key           = key;
+    entry.importedImage = importedImage;
+
+    m_entries.push_front(entry);
+    m_residentBytes += importedImage.size;
+
+    Trim();
+}
+
+void ImportCache::Release(uint64_t resourceId)
+{
+    for (auto entry = m_entries.begin(); entry != m_entries.end(); entry++)
+    {
+        if (entry->key.resourceId != resourceId)
+            continue;
+
+        entry->inUse = false;
+
+        m_entries.splice(m_entries.begin(), m_entries, entry);
+        break;
+    }
+
+    Trim();
+}
+
+void ImportCache::RecordBind(bool hit, double milliseconds)
+{
+    (hit ? m_hitBindMs : m_missBindMs).push_back(milliseconds);
+}
+
+ImportCacheCounters ImportCache::GetCounters() const
+{
+    ImportCacheCounters counters;
+    counters.hits          = m_hits;
+    counters.misses        = m_misses;
+    counters.evictions     = m_evictions;
+    counters.residentBytes = m_residentBytes;
+
+    // SummarizeSamples sorts in place.
+    std::vector<double> hitBindMs  = m_hitBindMs;
+    std::vector<double> missBindMs = m_missBindMs;
+
+    counters.hitBindMs  = SummarizeSamples(hitBindMs);
+    counters.missBindMs = SummarizeSamples(missBindMs);
+
+    return counters;
+}
+
+void ImportCache::Clear()
+{
+    while (!m_entries.empty())
+        Evict(std::prev(m_entries.end()));
+}
+
+void ImportCache::Evict(std::list<Entry>::iterator entry)
+{
+    const ImportedImage& importedImage = entry->importedImage;
+
+    vkDestroyImage (importedImage.vkDevice, importedImage.vkImage,       nullptr);
+    vkFreeMemory   (importedImage.vkDevice, importedImage.vkImageMemory, nullptr);
+
+    const uint64_t resourceId = entry->key.resourceId;
+
+    m_residentBytes -= importedImage.size;
+    m_evictions++;
+
+    m_entries.erase(entry);
+
+    m_evictCallback(resourceId);
+}
+
+void ImportCache::Trim()
+{
+    auto entry = m_entries.end();
+
+    while (m_residentBytes > m_budget && entry != m_entries.begin())
+    {
+        entry--;
+
+        if (entry->inUse)
+            continue;
+
+        // Erasing invalidates the iterator, continue from the following (more recently used) entry.
+        auto nextEntry = std::next(entry);
+        Evict(entry);
+        entry = nextEntry;
+    }
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <functional>
+#include <list>
+
+#include "InteropBackend.h"
+#include "Statistics.h"
+
+// Imports kept around once their shared image was destroyed, up to this many bytes.
+constexpr VkDeviceSize kImportCacheDefaultBudget = 512ull << 20;
+
+// An exporter-side resource (identified by the backend) viewed through one image description.
+struct ImportCacheKey
+{
+    uint64_t        resourceId = 0u;
+    SharedImageDesc desc;
+};
+
+// Importer-side image bound to the memory of an exporter resource.
+struct ImportedImage
+{
+    VkDevice       vkDevice      = VK_NULL_HANDLE;
+    VkImage        vkImage       = VK_NULL_HANDLE;
+    VkDeviceMemory vkImageMemory = VK_NULL_HANDLE;
+    VkDeviceSize   size          = 0u;
+};
+
+struct ImportCacheCounters
+{
+    uint64_t      hits          = 0u;
+    uint64_t      misses        = 0u;
+    uint64_t      evictions     = 0u;
+    VkDeviceSize  residentBytes = 0u;
+
+    // Shared image creation time (ms) when the import was reused or had to be created.
+    SampleSummary hitBindMs;
+    SampleSummary missBindMs;
+};
+
+// Called after an entry's image and memory were destroyed, so the backend can free the exporter resource.
+using ImportEvictCallback = std::function<void(uint64_t resourceId)>;
+
+// Keeps the VkImage/VkDeviceMemory pair of exporter resources whose shared image was destroyed, so that
+// re-creating a shared image of the same description skips the export, the import and the dedicated
+// allocation. Idle entries are evicted least recently used first once the resident size exceeds the budget.
+// Entries in use are never evicted. A backend holds a few dozen resources at most, so lookups are linear.
+class ImportCache
+{
+public:
+    explicit ImportCache(ImportEvictCallback evictCallback) : m_evictCallback(std::move(evictCallback)) {}
+
+    // Evicts idle entries right away if they no longer fit.
+    void SetBudget(VkDeviceSize budget);
+
+    // Reuses the most recently released idle import described by desc and marks it in use.
+    bool Acquire(const SharedImageDesc& desc, uint64_t& resourceId, ImportedImage& importedImage);
+
+    // Adds a new import, in use.
+    void Insert(const ImportCacheKey& key, const ImportedImage& importedImage);
+
+    // Marks an import idle, it stays resident until evicted.
+    void Release(uint64_t resourceId);
+
+    void RecordBind(bool hit, double milliseconds);
+
+    ImportCacheCounters GetCounters() const;
+
+    // Destroys every entry, in use or not.
+    void Clear();
+
+private:
+    struct Entry
+    {
+        ImportCacheKey key;
+        ImportedImage  importedImage;
+        bool           inUse = true;
+    };
+
+    void Evict(std::list<Entry>::iterator entry);
+
+    void Trim();
+
+    ImportEvictCallback m_evictCallback;
+    VkDeviceSize        m_budget        = kImportCacheDefaultBudget;
+    VkDeviceSize        m_residentBytes = 0u;
+
+    // Most recently used first.
+    std::list<Entry>    m_entries;
+
+    uint64_t            m_hits      = 0u;
+    uint64_t            m_misses    = 0u;
+    uint64_t            m_evictions = 0u;
+
+    std::vector<double> m_hitBindMs;
+    std::vector<double> m_missBindMs;
+};
@@ -0,0 +1,76 @@
+#include "InteropBackend.h"
+
+#include <cstring>
+
+#include <spdlog/spdlog.h>
+
+InteropBackendType GetDefaultInteropBackendType()
+{
+#if defined(_WIN32)
+    return InteropBackendType::D3D11;
+#else
+    return InteropBackendType::OpaqueFd;
+#endif
+}
+
+bool ParseInteropBackendType(const char* pName, InteropBackendType& type)
+{
+    if (!strcmp(pName, "d3d11"))
+        type = InteropBackendType::D3D11;
+    else if (!strcmp(pName, "opaque-fd"))
+        type = InteropBackendType::OpaqueFd;
+    else if (!strcmp(pName, "host-copy"))
+        type = InteropBackendType::HostCopy;
+    else
+        return false;
+
+    return true;
+}
+
+bool ValidateSharedImageDesc(const SharedImageDesc& desc)
+{
+    const PixelFormatTraits* pTraits = FindPixelFormatTraits(desc.format);
+
+    if (pTraits == nullptr || !pTraits->IsShareable())
+    {
+        spdlog::error("Shared images cannot use VkFormat {}.", (int)desc.format);
+        return false;
+    }
+
+    if (desc.width == 0u || desc.height == 0u)
+    {
+        spdlog::error("Shared images cannot be {}x{}.", desc.width, desc.height);
+        return false;
+    }
+
+    if (desc.arrayLayers == 0u)
+    {
+        spdlog::error("Shared images need at least one array layer.");
+        return false;
+    }
+
+    return true;
+}
+
+void GetSharedImageReadbackRegions(const SharedImageDesc& desc, const DirtyTileMap* pDirtyTiles, std::vector<DirtyRect>& regions)
+{
+    if (pDirtyTiles != nullptr)
+        pDirtyTiles->GetDirtyRegions(regions);
+    else
+        regions.assign(1u, { 0u, 0u, desc.width, desc.height });
+}
+
+std::unique_ptr<InteropBackend> CreateInteropBackend(InteropBackendType type)
+{
+    switch (type)
+    {
+#if defined(_WIN32)
+        case InteropBackendType::D3D11:    return CreateD3D11InteropBackend();
+#else
+        case InteropBackendType::OpaqueFd: return CreateVulkanInteropBackend(false);
+#endif
+        case InteropBackendType::HostCopy: return CreateVulkanInteropBackend(true);
+
+        default: return nullptr;
+    }
+}
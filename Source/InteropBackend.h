@@ -0,0 +1,272 @@
+#pragma once
+
+#include <memory>
+
+#include "DirtyTiles.h"
+#include "PixelFormat.h"
+#include "SharedMemoryArena.h"
+#include "Vulkan.h"
+
+class ImportCache;
+
+#if defined(_WIN32)
+// NT HANDLE produced by IDXGIResource1::CreateSharedHandle / vkGetMemoryWin32HandleKHR.
+using ExternalMemoryHandle = void*;
+constexpr ExternalMemoryHandle kInvalidExternalMemoryHandle = nullptr;
+#else
+// POSIX file descriptor produced by vkGetMemoryFdKHR.
+using ExternalMemoryHandle = int;
+constexpr ExternalMemoryHandle kInvalidExternalMemoryHandle = -1;
+#endif
+
+// Semaphores are shared through the same kind of OS handle as memory.
+using ExternalSemaphoreHandle = ExternalMemoryHandle;
+
+enum class InteropBackendType
+{
+    // Windows: D3D11 texture exported as an NT handle and imported with VK_KHR_external_memory_win32.
+    D3D11,
+
+    // Linux: memory of a second Vulkan device exported as an opaque file descriptor (VK_KHR_external_memory_fd).
+    OpaqueFd,
+
+    // Baseline: no memory is shared, pixels travel GPU -> host -> GPU between the two devices.
+    HostCopy,
+};
+
+struct SharedImageDesc
+{
+    uint32_t width  = 0u;
+    uint32_t height = 0u;
+    VkFormat format = VK_FORMAT_R8G8B8A8_UNORM;
+
+    // Batches of surfaces are shared as one array image: a single export, import, timeline and barrier for all of
+    // them, and every layer read back by a single copy.
+    uint32_t arrayLayers = 1u;
+};
+
+// Logs and returns false unless format is a single plane format of kPixelFormatTraits and the image has at least one layer.
+bool ValidateSharedImageDesc(const SharedImageDesc& desc);
+
+// Traits of a validated shared image format.
+inline const PixelFormatTraits& GetSharedImageFormatTraits(const SharedImageDesc& desc)
+{
+    return *FindPixelFormatTraits(desc.format);
+}
+
+// Tightly packed row pitch and size of a shared image, of one layer and of all of them.
+inline uint32_t GetSharedImageRowPitch(const SharedImageDesc& desc)
+{
+    return GetPixelPlaneRowPitch(GetSharedImageFormatTraits(desc), 0u, desc.width);
+}
+
+inline VkDeviceSize GetSharedImageLayerSize(const SharedImageDesc& desc)
+{
+    return (VkDeviceSize)GetSharedImageRowPitch(desc) * desc.height;
+}
+
+inline VkDeviceSize GetSharedImageSize(const SharedImageDesc& desc)
+{
+    return GetSharedImageLayerSize(desc) * desc.arrayLayers;
+}
+
+// Shareable formats have a single plane of one pixel blocks.
+inline uint32_t GetSharedImageBytesPerPixel(const SharedImageDesc& desc)
+{
+    return GetSharedImageFormatTraits(desc).planes[0].bytesPerBlock;
+}
+
+// Optional compute stage of a readback, run on the exporter's GPU before the copy to the host: a box filter over
+// downscale x downscale pixels, then conversion to NV12 (BT.601 limited range, as ConvertPixels). 1080p RGBA8 frames
+// shrink from 8 MiB to 3 MiB, or 0.75 MiB when also halved.
+struct ReadbackComputeDesc
+{
+    bool     enabled   = false;
+
+    // 1, 2 or 4.
+    uint32_t downscale = 1u;
+};
+
+// Size of the NV12 frames a readback compute stage delivers: the downscaled image, cropped to a multiple of 4
+// pixels wide and 2 high. Returns false for unsupported factors or images that end up empty.
+inline bool GetReadbackComputeExtent(const SharedImageDesc& desc, const ReadbackComputeDesc& computeDesc, uint32_t& width, uint32_t& height)
+{
+    if (computeDesc.downscale != 1u && computeDesc.downscale != 2u && computeDesc.downscale != 4u)
+        return false;
+
+    width  = (desc.width  / computeDesc.downscale) & ~3u;
+    height = (desc.height / computeDesc.downscale) & ~1u;
+
+    return width > 0u && height > 0u;
+}
+
+// Readbacks copy into their slot's own staging buffer unless SubmitReadback is given an offset into host memory
+// imported with ImportReadbackHostMemory.
+constexpr uint64_t kReadbackToSlot = UINT64_MAX;
+
+// Regions a readback copies: the dirty tiles, or the whole image without a tile map.
+void GetSharedImageReadbackRegions(const SharedImageDesc& desc, const DirtyTileMap* pDirtyTiles, std::vector<DirtyRect>& regions);
+
+// Importer-side (Vulkan) view of an image whose memory is owned by the backend's exporting API.
+struct SharedImage
+{
+    SharedImageDesc desc;
+
+    VkImage        vkImage       = VK_NULL_HANDLE;
+
+    // Null when the image is suballocated from the backend's memory arena, which owns the memory.
+    VkDeviceMemory vkImageMemory = VK_NULL_HANDLE;
+
+    // Importer-side handle of the timeline shared with the exporter, see GetSharedImageRenderWaitValue.
+    VkSemaphore    vkTimelineSemaphore = VK_NULL_HANDLE;
+
+    // Index of the exporter-side resource held by the backend.
+    uint32_t exporterIndex = UINT_MAX;
+};
+
+// Timeline values of a shared image for frame N: the importer starts rendering once the timeline reached 2N and
+// signals 2N + 1 when done; the exporter reads after 2N + 1 and signals 2N + 2 once the image may be overwritten.
+// Each side only ever waits for the one value it needs, so neither has to drain its device.
+constexpr uint64_t GetSharedImageRenderWaitValue(uint64_t frameIndex)   { return 2u * frameIndex; }
+constexpr uint64_t GetSharedImageRenderSignalValue(uint64_t frameIndex) { return 2u * frameIndex + 1u; }
+constexpr uint64_t GetSharedImageReadSignalValue(uint64_t frameIndex)   { return 2u * frameIndex + 2u; }
+
+// CPU pointer to the exporter-side copy of a shared image.
+struct MappedImage
+{
+    const void* pData    = nullptr;
+    uint32_t    rowPitch = 0u;
+
+    // Regions the readback copied, in place at their position in the image. Outside of them the contents are
+    // those of whichever frame last copied there.
+    const DirtyRect* pRegions    = nullptr;
+    uint32_t         regionCount = 0u;
+
+    // Layers the readback copied, see SetReadbackLayers, layerPitch bytes apart from pData on. The regions apply to
+    // each of them.
+    uint32_t     firstLayer = 0u;
+    uint32_t     layerCount = 1u;
+    VkDeviceSize layerPitch = 0u;
+};
+
+// CPU pointer to layer of a mapped image, which must be one of the layers the readback copied.
+inline const void* GetMappedImageLayer(const MappedImage& mappedImage, uint32_t layer)
+{
+    return (const uint8_t*)mappedImage.pData + (layer - mappedImage.firstLayer) * mappedImage.layerPitch;
+}
+
+// The "other side" of the interop: the API that owns and exports image memory, and that reads the
+// image back once the importing Vulkan device is done with it (D3D11 on Windows, a second Vulkan
+// device on Linux).
+//
+// Call order: CreateExporter -> SelectPhysicalDevice -> (create importer device) -> CreateSharedImage.
+// The importer is expected to leave shared images in VK_IMAGE_LAYOUT_GENERAL, released to
+// VK_QUEUE_FAMILY_EXTERNAL, and to signal the shared image timeline once its frame is rendered.
+class InteropBackend
+{
+public:
+    virtual ~InteropBackend() = default;
+
+    virtual const char* GetName() const = 0;
+
+    // Creates the exporting device.
+    virtual bool CreateExporter(VkInstance vkInstance) = 0;
+
+    // Creates the pipeline cache of the exporting device, which builds the readback compute stage, with the data of
+    // an earlier SavePipelineCache (see CreateVulkanPipelineCache). Call after CreateExporter.
+    virtual bool LoadPipelineCache(const char* pFileName) = 0;
+
+    // Returns false if the backend has no pipeline cache to save.
+    virtual bool SavePipelineCache(const char* pFileName) = 0;
+
+    // Device extensions the importing Vulkan device must enable.
+    virtual void GetRequiredDeviceExtensions(std::vector<const char*>& requiredExtensions) const = 0;
+
+    // Selects the Vulkan physical device that is able to import memory exported by this backend.
+    virtual bool SelectPhysicalDevice(VkInstance vkInstance, const std::vector<const char*>& requiredExtensions, VkPhysicalDevice& vkPhysicalDevice) = 0;
+
+    // Allocates an exportable image on the exporter and binds its memory to a Vulkan image on the importer.
+    virtual bool CreateSharedImage(const VulkanDevice& importer, const SharedImageDesc& desc, SharedImage& sharedImage) = 0;
+
+    // Grows the number of exporter-side readback slots of a shared image (CreateSharedImage creates one).
+    virtual bool CreateReadbackSlots(const SharedImage& sharedImage, uint32_t slotCount) = 0;
+
+    // Queues a copy of frame frameIndex into a readback slot and returns without waiting for it. The exporter
+    // waits for GetSharedImageRenderSignalValue(frameIndex) on the GPU and signals
+    // GetSharedImageReadSignalValue(frameIndex) as soon as its copy of the image finished. The slot must not be mapped.
+    // With pDirtyTiles only the dirty tiles are copied, with one region copy per run of tiles; the map is not kept.
+    // With a hostOffset the frame lands at that offset of the imported host memory instead of in the slot, packed
+    // as in the slot, and MapReadback points there. hostOffset must be a multiple of the bytes per pixel.
+    // The layers of SetReadbackLayers are copied together, by the same submission.
+    virtual bool SubmitReadback(const SharedImage& sharedImage, uint64_t frameIndex, uint32_t slotIndex, const DirtyTileMap* pDirtyTiles = nullptr, uint64_t hostOffset = kReadbackToSlot) = 0;
+
+    // Alignment of the address and size of the host memory ImportReadbackHostMemory accepts, or 0 when the backend
+    // cannot copy into host memory it did not allocate.
+    virtual uint64_t GetReadbackHostMemoryAlignment() const = 0;
+
+    // Imports size bytes of application memory (a mapped file, an encoder's input buffer) as a readback destination
+    // of the shared image, so that frames are copied by the GPU straight to where they are consumed. Replaces the
+    // previous import; a null pHostMemory only releases it. Waits for the image's readbacks in flight. The memory
+    // must stay allocated until released, or until the shared image is destroyed.
+    virtual bool ImportReadbackHostMemory(const SharedImage& sharedImage, void* pHostMemory, uint64_t size) = 0;
+
+    // Runs a compute stage in every later readback of the shared image, or none when computeDesc is disabled. Mapped
+    // readbacks then hold the NV12 frame of GetReadbackComputeExtent, luma rows rowPitch apart followed by the chroma
+    // plane, as a single region; dirty tiles are ignored. Returns false if the backend has no compute stage, the
+    // image is then read back as is.
+    virtual bool SetReadbackCompute(const SharedImage& sharedImage, const ReadbackComputeDesc& computeDesc) = 0;
+
+    // Restricts later readbacks of an array image to layerCount layers from firstLayer on, packed one after the other
+    // in the slot (all layers by default). Returns false for a range outside of the image, or with a compute stage,
+    // which only reads back single layer images.
+    virtual bool SetReadbackLayers(const SharedImage& sharedImage, uint32_t firstLayer, uint32_t layerCount) = 0;
+
+    // Returns true once the last copy submitted to the slot completed. Never blocks.
+    virtual bool IsReadbackComplete(const SharedImage& sharedImage, uint32_t slotIndex) = 0;
+
+    // Maps a readback slot for the CPU, blocking until its copy completed.
+    virtual bool MapReadback(const SharedImage& sharedImage, uint32_t slotIndex, MappedImage& mappedImage) = 0;
+
+    virtual void UnmapReadback(const SharedImage& sharedImage, uint32_t slotIndex) = 0;
+
+    // Synchronous readback of frame frameIndex through slot 0.
+    bool MapSharedImage(const SharedImage& sharedImage, uint64_t frameIndex, MappedImage& mappedImage)
+    {
+        return SubmitReadback(sharedImage, frameIndex, 0u) && MapReadback(sharedImage, 0u, mappedImage);
+    }
+
+    void UnmapSharedImage(const SharedImage& sharedImage) { UnmapReadback(sharedImage, 0u); }
+
+    // Destroying a shared image keeps its exporter resource and import in the cache, a later CreateSharedImage
+    // with the same description reuses them.
+    virtual void DestroySharedImage(const VulkanDevice& importer, SharedImage& sharedImage) = 0;
+
+    virtual ImportCache& GetImportCache() = 0;
+
+    // Chooses between suballocating shared images from a few large exported blocks (the default where supported)
+    // and a dedicated exported allocation per image. Applies to shared images created afterwards. Returns false
+    // if the backend does not support the requested mode.
+    virtual bool EnableMemoryArena(bool enabled) = 0;
+
+    // Arena blocks and allocations, plus the images holding dedicated memory.
+    virtual SharedMemoryArenaStats GetMemoryArenaStats() const = 0;
+
+    // Submissions made by readbacks so far, to the exporter's queues (and the importer's, for host copies) with
+    // Vulkan, flushes of the immediate context with D3D11.
+    virtual uint64_t GetReadbackSubmitCount() const = 0;
+
+    // Destroys the exporting device. All shared images must have been destroyed.
+    virtual void Release() = 0;
+};
+
+InteropBackendType GetDefaultInteropBackendType();
+
+bool ParseInteropBackendType(const char* pName, InteropBackendType& type);
+
+std::unique_ptr<InteropBackend> CreateInteropBackend(InteropBackendType type);
+
+#if defined(_WIN32)
+std::unique_ptr<InteropBackend> CreateD3D11InteropBackend();
+#endif
+
+std::unique_ptr<InteropBackend> CreateVulkanInteropBackend(bool useHostCopy);
@@ -0,0 +1,579 @@
+#include <dxgi.h>
+#include <dxgidebug.h>
+#include <dxgi1_6.h>
+
+#include <d3d11.h>
+#include <d3d11_4.h>
+
+#include <wrl.h>
+#include <chrono>
+#include <cstring>
+
+#include <spdlog/spdlog.h>
+
+#include "ExternalImage.h"
+#include "ImportCache.h"
+#include "InteropBackend.h"
+
+using namespace Microsoft::WRL;
+
+static bool SelectDXGIAdapter(IDXGIAdapter1** ppSelectedAdapter)
+{
+    ComPtr<IDXGIFactory1> pFactory;
+    if (!SUCCEEDED(CreateDXGIFactory1(IID_PPV_ARGS(&pFactory))))
+        return false;
+
+    UINT selectedAdapterIndex = UINT_MAX;
+
+    // Select DXGI adapter based on the one that has the most dedicated video memory.
+    SIZE_T dedicatedVideoMemory = 0u;
+
+    ComPtr<IDXGIAdapter1> pAdapter;
+    for (UINT i = 0; pFactory->EnumAdapters1(i, &pAdapter) != DXGI_ERROR_NOT_FOUND; ++i)
+    {
+        DXGI_ADAPTER_DESC adapterDesc;
+        pAdapter->GetDesc(&adapterDesc);
+
+        if (adapterDesc.DedicatedVideoMemory < dedicatedVideoMemory)
+            continue;
+
+        // Update largest video memory found so far.
+        dedicatedVideoMemory = adapterDesc.DedicatedVideoMemory;
+
+        // Update the selected adapter index for the current most dedicated VRAM found.
+        selectedAdapterIndex = i;
+    }
+
+    if (pFactory->EnumAdapters1(selectedAdapterIndex, ppSelectedAdapter) == DXGI_ERROR_NOT_FOUND)
+        return false;
+
+    DXGI_ADAPTER_DESC selectedAdapterDesc;
+    (*ppSelectedAdapter)->GetDesc(&selectedAdapterDesc);
+
+    spdlog::info(L"Selected DXGI Adapter: {}", selectedAdapterDesc.Description);
+
+    return true;
+}
+
+static bool SelectVulkanPhysicalDevice(const VkInstance& vkInstance, const std::vector<const char*> requiredExtensions, IDXGIAdapter* pDXGIAdapter, VkPhysicalDevice& vkPhysicalDevice)
+{
+    uint32_t deviceCount = 0u;
+    vkEnumeratePhysicalDevices(vkInstance, &deviceCount, nullptr);
+
+    std::vector<VkPhysicalDevice> vkPhysicalDevices(deviceCount);
+    vkEnumeratePhysicalDevices(vkInstance, &deviceCount, vkPhysicalDevices.data());
+
+    DXGI_ADAPTER_DESC selectedAdapterDesc;
+    pDXGIAdapter->GetDesc(&selectedAdapterDesc);
+
+    static_assert(sizeof(selectedAdapterDesc.AdapterLuid) == VK_LUID_SIZE);
+
+    vkPhysicalDevice = VK_NULL_HANDLE;
+
+    for (const auto& physicalDevice : vkPhysicalDevices)
+    {
+        // The LUID identifies the adapter itself, so identical GPUs (with identical names) are told apart.
+        VkPhysicalDeviceIDProperties vkIDProperties;
+        GetVulkanPhysicalDeviceIDProperties(physicalDevice, vkIDProperties);
+
+        if (!vkIDProperties.deviceLUIDValid || memcmp(vkIDProperties.deviceLUID, &selectedAdapterDesc.AdapterLuid, VK_LUID_SIZE))
+            continue;
+
+        // Found the matching Vulkan Physical Device for the existing DXGI Adapter.
+        vkPhysicalDevice = physicalDevice;
+
+        break;
+    }
+
+    if (vkPhysicalDevice == VK_NULL_HANDLE)
+        return false;
+
+    // Confirm that the selected physical device supports the required extensions.
+    return CheckVulkanDeviceExtensions(vkPhysicalDevice, requiredExtensions);
+}
+
+// D3D11 shared textures are always dedicated allocations: they cannot be suballocated from a memory arena.
+static bool BindD3D11ImageToVulkanImage(const VulkanDevice& importer, ID3D11Texture2D* pImageDX, const SharedImageDesc& desc, VkDeviceMemory& vkImageMemory, VkImage& vkImage, VkDeviceSize& allocationSize)
+{
+    const VkDevice vkLogicalDevice = importer.vkLogicalDevice;
+
+    VkExternalMemoryImageCreateInfo vkExternalMemoryImageCreateInfo = { VK_STRUCTURE_TYPE_EXTERNAL_MEMORY_IMAGE_CREATE_INFO };
+    vkExternalMemoryImageCreateInfo.handleTypes = VK_EXTERNAL_MEMORY_HANDLE_TYPE_D3D11_TEXTURE_BIT;
+
+    VkImageCreateInfo vkImageCreateInfo = { VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
+    {
+        vkImageCreateInfo.pNext       = &vkExternalMemoryImageCreateInfo;
+        vkImageCreateInfo.format      = desc.format;
+        vkImageCreateInfo.imageType   = VK_IMAGE_TYPE_2D;
+        vkImageCreateInfo.arrayLayers = desc.arrayLayers;
+        vkImageCreateInfo.mipLevels   = 1u;
+        vkImageCreateInfo.extent      = { desc.width, desc.height, 1};
+        vkImageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        vkImageCreateInfo.samples     = VK_SAMPLE_COUNT_1_BIT;
+        vkImageCreateInfo.usage       = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    }
+
+    if (vkCreateImage(vkLogicalDevice, &vkImageCreateInfo, nullptr, &vkImage) != VK_SUCCESS)
+        return false;
+
+    VkMemoryRequirements vkMemoryRequirements;
+    vkGetImageMemoryRequirements(vkLogicalDevice, vkImage, &vkMemoryRequirements);
+
+    allocationSize = vkMemoryRequirements.size;
+
+    // Open a shareable handle to D3D11 Image Resource.
+    ComPtr<IDXGIResource1> pSharedResource;
+    if (!SUCCEEDED(pImageDX->QueryInterface(IID_PPV_ARGS(pSharedResource.GetAddressOf()))))
+        return false;
+
+    HANDLE sharedHandle;
+    if (!SUCCEEDED(pSharedResource->CreateSharedHandle(nullptr, DXGI_SHARED_RESOURCE_READ | DXGI_SHARED_RESOURCE_WRITE, nullptr, &sharedHandle)))
+        return false;
+
+    // Bind the Vulkan Memory Allocation to the exported D3D11 Image Resource Handle.
+    VkMemoryWin32HandlePropertiesKHR vkImportedHandleProperties = { VK_STRUCTURE_TYPE_MEMORY_WIN32_HANDLE_PROPERTIES_KHR };
+    if (vkGetMemoryWin32HandlePropertiesKHR(vkLogicalDevice, VK_EXTERNAL_MEMORY_HANDLE_TYPE_D3D11_TEXTURE_BIT, sharedHandle, &vkImportedHandleProperties) != VK_SUCCESS)
+    {
+        CloseHandle(sharedHandle);
+        return false;
+    }
+
+    // The memory type must be one the handle can be imported as and the image can be bound to.
+    const uint32_t memoryTypeBits = vkImportedHandleProperties.memoryTypeBits & vkMemoryRequirements.memoryTypeBits;
+
+    uint32_t memoryTypeIndex;
+    if (!FindVulkanMemoryTypeIndex(importer.vkPhysicalDevice, memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, memoryTypeIndex) &&
+        !FindVulkanMemoryTypeIndex(importer.vkPhysicalDevice, memoryTypeBits, 0u, memoryTypeIndex))
+    {
+        CloseHandle(sharedHandle);
+        return false;
+    }
+
+    // Specify that the provided Vulkan Image is the only one that can be used with the D3D11 Image memory.
+    VkMemoryDedicatedAllocateInfo vkDedicatedAllocateInfo = { VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO };
+    vkDedicatedAllocateInfo.image = vkImage;
+
+    VkImportMemoryWin32HandleInfoKHR vkImportedHandleInfo = { VK_STRUCTURE_TYPE_IMPORT_MEMORY_WIN32_HANDLE_INFO_KHR };
+    vkImportedHandleInfo.handleType = VK_EXTERNAL_MEMORY_HANDLE_TYPE_D3D11_TEXTURE_BIT;
+    vkImportedHandleInfo.handle     = sharedHandle;
+    vkImportedHandleInfo.pNext      = &vkDedicatedAllocateInfo;
+
+    VkMemoryAllocateInfo vkImportAllocateInfo = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
+    vkImportAllocateInfo.pNext           = &vkImportedHandleInfo;
+    vkImportAllocateInfo.memoryTypeIndex = memoryTypeIndex;
+
+    const bool imported = vkAllocateMemory(vkLogicalDevice, &vkImportAllocateInfo, nullptr, &vkImageMemory) == VK_SUCCESS;
+
+    // Importing a Win32 handle does not take ownership of it, the allocation keeps the texture alive.
+    CloseHandle(sharedHandle);
+
+    if (!imported)
+        return false;
+
+    // Bind the Vulkan Image to the Memory.
+    vkBindImageMemory(vkLogicalDevice, vkImage, vkImageMemory, 0u);
+
+    return true;
+}
+
+// Shares a D3D11 fence with Vulkan as the timeline semaphore of a shared image.
+static bool ShareD3D11FenceWithVulkan(const VulkanDevice& importer, ID3D11Device5* pDeviceDX, ID3D11Fence** ppFenceDX, VkSemaphore& vkSemaphore)
+{
+    if (!SUCCEEDED(pDeviceDX->CreateFence(0u, D3D11_FENCE_FLAG_SHARED, IID_PPV_ARGS(ppFenceDX))))
+        return false;
+
+    HANDLE sharedHandle;
+    if (!SUCCEEDED((*ppFenceDX)->CreateSharedHandle(nullptr, GENERIC_ALL, nullptr, &sharedHandle)))
+        return false;
+
+    if (!CreateVulkanTimelineSemaphore(importer, 0u, vkSemaphore))
+    {
+        CloseHandle(sharedHandle);
+        return false;
+    }
+
+    const bool imported = ImportVulkanSemaphoreHandle(importer, vkSemaphore, VK_EXTERNAL_SEMAPHORE_HANDLE_TYPE_D3D11_FENCE_BIT, sharedHandle);
+
+    // Win32 handles are not consumed by the import.
+    CloseHandle(sharedHandle);
+
+    return imported;
+}
+
+class D3D11InteropBackend final : public InteropBackend
+{
+public:
+    const char* GetName() const override { return "d3d11"; }
+
+    bool CreateExporter(VkInstance) override
+    {
+        if (!SelectDXGIAdapter(m_pAdapter.GetAddressOf()))
+        {
+            spdlog::error("Failed to load a DXGI Adapter.");
+            return false;
+        }
+
+        D3D_FEATURE_LEVEL desiredFeatureLevel = D3D_FEATURE_LEVEL_11_1;
+
+        UINT deviceCreationFlags = 0u;
+
+#if defined(_DEBUG)
+        deviceCreationFlags |= D3D11_CREATE_DEVICE_DEBUG;
+#endif
+
+        D3D_FEATURE_LEVEL selectedFeatureLevel;
+        if (!SUCCEEDED(D3D11CreateDevice (m_pAdapter.Get(), D3D_DRIVER_TYPE_UNKNOWN, nullptr, deviceCreationFlags, &desiredFeatureLevel, 1u, D3D11_SDK_VERSION, m_pDeviceDX.GetAddressOf(), &selectedFeatureLevel, m_pImmediateContextDX.GetAddressOf())))
+        {
+            spdlog::error("Failed to create the D3D11 Device and Immediate Context.");
+            return false;
+        }
+
+        // Shared fences require the Windows 10 Creators Update interfaces.
+        if (!SUCCEEDED(m_pDeviceDX.As(&m_pDevice5DX)) || !SUCCEEDED(m_pImmediateContextDX.As(&m_pImmediateContext4DX)))
+        {
+            spdlog::error("The D3D11 Device does not support shared fences (ID3D11Device5).");
+            return false;
+        }
+
+        spdlog::info("Initialized D3D11.");
+
+        return true;
+    }
+
+    void GetRequiredDeviceExtensions(std::vector<const char*>& requiredExtensions) const override
+    {
+        requiredExtensions.push_back(VK_KHR_EXTERNAL_MEMORY_WIN32_EXTENSION_NAME);
+        requiredExtensions.push_back(VK_KHR_EXTERNAL_SEMAPHORE_WIN32_EXTENSION_NAME);
+    }
+
+    bool SelectPhysicalDevice(VkInstance vkInstance, const std::vector<const char*>& requiredExtensions, VkPhysicalDevice& vkPhysicalDevice) override
+    {
+        return SelectVulkanPhysicalDevice(vkInstance, requiredExtensions, m_pAdapter.Get(), vkPhysicalDevice);
+    }
+
+    bool CreateSharedImage(const VulkanDevice& importer, const SharedImageDesc& desc, SharedImage& sharedImage) override
+    {
+        if (!ValidateSharedImageDesc(desc))
+            return false;
+
+        const auto bindStart = std::chrono::steady_clock::now();
+
+        // Reuse an idle texture of the same description together with its Vulkan import.
+        uint64_t      resourceId;
+        ImportedImage importedImage;
+
+        const bool cacheHit = m_importCache.Acquire(desc, resourceId, importedImage);
+
+        if (!cacheHit && !CreateSharedTexture(importer, desc, resourceId, importedImage))
+            return false;
+
+        auto& sharedTexture = m_sharedTextures[resourceId];
+
+        // Fence values never go back, so every shared image starts a fresh timeline.
+        if (!ShareD3D11FenceWithVulkan(importer, m_pDevice5DX.Get(), sharedTexture.pFenceDX.ReleaseAndGetAddressOf(), sharedImage.vkTimelineSemaphore))
+        {
+            spdlog::error("Failed to share a D3D11 Fence with the Vulkan timeline semaphore.");
+
+            m_importCache.Release(resourceId);
+            return false;
+        }
+
+        sharedImage.desc          = desc;
+        sharedImage.vkImage       = importedImage.vkImage;
+        sharedImage.vkImageMemory = importedImage.vkImageMemory;
+        sharedImage.exporterIndex = (uint32_t)resourceId;
+
+        m_importCache.RecordBind(cacheHit, GetElapsedMilliseconds(bindStart));
+
+        return CreateReadbackSlots(sharedImage, 1u);
+    }
+
+    bool CreateReadbackSlots(const SharedImage& sharedImage, uint32_t slotCount) override
+    {
+        auto& sharedTexture = m_sharedTextures[sharedImage.exporterIndex];
+
+        // Create CPU-Accessible Staging D3D11 Image Resources.
+        D3D11_TEXTURE2D_DESC stagingImageDesc;
+        sharedTexture.pImageDX->GetDesc(&stagingImageDesc);
+
+        stagingImageDesc.Usage          = D3D11_USAGE_STAGING;
+        stagingImageDesc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+        stagingImageDesc.BindFlags      = 0u;
+        stagingImageDesc.MiscFlags      = 0u;
+
+        // Array slices are mapped one at a time, so the layers of a readback are stacked in a single tall staging
+        // image instead and mapped at once.
+        stagingImageDesc.Height    = sharedImage.desc.height * sharedImage.desc.arrayLayers;
+        stagingImageDesc.ArraySize = 1u;
+
+        // An event query per slot tells when its copy retired without mapping (and so stalling on) the staging image.
+        D3D11_QUERY_DESC queryDesc = {};
+        queryDesc.Query = D3D11_QUERY_EVENT;
+
+        while (sharedTexture.readbackSlots.size() < slotCount)
+        {
+            ReadbackSlot readbackSlot;
+
+            if (!SUCCEEDED(m_pDeviceDX->CreateTexture2D(&stagingImageDesc, nullptr, readbackSlot.pStagingImageDX.GetAddressOf())))
+            {
+                spdlog::error("Failed to create the D3D11 Staging Image resource");
+                return false;
+            }
+
+            if (!SUCCEEDED(m_pDeviceDX->CreateQuery(&queryDesc, readbackSlot.pCopyQueryDX.GetAddressOf())))
+                return false;
+
+            sharedTexture.readbackSlots.push_back(std::move(readbackSlot));
+        }
+
+        return true;
+    }
+
+    bool SubmitReadback(const SharedImage& sharedImage, uint64_t frameIndex, uint32_t slotIndex, const DirtyTileMap* pDirtyTiles, uint64_t hostOffset) override
+    {
+        // Staging textures are the only CPU-readable copy destination of D3D11.
+        if (hostOffset != kReadbackToSlot)
+            return false;
+
+        auto& sharedTexture = m_sharedTextures[sharedImage.exporterIndex];
+        auto& readbackSlot  = sharedTexture.readbackSlots[slotIndex];
+
+        // Queue a GPU-side wait for the Vulkan frame, then hand the image back right after the copy.
+        if (!SUCCEEDED(m_pImmediateContext4DX->Wait(sharedTexture.pFenceDX.Get(), GetSharedImageRenderSignalValue(frameIndex))))
+            return false;
+
+        // Transfer the native image to staging memory, whole or one box per run of dirty tiles and layer.
+        GetSharedImageReadbackRegions(sharedImage.desc, pDirtyTiles, readbackSlot.regions);
+
+        readbackSlot.firstLayer = sharedTexture.readbackFirstLayer;
+        readbackSlot.layerCount = sharedTexture.readbackLayerCount;
+
+        if (pDirtyTiles == nullptr && sharedImage.desc.arrayLayers == 1u)
+        {
+            m_pImmediateContextDX->CopyResource(readbackSlot.pStagingImageDX.Get(), sharedTexture.pImageDX.Get());
+        }
+        else
+        {
+            for (uint32_t layerIndex = 0u; layerIndex < readbackSlot.layerCount; layerIndex++)
+            {
+                const UINT     sourceSubresource = D3D11CalcSubresource(0u, readbackSlot.firstLayer + layerIndex, 1u);
+                const uint32_t stagingY          = layerIndex * sharedImage.desc.height;
+
+                for (const DirtyRect& region : readbackSlot.regions)
+                {
+                    const D3D11_BOX sourceBox = { region.x, region.y, 0u, region.x + region.width, region.y + region.height, 1u };
+
+                    m_pImmediateContextDX->CopySubresourceRegion(readbackSlot.pStagingImageDX.Get(), 0u, region.x, stagingY + region.y, 0u, sharedTexture.pImageDX.Get(), sourceSubresource, &sourceBox);
+                }
+            }
+        }
+
+        if (!SUCCEEDED(m_pImmediateContext4DX->Signal(sharedTexture.pFenceDX.Get(), GetSharedImageReadSignalValue(frameIndex))))
+            return false;
+
+        m_pImmediateContextDX->End(readbackSlot.pCopyQueryDX.Get());
+
+        // Kick off the copy now rather than at the next Map.
+        m_pImmediateContextDX->Flush();
+        m_readbackSubmitCount++;
+
+        return true;
+    }
+
+    uint64_t GetReadbackHostMemoryAlignment() const override { return 0u; }
+
+    bool ImportReadbackHostMemory(const SharedImage&, void* pHostMemory, uint64_t) override { return pHostMemory == nullptr; }
+
+    // Readbacks are staging texture copies of D3D11, there is no compute stage in front of them.
+    bool SetReadbackCompute(const SharedImage& sharedImage, const ReadbackComputeDesc& computeDesc) override { return !computeDesc.enabled; }
+
+    bool SetReadbackLayers(const SharedImage& sharedImage, uint32_t firstLayer, uint32_t layerCount) override
+    {
+        if (layerCount == 0u || firstLayer >= sharedImage.desc.arrayLayers || layerCount > sharedImage.desc.arrayLayers - firstLayer)
+            return false;
+
+        auto& sharedTexture = m_sharedTextures[sharedImage.exporterIndex];
+        sharedTexture.readbackFirstLayer = firstLayer;
+        sharedTexture.readbackLayerCount = layerCount;
+
+        return true;
+    }
+
+    bool IsReadbackComplete(const SharedImage& sharedImage, uint32_t slotIndex) override
+    {
+        const auto& readbackSlot = m_sharedTextures[sharedImage.exporterIndex].readbackSlots[slotIndex];
+
+        return m_pImmediateContextDX->GetData(readbackSlot.pCopyQueryDX.Get(), nullptr, 0u, D3D11_ASYNC_GETDATA_DONOTFLUSH) == S_OK;
+    }
+
+    bool MapReadback(const SharedImage& sharedImage, uint32_t slotIndex, MappedImage& mappedImage) override
+    {
+        const auto& readbackSlot = m_sharedTextures[sharedImage.exporterIndex].readbackSlots[slotIndex];
+
+        // Map to CPU for copy, blocks until the copy into the slot retired.
+        D3D11_MAPPED_SUBRESOURCE mappedStagingMemory;
+        if (!SUCCEEDED(m_pImmediateContextDX->Map(readbackSlot.pStagingImageDX.Get(), 0u, D3D11_MAP_READ, 0u, &mappedStagingMemory)))
+            return false;
+
+        mappedImage.pData       = mappedStagingMemory.pData;
+        mappedImage.rowPitch    = mappedStagingMemory.RowPitch;
+        mappedImage.pRegions    = readbackSlot.regions.data();
+        mappedImage.regionCount = (uint32_t)readbackSlot.regions.size();
+        mappedImage.firstLayer  = readbackSlot.firstLayer;
+        mappedImage.layerCount  = readbackSlot.layerCount;
+        mappedImage.layerPitch  = (VkDeviceSize)mappedStagingMemory.RowPitch * sharedImage.desc.height;
+
+        return true;
+    }
+
+    void UnmapReadback(const SharedImage& sharedImage, uint32_t slotIndex) override
+    {
+        m_pImmediateContextDX->Unmap(m_sharedTextures[sharedImage.exporterIndex].readbackSlots[slotIndex].pStagingImageDX.Get(), 0u);
+    }
+
+    void DestroySharedImage(const VulkanDevice& importer, SharedImage& sharedImage) override
+    {
+        vkDestroySemaphore(importer.vkLogicalDevice, sharedImage.vkTimelineSemaphore, nullptr);
+
+        auto& sharedTexture = m_sharedTextures[sharedImage.exporterIndex];
+        sharedTexture.pFenceDX.Reset();
+
+        sharedTexture.readbackFirstLayer = 0u;
+        sharedTexture.readbackLayerCount = sharedImage.desc.arrayLayers;
+
+        // The texture and its import stay cached, the cache may evict them right away.
+        m_importCache.Release(sharedImage.exporterIndex);
+
+        sharedImage = {};
+    }
+
+    ImportCache& GetImportCache() override { return m_importCache; }
+
+    // D3D11 builds no Vulkan pipelines.
+    bool LoadPipelineCache(const char* pFileName) override { return true; }
+
+    bool SavePipelineCache(const char* pFileName) override { return false; }
+
+    // Shared textures are dedicated allocations of D3D11, see BindD3D11ImageToVulkanImage.
+    bool EnableMemoryArena(bool enabled) override { return !enabled; }
+
+    uint64_t GetReadbackSubmitCount() const override { return m_readbackSubmitCount; }
+
+    SharedMemoryArenaStats GetMemoryArenaStats() const override
+    {
+        SharedMemoryArenaStats stats;
+
+        for (const auto& sharedTexture : m_sharedTextures)
+        {
+            if (sharedTexture.pImageDX)
+                stats.dedicatedCount++;
+        }
+
+        stats.deviceMemoryCount = 2u * stats.dedicatedCount;
+
+        return stats;
+    }
+
+    void Release() override
+    {
+        m_importCache.Clear();
+        m_sharedTextures.clear();
+
+        m_pImmediateContext4DX.Reset();
+        m_pImmediateContextDX.Reset();
+        m_pDevice5DX.Reset();
+        m_pDeviceDX.Reset();
+        m_pAdapter.Reset();
+    }
+
+private:
+    // Creates a shareable texture in a free exporter slot and imports it into the importer device.
+    bool CreateSharedTexture(const VulkanDevice& importer, const SharedImageDesc& desc, uint64_t& resourceId, ImportedImage& importedImage)
+    {
+        const auto formatDX = (DXGI_FORMAT)GetSharedImageFormatTraits(desc).dxgiFormat;
+
+        D3D11_TEXTURE2D_DESC imageDesc = {};
+        imageDesc.Width     = desc.width;
+        imageDesc.Height    = desc.height;
+        imageDesc.MipLevels = 1;
+        imageDesc.ArraySize = desc.arrayLayers;
+        imageDesc.Format    = formatDX;
+        imageDesc.Usage     = D3D11_USAGE_DEFAULT;
+        imageDesc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
+        imageDesc.MiscFlags = D3D11_RESOURCE_MISC_SHARED | D3D11_RESOURCE_MISC_SHARED_NTHANDLE;
+        imageDesc.SampleDesc.Count = 1;
+
+        SharedTexture sharedTexture;
+        sharedTexture.readbackLayerCount = desc.arrayLayers;
+
+        if (!SUCCEEDED(m_pDeviceDX->CreateTexture2D(&imageDesc, nullptr, sharedTexture.pImageDX.GetAddressOf())))
+        {
+            spdlog::error("Failed to create the D3D11 Image resource.");
+            return false;
+        }
+
+        // Bind the D3D11 Image To Vulkan Image (backed by the same memory on GPU).
+        importedImage.vkDevice = importer.vkLogicalDevice;
+
+        if (!BindD3D11ImageToVulkanImage(importer, sharedTexture.pImageDX.Get(), desc, importedImage.vkImageMemory, importedImage.vkImage, importedImage.size))
+        {
+            spdlog::error("Failed to bind the ID3D11 Image resource to a Vulkan Image.");
+
+            vkDestroyImage(importer.vkLogicalDevice, importedImage.vkImage, nullptr);
+            return false;
+        }
+
+        // Evicted textures leave holes that are filled first.
+        resourceId = 0u;
+        while (resourceId < m_sharedTextures.size() && m_sharedTextures[resourceId].pImageDX)
+            resourceId++;
+
+        if (resourceId == m_sharedTextures.size())
+            m_sharedTextures.emplace_back();
+
+        m_sharedTextures[resourceId] = std::move(sharedTexture);
+
+        m_importCache.Insert({ resourceId, desc }, importedImage);
+
+        return true;
+    }
+
+    struct ReadbackSlot
+    {
+        ComPtr<ID3D11Texture2D> pStagingImageDX;
+        ComPtr<ID3D11Query>     pCopyQueryDX;
+
+        // Regions and layers of the last copy into the slot.
+        std::vector<DirtyRect>  regions;
+        uint32_t                firstLayer = 0u;
+        uint32_t                layerCount = 1u;
+    };
+
+    struct SharedTexture
+    {
+        ComPtr<ID3D11Texture2D>   pImageDX;
+        ComPtr<ID3D11Fence>       pFenceDX;
+        std::vector<ReadbackSlot> readbackSlots;
+
+        // Layers later readbacks copy, set by SetReadbackLayers.
+        uint32_t                  readbackFirstLayer = 0u;
+        uint32_t                  readbackLayerCount = 1u;
+    };
+
+    ComPtr<IDXGIAdapter1>        m_pAdapter;
+    ComPtr<ID3D11Device>         m_pDeviceDX;
+    ComPtr<ID3D11Device5>        m_pDevice5DX;
+    ComPtr<ID3D11DeviceContext>  m_pImmediateContextDX;
+    ComPtr<ID3D11DeviceContext4> m_pImmediateContext4DX;
+
+    std::vector<SharedTexture>   m_sharedTextures;
+
+    uint64_t                     m_readbackSubmitCount = 0u;
+
+    ImportCache m_importCache { [this](uint64_t resourceId) { m_sharedTextures[resourceId] = {}; } };
+};
+
+std::unique_ptr<InteropBackend> CreateD3D11InteropBackend()
+{
+    return std::make_unique<D3D11InteropBackend>();
+}
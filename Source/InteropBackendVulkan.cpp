@@ -0,0 +1,834 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#include <spdlog/spdlog.h>
+
+#include "DeviceCache.h"
+#include "ExternalImage.h"
+#include "ImportCache.h"
+#include "ReadbackCompute.h"
+#include "Trace.h"
+
+// Exporter implemented with a second Vulkan logical device on the importer's physical device. This stands
+// in for a separate producer process: the two devices share nothing except the exported memory.
+//
+// With useHostCopy no memory is exported at all; both devices own private images and every readback moves
+// the pixels importer -> host -> exporter first. This is the baseline the zero-copy path is measured against.
+class VulkanInteropBackend final : public InteropBackend
+{
+public:
+    explicit VulkanInteropBackend(bool useHostCopy) : m_useHostCopy(useHostCopy), m_useArena(!useHostCopy) {}
+
+    const char* GetName() const override { return m_useHostCopy ? "host-copy" : "opaque-fd"; }
+
+    bool CreateExporter(VkInstance vkInstance) override
+    {
+        std::vector<const char*> requiredExtensions;
+        GetRequiredDeviceExtensions(requiredExtensions);
+
+        // Choose the first device that can export memory (this includes software ICDs such as lavapipe).
+        VkPhysicalDevice vkPhysicalDevice;
+        if (!SelectVulkanPhysicalDevice(vkInstance, requiredExtensions, nullptr, vkPhysicalDevice))
+        {
+            spdlog::error("No Vulkan physical device is able to export memory.");
+            return false;
+        }
+
+        // Zero-copy readbacks into application memory, where the driver imports host pointers.
+        const auto& extensionNames = GetVulkanDeviceCapabilities(vkPhysicalDevice).extensionNames;
+        const bool  hostImport     = !m_useHostCopy && std::binary_search(extensionNames.begin(), extensionNames.end(), std::string(VK_EXT_EXTERNAL_MEMORY_HOST_EXTENSION_NAME));
+
+        if (hostImport)
+            requiredExtensions.push_back(VK_EXT_EXTERNAL_MEMORY_HOST_EXTENSION_NAME);
+
+        if (!CreateVulkanDevice(vkPhysicalDevice, requiredExtensions, m_exporter))
+            return false;
+
+        if (hostImport)
+        {
+            VkPhysicalDeviceExternalMemoryHostPropertiesEXT vkHostProperties = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTERNAL_MEMORY_HOST_PROPERTIES_EXT };
+
+            VkPhysicalDeviceProperties2 vkProperties = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2 };
+            vkProperties.pNext = &vkHostProperties;
+
+            vkGetPhysicalDeviceProperties2(vkPhysicalDevice, &vkProperties);
+
+            m_hostImportAlignment = vkHostProperties.minImportedHostPointerAlignment;
+        }
+
+        // Readbacks are pure copies, they run on the transfer queue when the device has a dedicated one.
+        VkCommandPoolCreateInfo vkCommandPoolCreateInfo = { VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO };
+        vkCommandPoolCreateInfo.flags            = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+        vkCommandPoolCreateInfo.queueFamilyIndex = m_exporter.transferQueueIndex;
+
+        if (vkCreateCommandPool(m_exporter.vkLogicalDevice, &vkCommandPoolCreateInfo, nullptr, &m_vkReadbackCommandPool) != VK_SUCCESS)
+            return false;
+
+        // Readbacks with a compute stage run on the compute queue instead.
+        vkCommandPoolCreateInfo.queueFamilyIndex = m_exporter.computeQueueIndex;
+
+        if (vkCreateCommandPool(m_exporter.vkLogicalDevice, &vkCommandPoolCreateInfo, nullptr, &m_vkComputeCommandPool) != VK_SUCCESS)
+            return false;
+
+        // Region copies on the readback queue must be aligned to its transfer granularity, or cover whole images
+        // when it is zero.
+        const auto&       queueFamilyProperties = GetVulkanDeviceCapabilities(vkPhysicalDevice).queueFamilies;
+        const VkExtent3D& granularity           = queueFamilyProperties[m_exporter.transferQueueIndex].minImageTransferGranularity;
+
+        m_regionCopies = granularity.width != 0u && granularity.height != 0u &&
+                         kDirtyTileSize % granularity.width == 0u && kDirtyTileSize % granularity.height == 0u;
+
+        m_pTraceQueries = TRACE_GPU_CREATE(m_exporter, VulkanQueueType::Transfer, "Exporter readback");
+
+        VkPhysicalDeviceProperties physicalDeviceProperties;
+        vkGetPhysicalDeviceProperties(vkPhysicalDevice, &physicalDeviceProperties);
+
+        spdlog::info("Created Vulkan exporter device on: {} (readback queue family {}{}{})", physicalDeviceProperties.deviceName,
+                     m_exporter.transferQueueIndex, m_exporter.HasDedicatedTransferQueue() ? ", transfer only" : "", hostImport ? ", host memory import" : "");
+
+        return true;
+    }
+
+    void GetRequiredDeviceExtensions(std::vector<const char*>& requiredExtensions) const override
+    {
+        if (m_useHostCopy)
+            return;
+
+        requiredExtensions.push_back(kVulkanExternalMemoryExtensionName);
+        requiredExtensions.push_back(kVulkanExternalSemaphoreExtensionName);
+    }
+
+    bool SelectPhysicalDevice(VkInstance, const std::vector<const char*>& requiredExtensions, VkPhysicalDevice& vkPhysicalDevice) override
+    {
+        // Opaque handles can only be imported by the same physical device (and driver) that exported them.
+        vkPhysicalDevice = m_exporter.vkPhysicalDevice;
+
+        return CheckVulkanDeviceExtensions(vkPhysicalDevice, requiredExtensions);
+    }
+
+    bool CreateSharedImage(const VulkanDevice& importer, const SharedImageDesc& desc, SharedImage& sharedImage) override
+    {
+        if (!ValidateSharedImageDesc(desc))
+            return false;
+
+        const auto bindStart = std::chrono::steady_clock::now();
+
+        // Reuse an idle exported image of the same description together with its import.
+        uint64_t      resourceId;
+        ImportedImage importedImage;
+
+        const bool cacheHit = m_importCache.Acquire(desc, resourceId, importedImage);
+
+        if (!cacheHit && !CreateExportedImage(importer, desc, resourceId, importedImage))
+            return false;
+
+        auto& exportedImage = m_exportedImages[resourceId];
+
+        // Timeline values never go back, so every shared image starts a fresh timeline.
+        if (!CreateSharedTimeline(importer, sharedImage.vkTimelineSemaphore, exportedImage.vkTimelineSemaphore))
+        {
+            spdlog::error("Failed to share a timeline semaphore between the importer and the exporter.");
+
+            m_importCache.Release(resourceId);
+            return false;
+        }
+
+        sharedImage.desc          = desc;
+        sharedImage.vkImage       = importedImage.vkImage;
+        sharedImage.vkImageMemory = importedImage.vkImageMemory;
+        sharedImage.exporterIndex = (uint32_t)resourceId;
+
+        m_importCache.RecordBind(cacheHit, GetElapsedMilliseconds(bindStart));
+
+        return CreateReadbackSlots(sharedImage, 1u);
+    }
+
+    bool CreateReadbackSlots(const SharedImage& sharedImage, uint32_t slotCount) override
+    {
+        auto& readbackSlots = m_exportedImages[sharedImage.exporterIndex].readbackSlots;
+
+        while (readbackSlots.size() < slotCount)
+        {
+            ReadbackSlot readbackSlot;
+
+            if (!CreateVulkanStagingBuffer(m_exporter, GetSharedImageSize(sharedImage.desc), VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, readbackSlot.buffer))
+                return false;
+
+            VkCommandBufferAllocateInfo vkCommandAllocateInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
+            vkCommandAllocateInfo.commandBufferCount = 1u;
+            vkCommandAllocateInfo.commandPool        = m_vkReadbackCommandPool;
+            vkCommandAllocateInfo.level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+
+            // Created signaled so that a slot which never received a copy is complete.
+            VkFenceCreateInfo vkFenceCreateInfo = { VK_STRUCTURE_TYPE_FENCE_CREATE_INFO };
+            vkFenceCreateInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+            VkCommandBufferAllocateInfo vkComputeCommandAllocateInfo = vkCommandAllocateInfo;
+            vkComputeCommandAllocateInfo.commandPool = m_vkComputeCommandPool;
+
+            if (vkAllocateCommandBuffers(m_exporter.vkLogicalDevice, &vkCommandAllocateInfo, &readbackSlot.vkCommandBuffer) != VK_SUCCESS ||
+                vkAllocateCommandBuffers(m_exporter.vkLogicalDevice, &vkComputeCommandAllocateInfo, &readbackSlot.vkComputeCommandBuffer) != VK_SUCCESS ||
+                vkCreateFence(m_exporter.vkLogicalDevice, &vkFenceCreateInfo, nullptr, &readbackSlot.vkFence) != VK_SUCCESS)
+            {
+                DestroyReadbackSlot(readbackSlot);
+                return false;
+            }
+
+            readbackSlots.push_back(readbackSlot);
+        }
+
+        return true;
+    }
+
+    bool SubmitReadback(const SharedImage& sharedImage, uint64_t frameIndex, uint32_t slotIndex, const DirtyTileMap* pDirtyTiles, uint64_t hostOffset) override
+    {
+        auto& exportedImage = m_exportedImages[sharedImage.exporterIndex];
+        auto& readbackSlot  = exportedImage.readbackSlots[slotIndex];
+
+        // Zero-copy readbacks land in the imported host memory instead of the slot's buffer.
+        const bool                 toHost       = hostOffset != kReadbackToSlot;
+        const VulkanStagingBuffer& destination  = toHost ? exportedImage.hostReadbackBuffer : readbackSlot.buffer;
+        const VkDeviceSize         frameSize    = exportedImage.readbackCompute.IsCreated() ? exportedImage.readbackCompute.outputSize :
+                                                  GetSharedImageLayerSize(sharedImage.desc) * exportedImage.readbackLayerCount;
+        const VkDeviceSize         bufferOffset = toHost ? hostOffset : 0u;
+
+        if (toHost && (destination.vkBuffer == VK_NULL_HANDLE || bufferOffset % GetSharedImageBytesPerPixel(sharedImage.desc) != 0u || bufferOffset + frameSize > destination.size))
+        {
+            spdlog::error("Readback destination {} is outside of the imported host memory.", hostOffset);
+            return false;
+        }
+
+        // The previous copy into this slot must have retired before its command buffer is recorded again.
+        {
+            TRACE_ZONE("Wait readback slot");
+
+            vkWaitForFences(m_exporter.vkLogicalDevice, 1u, &readbackSlot.vkFence, VK_TRUE, UINT64_MAX);
+        }
+
+        if (m_useHostCopy && !CopyThroughHost(sharedImage, frameIndex, exportedImage, readbackSlot.buffer))
+            return false;
+
+        // With a shared timeline the exporter queue waits on the GPU for the importer's frame, and hands the
+        // image back as soon as its copy finished.
+        VulkanTimelineSubmit timelineSubmit;
+        if (!m_useHostCopy)
+        {
+            timelineSubmit.vkWaitSemaphore   = exportedImage.vkTimelineSemaphore;
+            timelineSubmit.waitValue         = GetSharedImageRenderSignalValue(frameIndex);
+            timelineSubmit.vkSignalSemaphore = exportedImage.vkTimelineSemaphore;
+            timelineSubmit.signalValue       = GetSharedImageReadSignalValue(frameIndex);
+        }
+
+        readbackSlot.pData = (const uint8_t*)destination.pMappedData + bufferOffset;
+
+        if (exportedImage.readbackCompute.IsCreated())
+            return SubmitComputeReadback(exportedImage, readbackSlot, destination.vkBuffer, bufferOffset, timelineSubmit);
+
+        VkCommandBufferBeginInfo vkCommandBeginInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+        vkCommandBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+        vkResetCommandBuffer(readbackSlot.vkCommandBuffer, 0u);
+        vkBeginCommandBuffer(readbackSlot.vkCommandBuffer, &vkCommandBeginInfo);
+
+        // Acquire the image from the importer and copy it into the slot's host-visible buffer.
+        {
+            TRACE_GPU_ZONE(m_pTraceQueries, readbackSlot.vkCommandBuffer, "Acquire");
+
+            if (m_useHostCopy)
+                RecordVulkanImageBarrier(readbackSlot.vkCommandBuffer, exportedImage.vkImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_GENERAL, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+            else
+                RecordVulkanImageBarrier(readbackSlot.vkCommandBuffer, exportedImage.vkImage, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL, 0u, VK_ACCESS_TRANSFER_READ_BIT, VK_QUEUE_FAMILY_EXTERNAL, m_exporter.transferQueueIndex);
+        }
+
+        GetSharedImageReadbackRegions(sharedImage.desc, m_regionCopies ? pDirtyTiles : nullptr, readbackSlot.regions);
+        readbackSlot.rowPitch   = GetSharedImageRowPitch(sharedImage.desc);
+        readbackSlot.firstLayer = exportedImage.readbackFirstLayer;
+        readbackSlot.layerCount = exportedImage.readbackLayerCount;
+        readbackSlot.layerPitch = GetSharedImageLayerSize(sharedImage.desc);
+
+        // Each region copy covers all the layers at once.
+        {
+            TRACE_GPU_ZONE(m_pTraceQueries, readbackSlot.vkCommandBuffer, "Readback copy");
+
+            RecordVulkanImageRegionsToBufferCopy(readbackSlot.vkCommandBuffer, exportedImage.vkImage, VK_IMAGE_LAYOUT_GENERAL, destination.vkBuffer, sharedImage.desc, readbackSlot.regions, bufferOffset,
+                                                 readbackSlot.firstLayer, readbackSlot.layerCount);
+        }
+
+        vkEndCommandBuffer(readbackSlot.vkCommandBuffer);
+
+        m_readbackSubmitCount++;
+
+        return SubmitReadbackSlot(m_exporter.vkTransferQueue, readbackSlot.vkCommandBuffer, timelineSubmit, readbackSlot);
+    }
+
+    bool SetReadbackCompute(const SharedImage& sharedImage, const ReadbackComputeDesc& computeDesc) override
+    {
+        // The baseline stays a plain copy through the host.
+        if (m_useHostCopy)
+            return !computeDesc.enabled;
+
+        // The stage samples a single layer.
+        if (computeDesc.enabled && sharedImage.desc.arrayLayers != 1u)
+            return false;
+
+        auto& exportedImage = m_exportedImages[sharedImage.exporterIndex];
+
+        // In-flight readbacks may still run the current stage.
+        for (auto& readbackSlot : exportedImage.readbackSlots)
+            vkWaitForFences(m_exporter.vkLogicalDevice, 1u, &readbackSlot.vkFence, VK_TRUE, UINT64_MAX);
+
+        m_readbackCompute.DestroyTarget(exportedImage.readbackCompute);
+
+        if (!computeDesc.enabled)
+            return true;
+
+        if (!m_readbackCompute.IsCreated() && !m_readbackCompute.Create(m_exporter))
+            return false;
+
+        // The NV12 frame is never larger than the image, so the readback slots already fit it.
+        return m_readbackCompute.CreateTarget(exportedImage.vkImage, sharedImage.desc, computeDesc, exportedImage.readbackCompute);
+    }
+
+    bool SetReadbackLayers(const SharedImage& sharedImage, uint32_t firstLayer, uint32_t layerCount) override
+    {
+        auto& exportedImage = m_exportedImages[sharedImage.exporterIndex];
+
+        if (exportedImage.readbackCompute.IsCreated() || layerCount == 0u || firstLayer >= sharedImage.desc.arrayLayers || layerCount > sharedImage.desc.arrayLayers - firstLayer)
+            return false;
+
+        // Slots record the layers of their own copy, readbacks in flight are not affected.
+        exportedImage.readbackFirstLayer = firstLayer;
+        exportedImage.readbackLayerCount = layerCount;
+
+        return true;
+    }
+
+    uint64_t GetReadbackHostMemoryAlignment() const override { return m_hostImportAlignment; }
+
+    bool ImportReadbackHostMemory(const SharedImage& sharedImage, void* pHostMemory, uint64_t size) override
+    {
+        auto& exportedImage = m_exportedImages[sharedImage.exporterIndex];
+
+        // In-flight readbacks may still write to the current import.
+        for (auto& readbackSlot : exportedImage.readbackSlots)
+            vkWaitForFences(m_exporter.vkLogicalDevice, 1u, &readbackSlot.vkFence, VK_TRUE, UINT64_MAX);
+
+        DestroyVulkanStagingBuffer(m_exporter, exportedImage.hostReadbackBuffer);
+
+        if (pHostMemory == nullptr)
+            return true;
+
+        if (m_hostImportAlignment == 0u || (uintptr_t)pHostMemory % m_hostImportAlignment != 0u || size % m_hostImportAlignment != 0u)
+        {
+            spdlog::error("Host memory at {} ({} bytes) cannot be imported as a readback destination.", pHostMemory, size);
+            return false;
+        }
+
+        if (!ImportVulkanHostMemoryBuffer(m_exporter, pHostMemory, size, exportedImage.hostReadbackBuffer))
+        {
+            spdlog::error("The driver rejected {} bytes of host memory as a readback destination.", size);
+            return false;
+        }
+
+        return true;
+    }
+
+    bool IsReadbackComplete(const SharedImage& sharedImage, uint32_t slotIndex) override
+    {
+        const auto& readbackSlot = m_exportedImages[sharedImage.exporterIndex].readbackSlots[slotIndex];
+
+        return vkGetFenceStatus(m_exporter.vkLogicalDevice, readbackSlot.vkFence) == VK_SUCCESS;
+    }
+
+    bool MapReadback(const SharedImage& sharedImage, uint32_t slotIndex, MappedImage& mappedImage) override
+    {
+        const auto& readbackSlot = m_exportedImages[sharedImage.exporterIndex].readbackSlots[slotIndex];
+
+        if (vkWaitForFences(m_exporter.vkLogicalDevice, 1u, &readbackSlot.vkFence, VK_TRUE, UINT64_MAX) != VK_SUCCESS)
+            return false;
+
+        mappedImage.pData       = readbackSlot.pData;
+        mappedImage.rowPitch    = readbackSlot.rowPitch;
+        mappedImage.pRegions    = readbackSlot.regions.data();
+        mappedImage.regionCount = (uint32_t)readbackSlot.regions.size();
+        mappedImage.firstLayer  = readbackSlot.firstLayer;
+        mappedImage.layerCount  = readbackSlot.layerCount;
+        mappedImage.layerPitch  = readbackSlot.layerPitch;
+
+        return true;
+    }
+
+    void UnmapReadback(const SharedImage&, uint32_t) override
+    {
+        // Readback buffers stay persistently mapped.
+    }
+
+    void DestroySharedImage(const VulkanDevice& importer, SharedImage& sharedImage) override
+    {
+        auto& exportedImage = m_exportedImages[sharedImage.exporterIndex];
+
+        // In-flight copies still wait on and signal the timeline.
+        for (auto& readbackSlot : exportedImage.readbackSlots)
+            vkWaitForFences(m_exporter.vkLogicalDevice, 1u, &readbackSlot.vkFence, VK_TRUE, UINT64_MAX);
+
+        vkDestroySemaphore(importer.vkLogicalDevice, sharedImage.vkTimelineSemaphore, nullptr);
+
+        // The compute stage, host memory import and readback layers belong to the shared image, not to the cached
+        // exporter image.
+        m_readbackCompute.DestroyTarget(exportedImage.readbackCompute);
+        DestroyVulkanStagingBuffer(m_exporter, exportedImage.hostReadbackBuffer);
+
+        exportedImage.readbackFirstLayer = 0u;
+        exportedImage.readbackLayerCount = sharedImage.desc.arrayLayers;
+
+        if (exportedImage.vkTimelineSemaphore != VK_NULL_HANDLE)
+            vkDestroySemaphore(m_exporter.vkLogicalDevice, exportedImage.vkTimelineSemaphore, nullptr);
+
+        exportedImage.vkTimelineSemaphore = VK_NULL_HANDLE;
+
+        // The exported image and its import stay cached, the cache may evict them right away.
+        m_importCache.Release(sharedImage.exporterIndex);
+
+        sharedImage = {};
+    }
+
+    ImportCache& GetImportCache() override { return m_importCache; }
+
+    bool LoadPipelineCache(const char* pFileName) override { return CreateVulkanPipelineCache(m_exporter, pFileName); }
+
+    bool SavePipelineCache(const char* pFileName) override { return SaveVulkanPipelineCache(m_exporter, pFileName); }
+
+    bool EnableMemoryArena(bool enabled) override
+    {
+        // The baseline shares no memory.
+        if (enabled && m_useHostCopy)
+            return false;
+
+        m_useArena = enabled;
+        return true;
+    }
+
+    uint64_t GetReadbackSubmitCount() const override { return m_readbackSubmitCount; }
+
+    SharedMemoryArenaStats GetMemoryArenaStats() const override
+    {
+        SharedMemoryArenaStats stats = m_arena.GetStats();
+
+        for (const auto& exportedImage : m_exportedImages)
+        {
+            if (exportedImage.vkImageMemory != VK_NULL_HANDLE)
+                stats.dedicatedCount++;
+        }
+
+        stats.deviceMemoryCount += 2u * stats.dedicatedCount;
+
+        return stats;
+    }
+
+    void Release() override
+    {
+        m_importCache.Clear();
+        m_exportedImages.clear();
+
+        if (m_vkReadbackCommandPool != VK_NULL_HANDLE)
+            vkDestroyCommandPool(m_exporter.vkLogicalDevice, m_vkReadbackCommandPool, nullptr);
+
+        if (m_vkComputeCommandPool != VK_NULL_HANDLE)
+            vkDestroyCommandPool(m_exporter.vkLogicalDevice, m_vkComputeCommandPool, nullptr);
+
+        m_vkReadbackCommandPool = VK_NULL_HANDLE;
+        m_vkComputeCommandPool  = VK_NULL_HANDLE;
+
+        m_readbackCompute.Destroy();
+
+        TRACE_GPU_DESTROY(m_pTraceQueries);
+        m_pTraceQueries = nullptr;
+
+        m_arena.Destroy();
+
+        DestroyVulkanDevice(m_exporter);
+    }
+
+private:
+    // Exporter-side destination of one asynchronous readback.
+    struct ReadbackSlot
+    {
+        VulkanStagingBuffer buffer;
+        VkCommandBuffer     vkCommandBuffer        = VK_NULL_HANDLE;
+        VkCommandBuffer     vkComputeCommandBuffer = VK_NULL_HANDLE;
+        VkFence             vkFence                = VK_NULL_HANDLE;
+
+        // Destination, regions, row pitch and layers of the last copy into the slot.
+        const void*            pData      = nullptr;
+        std::vector<DirtyRect> regions;
+        uint32_t               rowPitch   = 0u;
+        uint32_t               firstLayer = 0u;
+        uint32_t               layerCount = 1u;
+        VkDeviceSize           layerPitch = 0u;
+    };
+
+    struct ExportedImage
+    {
+        VulkanDevice        importer;
+
+        VkImage             vkImage        = VK_NULL_HANDLE;
+
+        // Dedicated memory, or a suballocation of the arena shared by both images.
+        VkDeviceMemory      vkImageMemory  = VK_NULL_HANDLE;
+        VkDeviceSize        allocationSize = 0u;
+
+        SharedMemoryArenaAllocation arenaAllocation;
+
+        // Exporter-side handle of the shared image timeline (unused by the host copy baseline).
+        VkSemaphore         vkTimelineSemaphore = VK_NULL_HANDLE;
+
+        std::vector<ReadbackSlot> readbackSlots;
+
+        // Importer-side buffer used only by the host copy baseline.
+        VulkanStagingBuffer hostCopyBuffer;
+
+        // Created by SetReadbackCompute.
+        ReadbackComputeTarget readbackCompute;
+
+        // Application memory imported by ImportReadbackHostMemory, not owned.
+        VulkanStagingBuffer hostReadbackBuffer;
+
+        // Layers later readbacks copy, set by SetReadbackLayers.
+        uint32_t            readbackFirstLayer = 0u;
+        uint32_t            readbackLayerCount = 1u;
+    };
+
+    void DestroyReadbackSlot(ReadbackSlot& readbackSlot)
+    {
+        if (readbackSlot.vkFence != VK_NULL_HANDLE)
+            vkDestroyFence(m_exporter.vkLogicalDevice, readbackSlot.vkFence, nullptr);
+
+        if (readbackSlot.vkCommandBuffer != VK_NULL_HANDLE)
+            vkFreeCommandBuffers(m_exporter.vkLogicalDevice, m_vkReadbackCommandPool, 1u, &readbackSlot.vkCommandBuffer);
+
+        if (readbackSlot.vkComputeCommandBuffer != VK_NULL_HANDLE)
+            vkFreeCommandBuffers(m_exporter.vkLogicalDevice, m_vkComputeCommandPool, 1u, &readbackSlot.vkComputeCommandBuffer);
+
+        DestroyVulkanStagingBuffer(m_exporter, readbackSlot.buffer);
+
+        readbackSlot = {};
+    }
+
+    // Creates an exportable image in a free exporter slot and an importer image bound to the same memory
+    // (or to private memory for the host copy baseline).
+    bool CreateExportedImage(const VulkanDevice& importer, const SharedImageDesc& desc, uint64_t& resourceId, ImportedImage& importedImage)
+    {
+        ExportedImage exportedImage;
+        exportedImage.importer           = importer;
+        exportedImage.readbackLayerCount = desc.arrayLayers;
+
+        const VkExternalMemoryHandleTypeFlags handleTypes = m_useHostCopy ? 0u : kVulkanExternalMemoryHandleType;
+
+        // Identically described images on both sides, bound to the same memory.
+        if (!CreateVulkanImage2D(m_exporter, desc, handleTypes, exportedImage.vkImage))
+            return false;
+
+        importedImage.vkDevice = importer.vkLogicalDevice;
+
+        bool bound = CreateVulkanImage2D(importer, desc, handleTypes, importedImage.vkImage);
+
+        VkMemoryRequirements vkArenaRequirements;
+        if (bound && GetArenaRequirements(importer, desc, exportedImage.vkImage, importedImage.vkImage, vkArenaRequirements) &&
+            m_arena.Allocate(vkArenaRequirements, exportedImage.arenaAllocation))
+        {
+            const SharedMemoryArenaAllocation& allocation = exportedImage.arenaAllocation;
+
+            bound = vkBindImageMemory(m_exporter.vkLogicalDevice, exportedImage.vkImage, allocation.vkExporterMemory, allocation.offset) == VK_SUCCESS &&
+                    vkBindImageMemory(importer.vkLogicalDevice, importedImage.vkImage, allocation.vkImporterMemory, allocation.offset) == VK_SUCCESS;
+
+            importedImage.size = allocation.size;
+
+            if (!bound)
+                spdlog::error("Failed to bind the shared image to its memory arena allocation.");
+        }
+        else if (bound)
+        {
+            bound = AllocateDedicatedMemory(importer, desc, exportedImage, importedImage);
+        }
+
+        if (!bound)
+        {
+            vkDestroyImage (importer.vkLogicalDevice, importedImage.vkImage,       nullptr);
+            vkFreeMemory   (importer.vkLogicalDevice, importedImage.vkImageMemory, nullptr);
+
+            DestroyExportedImage(exportedImage);
+            return false;
+        }
+
+        // Evicted images leave holes that are filled first.
+        resourceId = 0u;
+        while (resourceId < m_exportedImages.size() && m_exportedImages[resourceId].vkImage != VK_NULL_HANDLE)
+            resourceId++;
+
+        if (resourceId == m_exportedImages.size())
+            m_exportedImages.emplace_back();
+
+        m_exportedImages[resourceId] = exportedImage;
+
+        m_importCache.Insert({ resourceId, desc }, importedImage);
+
+        return true;
+    }
+
+    // Exportable dedicated memory for the exporter image, imported for the importer image (private memory on both
+    // sides for the host copy baseline).
+    bool AllocateDedicatedMemory(const VulkanDevice& importer, const SharedImageDesc& desc, ExportedImage& exportedImage, ImportedImage& importedImage)
+    {
+        const VkExternalMemoryHandleTypeFlags handleTypes = m_useHostCopy ? 0u : kVulkanExternalMemoryHandleType;
+
+        if (!AllocateVulkanImageMemory(m_exporter, exportedImage.vkImage, handleTypes, exportedImage.vkImageMemory, exportedImage.allocationSize))
+        {
+            spdlog::error("Failed to allocate exportable memory for the shared image.");
+            return false;
+        }
+
+        importedImage.size = exportedImage.allocationSize;
+
+        if (m_useHostCopy)
+        {
+            return AllocateVulkanImageMemory(importer, importedImage.vkImage, 0u, importedImage.vkImageMemory, importedImage.size) &&
+                   CreateVulkanStagingBuffer(importer, GetSharedImageSize(desc), VK_BUFFER_USAGE_TRANSFER_DST_BIT, exportedImage.hostCopyBuffer);
+        }
+
+        if (!ImportImageMemory(importer, exportedImage, importedImage.vkImage, importedImage.vkImageMemory))
+        {
+            spdlog::error("Failed to import the exported memory into the importer device.");
+            return false;
+        }
+
+        return true;
+    }
+
+    // Requirements of a suballocation satisfying both images. Returns false for images that keep a dedicated
+    // allocation: when the arena is disabled, when the driver only shares or prefers dedicated memory for them,
+    // and for images too large to share a block with others.
+    bool GetArenaRequirements(const VulkanDevice& importer, const SharedImageDesc& desc, VkImage vkExportedImage, VkImage vkImportedImage, VkMemoryRequirements& vkRequirements)
+    {
+        if (!m_useArena || IsVulkanExternalImageDedicatedOnly(m_exporter, desc, kVulkanExternalMemoryHandleType))
+            return false;
+
+        if (!m_arena.IsCreated())
+            m_arena.Create(m_exporter, importer, kVulkanExternalMemoryHandleType);
+
+        if (m_arena.GetImporter().vkLogicalDevice != importer.vkLogicalDevice)
+            return false;
+
+        VkMemoryRequirements vkExporterRequirements, vkImporterRequirements;
+        bool                 exporterPrefersDedicated, importerPrefersDedicated;
+
+        if (!GetVulkanImageMemoryRequirements(m_exporter, vkExportedImage, vkExporterRequirements, exporterPrefersDedicated) ||
+            !GetVulkanImageMemoryRequirements(importer,   vkImportedImage, vkImporterRequirements, importerPrefersDedicated))
+            return false;
+
+        vkRequirements.size           = std::max(vkExporterRequirements.size,      vkImporterRequirements.size);
+        vkRequirements.alignment      = std::max(vkExporterRequirements.alignment, vkImporterRequirements.alignment);
+        vkRequirements.memoryTypeBits = vkExporterRequirements.memoryTypeBits & vkImporterRequirements.memoryTypeBits;
+
+        return !exporterPrefersDedicated && !importerPrefersDedicated && vkRequirements.memoryTypeBits != 0u &&
+               vkRequirements.size <= m_arena.GetBlockSize() / 2u;
+    }
+
+    // Frees everything but the timeline, which DestroySharedImage already released.
+    void DestroyExportedImage(ExportedImage& exportedImage)
+    {
+        DestroyVulkanStagingBuffer(exportedImage.importer, exportedImage.hostCopyBuffer);
+
+        for (auto& readbackSlot : exportedImage.readbackSlots)
+        {
+            vkWaitForFences(m_exporter.vkLogicalDevice, 1u, &readbackSlot.vkFence, VK_TRUE, UINT64_MAX);
+            DestroyReadbackSlot(readbackSlot);
+        }
+
+        m_readbackCompute.DestroyTarget(exportedImage.readbackCompute);
+        DestroyVulkanStagingBuffer(m_exporter, exportedImage.hostReadbackBuffer);
+
+        vkDestroyImage (m_exporter.vkLogicalDevice, exportedImage.vkImage,       nullptr);
+        vkFreeMemory   (m_exporter.vkLogicalDevice, exportedImage.vkImageMemory, nullptr);
+
+        // Both images are destroyed by now, the import cache destroys the importer image before calling back.
+        m_arena.Free(exportedImage.arenaAllocation);
+
+        exportedImage = {};
+    }
+
+    bool ImportImageMemory(const VulkanDevice& importer, const ExportedImage& exportedImage, VkImage vkImage, VkDeviceMemory& vkImageMemory)
+    {
+        ExternalMemoryHandle memoryHandle;
+        if (!ExportVulkanMemoryHandle(m_exporter, exportedImage.vkImageMemory, memoryHandle))
+            return false;
+
+        return ImportVulkanImageMemory(importer, vkImage, memoryHandle, exportedImage.allocationSize, vkImageMemory);
+    }
+
+    // Acquires the image on the compute queue, converts it into the compute target and copies the frame to the destination.
+    bool SubmitComputeReadback(const ExportedImage& exportedImage, ReadbackSlot& readbackSlot, VkBuffer vkDestinationBuffer, VkDeviceSize destinationOffset, const VulkanTimelineSubmit& timelineSubmit)
+    {
+        const ReadbackComputeTarget& target          = exportedImage.readbackCompute;
+        const VkCommandBuffer        vkCommandBuffer = readbackSlot.vkComputeCommandBuffer;
+
+        VkCommandBufferBeginInfo vkCommandBeginInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+        vkCommandBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+        vkResetCommandBuffer(vkCommandBuffer, 0u);
+        vkBeginCommandBuffer(vkCommandBuffer, &vkCommandBeginInfo);
+
+        RecordVulkanImageBarrier(vkCommandBuffer, exportedImage.vkImage, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL, 0u, VK_ACCESS_SHADER_READ_BIT, VK_QUEUE_FAMILY_EXTERNAL, m_exporter.computeQueueIndex);
+
+        m_readbackCompute.RecordDispatch(vkCommandBuffer, target, vkDestinationBuffer, destinationOffset);
+
+        vkEndCommandBuffer(vkCommandBuffer);
+
+        readbackSlot.regions    = { { 0u, 0u, target.width, target.height } };
+        readbackSlot.rowPitch   = target.width;
+        readbackSlot.firstLayer = 0u;
+        readbackSlot.layerCount = 1u;
+        readbackSlot.layerPitch = target.outputSize;
+
+        m_readbackSubmitCount++;
+
+        return SubmitReadbackSlot(m_exporter.vkComputeQueue, vkCommandBuffer, timelineSubmit, readbackSlot);
+    }
+
+    // The slot's fence is only reset once nothing can fail before the submit that signals it, a readback that fails
+    // earlier leaves it signaled so that waits on the slot still return.
+    bool SubmitReadbackSlot(VkQueue vkQueue, VkCommandBuffer vkCommandBuffer, const VulkanTimelineSubmit& timelineSubmit, ReadbackSlot& readbackSlot)
+    {
+        vkResetFences(m_exporter.vkLogicalDevice, 1u, &readbackSlot.vkFence);
+
+        if (SubmitVulkanCommandBuffer(vkQueue, vkCommandBuffer, timelineSubmit, readbackSlot.vkFence))
+            return true;
+
+        // Signal the fence with an empty batch in place of the failed one.
+        vkQueueSubmit(vkQueue, 0u, nullptr, readbackSlot.vkFence);
+        return false;
+    }
+
+    bool CreateSharedTimeline(const VulkanDevice& importer, VkSemaphore& vkImporterSemaphore, VkSemaphore& vkExporterSemaphore)
+    {
+        // The baseline only synchronizes the importer with the host.
+        if (m_useHostCopy)
+            return CreateVulkanTimelineSemaphore(importer, 0u, vkImporterSemaphore);
+
+        vkImporterSemaphore = VK_NULL_HANDLE;
+        vkExporterSemaphore = VK_NULL_HANDLE;
+
+        bool shared = CreateVulkanTimelineSemaphore(importer, kVulkanExternalSemaphoreHandleType, vkImporterSemaphore) &&
+                      CreateVulkanTimelineSemaphore(m_exporter, 0u, vkExporterSemaphore);
+
+        ExternalSemaphoreHandle semaphoreHandle;
+        shared = shared && ExportVulkanSemaphoreHandle(importer, vkImporterSemaphore, semaphoreHandle);
+
+        if (shared)
+        {
+            shared = ImportVulkanSemaphoreHandle(m_exporter, vkExporterSemaphore, kVulkanExternalSemaphoreHandleType, semaphoreHandle);
+
+#if defined(_WIN32)
+            CloseExternalMemoryHandle(semaphoreHandle);
+#endif
+        }
+
+        if (shared)
+            return true;
+
+        // Destroy whichever semaphores were created.
+        if (vkImporterSemaphore != VK_NULL_HANDLE)
+            vkDestroySemaphore(importer.vkLogicalDevice, vkImporterSemaphore, nullptr);
+
+        if (vkExporterSemaphore != VK_NULL_HANDLE)
+            vkDestroySemaphore(m_exporter.vkLogicalDevice, vkExporterSemaphore, nullptr);
+
+        vkImporterSemaphore = VK_NULL_HANDLE;
+        vkExporterSemaphore = VK_NULL_HANDLE;
+
+        return false;
+    }
+
+    // Baseline path: importer image -> importer host buffer -> memcpy -> exporter host buffer -> exporter image.
+    bool CopyThroughHost(const SharedImage& sharedImage, uint64_t frameIndex, ExportedImage& exportedImage, const VulkanStagingBuffer& exporterBuffer)
+    {
+        TRACE_ZONE("Copy through host");
+
+        // A download on the importer and an upload on the exporter.
+        m_readbackSubmitCount += 2u;
+
+        VulkanTimelineSubmit timelineSubmit;
+        timelineSubmit.vkWaitSemaphore = sharedImage.vkTimelineSemaphore;
+        timelineSubmit.waitValue       = GetSharedImageRenderSignalValue(frameIndex);
+
+        const bool downloaded = SubmitVulkanCommandsImmediate(exportedImage.importer, [&](VkCommandBuffer vkCommandBuffer)
+        {
+            // Take back the ownership the importer released for the exporter, on the importer's transfer queue.
+            RecordVulkanImageBarrier(vkCommandBuffer, sharedImage.vkImage, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL, 0u, VK_ACCESS_TRANSFER_READ_BIT, VK_QUEUE_FAMILY_EXTERNAL, exportedImage.importer.transferQueueIndex);
+
+            RecordVulkanImageToBufferCopy(vkCommandBuffer, sharedImage.vkImage, VK_IMAGE_LAYOUT_GENERAL, exportedImage.hostCopyBuffer.vkBuffer, sharedImage.desc);
+        }, timelineSubmit, VulkanQueueType::Transfer);
+
+        if (!downloaded)
+            return false;
+
+        // The pixels are on the host now, the importer may render the next frame.
+        VkSemaphoreSignalInfo vkSignalInfo = { VK_STRUCTURE_TYPE_SEMAPHORE_SIGNAL_INFO };
+        vkSignalInfo.semaphore = sharedImage.vkTimelineSemaphore;
+        vkSignalInfo.value     = GetSharedImageReadSignalValue(frameIndex);
+
+        if (vkSignalSemaphore(exportedImage.importer.vkLogicalDevice, &vkSignalInfo) != VK_SUCCESS)
+            return false;
+
+        memcpy(exporterBuffer.pMappedData, exportedImage.hostCopyBuffer.pMappedData, GetSharedImageSize(sharedImage.desc));
+
+        return SubmitVulkanCommandsImmediate(m_exporter, [&](VkCommandBuffer vkCommandBuffer)
+        {
+            RecordVulkanImageBarrier(vkCommandBuffer, exportedImage.vkImage, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0u, VK_ACCESS_TRANSFER_WRITE_BIT);
+
+            VkBufferImageCopy vkCopyRegion = {};
+            vkCopyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            vkCopyRegion.imageSubresource.layerCount = sharedImage.desc.arrayLayers;
+            vkCopyRegion.imageExtent                 = { sharedImage.desc.width, sharedImage.desc.height, 1u };
+
+            vkCmdCopyBufferToImage(vkCommandBuffer, exporterBuffer.vkBuffer, exportedImage.vkImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1u, &vkCopyRegion);
+        }, {}, VulkanQueueType::Transfer);
+    }
+
+    bool                       m_useHostCopy;
+
+    // Whether new shared images are suballocated from m_arena, see EnableMemoryArena.
+    bool                       m_useArena;
+
+    VulkanDevice               m_exporter;
+
+    // Whether dirty tiles can be copied with region copies on the readback queue, otherwise readbacks copy whole images.
+    bool                       m_regionCopies = false;
+
+    uint64_t                   m_readbackSubmitCount = 0u;
+
+    // Exporter command buffers of the readback slots are allocated from here, for the transfer and compute queues.
+    VkCommandPool              m_vkReadbackCommandPool = VK_NULL_HANDLE;
+    VkCommandPool              m_vkComputeCommandPool  = VK_NULL_HANDLE;
+
+    // Created with the first readback compute stage.
+    ReadbackComputePipeline    m_readbackCompute;
+
+    // minImportedHostPointerAlignment of VK_EXT_external_memory_host, 0 without it.
+    VkDeviceSize               m_hostImportAlignment = 0u;
+
+    // GPU zones of the readbacks, null unless tracing.
+    VulkanTraceQueries*        m_pTraceQueries = nullptr;
+
+    // Declared before the images so that it outlives them.
+    SharedMemoryArena          m_arena;
+
+    std::vector<ExportedImage> m_exportedImages;
+
+    ImportCache                m_importCache { [this](uint64_t resourceId) { DestroyExportedImage(m_exportedImages[resourceId]); } };
+};
+
+std::unique_ptr<InteropBackend> CreateVulkanInteropBackend(bool useHostCopy)
+{
+    return std::make_unique<VulkanInteropBackend>(useHostCopy);
+}
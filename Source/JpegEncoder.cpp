@@ -0,0 +1,624 @@
+#include "JpegEncoder.h"
+
+#include <algorithm>
+#include <cstdio>
+
+#include <spdlog/spdlog.h>
+
+#include "Simd.h"
+#include "ThreadPool.h"
+#include "Trace.h"
+
+// Tables
+// ------------------------------------------------
+
+// Natural (row-major) index of each zig-zag position.
+static constexpr uint8_t kZigZagToNatural[64] =
+{
+     0,  1,  8, 16,  9,  2,  3, 10, 17, 24, 32, 25, 18, 11,  4,  5,
+    12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13,  6,  7, 14, 21, 28,
+    35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+    58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63,
+};
+
+// Annex K quantization tables in natural order.
+static constexpr uint8_t kLuminanceQuantization[64] =
+{
+    16, 11, 10, 16,  24,  40,  51,  61,  12, 12, 14, 19,  26,  58,  60,  55,
+    14, 13, 16, 24,  40,  57,  69,  56,  14, 17, 22, 29,  51,  87,  80,  62,
+    18, 22, 37, 56,  68, 109, 103,  77,  24, 35, 55, 64,  81, 104, 113,  92,
+    49, 64, 78, 87, 103, 121, 120, 101,  72, 92, 95, 98, 112, 100, 103,  99,
+};
+
+static constexpr uint8_t kChrominanceQuantization[64] =
+{
+    17, 18, 24, 47, 99, 99, 99, 99,  18, 21, 26, 66, 99, 99, 99, 99,
+    24, 26, 56, 99, 99, 99, 99, 99,  47, 66, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99,  99, 99, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99,  99, 99, 99, 99, 99, 99, 99, 99,
+};
+
+// Annex K Huffman tables: code counts per length 1..16 followed by the symbols.
+static constexpr uint8_t kDCLuminanceCounts[16]   = { 0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0 };
+static constexpr uint8_t kDCChrominanceCounts[16] = { 0, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0 };
+static constexpr uint8_t kDCSymbols[12]           = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11 };
+
+static constexpr uint8_t kACLuminanceCounts[16] = { 0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0, 0, 1, 0x7d };
+static constexpr uint8_t kACLuminanceSymbols[162] =
+{
+    0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x41, 0x06, 0x13, 0x51, 0x61, 0x07, 0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xa1, 0x08,
+    0x23, 0x42, 0xb1, 0xc1, 0x15, 0x52, 0xd1, 0xf0, 0x24, 0x33, 0x62, 0x72, 0x82, 0x09, 0x0a, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x25, 0x26, 0x27, 0x28,
+    0x29, 0x2a, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59,
+    0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89,
+    0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6,
+    0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xe1, 0xe2,
+    0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa,
+};
+
+static constexpr uint8_t kACChrominanceCounts[16] = { 0, 2, 1, 2, 4, 4, 3, 4, 7, 5, 4, 4, 0, 1, 2, 0x77 };
+static constexpr uint8_t kACChrominanceSymbols[162] =
+{
+    0x00, 0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21, 0x31, 0x06, 0x12, 0x41, 0x51, 0x07, 0x61, 0x71, 0x13, 0x22, 0x32, 0x81, 0x08, 0x14, 0x42, 0x91,
+    0xa1, 0xb1, 0xc1, 0x09, 0x23, 0x33, 0x52, 0xf0, 0x15, 0x62, 0x72, 0xd1, 0x0a, 0x16, 0x24, 0x34, 0xe1, 0x25, 0xf1, 0x17, 0x18, 0x19, 0x1a, 0x26,
+    0x27, 0x28, 0x29, 0x2a, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58,
+    0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87,
+    0x88, 0x89, 0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4,
+    0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda,
+    0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa,
+};
+
+// AAN DCT output scale per frequency, multiplied by sqrt(8).
+static constexpr float kAANScale[8] =
+{
+    1.0f * 2.828427125f, 1.387039845f * 2.828427125f, 1.306562965f * 2.828427125f, 1.175875602f * 2.828427125f,
+    1.0f * 2.828427125f, 0.785694958f * 2.828427125f, 0.541196100f * 2.828427125f, 0.275899379f * 2.828427125f,
+};
+
+// Rows between restart markers are kept to whole MCU rows, with a few stripes per thread to balance the load.
+constexpr uint32_t kJpegStripesPerThread = 4u;
+
+struct HuffmanTable
+{
+    uint16_t codes[256]   = {};
+    uint8_t  lengths[256] = {};
+};
+
+struct JpegTables
+{
+    // Reciprocal quantization steps including the AAN scale, laid out like the transposed DCT output.
+    alignas(16) float luminanceScale[64];
+    alignas(16) float chrominanceScale[64];
+
+    // Quantization tables in zig-zag order, as written to the DQT segment.
+    uint8_t luminanceQuantization[64];
+    uint8_t chrominanceQuantization[64];
+};
+
+static HuffmanTable BuildHuffmanTable(const uint8_t* pCounts, const uint8_t* pSymbols)
+{
+    HuffmanTable table;
+
+    uint16_t code        = 0u;
+    uint32_t symbolIndex = 0u;
+
+    for (uint32_t length = 1u; length <= 16u; length++)
+    {
+        for (uint32_t i = 0u; i < pCounts[length - 1u]; i++)
+        {
+            table.codes  [pSymbols[symbolIndex]] = code++;
+            table.lengths[pSymbols[symbolIndex]] = (uint8_t)length;
+            symbolIndex++;
+        }
+
+        code <<= 1;
+    }
+
+    return table;
+}
+
+struct HuffmanTables
+{
+    HuffmanTable dcLuminance   = BuildHuffmanTable(kDCLuminanceCounts,   kDCSymbols);
+    HuffmanTable acLuminance   = BuildHuffmanTable(kACLuminanceCounts,   kACLuminanceSymbols);
+    HuffmanTable dcChrominance = BuildHuffmanTable(kDCChrominanceCounts, kDCSymbols);
+    HuffmanTable acChrominance = BuildHuffmanTable(kACChrominanceCounts, kACChrominanceSymbols);
+};
+
+static const HuffmanTables& GetHuffmanTables()
+{
+    static const HuffmanTables huffmanTables;
+    return huffmanTables;
+}
+
+static void BuildJpegTables(uint32_t quality, JpegTables& tables)
+{
+    // Same quality curve as stbi_write_jpg and libjpeg.
+    quality = std::clamp(quality, 1u, 100u);
+    quality = quality < 50u ? 5000u / quality : 200u - quality * 2u;
+
+    for (uint32_t zigZagIndex = 0u; zigZagIndex < 64u; zigZagIndex++)
+    {
+        const uint32_t naturalIndex = kZigZagToNatural[zigZagIndex];
+
+        tables.luminanceQuantization  [zigZagIndex] = (uint8_t)std::clamp((kLuminanceQuantization  [naturalIndex] * quality + 50u) / 100u, 1u, 255u);
+        tables.chrominanceQuantization[zigZagIndex] = (uint8_t)std::clamp((kChrominanceQuantization[naturalIndex] * quality + 50u) / 100u, 1u, 255u);
+
+        const uint32_t row    = naturalIndex / 8u;
+        const uint32_t column = naturalIndex % 8u;
+        const float    scale  = kAANScale[row] * kAANScale[column];
+
+        // The DCT leaves coefficient (row, column) at (column, row).
+        tables.luminanceScale  [column * 8u + row] = 1.0f / (tables.luminanceQuantization  [zigZagIndex] * scale);
+        tables.chrominanceScale[column * 8u + row] = 1.0f / (tables.chrominanceQuantization[zigZagIndex] * scale);
+    }
+}
+
+// Transform
+// ------------------------------------------------
+
+// 8x8 block of samples as 8 rows of two 4-wide halves.
+struct FloatBlock
+{
+    Float4 rows[8][2];
+};
+
+// One dimensional AAN forward DCT (jfdctflt) applied lane-wise to eight vectors.
+static inline void ForwardDCT8(Float4& d0, Float4& d1, Float4& d2, Float4& d3, Float4& d4, Float4& d5, Float4& d6, Float4& d7)
+{
+    const Float4 tmp0 = d0 + d7;
+    const Float4 tmp7 = d0 - d7;
+    const Float4 tmp1 = d1 + d6;
+    const Float4 tmp6 = d1 - d6;
+    const Float4 tmp2 = d2 + d5;
+    const Float4 tmp5 = d2 - d5;
+    const Float4 tmp3 = d3 + d4;
+    const Float4 tmp4 = d3 - d4;
+
+    // Even part.
+    Float4 tmp10 = tmp0 + tmp3;
+    Float4 tmp13 = tmp0 - tmp3;
+    Float4 tmp11 = tmp1 + tmp2;
+    Float4 tmp12 = tmp1 - tmp2;
+
+    d0 = tmp10 + tmp11;
+    d4 = tmp10 - tmp11;
+
+    const Float4 z1 = (tmp12 + tmp13) * 0.707106781f;
+    d2 = tmp13 + z1;
+    d6 = tmp13 - z1;
+
+    // Odd part.
+    tmp10 = tmp4 + tmp5;
+    tmp11 = tmp5 + tmp6;
+    tmp12 = tmp6 + tmp7;
+
+    const Float4 z5 = (tmp10 - tmp12) * 0.382683433f;
+    const Float4 z2 = tmp10 * 0.541196100f + z5;
+    const Float4 z4 = tmp12 * 1.306562965f + z5;
+    const Float4 z3 = tmp11 * 0.707106781f;
+
+    const Float4 z11 = tmp7 + z3;
+    const Float4 z13 = tmp7 - z3;
+
+    d5 = z13 + z2;
+    d3 = z13 - z2;
+    d1 = z11 + z4;
+    d7 = z11 - z4;
+}
+
+static inline void ForwardDCTColumns(FloatBlock& block)
+{
+    for (int half = 0; half < 2; half++)
+    {
+        auto& r = block.rows;
+        ForwardDCT8(r[0][half], r[1][half], r[2][half], r[3][half], r[4][half], r[5][half], r[6][half], r[7][half]);
+    }
+}
+
+static inline void TransposeBlock(FloatBlock& block)
+{
+    auto& r = block.rows;
+
+    Transpose4(r[0][0], r[1][0], r[2][0], r[3][0]);
+    Transpose4(r[0][1], r[1][1], r[2][1], r[3][1]);
+    Transpose4(r[4][0], r[5][0], r[6][0], r[7][0]);
+    Transpose4(r[4][1], r[5][1], r[6][1], r[7][1]);
+
+    for (int row = 0; row < 4; row++)
+        std::swap(r[row][1], r[row + 4][0]);
+}
+
+// Transforms and quantizes a block of level-shifted samples into zig-zag ordered coefficients.
+static void QuantizeBlock(FloatBlock& block, const float* pScale, int32_t* pCoefficients)
+{
+    // Columns, then rows through the transpose; the result stays transposed, pScale accounts for it.
+    ForwardDCTColumns(block);
+    TransposeBlock(block);
+    ForwardDCTColumns(block);
+
+    alignas(16) int32_t quantized[64];
+    for (int row = 0; row < 8; row++)
+    {
+        for (int half = 0; half < 2; half++)
+        {
+            const int offset = row * 8 + half * 4;
+            (block.rows[row][half] * Float4::Load(pScale + offset)).StoreRoundedInt32(quantized + offset);
+        }
+    }
+
+    for (int zigZagIndex = 0; zigZagIndex < 64; zigZagIndex++)
+    {
+        const int naturalIndex = kZigZagToNatural[zigZagIndex];
+        pCoefficients[zigZagIndex] = quantized[(naturalIndex % 8) * 8 + naturalIndex / 8];
+    }
+}
+
+// Color conversion
+// ------------------------------------------------
+
+struct JpegImage
+{
+    const uint8_t* pPixels;
+    uint32_t       width;
+    uint32_t       height;
+    uint32_t       rowPitch;
+};
+
+// Returns pointers to the size x size tile at (x, y). Tiles crossing the image edge are copied to pScratch
+// with the edge pixels repeated.
+static void GatherTile(const JpegImage& image, uint32_t x, uint32_t y, uint32_t size, const uint8_t** ppRows, uint8_t* pScratch)
+{
+    if (x + size <= image.width && y + size <= image.height)
+    {
+        for (uint32_t row = 0u; row < size; row++)
+            ppRows[row] = image.pPixels + (size_t)(y + row) * image.rowPitch + (size_t)x * 4u;
+
+        return;
+    }
+
+    for (uint32_t row = 0u; row < size; row++)
+    {
+        const uint8_t* pSourceRow = image.pPixels + (size_t)std::min(y + row, image.height - 1u) * image.rowPitch;
+
+        for (uint32_t column = 0u; column < size; column++)
+            memcpy(pScratch + (row * size + column) * 4u, pSourceRow + (size_t)std::min(x + column, image.width - 1u) * 4u, 4u);
+
+        ppRows[row] = pScratch + row * size * 4u;
+    }
+}
+
+// Converts 8x8 RGBA pixels starting at column offset x of the given rows to level-shifted YCbCr.
+static inline void ConvertBlock(const uint8_t* const* ppRows, uint32_t x, FloatBlock& luma, FloatBlock& blue, FloatBlock& red)
+{
+    const Float4 kLevelShift = Float4::Set1(128.0f);
+
+    for (int row = 0; row < 8; row++)
+    {
+        for (int half = 0; half < 2; half++)
+        {
+            Float4 r, g, b;
+            LoadRGBA8(ppRows[row] + (x + half * 4u) * 4u, r, g, b);
+
+            luma.rows[row][half] = r *  0.29900f + g *  0.58700f + b *  0.11400f - kLevelShift;
+            blue.rows[row][half] = r * -0.16874f + g * -0.33126f + b *  0.50000f;
+            red .rows[row][half] = r *  0.50000f + g * -0.41869f + b * -0.08131f;
+        }
+    }
+}
+
+// Averages each 2x2 group of four chroma blocks laid out as a 16x16 tile into one block.
+static void DownsampleChroma(const FloatBlock (&blocks)[2][2], FloatBlock& downsampled)
+{
+    alignas(16) float source[16][16];
+    alignas(16) float result[8][8];
+
+    for (int blockY = 0; blockY < 2; blockY++)
+        for (int blockX = 0; blockX < 2; blockX++)
+            for (int row = 0; row < 8; row++)
+                for (int half = 0; half < 2; half++)
+                    blocks[blockY][blockX].rows[row][half].Store(&source[blockY * 8 + row][blockX * 8 + half * 4]);
+
+    for (int row = 0; row < 8; row++)
+        for (int column = 0; column < 8; column++)
+            result[row][column] = 0.25f * (source[row * 2][column * 2] + source[row * 2][column * 2 + 1] + source[row * 2 + 1][column * 2] + source[row * 2 + 1][column * 2 + 1]);
+
+    for (int row = 0; row < 8; row++)
+        for (int half = 0; half < 2; half++)
+            downsampled.rows[row][half] = Float4::Load(&result[row][half * 4]);
+}
+
+// Entropy coding
+// ------------------------------------------------
+
+class BitWriter
+{
+public:
+    explicit BitWriter(std::vector<uint8_t>& output) : m_output(output) {}
+
+    void Write(uint32_t code, uint32_t length)
+    {
+        m_bitCount  += length;
+        m_bitBuffer |= code << (24u - m_bitCount);
+
+        while (m_bitCount >= 8u)
+        {
+            const uint8_t byte = (uint8_t)(m_bitBuffer >> 16);
+            m_output.push_back(byte);
+
+            // Byte stuffing: 0xFF in entropy coded data is followed by 0x00.
+            if (byte == 0xFFu)
+                m_output.push_back(0u);
+
+            m_bitBuffer <<= 8;
+            m_bitCount   -= 8u;
+        }
+    }
+
+    // Pads the last byte with one bits, required before a marker.
+    void Flush() { Write(0x7Fu, 7u); m_bitBuffer = 0u; m_bitCount = 0u; }
+
+private:
+    std::vector<uint8_t>& m_output;
+
+    uint32_t m_bitBuffer = 0u;
+    uint32_t m_bitCount  = 0u;
+};
+
+// Number of bits of the magnitude and its JPEG representation (one's complement for negatives).
+static inline void GetMagnitude(int32_t value, uint32_t& bits, uint32_t& length)
+{
+    const uint32_t magnitude = (uint32_t)(value < 0 ? -value : value);
+
+    length = 0u;
+    for (uint32_t remaining = magnitude; remaining != 0u; remaining >>= 1)
+        length++;
+
+    bits = (uint32_t)(value < 0 ? value - 1 : value) & ((1u << length) - 1u);
+}
+
+static void EncodeBlock(BitWriter& writer, const int32_t* pCoefficients, int32_t& previousDC, const HuffmanTable& dcTable, const HuffmanTable& acTable)
+{
+    uint32_t bits, length;
+
+    GetMagnitude(pCoefficients[0] - previousDC, bits, length);
+    writer.Write(dcTable.codes[length], dcTable.lengths[length]);
+    writer.Write(bits, length);
+
+    previousDC = pCoefficients[0];
+
+    int lastNonZero = 63;
+    while (lastNonZero > 0 && pCoefficients[lastNonZero] == 0)
+        lastNonZero--;
+
+    uint32_t zeroRun = 0u;
+    for (int index = 1; index <= lastNonZero; index++)
+    {
+        if (pCoefficients[index] == 0)
+        {
+            zeroRun++;
+            continue;
+        }
+
+        // ZRL: sixteen zeros.
+        for (; zeroRun >= 16u; zeroRun -= 16u)
+            writer.Write(acTable.codes[0xF0], acTable.lengths[0xF0]);
+
+        GetMagnitude(pCoefficients[index], bits, length);
+
+        const uint32_t symbol = (zeroRun << 4) | length;
+        writer.Write(acTable.codes[symbol], acTable.lengths[symbol]);
+        writer.Write(bits, length);
+
+        zeroRun = 0u;
+    }
+
+    // EOB
+    if (lastNonZero < 63)
+        writer.Write(acTable.codes[0x00], acTable.lengths[0x00]);
+}
+
+// Encodes MCU rows [mcuRowBegin, mcuRowEnd) as one restart interval, predictors start from zero.
+static void EncodeStripe(const JpegImage& image, const JpegTables& tables, bool subsample, uint32_t mcuRowBegin, uint32_t mcuRowEnd, std::vector<uint8_t>& output)
+{
+    const auto& huffmanTables = GetHuffmanTables();
+
+    const uint32_t mcuSize = subsample ? 16u : 8u;
+
+    BitWriter writer(output);
+
+    int32_t previousDC[3] = { 0, 0, 0 };
+
+    const uint8_t* pRows[16];
+    uint8_t        scratch[16 * 16 * 4];
+
+    alignas(16) int32_t coefficients[64];
+
+    for (uint32_t y = mcuRowBegin * mcuSize; y < mcuRowEnd * mcuSize; y += mcuSize)
+    {
+        for (uint32_t x = 0u; x < image.width; x += mcuSize)
+        {
+            GatherTile(image, x, y, mcuSize, pRows, scratch);
+
+            if (!subsample)
+            {
+                FloatBlock luma, blue, red;
+                ConvertBlock(pRows, 0u, luma, blue, red);
+
+                QuantizeBlock(luma, tables.luminanceScale, coefficients);
+                EncodeBlock(writer, coefficients, previousDC[0], huffmanTables.dcLuminance, huffmanTables.acLuminance);
+
+                QuantizeBlock(blue, tables.chrominanceScale, coefficients);
+                EncodeBlock(writer, coefficients, previousDC[1], huffmanTables.dcChrominance, huffmanTables.acChrominance);
+
+                QuantizeBlock(red, tables.chrominanceScale, coefficients);
+                EncodeBlock(writer, coefficients, previousDC[2], huffmanTables.dcChrominance, huffmanTables.acChrominance);
+
+                continue;
+            }
+
+            // 4:2:0, four luma blocks in raster order followed by one block per chroma component.
+            FloatBlock blueBlocks[2][2];
+            FloatBlock redBlocks[2][2];
+
+            for (uint32_t blockY = 0u; blockY < 2u; blockY++)
+            {
+                for (uint32_t blockX = 0u; blockX < 2u; blockX++)
+                {
+                    FloatBlock luma;
+                    ConvertBlock(pRows + blockY * 8u, blockX * 8u, luma, blueBlocks[blockY][blockX], redBlocks[blockY][blockX]);
+
+                    QuantizeBlock(luma, tables.luminanceScale, coefficients);
+                    EncodeBlock(writer, coefficients, previousDC[0], huffmanTables.dcLuminance, huffmanTables.acLuminance);
+                }
+            }
+
+            FloatBlock chroma;
+
+            DownsampleChroma(blueBlocks, chroma);
+            QuantizeBlock(chroma, tables.chrominanceScale, coefficients);
+            EncodeBlock(writer, coefficients, previousDC[1], huffmanTables.dcChrominance, huffmanTables.acChrominance);
+
+            DownsampleChroma(redBlocks, chroma);
+            QuantizeBlock(chroma, tables.chrominanceScale, coefficients);
+            EncodeBlock(writer, coefficients, previousDC[2], huffmanTables.dcChrominance, huffmanTables.acChrominance);
+        }
+    }
+
+    writer.Flush();
+}
+
+// Container
+// ------------------------------------------------
+
+static void WriteMarkerSegment(std::vector<uint8_t>& output, uint8_t marker, std::initializer_list<uint8_t> payload)
+{
+    const uint32_t length = (uint32_t)payload.size() + 2u;
+
+    output.insert(output.end(), { 0xFF, marker, (uint8_t)(length >> 8), (uint8_t)length });
+    output.insert(output.end(), payload);
+}
+
+static void WriteHuffmanTable(std::vector<uint8_t>& output, uint8_t tableClassAndIndex, const uint8_t* pCounts, const uint8_t* pSymbols, uint32_t symbolCount)
+{
+    output.push_back(tableClassAndIndex);
+    output.insert(output.end(), pCounts,  pCounts  + 16u);
+    output.insert(output.end(), pSymbols, pSymbols + symbolCount);
+}
+
+static void WriteJpegHeader(std::vector<uint8_t>& output, const JpegImage& image, const JpegTables& tables, bool subsample, uint32_t restartInterval)
+{
+    // SOI
+    output.insert(output.end(), { 0xFF, 0xD8 });
+
+    // APP0 (JFIF 1.1, no thumbnail)
+    WriteMarkerSegment(output, 0xE0, { 'J', 'F', 'I', 'F', 0, 1, 1, 0, 0, 1, 0, 1, 0, 0 });
+
+    // DQT
+    output.insert(output.end(), { 0xFF, 0xDB, 0x00, 0x84, 0x00 });
+    output.insert(output.end(), tables.luminanceQuantization, tables.luminanceQuantization + 64);
+    output.push_back(0x01);
+    output.insert(output.end(), tables.chrominanceQuantization, tables.chrominanceQuantization + 64);
+
+    // SOF0
+    const uint8_t lumaSampling = subsample ? 0x22 : 0x11;
+    WriteMarkerSegment(output, 0xC0,
+    {
+        8,
+        (uint8_t)(image.height >> 8), (uint8_t)image.height,
+        (uint8_t)(image.width  >> 8), (uint8_t)image.width,
+        3,
+        1, lumaSampling, 0,
+        2, 0x11,         1,
+        3, 0x11,         1,
+    });
+
+    // DHT
+    output.insert(output.end(), { 0xFF, 0xC4, 0x01, 0xA2 });
+    WriteHuffmanTable(output, 0x00, kDCLuminanceCounts,   kDCSymbols,            sizeof(kDCSymbols));
+    WriteHuffmanTable(output, 0x10, kACLuminanceCounts,   kACLuminanceSymbols,   sizeof(kACLuminanceSymbols));
+    WriteHuffmanTable(output, 0x01, kDCChrominanceCounts, kDCSymbols,            sizeof(kDCSymbols));
+    WriteHuffmanTable(output, 0x11, kACChrominanceCounts, kACChrominanceSymbols, sizeof(kACChrominanceSymbols));
+
+    // DRI
+    WriteMarkerSegment(output, 0xDD, { (uint8_t)(restartInterval >> 8), (uint8_t)restartInterval });
+
+    // SOS
+    WriteMarkerSegment(output, 0xDA, { 3, 1, 0x00, 2, 0x11, 3, 0x11, 0, 63, 0 });
+}
+
+bool EncodeJpeg(ThreadPool& threadPool, const void* pPixels, uint32_t width, uint32_t height, uint32_t rowPitch, uint32_t quality, std::vector<uint8_t>& jpegData)
+{
+    if (width == 0u || height == 0u || width > 0xFFFFu || height > 0xFFFFu || rowPitch < width * 4u)
+    {
+        spdlog::error("Cannot encode a {}x{} image with a row pitch of {} bytes as JPEG.", width, height, rowPitch);
+        return false;
+    }
+
+    TRACE_ZONE("Encode JPEG");
+
+    const JpegImage image = { (const uint8_t*)pPixels, width, height, rowPitch };
+
+    const bool subsample = quality <= 90u;
+
+    JpegTables tables;
+    BuildJpegTables(quality, tables);
+
+    const uint32_t mcuSize     = subsample ? 16u : 8u;
+    const uint32_t mcusPerRow  = (width  + mcuSize - 1u) / mcuSize;
+    const uint32_t mcuRowCount = (height + mcuSize - 1u) / mcuSize;
+
+    // The restart interval is counted in MCUs and limited to 16 bits.
+    const uint32_t targetStripes    = threadPool.GetThreadCount() * kJpegStripesPerThread;
+    const uint32_t mcuRowsPerStripe = std::clamp((mcuRowCount + targetStripes - 1u) / targetStripes, 1u, 0xFFFFu / mcusPerRow);
+    const uint32_t stripeCount      = (mcuRowCount + mcuRowsPerStripe - 1u) / mcuRowsPerStripe;
+
+    std::vector<std::vector<uint8_t>> stripes(stripeCount);
+
+    threadPool.ParallelFor(stripeCount, [&](uint32_t stripeIndex)
+    {
+        TRACE_ZONE("Encode JPEG stripe");
+
+        auto& stripe = stripes[stripeIndex];
+        stripe.reserve((size_t)mcuRowsPerStripe * mcuSize * width);
+
+        const uint32_t mcuRowBegin = stripeIndex * mcuRowsPerStripe;
+        EncodeStripe(image, tables, subsample, mcuRowBegin, std::min(mcuRowBegin + mcuRowsPerStripe, mcuRowCount), stripe);
+    });
+
+    jpegData.clear();
+    WriteJpegHeader(jpegData, image, tables, subsample, mcusPerRow * mcuRowsPerStripe);
+
+    for (uint32_t stripeIndex = 0u; stripeIndex < stripeCount; stripeIndex++)
+    {
+        // RST0..RST7 separate the restart intervals.
+        if (stripeIndex > 0u)
+            jpegData.insert(jpegData.end(), { 0xFF, (uint8_t)(0xD0 + ((stripeIndex - 1u) & 7u)) });
+
+        jpegData.insert(jpegData.end(), stripes[stripeIndex].begin(), stripes[stripeIndex].end());
+    }
+
+    // EOI
+    jpegData.insert(jpegData.end(), { 0xFF, 0xD9 });
+
+    return true;
+}
+
+bool WriteJpegFile(const char* pFileName, ThreadPool& threadPool, const void* pPixels, uint32_t width, uint32_t height, uint32_t rowPitch, uint32_t quality)
+{
+    std::vector<uint8_t> jpegData;
+    if (!EncodeJpeg(threadPool, pPixels, width, height, rowPitch, quality, jpegData))
+        return false;
+
+    FILE* pFile = fopen(pFileName, "wb");
+    if (pFile == nullptr)
+    {
+        spdlog::error("Failed to open {} for writing.", pFileName);
+        return false;
+    }
+
+    const bool written = fwrite(jpegData.data(), 1u, jpegData.size(), pFile) == jpegData.size();
+
+    fclose(pFile);
+
+    return written;
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+class ThreadPool;
+
+// Encodes 4-byte RGBA pixels (alpha is ignored) as a baseline JPEG, rows are rowPitch bytes apart.
+// The scan is split into restart-interval stripes of whole MCU rows that are converted, transformed and
+// entropy coded in parallel on threadPool, then joined with RSTn markers. Quality and chroma subsampling
+// follow stbi_write_jpg (4:4:4 above quality 90, 4:2:0 otherwise).
+bool EncodeJpeg(ThreadPool& threadPool, const void* pPixels, uint32_t width, uint32_t height, uint32_t rowPitch, uint32_t quality, std::vector<uint8_t>& jpegData);
+
+bool WriteJpegFile(const char* pFileName, ThreadPool& threadPool, const void* pPixels, uint32_t width, uint32_t height, uint32_t rowPitch, uint32_t quality);
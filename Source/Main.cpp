@@ -1,428 +1,537 @@
 #include <climits>
 #include <cstdint>
-
-#include <dxgi.h>
-#include <dxgidebug.h>
-#include <dxgi1_6.h>
-
-#include <d3d11.h>
+#include <cstdio>
 
 #include <spdlog/spdlog.h>
 
-// Compile Vulkan for usage of extension:
-// VK_NV_external_memory_win32
-#define VK_USE_PLATFORM_WIN32_KHR
-
-#define VOLK_IMPLEMENTATION
-#include <volk.h>
+#include "CommandLine.h"
+#include "DeviceCache.h"
+#include "ExternalImage.h"
+#include "FrameCodec.h"
+#include "FrameContext.h"
+#include "FrameStream.h"
+#include "ImportCache.h"
+#include "JpegEncoder.h"
+#include "PixelConversion.h"
+#include "ReadbackRing.h"
+#include "Statistics.h"
+#include "ThreadPool.h"
+#include "Trace.h"
+#include "VideoFile.h"
 
 // This experiment just writes images to disk, no swapchain or OS window.
+// stb is only kept as the reference for --check-encoder.
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include <stb_image_write.h>
 
-constexpr const char* kOutputFileName = "Output.jpg";
-
-#include <format>
-#include <wrl.h>
-#include <codecvt>
-#include <filesystem>
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
 
-using namespace Microsoft::WRL;
+constexpr const char* kOutputFileName    = "Output.jpg";
+constexpr uint32_t    kOutputJpegQuality = 100u;
 
-const UINT kTestImageWidth  = 1920;
-const UINT kTestImageHeight = 1080;
+// The parallel encoder may trail stbi_write_jpg by at most this much PSNR on the check pattern.
+constexpr double kJpegMaxPsnrLossDb = 0.5;
 
-bool SelectVulkanPhysicalDevice(const VkInstance& vkInstance, const std::vector<const char*> requiredExtensions, IDXGIAdapter* pDXGIAdapter, VkPhysicalDevice& vkPhysicalDevice)
-{    
-    uint32_t deviceCount = 0u;
-    vkEnumeratePhysicalDevices(vkInstance, &deviceCount, nullptr);
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
 
-    std::vector<VkPhysicalDevice> vkPhysicalDevices(deviceCount);
-    vkEnumeratePhysicalDevices(vkInstance, &deviceCount, vkPhysicalDevices.data());
+constexpr uint32_t kTestImageWidth  = 1920;
+constexpr uint32_t kTestImageHeight = 1080;
 
-    DXGI_ADAPTER_DESC selectedAdapterDesc;
-    pDXGIAdapter->GetDesc(&selectedAdapterDesc);
+// Frames preallocated in the video file when --stream is given without --frames.
+constexpr uint32_t kDefaultCaptureFrameCount = 300u;
 
-    std::wstring_convert<std::codecvt_utf8<wchar_t>, wchar_t> wideStringConvert;
-    const auto dxgiAdapterName = wideStringConvert.to_bytes(selectedAdapterDesc.Description);
+// Startup caches, in the working directory. Both are keyed by the driver, so an update only costs one cold start.
+constexpr const char* kDeviceCacheFileName   = "VulkanDeviceCache.bin";
+constexpr const char* kPipelineCacheFileName = "VulkanPipelineCache.bin";
 
-    vkPhysicalDevice = VK_NULL_HANDLE;
+// PSNR of the RGB channels of two tightly packed RGBA images.
+static double ComputeRGBPsnr(const uint8_t* pImageA, const uint8_t* pImageB, size_t pixelCount)
+{
+    double squaredErrorSum = 0.0;
 
-    for (const auto& physicalDevice : vkPhysicalDevices)
+    for (size_t byteIndex = 0u; byteIndex < pixelCount * 4u; byteIndex++)
     {
-        VkPhysicalDeviceProperties physicalDeviceProperties;
-        vkGetPhysicalDeviceProperties(physicalDevice, &physicalDeviceProperties);
-
-        if (strcmp(dxgiAdapterName.c_str(), physicalDeviceProperties.deviceName))
+        if (byteIndex % 4u == 3u)
             continue;
 
-        // Found the matching Vulkan Physical Device for the existing DXGI Adapter.
-        vkPhysicalDevice = physicalDevice;
-
-        break;
+        const double error = (double)pImageA[byteIndex] - (double)pImageB[byteIndex];
+        squaredErrorSum += error * error;
     }
 
-    if (vkPhysicalDevice == VK_NULL_HANDLE)
-        return false;
+    const double meanSquaredError = squaredErrorSum / (pixelCount * 3u);
+
+    return meanSquaredError > 0.0 ? 10.0 * std::log10(255.0 * 255.0 / meanSquaredError) : INFINITY;
+}
 
-    // Confirm that the selected physical device supports the required extensions.
-    uint32_t supportedDeviceExtensionCount; 
-    vkEnumerateDeviceExtensionProperties(vkPhysicalDevice, nullptr, &supportedDeviceExtensionCount, nullptr);
+// Encodes a test pattern with padded rows through stbi_write_jpg and through the parallel encoder, decodes both
+// with stb_image and compares them with the source.
+static bool CheckJpegEncoder(ThreadPool& threadPool)
+{
+    constexpr uint32_t kRowPadding = 256u;
+
+    const uint32_t rowPitch = kTestImageWidth * 4u + kRowPadding;
 
-    std::vector<VkExtensionProperties> supportedDeviceExtensions(supportedDeviceExtensionCount);
-    vkEnumerateDeviceExtensionProperties(vkPhysicalDevice, nullptr, &supportedDeviceExtensionCount, supportedDeviceExtensions.data());
+    std::vector<uint8_t> pitchedPixels((size_t)rowPitch * kTestImageHeight, 0xCDu);
+    std::vector<uint8_t> packedPixels ((size_t)kTestImageWidth * kTestImageHeight * 4u);
 
-    auto CheckExtension = [&](const char* extensionName)
+    for (uint32_t y = 0u; y < kTestImageHeight; y++)
     {
-        for (const auto& deviceExtension : supportedDeviceExtensions)
+        for (uint32_t x = 0u; x < kTestImageWidth; x++)
         {
-            if (!strcmp(deviceExtension.extensionName, extensionName))
-                return true;
+            uint8_t* pPixel = &pitchedPixels[(size_t)y * rowPitch + x * 4u];
+
+            pPixel[0] = (uint8_t)(x * 255u / kTestImageWidth);
+            pPixel[1] = (uint8_t)(y * 255u / kTestImageHeight);
+            pPixel[2] = (uint8_t)(128.0 + 100.0 * std::sin(x * 0.05) * std::cos(y * 0.07));
+            pPixel[3] = 255u;
         }
 
+        memcpy(&packedPixels[(size_t)y * kTestImageWidth * 4u], &pitchedPixels[(size_t)y * rowPitch], kTestImageWidth * 4u);
+    }
+
+    // stb has no row pitch, it gets the packed copy.
+    std::vector<uint8_t> stbData;
+    auto encodeStart = std::chrono::steady_clock::now();
+
+    stbi_write_jpg_to_func([](void* pContext, void* pData, int size)
+    {
+        auto* pOutput = (std::vector<uint8_t>*)pContext;
+        pOutput->insert(pOutput->end(), (const uint8_t*)pData, (const uint8_t*)pData + size);
+    }, &stbData, kTestImageWidth, kTestImageHeight, 4, packedPixels.data(), kOutputJpegQuality);
+
+    const double stbMilliseconds = GetElapsedMilliseconds(encodeStart);
+
+    std::vector<uint8_t> parallelData;
+    encodeStart = std::chrono::steady_clock::now();
+
+    if (!EncodeJpeg(threadPool, pitchedPixels.data(), kTestImageWidth, kTestImageHeight, rowPitch, kOutputJpegQuality, parallelData))
         return false;
-    };
 
-    for (const auto& requiredExtension : requiredExtensions)
+    const double parallelMilliseconds = GetElapsedMilliseconds(encodeStart);
+
+    int width, height, channels;
+    stbi_uc* pStbDecoded      = stbi_load_from_memory(stbData.data(),      (int)stbData.size(),      &width, &height, &channels, 4);
+    stbi_uc* pParallelDecoded = stbi_load_from_memory(parallelData.data(), (int)parallelData.size(), &width, &height, &channels, 4);
+
+    if (pStbDecoded == nullptr || pParallelDecoded == nullptr || width != (int)kTestImageWidth || height != (int)kTestImageHeight)
     {
-        if (CheckExtension(requiredExtension))
-            continue;
-        
-        spdlog::error("The selected Vulkan physical device does not support required Vulkan Extension: {}", requiredExtension);
+        spdlog::error("Failed to decode the encoder check images: {}", stbi_failure_reason());
+        stbi_image_free(pStbDecoded);
+        stbi_image_free(pParallelDecoded);
         return false;
     }
 
-    return true;
+    const size_t pixelCount   = (size_t)kTestImageWidth * kTestImageHeight;
+    const double stbPsnr      = ComputeRGBPsnr(packedPixels.data(), pStbDecoded,      pixelCount);
+    const double parallelPsnr = ComputeRGBPsnr(packedPixels.data(), pParallelDecoded, pixelCount);
+    const double mutualPsnr   = ComputeRGBPsnr(pStbDecoded,         pParallelDecoded, pixelCount);
+
+    stbi_image_free(pStbDecoded);
+    stbi_image_free(pParallelDecoded);
+
+    spdlog::info("stbi_write_jpg:   {:.3f} ms, {} bytes, {:.2f} dB.", stbMilliseconds, stbData.size(), stbPsnr);
+    spdlog::info("Parallel encoder: {:.3f} ms, {} bytes, {:.2f} dB on {} threads ({:.2f} dB against stb).", parallelMilliseconds, parallelData.size(), parallelPsnr, threadPool.GetThreadCount(), mutualPsnr);
+
+    return parallelPsnr >= stbPsnr - kJpegMaxPsnrLossDb;
 }
 
-bool GetVulkanGraphicsQueueIndexFromDevice(const VkPhysicalDevice& vkPhysicalDevice, uint32_t& graphicsQueueIndex)
+// Uploads random pixels to the shared image and reads them back through the compute stage at every downscale,
+// against DownscalePixelsToNV12. Each downscale renders one frame from firstFrameIndex on.
+static bool CheckReadbackCompute(InteropBackend* pBackend, const VulkanDevice& device, const SharedImage& sharedImage, uint64_t firstFrameIndex)
 {
-    graphicsQueueIndex = UINT_MAX;
+    const PixelFormat imageFormat = GetSharedImageFormatTraits(sharedImage.desc).format;
+    const uint32_t    rowPitch    = GetSharedImageRowPitch(sharedImage.desc);
+
+    std::mt19937 random(1234u);
+
+    std::vector<uint8_t> pixels((size_t)GetSharedImageSize(sharedImage.desc));
+    FillRandomPixels(imageFormat, pixels, random);
+
+    VulkanStagingBuffer uploadBuffer;
+    if (!CreateVulkanStagingBuffer(device, pixels.size(), VK_BUFFER_USAGE_TRANSFER_SRC_BIT, uploadBuffer))
+        return false;
 
-    uint32_t queueFamilyCount = 0u;
-    vkGetPhysicalDeviceQueueFamilyProperties(vkPhysicalDevice, &queueFamilyCount, nullptr);
+    memcpy(uploadBuffer.pMappedData, pixels.data(), pixels.size());
 
-    std::vector<VkQueueFamilyProperties> queueFamilyProperties(queueFamilyCount);
-    vkGetPhysicalDeviceQueueFamilyProperties(vkPhysicalDevice, &queueFamilyCount, queueFamilyProperties.data());
+    bool succeeded = true;
 
-    for (uint32_t queueFamilyIndex = 0; queueFamilyIndex < queueFamilyCount; queueFamilyIndex++)
+    uint64_t frameIndex = firstFrameIndex;
+
+    for (uint32_t downscale : { 1u, 2u, 4u })
     {
-        if (!(queueFamilyProperties[queueFamilyIndex].queueFlags & VK_QUEUE_GRAPHICS_BIT))
-            continue;
+        ReadbackComputeDesc computeDesc;
+        computeDesc.enabled   = true;
+        computeDesc.downscale = downscale;
 
-        // Choose the first graphics queue we find.
-        graphicsQueueIndex = queueFamilyIndex;
+        uint32_t width, height;
+        if (!GetReadbackComputeExtent(sharedImage.desc, computeDesc, width, height) || !pBackend->SetReadbackCompute(sharedImage, computeDesc))
+        {
+            spdlog::error("The interop backend has no readback compute stage for downscale {}.", downscale);
+            succeeded = false;
+            break;
+        }
 
-        break;
-    }
+        std::vector<uint8_t> expected(GetPixelImageSize(GetPixelFormatTraits(PixelFormat::NV12), width, height));
+        DownscalePixelsToNV12(imageFormat, pixels.data(), rowPitch, expected.data(), width, width, height, downscale);
 
-    return graphicsQueueIndex != UINT_MAX;
-}
+        // Like a rendered frame: written on the graphics queue, then released to the exporter.
+        succeeded = SubmitVulkanCommandsImmediate(device, [&](VkCommandBuffer vkCommandBuffer)
+        {
+            RecordVulkanImageBarrier(vkCommandBuffer, sharedImage.vkImage, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0u, VK_ACCESS_TRANSFER_WRITE_BIT);
 
-bool CreateVulkanLogicalDevice(const VkPhysicalDevice& vkPhysicalDevice, const std::vector<const char*>& requiredExtensions, uint32_t vkGraphicsQueueIndex, VkDevice& vkLogicalDevice)
-{
-    float graphicsQueuePriority = 1.0;
+            VkBufferImageCopy vkCopyRegion = {};
+            vkCopyRegion.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0u, 0u, 1u };
+            vkCopyRegion.imageExtent      = { sharedImage.desc.width, sharedImage.desc.height, 1u };
+
+            vkCmdCopyBufferToImage(vkCommandBuffer, uploadBuffer.vkBuffer, sharedImage.vkImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1u, &vkCopyRegion);
+
+            RecordVulkanImageBarrier(vkCommandBuffer, sharedImage.vkImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_GENERAL, VK_ACCESS_TRANSFER_WRITE_BIT, 0u, device.graphicsQueueIndex, VK_QUEUE_FAMILY_EXTERNAL);
+        }, GetFrameTimelineSubmit(sharedImage, frameIndex));
+
+        uint32_t maxDifference = 0u;
+
+        ReadbackRing readbackRing;
+        succeeded = succeeded && readbackRing.Create(pBackend, sharedImage, 1u, [&](uint64_t, const MappedImage& mappedImage)
+        {
+            const uint8_t* pOutput = (const uint8_t*)mappedImage.pData;
+
+            for (size_t byteIndex = 0u; byteIndex < expected.size(); byteIndex++)
+                maxDifference = std::max(maxDifference, (uint32_t)std::abs((int)pOutput[byteIndex] - (int)expected[byteIndex]));
+        });
+
+        succeeded = succeeded && readbackRing.Submit(frameIndex) && readbackRing.Flush();
+
+        if (!succeeded)
+            break;
 
-    VkDeviceQueueCreateInfo vkGraphicsQueueCreateInfo = { VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO };
-    vkGraphicsQueueCreateInfo.queueFamilyIndex = vkGraphicsQueueIndex;
-    vkGraphicsQueueCreateInfo.queueCount       = 1u;
-    vkGraphicsQueueCreateInfo.pQueuePriorities = &graphicsQueuePriority;
+        spdlog::info("Readback compute {}x{} -> {}x{} NV12 (downscale {}): max difference {}.", sharedImage.desc.width, sharedImage.desc.height, width, height, downscale, maxDifference);
 
-    VkDeviceCreateInfo vkLogicalDeviceCreateInfo = { VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO };
-    vkLogicalDeviceCreateInfo.pQueueCreateInfos       = &vkGraphicsQueueCreateInfo;
-    vkLogicalDeviceCreateInfo.queueCreateInfoCount    = 1u;
-    vkLogicalDeviceCreateInfo.enabledExtensionCount   = (uint32_t)requiredExtensions.size();
-    vkLogicalDeviceCreateInfo.ppEnabledExtensionNames = requiredExtensions.data();
+        succeeded = maxDifference <= 1u;
+        frameIndex++;
 
-    return vkCreateDevice(vkPhysicalDevice, &vkLogicalDeviceCreateInfo, nullptr, &vkLogicalDevice) == VK_SUCCESS;
+        if (!succeeded)
+            break;
+    }
+
+    pBackend->SetReadbackCompute(sharedImage, {});
+
+    // Uploads are immediate submissions, the buffer is no longer in use.
+    DestroyVulkanStagingBuffer(device, uploadBuffer);
+
+    return succeeded;
 }
 
-bool SelectDXGIAdapter(IDXGIAdapter1** ppSelectedAdapter)
+int main(int argc, char** argv)
 {
-    ComPtr<IDXGIFactory1> pFactory;
-    if (!SUCCEEDED(CreateDXGIFactory1(IID_PPV_ARGS(&pFactory))))
-        return false;
+    InteropBackendType backendType   = GetDefaultInteropBackendType();
+    uint32_t           streamFrames  = 0u;
+    uint32_t           readbackDepth = 3u;
+    uint32_t           streamSeconds = 0u;
+    const char*        pCaptureFile  = nullptr;
+    const char*        pTraceFile    = nullptr;
+    bool               checkEncoder  = false;
+    bool               checkConvert  = false;
+    bool               prerecord     = false;
+    bool               startupCache  = true;
+    bool               memoryArena   = true;
+    bool               checkCompute  = false;
+    bool               zeroCopy      = false;
+    bool               frameCodec    = false;
+    bool               checkCodec    = false;
+    uint32_t           downscale     = 0u;
+    uint32_t           layerCount    = 1u;
+    uint32_t           pipelineDepth = 0u;
+    DirtyRect          dirtyRect;
+
+    const PixelFormatTraits* pImageFormat  = &GetPixelFormatTraits(PixelFormat::RGBA8);
+    const PixelFormatTraits* pStreamFormat = nullptr;
+
+    for (int argIndex = 1; argIndex < argc; argIndex++)
+    {
+        const char* pBackendName;
+        if (ParseStringArgument(argv[argIndex], "--backend=", pBackendName) && ParseInteropBackendType(pBackendName, backendType))
+            continue;
 
-    UINT selectedAdapterIndex = UINT_MAX;
+        if (ParseUIntArgument(argv[argIndex], "--frames=",         streamFrames) ||
+            ParseUIntArgument(argv[argIndex], "--readback-depth=", readbackDepth) ||
+            ParseUIntArgument(argv[argIndex], "--duration=",       streamSeconds) ||
+            ParseUIntArgument(argv[argIndex], "--readback-compute=", downscale) ||
+            ParseUIntArgument(argv[argIndex], "--layers=",         layerCount) ||
+            ParseUIntArgument(argv[argIndex], "--pipeline=",       pipelineDepth) ||
+            ParseStringArgument(argv[argIndex], "--stream=",       pCaptureFile) ||
+            ParseStringArgument(argv[argIndex], "--trace=",        pTraceFile))
+            continue;
 
-    // Select DXGI adapter based on the one that has the most dedicated video memory.
-    SIZE_T dedicatedVideoMemory = 0u;
+        const char* pFormatName;
+        if (ParseStringArgument(argv[argIndex], "--format=", pFormatName) && (pImageFormat = FindPixelFormatTraits(pFormatName)) != nullptr && pImageFormat->IsShareable())
+            continue;
 
-    ComPtr<IDXGIAdapter1> pAdapter;
-    for (UINT i = 0; pFactory->EnumAdapters1(i, &pAdapter) != DXGI_ERROR_NOT_FOUND; ++i)
-    {
-        DXGI_ADAPTER_DESC adapterDesc;
-        pAdapter->GetDesc(&adapterDesc);
+        if (ParseStringArgument(argv[argIndex], "--stream-format=", pFormatName) && (pStreamFormat = FindPixelFormatTraits(pFormatName)) != nullptr)
+            continue;
+
+        if (!strcmp(argv[argIndex], "--check-encoder"))
+        {
+            checkEncoder = true;
+            continue;
+        }
 
-        if (adapterDesc.DedicatedVideoMemory < dedicatedVideoMemory)
+        if (!strcmp(argv[argIndex], "--check-conversion"))
+        {
+            checkConvert = true;
             continue;
+        }
 
-        // Update largest video memory found so far.
-        dedicatedVideoMemory = adapterDesc.DedicatedVideoMemory;
+        if (!strcmp(argv[argIndex], "--check-readback-compute"))
+        {
+            checkCompute = true;
+            continue;
+        }
 
-        // Update the selected adapter index for the current most dedicated VRAM found.
-        selectedAdapterIndex = i;
-    }
+        if (!strcmp(argv[argIndex], "--check-frame-codec"))
+        {
+            checkCodec = true;
+            continue;
+        }
 
-    if (pFactory->EnumAdapters1(selectedAdapterIndex, ppSelectedAdapter) == DXGI_ERROR_NOT_FOUND)
-        return false;
+        // Size of the rectangle each streamed frame declares dirty.
+        const char* pDirtyRect;
+        char        separator;
+        if (ParseStringArgument(argv[argIndex], "--dirty-rect=", pDirtyRect) &&
+            sscanf(pDirtyRect, "%u%c%u", &dirtyRect.width, &separator, &dirtyRect.height) == 3 && separator == 'x')
+            continue;
+
+        if (!strcmp(argv[argIndex], "--no-startup-cache"))
+        {
+            startupCache = false;
+            continue;
+        }
 
-    DXGI_ADAPTER_DESC selectedAdapterDesc;
-    (*ppSelectedAdapter)->GetDesc(&selectedAdapterDesc);
+        if (!strcmp(argv[argIndex], "--dedicated-memory"))
+        {
+            memoryArena = false;
+            continue;
+        }
 
-    spdlog::info(L"Selected DXGI Adapter: {}", selectedAdapterDesc.Description);
+        if (!strcmp(argv[argIndex], "--zero-copy"))
+        {
+            zeroCopy = true;
+            continue;
+        }
 
-    return true;
-}
+        if (!strcmp(argv[argIndex], "--prerecord"))
+        {
+            prerecord = true;
+            continue;
+        }
 
-bool BindD3D11ImageToVulkanImage(const VkDevice& vkLogicalDevice, ID3D11Texture2D* pImageDX, VkDeviceMemory& vkImageMemory, VkImage& vkImage)
-{
-    VkExternalMemoryImageCreateInfo vkExternalMemoryImageCreateInfo = { VK_STRUCTURE_TYPE_EXTERNAL_MEMORY_IMAGE_CREATE_INFO };
-    vkExternalMemoryImageCreateInfo.handleTypes = VK_EXTERNAL_MEMORY_HANDLE_TYPE_D3D11_TEXTURE_BIT;
+        if (!strcmp(argv[argIndex], "--frame-codec"))
+        {
+            frameCodec = true;
+            continue;
+        }
 
-    VkImageCreateInfo vkImageCreateInfo = { VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
-    {
-        vkImageCreateInfo.pNext       = &vkExternalMemoryImageCreateInfo;
-        vkImageCreateInfo.format      = VK_FORMAT_R8G8B8A8_UNORM;
-        vkImageCreateInfo.imageType   = VK_IMAGE_TYPE_2D;
-        vkImageCreateInfo.arrayLayers = 1u;
-        vkImageCreateInfo.mipLevels   = 1u;
-        vkImageCreateInfo.extent      = { kTestImageWidth, kTestImageHeight, 1};
-        vkImageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-        vkImageCreateInfo.samples     = VK_SAMPLE_COUNT_1_BIT;
-        vkImageCreateInfo.usage       = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+        spdlog::critical("Unknown argument: {} (usage: --backend=d3d11|opaque-fd|host-copy --frames=N --readback-depth=K --format=rgba8|bgra8|rgb10a2|rgba16f "
+                         "--stream=FILE --stream-format=FORMAT|nv12 --duration=S --prerecord --dirty-rect=WxH --readback-compute=1|2|4 --layers=N --zero-copy --frame-codec --pipeline=N --trace=FILE --no-startup-cache "
+                         "--dedicated-memory --check-encoder --check-conversion --check-readback-compute --check-frame-codec)", argv[argIndex]);
+        return 1;
     }
 
-    if (vkCreateImage(vkLogicalDevice, &vkImageCreateInfo, nullptr, &vkImage) != VK_SUCCESS)
-        return false;
+    if (pTraceFile != nullptr && !kTracingEnabled)
+        spdlog::warn("Tracing is compiled out of this build (INTEROP_ENABLE_TRACING, non-Release builds only), {} is not written.", pTraceFile);
 
-    // Open a shareable handle to D3D11 Image Resource.
-    ComPtr<IDXGIResource1> pSharedResource;
-    if (!SUCCEEDED(pImageDX->QueryInterface(IID_PPV_ARGS(pSharedResource.GetAddressOf()))))
-        return false;
+    TRACE_THREAD_NAME("Main");
 
-    HANDLE sharedHandle;
-    if (!SUCCEEDED(pSharedResource->CreateSharedHandle(nullptr, DXGI_SHARED_RESOURCE_READ | DXGI_SHARED_RESOURCE_WRITE, L"Shared-D3D11-Image", &sharedHandle)))
-        return false;
-    
-    // Bind the Vulkan Memory Allocation to the exported D3D11 Image Resource Handle.
-    VkMemoryWin32HandlePropertiesKHR vkImportedHandleProperties = { VK_STRUCTURE_TYPE_MEMORY_WIN32_HANDLE_PROPERTIES_KHR };
-    if (vkGetMemoryWin32HandlePropertiesKHR(vkLogicalDevice, VK_EXTERNAL_MEMORY_HANDLE_TYPE_D3D11_TEXTURE_BIT, sharedHandle, &vkImportedHandleProperties) != VK_SUCCESS)
-        return false;
+    ThreadPool encoderThreadPool;
 
-    // Specify that the provided Vulkan Image is the only one that can be used with the D3D11 Image memory. 
-    VkMemoryDedicatedAllocateInfo vkDedicatedAllocateInfo = { VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO };
-    vkDedicatedAllocateInfo.image = vkImage;
+    if (checkEncoder)
+    {
+        if (!CheckJpegEncoder(encoderThreadPool))
+        {
+            spdlog::critical("The parallel JPEG encoder does not match stbi_write_jpg.");
+            return 1;
+        }
 
-    VkImportMemoryWin32HandleInfoKHR vkImportedHandleInfo = { VK_STRUCTURE_TYPE_IMPORT_MEMORY_WIN32_HANDLE_INFO_KHR };
-    vkImportedHandleInfo.handleType = VK_EXTERNAL_MEMORY_HANDLE_TYPE_D3D11_TEXTURE_BIT;
-    vkImportedHandleInfo.handle     = sharedHandle;
-    vkImportedHandleInfo.name       = L"Shared-D3D11-Image";
-    vkImportedHandleInfo.pNext      = &vkDedicatedAllocateInfo;
+        return 0;
+    }
 
-    VkMemoryAllocateInfo vkImportAllocateInfo = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
-    vkImportAllocateInfo.pNext           = &vkImportedHandleInfo;
-    vkImportAllocateInfo.memoryTypeIndex = VK_EXTERNAL_MEMORY_FEATURE_DEDICATED_ONLY_BIT; 
+    if (checkConvert)
+    {
+        if (!CheckPixelConversions())
+        {
+            spdlog::critical("The SIMD pixel conversions do not match their scalar reference.");
+            return 1;
+        }
 
-    if (vkAllocateMemory(vkLogicalDevice, &vkImportAllocateInfo, nullptr, &vkImageMemory) != VK_SUCCESS)
-        return false;
+        return 0;
+    }
 
-    // Bind the Vulkan Image to the Memory.
-    vkBindImageMemory(vkLogicalDevice, vkImage, vkImageMemory, 0u);
+    if (checkCodec)
+    {
+        if (!CheckFrameCodec(encoderThreadPool))
+        {
+            spdlog::critical("The frame codec does not round trip frames or accepts malformed ones.");
+            return 1;
+        }
 
-    return true;
-}
+        return 0;
+    }
 
-int main()
-{
-    ComPtr<IDXGIAdapter1> pAdapter;
-    if (!SelectDXGIAdapter(pAdapter.GetAddressOf()))
+    // The compute stage delivers NV12 frames, which are captured as they are.
+    ReadbackComputeDesc readbackCompute;
+    readbackCompute.enabled   = downscale > 0u;
+    readbackCompute.downscale = readbackCompute.enabled ? downscale : 1u;
+
+    if (readbackCompute.enabled && pStreamFormat != nullptr && pStreamFormat->format != PixelFormat::NV12)
     {
-        spdlog::critical("Failed to load a DXGI Adapter.");
+        spdlog::critical("Frames of the readback compute stage can only be captured as nv12.");
         return 1;
     }
 
-    D3D_FEATURE_LEVEL desiredFeatureLevel = D3D_FEATURE_LEVEL_11_1;
-
-    UINT deviceCreationFlags = 0u;
-    
-#if defined(_DEBUG)
-    deviceCreationFlags |= D3D11_CREATE_DEVICE_DEBUG;
-#endif
+    if (zeroCopy && pipelineDepth > 0u)
+    {
+        spdlog::critical("Zero-copy readbacks write frames into the video file themselves, they cannot go through a pipeline.");
+        return 1;
+    }
 
-    ComPtr<ID3D11Device>        pDeviceDX;
-    ComPtr<ID3D11DeviceContext> pImmediateContextDX;
-    D3D_FEATURE_LEVEL           selectedFeatureLevel;
-    if (!SUCCEEDED(D3D11CreateDevice (pAdapter.Get(), D3D_DRIVER_TYPE_UNKNOWN, nullptr, deviceCreationFlags, &desiredFeatureLevel, 1u, D3D11_SDK_VERSION, pDeviceDX.GetAddressOf(), &selectedFeatureLevel, pImmediateContextDX.GetAddressOf())))
+    if ((readbackCompute.enabled || checkCompute) && layerCount != 1u)
     {
-        spdlog::critical("Failed to create the D3D11 Device and Immediate Context.");
+        spdlog::critical("The readback compute stage only reads back single layer images.");
         return 1;
     }
 
-    spdlog::info("Initialized D3D11.");
+    if (readbackCompute.enabled)
+        pStreamFormat = &GetPixelFormatTraits(PixelFormat::NV12);
 
-    // Initialize Vulkan
-    // ------------------------------------------------
+    if (pStreamFormat == nullptr)
+        pStreamFormat = pImageFormat;
 
-    if (volkInitialize() != VK_SUCCESS)
+    if (!readbackCompute.enabled && !IsPixelConversionSupported(pImageFormat->format, pStreamFormat->format))
     {
-        spdlog::critical("Failed to initialize Volk.");
+        spdlog::critical("Frames of {} images cannot be captured as {}.", pImageFormat->pName, pStreamFormat->pName);
         return 1;
     }
 
-    VkApplicationInfo vkApplicationInfo = { VK_STRUCTURE_TYPE_APPLICATION_INFO };
-    vkApplicationInfo.pApplicationName   = "SharedMemory-Vulkan-D3D11";
-    vkApplicationInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
-    vkApplicationInfo.pEngineName        = "No Engine";
-    vkApplicationInfo.engineVersion      = VK_MAKE_VERSION(0, 0, 0);
-    vkApplicationInfo.apiVersion         = VK_API_VERSION_1_3;
+    // Initialize Vulkan
+    // ------------------------------------------------
+
+    // Cold start to the first shared frame, phase by phase.
+    PhaseTimer startupTimer;
 
-    std::vector<const char*> requiredInstanceExtensions;
-#ifdef _DEBUG
-    requiredInstanceExtensions.push_back("VK_LAYER_KHRONOS_validation");
-#endif
+    // Without the cache the capabilities are queried from the driver, and saved for the next launch.
+    const bool deviceCacheLoaded = startupCache && LoadVulkanDeviceCache(kDeviceCacheFileName);
 
-    VkInstanceCreateInfo vkInstanceCreateInfo = { VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO };
-    vkInstanceCreateInfo.pApplicationInfo     = &vkApplicationInfo;
-    vkInstanceCreateInfo.enabledLayerCount    = (uint32_t)requiredInstanceExtensions.size();
-    vkInstanceCreateInfo.ppEnabledLayerNames  = requiredInstanceExtensions.data();
+    startupTimer.EndPhase("device cache");
 
     VkInstance vkInstance;
-    if (vkCreateInstance(&vkInstanceCreateInfo, nullptr, &vkInstance) != VK_SUCCESS)
+    if (!CreateVulkanInstance(vkInstance))
     {
         spdlog::critical("Failed to create the Vulkan Instance.");
         return 1;
     }
 
-    volkLoadInstanceOnly(vkInstance);
+    startupTimer.EndPhase("instance");
 
-    std::vector<const char*> requiredDeviceExtensions;
+    auto pBackend = CreateInteropBackend(backendType);
+    if (!pBackend)
     {
-        requiredDeviceExtensions.push_back(VK_KHR_EXTERNAL_MEMORY_WIN32_EXTENSION_NAME);
+        spdlog::critical("The requested interop backend is not available on this platform.");
+        return 1;
     }
 
-    VkPhysicalDevice vkPhysicalDevice;
-    if (!SelectVulkanPhysicalDevice(vkInstance, requiredDeviceExtensions, pAdapter.Get(), vkPhysicalDevice))
+    // Backends without a memory arena already use dedicated allocations.
+    pBackend->EnableMemoryArena(memoryArena);
+
+    if (!pBackend->CreateExporter(vkInstance))
     {
-        spdlog::critical("Failed to select a Vulkan Physical Device.");
+        spdlog::critical("Failed to create the exporter for the {} interop backend.", pBackend->GetName());
         return 1;
     }
 
-    uint32_t vkGraphicsQueueIndex;
-    if (!GetVulkanGraphicsQueueIndexFromDevice(vkPhysicalDevice, vkGraphicsQueueIndex))
+    // The exporter compiles the readback compute stage against the previous launch's pipeline cache.
+    if (!pBackend->LoadPipelineCache(startupCache ? kPipelineCacheFileName : nullptr))
     {
-        spdlog::critical("Failed to get the graphics queue from the selected Vulkan Physical Device.");
+        spdlog::critical("Failed to create the Vulkan pipeline cache.");
         return 1;
     }
 
-    VkDevice vkLogicalDevice;
-    if (!CreateVulkanLogicalDevice(vkPhysicalDevice, requiredDeviceExtensions, vkGraphicsQueueIndex, vkLogicalDevice))
+    startupTimer.EndPhase("exporter");
+
+    std::vector<const char*> requiredDeviceExtensions;
+    pBackend->GetRequiredDeviceExtensions(requiredDeviceExtensions);
+
+    VkPhysicalDevice vkPhysicalDevice;
+    if (!pBackend->SelectPhysicalDevice(vkInstance, requiredDeviceExtensions, vkPhysicalDevice))
     {
-        spdlog::critical("Failed to create the Vulkan Logical Device");
+        spdlog::critical("Failed to select a Vulkan Physical Device.");
         return 1;
     }
 
-    volkLoadDevice(vkLogicalDevice);
-    
-    spdlog::info("Initialized Vulkan.");
-
-    // Create GPU-native Image Resource.
-    // ------------------------------------------------
+    startupTimer.EndPhase("physical device");
 
-    D3D11_TEXTURE2D_DESC imageDesc = {};
-    imageDesc.Width     = kTestImageWidth;
-    imageDesc.Height    = kTestImageHeight;
-    imageDesc.MipLevels = 1;
-    imageDesc.ArraySize = 1;
-    imageDesc.Format    = DXGI_FORMAT_R8G8B8A8_UNORM;
-    imageDesc.Usage     = D3D11_USAGE_DEFAULT;
-    imageDesc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
-    imageDesc.MiscFlags = D3D11_RESOURCE_MISC_SHARED | D3D11_RESOURCE_MISC_SHARED_NTHANDLE;
-    imageDesc.SampleDesc.Count = 1;
-
-    ComPtr<ID3D11Texture2D> pImageDX;
-    if (!SUCCEEDED(pDeviceDX->CreateTexture2D(&imageDesc, nullptr, pImageDX.GetAddressOf())))
+    VulkanDevice device;
+    if (!CreateVulkanDevice(vkPhysicalDevice, requiredDeviceExtensions, device))
     {
-        spdlog::critical("Failed to create the D3D11 Image resource.");
+        spdlog::critical("Failed to create the Vulkan Logical Device");
         return 1;
     }
 
-    spdlog::info("Successfully created a D3D11 Image Resource with external memory support.");
-    
-    // Bind the D3D11 Image To Vulkan Image (backed by the same memory on GPU).
-    // ------------------------------------------------
+    startupTimer.EndPhase("device");
+
+    spdlog::info("Initialized Vulkan (queue families: graphics {}, compute {}, transfer {}).", device.graphicsQueueIndex, device.computeQueueIndex, device.transferQueueIndex);
 
-    VkImage        vkImage;
-    VkDeviceMemory vkImageMemory;
-    if (!BindD3D11ImageToVulkanImage(vkLogicalDevice, pImageDX.Get(), vkImageMemory, vkImage))
+    VulkanTraceQueries* pTraceQueries = TRACE_GPU_CREATE(device, VulkanQueueType::Graphics, "Renderer");
+
+    // Command buffers and fences are recycled across frames, one pool per recording thread.
+    FrameContextPools frameContextPools;
+    FrameContextPool* pFrameContexts = frameContextPools.Create(device, 2u) ? frameContextPools.GetForCurrentThread() : nullptr;
+    if (pFrameContexts == nullptr)
     {
-        spdlog::critical("Failed to bind the ID3D11 Image resource to a Vulkan Image.");
+        spdlog::critical("Failed to create the frame contexts.");
         return 1;
     }
 
-    spdlog::info("Successfully created a Vulkan Image backed by the D3D11 Image memory allocation.");
+    startupTimer.EndPhase("frame contexts");
 
-    // Create CPU-Accessible Staging D3D11 Image Resource.
+    // Create the shared Image Resource and bind it to a Vulkan Image (backed by the same memory on GPU).
     // ------------------------------------------------
 
-    D3D11_TEXTURE2D_DESC stagingImageDesc = imageDesc;
-    stagingImageDesc.Usage          = D3D11_USAGE_STAGING;
-    stagingImageDesc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
-    stagingImageDesc.BindFlags      = 0u;
-    stagingImageDesc.MiscFlags      = 0u;
-    
-    ComPtr<ID3D11Texture2D> pStagingImageDX;
-    if (!SUCCEEDED(pDeviceDX->CreateTexture2D(&stagingImageDesc, nullptr, pStagingImageDX.GetAddressOf())))
+    SharedImageDesc sharedImageDesc;
+    sharedImageDesc.width  = kTestImageWidth;
+    sharedImageDesc.height = kTestImageHeight;
+    sharedImageDesc.format = pImageFormat->vkFormat;
+
+    // Streams then render and read back a batch of surfaces per frame, the video file captures the first.
+    sharedImageDesc.arrayLayers = layerCount;
+
+    const auto bindStart = std::chrono::steady_clock::now();
+
+    SharedImage sharedImage;
+    if (!pBackend->CreateSharedImage(device, sharedImageDesc, sharedImage))
     {
-        spdlog::critical("Failed to create the D3D11 Staging Image resource");
+        spdlog::critical("Failed to create a shared image with the {} interop backend.", pBackend->GetName());
         return 1;
     }
 
-#if 0
-    // Clear the Image Resource from D3D11.
-    // ------------------------------------------------
-    {
-        ComPtr<ID3D11RenderTargetView> pRenderTargetViewDX;
-        if (!SUCCEEDED(pDeviceDX->CreateRenderTargetView(pImageDX.Get(), nullptr, pRenderTargetViewDX.GetAddressOf())))
-        {
-            spdlog::critical("Failed to create the D3D11 Render Target View for Image resource.");
-            return 1;
-        }
+    startupTimer.EndPhase("shared image");
+
+    spdlog::info("Successfully created a Vulkan Image backed by the {} shared memory allocation in {:.3f} ms.", pBackend->GetName(), GetElapsedMilliseconds(bindStart));
 
-        FLOAT clearColor[4] = { 1.0, 0.0, 0.0, 1.0 };
-        pImmediateContextDX->ClearRenderTargetView(pRenderTargetViewDX.Get(), clearColor);
-    }
-#else
     // Clear the Image Resource from Vulkan
     // -----------------------------------------------
-    {
-        VkQueue vkGraphicsQueue;
-        vkGetDeviceQueue(vkLogicalDevice, vkGraphicsQueueIndex, 0u, &vkGraphicsQueue);
+    constexpr uint64_t kFrameIndex = 0u;
 
-        VkCommandPoolCreateInfo vkGraphicsCommandPoolCreateInfo = { VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO };
-        {
-            vkGraphicsCommandPoolCreateInfo.flags            = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT | VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
-            vkGraphicsCommandPoolCreateInfo.queueFamilyIndex = vkGraphicsQueueIndex;
-        }
-
-        VkCommandPool vkGraphicsCommandPool;
-        if (vkCreateCommandPool(vkLogicalDevice, &vkGraphicsCommandPoolCreateInfo, nullptr, &vkGraphicsCommandPool) != VK_SUCCESS)
-        {
-            spdlog::critical("Failed to create a Vulkan Command Pool.");
-            return 1;
-        }
-
-        VkCommandBufferAllocateInfo vkGraphicsCommandAllocateInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
-        {
-            vkGraphicsCommandAllocateInfo.commandBufferCount = 1u;
-            vkGraphicsCommandAllocateInfo.commandPool        = vkGraphicsCommandPool;
-            vkGraphicsCommandAllocateInfo.level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-        }
+    {
+        TRACE_FRAME(kFrameIndex);
+        TRACE_ZONE("First frame");
 
         VkCommandBuffer vkGraphicsCommandBuffer;
-        if (vkAllocateCommandBuffers(vkLogicalDevice, &vkGraphicsCommandAllocateInfo, &vkGraphicsCommandBuffer) != VK_SUCCESS)
+        if (!pFrameContexts->AcquireFrameContext(vkGraphicsCommandBuffer))
         {
-            spdlog::critical("Failed to create a Vulkan Command Buffer.");
+            spdlog::critical("Failed to acquire a Vulkan Command Buffer.");
             return 1;
         }
 
@@ -435,85 +544,292 @@ int main()
         barrier.newLayout           = VK_IMAGE_LAYOUT_GENERAL;
         barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
         barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-        barrier.image               = vkImage;
-        
+        barrier.image               = sharedImage.vkImage;
+
         barrier.subresourceRange.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
         barrier.subresourceRange.baseMipLevel   = 0;
         barrier.subresourceRange.levelCount     = 1;
         barrier.subresourceRange.baseArrayLayer = 0;
-        barrier.subresourceRange.layerCount     = 1;
-        
+        barrier.subresourceRange.layerCount     = VK_REMAINING_ARRAY_LAYERS;
+
         barrier.srcAccessMask = 0;
         barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-        
-        vkCmdPipelineBarrier(vkGraphicsCommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+        {
+            TRACE_GPU_ZONE(pTraceQueries, vkGraphicsCommandBuffer, "Barrier");
+            vkCmdPipelineBarrier(vkGraphicsCommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+        }
 
         VkImageSubresourceRange vkImageClearRange;
-        vkImageClearRange.layerCount     = 1u;
+        vkImageClearRange.layerCount     = VK_REMAINING_ARRAY_LAYERS;
         vkImageClearRange.baseMipLevel   = 0u;
         vkImageClearRange.baseArrayLayer = 0u;
         vkImageClearRange.levelCount     = 1u;
         vkImageClearRange.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
 
         VkClearColorValue clearColor = { {0.25f, 0.5f, 1.0f, 1.0f} };
-        vkCmdClearColorImage(vkGraphicsCommandBuffer, vkImage, VK_IMAGE_LAYOUT_GENERAL, &clearColor, 1u, &vkImageClearRange);
 
-        vkEndCommandBuffer(vkGraphicsCommandBuffer);
+        {
+            TRACE_GPU_ZONE(pTraceQueries, vkGraphicsCommandBuffer, "Clear");
+            vkCmdClearColorImage(vkGraphicsCommandBuffer, sharedImage.vkImage, VK_IMAGE_LAYOUT_GENERAL, &clearColor, 1u, &vkImageClearRange);
+        }
+
+        // Release the image to the exporting API.
+        barrier.oldLayout           = VK_IMAGE_LAYOUT_GENERAL;
+        barrier.srcQueueFamilyIndex = device.graphicsQueueIndex;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_EXTERNAL;
+        barrier.srcAccessMask       = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask       = 0;
 
-        VkSubmitInfo vkGraphicsQueueSubmitInfo = { VK_STRUCTURE_TYPE_SUBMIT_INFO };
         {
-            vkGraphicsQueueSubmitInfo.commandBufferCount = 1u;
-            vkGraphicsQueueSubmitInfo.pCommandBuffers    = &vkGraphicsCommandBuffer;
+            TRACE_GPU_ZONE(pTraceQueries, vkGraphicsCommandBuffer, "Release");
+            vkCmdPipelineBarrier(vkGraphicsCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
         }
 
-        if (vkQueueSubmit(vkGraphicsQueue, 1u, &vkGraphicsQueueSubmitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+        vkEndCommandBuffer(vkGraphicsCommandBuffer);
+
+        // No CPU wait here: the exporter waits for the render signal value of the shared image timeline on its own queue.
+        VulkanTimelineSubmit timelineSubmit;
+        timelineSubmit.vkWaitSemaphore   = sharedImage.vkTimelineSemaphore;
+        timelineSubmit.waitValue         = GetSharedImageRenderWaitValue(kFrameIndex);
+        timelineSubmit.vkSignalSemaphore = sharedImage.vkTimelineSemaphore;
+        timelineSubmit.signalValue       = GetSharedImageRenderSignalValue(kFrameIndex);
+
+        if (!pFrameContexts->SubmitFrameContext(vkGraphicsCommandBuffer, timelineSubmit))
         {
             spdlog::critical("Failed to submit commands to the Vulkan Graphics Queue.");
             return 1;
         }
-        
-        // Pause execution until the graphics queue has finished work.
-        vkDeviceWaitIdle(vkLogicalDevice);
-
-        spdlog::info("Successfully cleared the Vulkan Image with color: [{},{},{},{}]", 
-            clearColor.float32[0], 
-            clearColor.float32[1], 
-            clearColor.float32[2], 
+
+        spdlog::info("Successfully cleared the Vulkan Image with color: [{},{},{},{}]",
+            clearColor.float32[0],
+            clearColor.float32[1],
+            clearColor.float32[2],
             clearColor.float32[3]
         );
+    }
+
+    // Read the image back through the exporting API and map it to the CPU.
+    const auto readbackStart = std::chrono::steady_clock::now();
+
+    MappedImage mappedImage;
+    {
+        TRACE_FRAME(kFrameIndex);
+        TRACE_ZONE("First readback");
+
+        if (!pBackend->MapSharedImage(sharedImage, kFrameIndex, mappedImage))
+        {
+            spdlog::critical("Failed to map a pointer to the staging image memory.");
+            return 1;
+        }
+    }
+
+    spdlog::info("Successfully copied the shared image to staging mapped memory in {:.3f} ms.", GetElapsedMilliseconds(readbackStart));
+
+    startupTimer.EndPhase("first shared frame");
+    startupTimer.Log(deviceCacheLoaded ? "Startup (warm)" : "Startup (cold)");
+
+    // The encoder reads RGBA8, convert other formats first.
+    MappedImage encoderImage = mappedImage;
 
-        // Destroy command primitives.
-        vkDestroyCommandPool(vkLogicalDevice, vkGraphicsCommandPool, nullptr);
+    std::vector<uint8_t> convertedPixels;
+
+    if (pImageFormat->format != PixelFormat::RGBA8)
+    {
+        const auto convertStart = std::chrono::steady_clock::now();
+
+        encoderImage.rowPitch = kTestImageWidth * 4u;
+        convertedPixels.resize((size_t)encoderImage.rowPitch * kTestImageHeight);
+        encoderImage.pData    = convertedPixels.data();
+
+        if (!ConvertPixels(pImageFormat->format, mappedImage.pData, mappedImage.rowPitch, PixelFormat::RGBA8, convertedPixels.data(), encoderImage.rowPitch, kTestImageWidth, kTestImageHeight))
+        {
+            spdlog::critical("Failed to convert the {} image to rgba8.", pImageFormat->pName);
+            return 1;
+        }
+
+        spdlog::info("Converted the {} image to rgba8 in {:.3f} ms.", pImageFormat->pName, GetElapsedMilliseconds(convertStart));
     }
-#endif
-    
-    // Transfer the cleared native image to staging memory.
-    pImmediateContextDX->CopyResource(pStagingImageDX.Get(), pImageDX.Get());
-
-    // Map to CPU for copy.
-    D3D11_MAPPED_SUBRESOURCE mappedStagingMemory;
-    if (!SUCCEEDED(pImmediateContextDX->Map(pStagingImageDX.Get(), 0u, D3D11_MAP_READ, 0u, &mappedStagingMemory)))
+
+    // Write out the result to disk, honoring the row pitch of the exporter's staging memory.
+    const auto encodeStart = std::chrono::steady_clock::now();
+
+    const bool written = WriteJpegFile(kOutputFileName, encoderThreadPool, encoderImage.pData, kTestImageWidth, kTestImageHeight, encoderImage.rowPitch, kOutputJpegQuality);
+
+    pBackend->UnmapSharedImage(sharedImage);
+
+    if (!written)
     {
-        spdlog::critical("Failed to map a pointer to the staging image memory.");
+        spdlog::critical("Failed to write {}.", kOutputFileName);
         return 1;
     }
 
-    spdlog::info("Successfully copied the D3D11 Image to staging mapped memory.");
-    
-    // Write out the result to disk.
-    stbi_write_jpg(kOutputFileName, kTestImageWidth, kTestImageHeight, 4, mappedStagingMemory.pData, 100);
+    spdlog::info("Encoded the image on {} threads in {:.3f} ms.", encoderThreadPool.GetThreadCount(), GetElapsedMilliseconds(encodeStart));
+
+    spdlog::info("Successfully wrote image result to: {}", std::filesystem::absolute(kOutputFileName).string());
+
+    // The exporter signals the read value once it is done with the image, the clear has completed long before.
+    if (!WaitVulkanTimelineSemaphore(device, sharedImage.vkTimelineSemaphore, GetSharedImageReadSignalValue(kFrameIndex)))
+        spdlog::warn("Timed out waiting for the exporter to release the shared image.");
+
+    // Optionally validate the readback compute stage against its CPU reference instead of streaming.
+    // -----------------------------------------------
+    if (checkCompute)
+    {
+        if (!CheckReadbackCompute(pBackend.get(), device, sharedImage, kFrameIndex + 1u))
+        {
+            spdlog::critical("The readback compute stage does not match its CPU reference.");
+            return 1;
+        }
+    }
+
+    // Optionally capture a continuous stream of frames into a memory-mapped video file.
+    // -----------------------------------------------
+    else if (pCaptureFile != nullptr)
+    {
+        // Compute readbacks deliver NV12 frames of the downscaled size. Array images are captured one layer per frame.
+        SharedImageDesc videoDesc = sharedImageDesc;
+        videoDesc.arrayLayers = 1u;
+
+        if (readbackCompute.enabled)
+        {
+            if (!GetReadbackComputeExtent(sharedImageDesc, readbackCompute, videoDesc.width, videoDesc.height))
+            {
+                spdlog::critical("Readback compute downscale must be 1, 2 or 4.");
+                return 1;
+            }
 
-    char workingDirectory[MAX_PATH];
-    GetModuleFileNameA(NULL, workingDirectory, MAX_PATH);
-    std::filesystem::path workingDirectoryPath(workingDirectory);
+            videoDesc.format = pStreamFormat->vkFormat;
+        }
 
-    spdlog::info("Successfully wrote image result to: {}\\{}", workingDirectoryPath.parent_path().string(), kOutputFileName);
+        MappedVideoFile videoFile;
+        if (!videoFile.Create(pCaptureFile, videoDesc, pStreamFormat->format, streamFrames > 0u ? streamFrames : kDefaultCaptureFrameCount))
+        {
+            spdlog::critical("Failed to create the video file {}.", pCaptureFile);
+            return 1;
+        }
+
+        FrameStreamDesc streamDesc;
+        streamDesc.firstFrameIndex  = kFrameIndex + 1u;
+        streamDesc.frameCount       = videoFile.GetFrameCapacity();
+        streamDesc.durationSeconds  = streamSeconds;
+        streamDesc.readbackDepth    = readbackDepth;
+        streamDesc.prerecordFrames  = prerecord;
+        streamDesc.dirtyRectWidth   = dirtyRect.width;
+        streamDesc.dirtyRectHeight  = dirtyRect.height;
+        streamDesc.readbackCompute  = readbackCompute;
+        streamDesc.pVideoFile       = &videoFile;
+        streamDesc.zeroCopy         = zeroCopy;
+        streamDesc.pCodecThreadPool = frameCodec ? &encoderThreadPool : nullptr;
+        streamDesc.pipelineDepth    = pipelineDepth;
+        streamDesc.pTraceQueries    = pTraceQueries;
+
+        FrameStreamResult streamResult;
+        if (!RunFrameStream(pBackend.get(), device, *pFrameContexts, sharedImage, streamDesc, streamResult))
+        {
+            spdlog::critical("Failed to stream frames into {}.", pCaptureFile);
+            return 1;
+        }
+
+        LogFrameStreamResult(readbackDepth, streamResult);
+
+        spdlog::info("Captured {} frames to: {} (raw {} frames start at byte {}).",
+            videoFile.GetFrameCount(),
+            std::filesystem::absolute(pCaptureFile).string(),
+            pStreamFormat->pFFmpegName,
+            videoFile.GetDataOffset()
+        );
+
+        videoFile.Close();
+    }
+
+    // Otherwise optionally stream frames through the asynchronous readback ring and compare it with one readback at a time.
+    // -----------------------------------------------
+    else if (streamFrames > 0u)
+    {
+        FrameStreamDesc synchronousDesc;
+        synchronousDesc.firstFrameIndex  = kFrameIndex + 1u;
+        synchronousDesc.frameCount       = streamFrames;
+        synchronousDesc.durationSeconds  = streamSeconds;
+        synchronousDesc.readbackDepth    = 1u;
+        synchronousDesc.prerecordFrames  = prerecord;
+        synchronousDesc.dirtyRectWidth   = dirtyRect.width;
+        synchronousDesc.dirtyRectHeight  = dirtyRect.height;
+        synchronousDesc.readbackCompute  = readbackCompute;
+        synchronousDesc.pCodecThreadPool = frameCodec ? &encoderThreadPool : nullptr;
+        synchronousDesc.pipelineDepth    = pipelineDepth;
+        synchronousDesc.pTraceQueries    = pTraceQueries;
+
+        FrameStreamDesc pipelinedDesc = synchronousDesc;
+        pipelinedDesc.firstFrameIndex = synchronousDesc.firstFrameIndex + streamFrames;
+        pipelinedDesc.readbackDepth   = readbackDepth;
+
+        FrameStreamResult synchronousResult;
+        FrameStreamResult pipelinedResult;
+
+        if (!RunFrameStream(pBackend.get(), device, *pFrameContexts, sharedImage, synchronousDesc, synchronousResult) ||
+            !RunFrameStream(pBackend.get(), device, *pFrameContexts, sharedImage, pipelinedDesc,   pipelinedResult))
+        {
+            spdlog::critical("Failed to stream frames through the readback ring.");
+            return 1;
+        }
+
+        LogFrameStreamResult(1u,            synchronousResult);
+        LogFrameStreamResult(readbackDepth, pipelinedResult);
+
+        spdlog::info("Readback depth {} vs 1: {:.2f}x throughput for {:+.3f} ms p50 latency.",
+            readbackDepth,
+            pipelinedResult.framesPerSecond / std::max(synchronousResult.framesPerSecond, 1e-9),
+            pipelinedResult.latencyMs.p50 - synchronousResult.latencyMs.p50
+        );
+    }
 
     // Release Vulkan Primitives.
-    vkDestroyImage    (vkLogicalDevice, vkImage,       nullptr);
-    vkFreeMemory      (vkLogicalDevice, vkImageMemory, nullptr);
-    vkDestroyDevice   (vkLogicalDevice,                nullptr);
-    vkDestroyInstance (vkInstance,                     nullptr);
+
+    frameContextPools.Destroy();
+
+    pBackend->DestroySharedImage(device, sharedImage);
+
+    const ImportCacheCounters importCounters = pBackend->GetImportCache().GetCounters();
+
+    spdlog::info("Import cache: {} hits, {} misses, {} evictions, {:.1f} MiB resident, bind p50 {:.3f} ms (hit) / {:.3f} ms (miss).",
+        importCounters.hits,
+        importCounters.misses,
+        importCounters.evictions,
+        importCounters.residentBytes / (1024.0 * 1024.0),
+        importCounters.hitBindMs.p50,
+        importCounters.missBindMs.p50
+    );
+
+    const SharedMemoryArenaStats arenaStats = pBackend->GetMemoryArenaStats();
+
+    spdlog::info("Memory arena: {} device memory objects, {} blocks ({:.1f} / {:.1f} MiB used, {} allocations, {:.0f}% fragmented), {} dedicated images.",
+        arenaStats.deviceMemoryCount,
+        arenaStats.blockCount,
+        arenaStats.usedBytes / (1024.0 * 1024.0),
+        arenaStats.reservedBytes / (1024.0 * 1024.0),
+        arenaStats.allocationCount,
+        arenaStats.fragmentation * 100.0,
+        arenaStats.dedicatedCount
+    );
+
+    // Every submission retired above, so the GPU zones of both devices are complete.
+    if (pTraceFile != nullptr)
+        TRACE_WRITE(pTraceFile);
+
+    // The caches are not saved with --no-startup-cache.
+    if (startupCache)
+    {
+        pBackend->SavePipelineCache(kPipelineCacheFileName);
+        SaveVulkanDeviceCache(kDeviceCacheFileName);
+    }
+
+    pBackend->Release();
+
+    TRACE_GPU_DESTROY(pTraceQueries);
+
+    DestroyVulkanDevice(device);
+    vkDestroyInstance(vkInstance, nullptr);
 
     return 0;
-}
\ No newline at end of file
+}
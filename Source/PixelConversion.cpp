@@ -0,0 +1,554 @@
+#include "PixelConversion.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+
+#include "Simd.h"
+
+// BT.601 limited range RGB -> YCbCr, for RGB in [0, 255].
+constexpr float kLumaRed      =  0.256788f;
+constexpr float kLumaGreen    =  0.504129f;
+constexpr float kLumaBlue     =  0.097906f;
+constexpr float kChromaBlueR  = -0.148223f;
+constexpr float kChromaBlueG  = -0.290993f;
+constexpr float kChromaBlueB  =  0.439216f;
+constexpr float kChromaRedR   =  0.439216f;
+constexpr float kChromaRedG   = -0.367788f;
+constexpr float kChromaRedB   = -0.071427f;
+
+constexpr float kToneMapInverseWhiteSquared = 1.0f / (kToneMapWhitePoint * kToneMapWhitePoint);
+
+template <PixelFormat Format>
+constexpr uint32_t kBytesPerPixel = GetPixelFormatTraits(Format).planes[0].bytesPerBlock;
+
+// Scalar Reference
+// ------------------------------------------------
+// Plain per-pixel versions of every kernel. They convert the tails the vector loops leave over and are what
+// CheckPixelConversions compares the vector kernels against, so they avoid sharing code with them.
+
+static float HalfToFloatReference(uint16_t half)
+{
+    const int   exponent = (half >> 10) & 0x1F;
+    const int   mantissa = half & 0x3FF;
+    const float value    = exponent == 0 ? std::ldexp((float)mantissa, -24) : std::ldexp((float)(mantissa + 1024), exponent - 25);
+
+    return (half & 0x8000u) ? -value : value;
+}
+
+static float ToneMapReference(float linear)
+{
+    const float value  = std::max(linear, 0.0f);
+    const float mapped = value * (1.0f + value * kToneMapInverseWhiteSquared) / (1.0f + value);
+
+    return std::sqrt(std::min(mapped, 1.0f)) * 255.0f;
+}
+
+// Reads pixel x of a row as RGBA in [0, 255], before rounding.
+template <PixelFormat Format>
+static void LoadPixelReference(const uint8_t* pRow, uint32_t x, float rgba[4])
+{
+    const uint8_t* pPixel = pRow + (size_t)x * kBytesPerPixel<Format>;
+
+    if constexpr (Format == PixelFormat::RGBA8 || Format == PixelFormat::BGRA8)
+    {
+        const bool swapRedBlue = Format == PixelFormat::BGRA8;
+
+        rgba[0] = pPixel[swapRedBlue ? 2 : 0];
+        rgba[1] = pPixel[1];
+        rgba[2] = pPixel[swapRedBlue ? 0 : 2];
+        rgba[3] = pPixel[3];
+    }
+    else if constexpr (Format == PixelFormat::RGB10A2)
+    {
+        uint32_t pixel;
+        memcpy(&pixel, pPixel, sizeof(pixel));
+
+        rgba[0] = (float)(pixel & 0x3FFu)         * (255.0f / 1023.0f);
+        rgba[1] = (float)((pixel >> 10) & 0x3FFu) * (255.0f / 1023.0f);
+        rgba[2] = (float)((pixel >> 20) & 0x3FFu) * (255.0f / 1023.0f);
+        rgba[3] = (float)(pixel >> 30)            * 85.0f;
+    }
+    else if constexpr (Format == PixelFormat::RGBA16F)
+    {
+        uint16_t halves[4];
+        memcpy(halves, pPixel, sizeof(halves));
+
+        for (int channel = 0; channel < 3; channel++)
+            rgba[channel] = ToneMapReference(HalfToFloatReference(halves[channel]));
+
+        rgba[3] = std::min(std::max(HalfToFloatReference(halves[3]), 0.0f), 1.0f) * 255.0f;
+    }
+}
+
+static uint8_t RoundToUInt8Reference(float value)
+{
+    return (uint8_t)std::min(std::max(std::nearbyint(value), 0.0f), 255.0f);
+}
+
+template <PixelFormat Format>
+static void ConvertRowToRGBA8Reference(const uint8_t* pSource, uint8_t* pDestination, uint32_t firstPixel, uint32_t width)
+{
+    for (uint32_t x = firstPixel; x < width; x++)
+    {
+        float rgba[4];
+        LoadPixelReference<Format>(pSource, x, rgba);
+
+        for (int channel = 0; channel < 4; channel++)
+            pDestination[x * 4u + channel] = RoundToUInt8Reference(rgba[channel]);
+    }
+}
+
+// Converts the 2x2 pixel blocks starting at column firstPixel of two rows to NV12.
+template <PixelFormat Format>
+static void ConvertRowPairToNV12Reference(const uint8_t* pRow0, const uint8_t* pRow1, uint8_t* pLuma0, uint8_t* pLuma1, uint8_t* pChroma, uint32_t firstPixel, uint32_t width)
+{
+    for (uint32_t x = firstPixel; x < width; x += 2u)
+    {
+        float block[4][4];
+        LoadPixelReference<Format>(pRow0, x,      block[0]);
+        LoadPixelReference<Format>(pRow0, x + 1u, block[1]);
+        LoadPixelReference<Format>(pRow1, x,      block[2]);
+        LoadPixelReference<Format>(pRow1, x + 1u, block[3]);
+
+        uint8_t* pLumaRows[2] = { pLuma0, pLuma1 };
+
+        for (int pixel = 0; pixel < 4; pixel++)
+        {
+            const float* pRgba = block[pixel];
+            pLumaRows[pixel / 2][x + pixel % 2] = RoundToUInt8Reference(pRgba[0] * kLumaRed + pRgba[1] * kLumaGreen + pRgba[2] * kLumaBlue + 16.0f);
+        }
+
+        float average[3];
+        for (int channel = 0; channel < 3; channel++)
+            average[channel] = ((block[0][channel] + block[1][channel]) + (block[2][channel] + block[3][channel])) * 0.25f;
+
+        pChroma[x + 0u] = RoundToUInt8Reference(average[0] * kChromaBlueR + average[1] * kChromaBlueG + average[2] * kChromaBlueB + 128.0f);
+        pChroma[x + 1u] = RoundToUInt8Reference(average[0] * kChromaRedR  + average[1] * kChromaRedG  + average[2] * kChromaRedB  + 128.0f);
+    }
+}
+
+// Vector Kernels
+// ------------------------------------------------
+
+// Loads four pixels as RGBA channel vectors in [0, 255], before rounding.
+template <PixelFormat Format>
+static void LoadPixels4(const uint8_t* pPixels, Float4& red, Float4& green, Float4& blue, Float4& alpha)
+{
+    if constexpr (Format == PixelFormat::RGBA8)
+    {
+        LoadRGBA8(pPixels, red, green, blue, alpha);
+    }
+    else if constexpr (Format == PixelFormat::BGRA8)
+    {
+        LoadRGBA8(pPixels, blue, green, red, alpha);
+    }
+    else if constexpr (Format == PixelFormat::RGB10A2)
+    {
+        LoadRGB10A2(pPixels, red, green, blue, alpha);
+
+        red   = red   * (255.0f / 1023.0f);
+        green = green * (255.0f / 1023.0f);
+        blue  = blue  * (255.0f / 1023.0f);
+        alpha = alpha * 85.0f;
+    }
+    else if constexpr (Format == PixelFormat::RGBA16F)
+    {
+        // One pixel per vector, transposed into one channel per vector.
+        red   = LoadHalf4((const uint16_t*)pPixels + 0);
+        green = LoadHalf4((const uint16_t*)pPixels + 4);
+        blue  = LoadHalf4((const uint16_t*)pPixels + 8);
+        alpha = LoadHalf4((const uint16_t*)pPixels + 12);
+
+        Transpose4(red, green, blue, alpha);
+
+        const Float4 zero = Float4::Set1(0.0f);
+        const Float4 one  = Float4::Set1(1.0f);
+
+        Float4* channels[3] = { &red, &green, &blue };
+        for (Float4* pChannel : channels)
+        {
+            const Float4 value  = Max(*pChannel, zero);
+            const Float4 mapped = value * (one + value * kToneMapInverseWhiteSquared) / (one + value);
+
+            *pChannel = Sqrt(Min(mapped, one)) * 255.0f;
+        }
+
+        alpha = Min(Max(alpha, zero), one) * 255.0f;
+    }
+}
+
+template <PixelFormat Format>
+static void ConvertRowToRGBA8(const uint8_t* pSource, uint8_t* pDestination, uint32_t width)
+{
+    uint32_t x = 0u;
+
+    if constexpr (Format == PixelFormat::BGRA8)
+    {
+        // Plain byte swizzle, no need to go through floats.
+        for (; x + 4u <= width; x += 4u)
+            SwapRedBlue4(pSource + x * 4u, pDestination + x * 4u);
+    }
+    else
+    {
+        for (; x + 4u <= width; x += 4u)
+        {
+            Float4 red, green, blue, alpha;
+            LoadPixels4<Format>(pSource + (size_t)x * kBytesPerPixel<Format>, red, green, blue, alpha);
+
+            StoreRGBA8(pDestination + x * 4u, red, green, blue, alpha);
+        }
+    }
+
+    ConvertRowToRGBA8Reference<Format>(pSource, pDestination, x, width);
+}
+
+static Float4 ComputeLuma(Float4 red, Float4 green, Float4 blue)
+{
+    return red * kLumaRed + green * kLumaGreen + blue * kLumaBlue + 16.0f;
+}
+
+// Converts two rows to NV12, eight pixels (four chroma samples) at a time.
+template <PixelFormat Format>
+static void ConvertRowPairToNV12(const uint8_t* pRow0, const uint8_t* pRow1, uint8_t* pLuma0, uint8_t* pLuma1, uint8_t* pChroma, uint32_t width)
+{
+    constexpr uint32_t kBpp = kBytesPerPixel<Format>;
+
+    uint32_t x = 0u;
+    for (; x + 8u <= width; x += 8u)
+    {
+        // Left and right halves of the eight pixels of both rows.
+        Float4 red[4], green[4], blue[4], alpha;
+        LoadPixels4<Format>(pRow0 + (size_t)x * kBpp,        red[0], green[0], blue[0], alpha);
+        LoadPixels4<Format>(pRow0 + (size_t)(x + 4u) * kBpp, red[1], green[1], blue[1], alpha);
+        LoadPixels4<Format>(pRow1 + (size_t)x * kBpp,        red[2], green[2], blue[2], alpha);
+        LoadPixels4<Format>(pRow1 + (size_t)(x + 4u) * kBpp, red[3], green[3], blue[3], alpha);
+
+        ComputeLuma(red[0], green[0], blue[0]).StoreRoundedUInt8(pLuma0 + x);
+        ComputeLuma(red[1], green[1], blue[1]).StoreRoundedUInt8(pLuma0 + x + 4u);
+        ComputeLuma(red[2], green[2], blue[2]).StoreRoundedUInt8(pLuma1 + x);
+        ComputeLuma(red[3], green[3], blue[3]).StoreRoundedUInt8(pLuma1 + x + 4u);
+
+        // Average each 2x2 block: horizontal pairs first, then the two rows.
+        const Float4 averageRed   = (PairwiseAdd(red[0],   red[1])   + PairwiseAdd(red[2],   red[3]))   * 0.25f;
+        const Float4 averageGreen = (PairwiseAdd(green[0], green[1]) + PairwiseAdd(green[2], green[3])) * 0.25f;
+        const Float4 averageBlue  = (PairwiseAdd(blue[0],  blue[1])  + PairwiseAdd(blue[2],  blue[3]))  * 0.25f;
+
+        const Float4 chromaBlue = averageRed * kChromaBlueR + averageGreen * kChromaBlueG + averageBlue * kChromaBlueB + 128.0f;
+        const Float4 chromaRed  = averageRed * kChromaRedR  + averageGreen * kChromaRedG  + averageBlue * kChromaRedB  + 128.0f;
+
+        uint8_t chromaBlueBytes[4];
+        uint8_t chromaRedBytes[4];
+        chromaBlue.StoreRoundedUInt8(chromaBlueBytes);
+        chromaRed .StoreRoundedUInt8(chromaRedBytes);
+
+        for (uint32_t sample = 0u; sample < 4u; sample++)
+        {
+            pChroma[x + sample * 2u + 0u] = chromaBlueBytes[sample];
+            pChroma[x + sample * 2u + 1u] = chromaRedBytes[sample];
+        }
+    }
+
+    ConvertRowPairToNV12Reference<Format>(pRow0, pRow1, pLuma0, pLuma1, pChroma, x, width);
+}
+
+// Dispatch
+// ------------------------------------------------
+
+using ConvertRowFunc     = void (*)(const uint8_t* pSource, uint8_t* pDestination, uint32_t width);
+using ConvertRowPairFunc = void (*)(const uint8_t* pRow0, const uint8_t* pRow1, uint8_t* pLuma0, uint8_t* pLuma1, uint8_t* pChroma, uint32_t width);
+
+struct ConversionKernels
+{
+    ConvertRowFunc     toRGBA8 = nullptr;
+    ConvertRowPairFunc toNV12  = nullptr;
+};
+
+template <PixelFormat Format>
+static void ConvertRowToRGBA8Scalar(const uint8_t* pSource, uint8_t* pDestination, uint32_t width)
+{
+    ConvertRowToRGBA8Reference<Format>(pSource, pDestination, 0u, width);
+}
+
+template <PixelFormat Format>
+static void ConvertRowPairToNV12Scalar(const uint8_t* pRow0, const uint8_t* pRow1, uint8_t* pLuma0, uint8_t* pLuma1, uint8_t* pChroma, uint32_t width)
+{
+    ConvertRowPairToNV12Reference<Format>(pRow0, pRow1, pLuma0, pLuma1, pChroma, 0u, width);
+}
+
+template <PixelFormat Format>
+constexpr ConversionKernels kVectorKernels = { &ConvertRowToRGBA8<Format>, &ConvertRowPairToNV12<Format> };
+
+template <PixelFormat Format>
+constexpr ConversionKernels kScalarKernels = { &ConvertRowToRGBA8Scalar<Format>, &ConvertRowPairToNV12Scalar<Format> };
+
+// Indexed by source PixelFormat, planar formats cannot be converted from.
+constexpr ConversionKernels kConversionKernels[] =
+{
+    kVectorKernels<PixelFormat::RGBA8>,
+    kVectorKernels<PixelFormat::BGRA8>,
+    kVectorKernels<PixelFormat::RGB10A2>,
+    kVectorKernels<PixelFormat::RGBA16F>,
+    {},
+};
+
+constexpr ConversionKernels kReferenceKernels[] =
+{
+    kScalarKernels<PixelFormat::RGBA8>,
+    kScalarKernels<PixelFormat::BGRA8>,
+    kScalarKernels<PixelFormat::RGB10A2>,
+    kScalarKernels<PixelFormat::RGBA16F>,
+    {},
+};
+
+static_assert(sizeof(kConversionKernels) / sizeof(kConversionKernels[0]) == (size_t)PixelFormat::Count);
+static_assert(sizeof(kReferenceKernels)  / sizeof(kReferenceKernels[0])  == (size_t)PixelFormat::Count);
+
+bool IsPixelConversionSupported(PixelFormat sourceFormat, PixelFormat destinationFormat)
+{
+    if (sourceFormat == destinationFormat)
+        return true;
+
+    const ConversionKernels& kernels = kConversionKernels[(uint32_t)sourceFormat];
+
+    return (destinationFormat == PixelFormat::RGBA8 && kernels.toRGBA8 != nullptr) ||
+           (destinationFormat == PixelFormat::NV12  && kernels.toNV12  != nullptr);
+}
+
+static bool ConvertPixelsWith(const ConversionKernels* pKernelTable, PixelFormat sourceFormat, const void* pSource, uint32_t sourceRowPitch,
+                              PixelFormat destinationFormat, void* pDestination, uint32_t destinationRowPitch, uint32_t width, uint32_t height)
+{
+    if (!IsPixelConversionSupported(sourceFormat, destinationFormat))
+    {
+        spdlog::error("Conversion from {} to {} is not supported.", GetPixelFormatTraits(sourceFormat).pName, GetPixelFormatTraits(destinationFormat).pName);
+        return false;
+    }
+
+    const auto* pSourceBytes      = (const uint8_t*)pSource;
+    auto*       pDestinationBytes = (uint8_t*)pDestination;
+
+    if (sourceFormat == destinationFormat)
+    {
+        const PixelFormatTraits& traits = GetPixelFormatTraits(sourceFormat);
+
+        // Every plane of the formats is addressed with the same row pitch.
+        for (uint32_t plane = 0u; plane < traits.planeCount; plane++)
+        {
+            const uint32_t rowSize  = GetPixelPlaneRowPitch(traits, plane, width);
+            const uint32_t rowCount = (uint32_t)(GetPixelPlaneSize(traits, plane, width, height) / rowSize);
+
+            for (uint32_t row = 0u; row < rowCount; row++)
+                memcpy(pDestinationBytes + (size_t)row * destinationRowPitch, pSourceBytes + (size_t)row * sourceRowPitch, rowSize);
+
+            pSourceBytes      += (size_t)sourceRowPitch      * rowCount;
+            pDestinationBytes += (size_t)destinationRowPitch * rowCount;
+        }
+
+        return true;
+    }
+
+    const ConversionKernels& kernels = pKernelTable[(uint32_t)sourceFormat];
+
+    if (destinationFormat == PixelFormat::RGBA8)
+    {
+        for (uint32_t row = 0u; row < height; row++)
+            kernels.toRGBA8(pSourceBytes + (size_t)row * sourceRowPitch, pDestinationBytes + (size_t)row * destinationRowPitch, width);
+
+        return true;
+    }
+
+    // NV12 chroma is shared by 2x2 blocks.
+    if ((width | height) & 1u)
+    {
+        spdlog::error("NV12 images need an even width and height, not {}x{}.", width, height);
+        return false;
+    }
+
+    uint8_t* pChromaPlane = pDestinationBytes + (size_t)destinationRowPitch * height;
+
+    for (uint32_t row = 0u; row < height; row += 2u)
+    {
+        kernels.toNV12(pSourceBytes + (size_t)row * sourceRowPitch,
+                       pSourceBytes + (size_t)(row + 1u) * sourceRowPitch,
+                       pDestinationBytes + (size_t)row * destinationRowPitch,
+                       pDestinationBytes + (size_t)(row + 1u) * destinationRowPitch,
+                       pChromaPlane + (size_t)(row / 2u) * destinationRowPitch,
+                       width);
+    }
+
+    return true;
+}
+
+bool ConvertPixels(PixelFormat sourceFormat, const void* pSource, uint32_t sourceRowPitch,
+                   PixelFormat destinationFormat, void* pDestination, uint32_t destinationRowPitch,
+                   uint32_t width, uint32_t height)
+{
+    return ConvertPixelsWith(kConversionKernels, sourceFormat, pSource, sourceRowPitch, destinationFormat, pDestination, destinationRowPitch, width, height);
+}
+
+// Readback Compute Reference
+// ------------------------------------------------
+// Same steps as Shaders/ReadbackNV12.comp, one output pixel at a time.
+
+using LoadPixelFunc = void (*)(const uint8_t* pRow, uint32_t x, float rgba[4]);
+
+// Indexed by source PixelFormat.
+constexpr LoadPixelFunc kLoadPixelReference[] =
+{
+    &LoadPixelReference<PixelFormat::RGBA8>,
+    &LoadPixelReference<PixelFormat::BGRA8>,
+    &LoadPixelReference<PixelFormat::RGB10A2>,
+    &LoadPixelReference<PixelFormat::RGBA16F>,
+    nullptr,
+};
+
+static_assert(sizeof(kLoadPixelReference) / sizeof(kLoadPixelReference[0]) == (size_t)PixelFormat::Count);
+
+bool DownscalePixelsToNV12(PixelFormat sourceFormat, const void* pSource, uint32_t sourceRowPitch, void* pDestination, uint32_t destinationRowPitch,
+                           uint32_t width, uint32_t height, uint32_t downscale)
+{
+    const LoadPixelFunc loadPixel = kLoadPixelReference[(uint32_t)sourceFormat];
+
+    if (loadPixel == nullptr || downscale == 0u || ((width | height) & 1u))
+    {
+        spdlog::error("{} images cannot be downscaled to {}x{} NV12.", GetPixelFormatTraits(sourceFormat).pName, width, height);
+        return false;
+    }
+
+    const auto* pSourceBytes = (const uint8_t*)pSource;
+
+    // Mean of the downscale x downscale source pixels of output pixel (x, y).
+    auto loadOutputPixel = [&](uint32_t x, uint32_t y, float rgb[3])
+    {
+        float sum[3] = {};
+
+        for (uint32_t sourceY = y * downscale; sourceY < (y + 1u) * downscale; sourceY++)
+        {
+            for (uint32_t sourceX = x * downscale; sourceX < (x + 1u) * downscale; sourceX++)
+            {
+                float rgba[4];
+                loadPixel(pSourceBytes + (size_t)sourceY * sourceRowPitch, sourceX, rgba);
+
+                for (int channel = 0; channel < 3; channel++)
+                    sum[channel] += rgba[channel];
+            }
+        }
+
+        for (int channel = 0; channel < 3; channel++)
+            rgb[channel] = sum[channel] / (float)(downscale * downscale);
+    };
+
+    auto* pLumaPlane   = (uint8_t*)pDestination;
+    auto* pChromaPlane = pLumaPlane + (size_t)destinationRowPitch * height;
+
+    for (uint32_t y = 0u; y < height; y += 2u)
+    {
+        for (uint32_t x = 0u; x < width; x += 2u)
+        {
+            float block[4][3];
+            loadOutputPixel(x,      y,      block[0]);
+            loadOutputPixel(x + 1u, y,      block[1]);
+            loadOutputPixel(x,      y + 1u, block[2]);
+            loadOutputPixel(x + 1u, y + 1u, block[3]);
+
+            for (int pixel = 0; pixel < 4; pixel++)
+            {
+                const float* pRgb = block[pixel];
+                pLumaPlane[(size_t)(y + pixel / 2) * destinationRowPitch + x + pixel % 2] = RoundToUInt8Reference(pRgb[0] * kLumaRed + pRgb[1] * kLumaGreen + pRgb[2] * kLumaBlue + 16.0f);
+            }
+
+            float average[3];
+            for (int channel = 0; channel < 3; channel++)
+                average[channel] = ((block[0][channel] + block[1][channel]) + (block[2][channel] + block[3][channel])) * 0.25f;
+
+            uint8_t* pChroma = pChromaPlane + (size_t)(y / 2u) * destinationRowPitch + x;
+            pChroma[0] = RoundToUInt8Reference(average[0] * kChromaBlueR + average[1] * kChromaBlueG + average[2] * kChromaBlueB + 128.0f);
+            pChroma[1] = RoundToUInt8Reference(average[0] * kChromaRedR  + average[1] * kChromaRedG  + average[2] * kChromaRedB  + 128.0f);
+        }
+    }
+
+    return true;
+}
+
+// Self Check
+// ------------------------------------------------
+
+void FillRandomPixels(PixelFormat format, std::vector<uint8_t>& pixels, std::mt19937& random)
+{
+    if (format == PixelFormat::RGBA16F)
+    {
+        std::uniform_int_distribution<uint32_t> halfDistribution(0u, 0x4C00u); // [0, 16]
+
+        for (size_t offset = 0u; offset + 1u < pixels.size(); offset += 2u)
+        {
+            const uint16_t half = (uint16_t)(halfDistribution(random) | (random() % 8u == 0u ? 0x8000u : 0u));
+            memcpy(&pixels[offset], &half, sizeof(half));
+        }
+
+        return;
+    }
+
+    for (auto& byte : pixels)
+        byte = (uint8_t)random();
+}
+
+bool CheckPixelConversions()
+{
+    struct CheckSize { uint32_t width, height; };
+
+    // Vector-friendly sizes, and sizes that leave tails for the scalar path.
+    constexpr CheckSize kCheckSizes[] = { { 64u, 32u }, { 38u, 10u }, { 6u, 2u } };
+
+    std::mt19937 random(1234u);
+
+    bool passed = true;
+
+    for (uint32_t sourceIndex = 0u; sourceIndex < (uint32_t)PixelFormat::Count; sourceIndex++)
+    {
+        const PixelFormatTraits& sourceTraits = kPixelFormatTraits[sourceIndex];
+
+        for (PixelFormat destinationFormat : { PixelFormat::RGBA8, PixelFormat::NV12 })
+        {
+            if (sourceTraits.format == destinationFormat || !IsPixelConversionSupported(sourceTraits.format, destinationFormat))
+                continue;
+
+            const PixelFormatTraits& destinationTraits = GetPixelFormatTraits(destinationFormat);
+
+            int maxDifference = 0;
+
+            for (const auto& size : kCheckSizes)
+            {
+                // Padded source rows, so the kernels are also checked against a non-tight pitch.
+                const uint32_t sourceRowPitch      = GetPixelPlaneRowPitch(sourceTraits, 0u, size.width) + 16u;
+                const uint32_t destinationRowPitch = GetPixelPlaneRowPitch(destinationTraits, 0u, size.width);
+
+                std::vector<uint8_t> source((size_t)sourceRowPitch * size.height);
+                FillRandomPixels(sourceTraits.format, source, random);
+
+                const size_t destinationSize = GetPixelImageSize(destinationTraits, size.width, size.height);
+
+                std::vector<uint8_t> vectorOutput   (destinationSize);
+                std::vector<uint8_t> referenceOutput(destinationSize);
+
+                if (!ConvertPixelsWith(kConversionKernels, sourceTraits.format, source.data(), sourceRowPitch, destinationFormat, vectorOutput.data(),    destinationRowPitch, size.width, size.height) ||
+                    !ConvertPixelsWith(kReferenceKernels,  sourceTraits.format, source.data(), sourceRowPitch, destinationFormat, referenceOutput.data(), destinationRowPitch, size.width, size.height))
+                    return false;
+
+                for (size_t offset = 0u; offset < destinationSize; offset++)
+                    maxDifference = std::max(maxDifference, std::abs((int)vectorOutput[offset] - (int)referenceOutput[offset]));
+            }
+
+            // Fused multiply-adds on some targets may round the last step differently.
+            const bool matches = maxDifference <= 1;
+
+            spdlog::info("{} -> {}: max difference {} against the scalar reference{}", sourceTraits.pName, destinationTraits.pName, maxDifference, matches ? "." : ", FAILED.");
+
+            passed = passed && matches;
+        }
+    }
+
+    return passed;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <random>
+#include <vector>
+
+#include "PixelFormat.h"
+
+// Converts a width x height image between pixel formats. Rows of each plane are rowPitch bytes apart
+// and the planes of a planar image follow each other (the NV12 chroma plane starts rowPitch * height
+// bytes after the luma plane).
+//
+// Supported: any format to itself, any single plane format to RGBA8, and any single plane format to NV12
+// (even width and height only). RGBA16F is treated as finite scene-linear values and tone mapped, see
+// kToneMapWhitePoint.
+bool ConvertPixels(PixelFormat sourceFormat, const void* pSource, uint32_t sourceRowPitch,
+                   PixelFormat destinationFormat, void* pDestination, uint32_t destinationRowPitch,
+                   uint32_t width, uint32_t height);
+
+bool IsPixelConversionSupported(PixelFormat sourceFormat, PixelFormat destinationFormat);
+
+// Reference of the readback compute stage (Shaders/ReadbackNV12.comp): averages blocks of downscale x downscale
+// source pixels into a width x height image and converts it to NV12 like ConvertPixels. width and height are those
+// of the output, even, and the source must cover downscale times as many pixels.
+bool DownscalePixelsToNV12(PixelFormat sourceFormat, const void* pSource, uint32_t sourceRowPitch, void* pDestination, uint32_t destinationRowPitch,
+                           uint32_t width, uint32_t height, uint32_t downscale);
+
+// Linear RGBA16F values at or above the white point map to 255 (extended Reinhard, then gamma 2).
+constexpr float kToneMapWhitePoint = 4.0f;
+
+// Random source pixels of format. Half floats stay finite and mostly within the tone mapped range.
+void FillRandomPixels(PixelFormat format, std::vector<uint8_t>& pixels, std::mt19937& random);
+
+// Runs every SIMD conversion kernel against its scalar reference on random images, including sizes that
+// are not a multiple of the vector width. Returns false if any output differs by more than one step.
+bool CheckPixelConversions();
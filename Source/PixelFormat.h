@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#include <volk.h>
+
+// Pixel formats shared images are created with or converted to on readback.
+enum class PixelFormat : uint32_t
+{
+    RGBA8,
+    BGRA8,
+    RGB10A2,
+    RGBA16F,
+
+    // 8-bit luma plane followed by an interleaved CbCr plane at half resolution (BT.601, limited range).
+    NV12,
+
+    Count,
+};
+
+// Blocks of blockWidth x blockHeight pixels are stored as bytesPerBlock bytes.
+struct PixelPlaneLayout
+{
+    uint32_t bytesPerBlock = 0u;
+    uint32_t blockWidth    = 1u;
+    uint32_t blockHeight   = 1u;
+};
+
+constexpr uint32_t kPixelFormatMaxPlanes = 2u;
+
+struct PixelFormatTraits
+{
+    PixelFormat      format;
+
+    // Name on the command line.
+    const char*      pName;
+
+    VkFormat         vkFormat;
+
+    // DXGI_FORMAT value, kept numeric so that only the D3D11 backend needs the DXGI headers.
+    uint32_t         dxgiFormat;
+
+    // ffmpeg -pixel_format of tightly packed frames.
+    const char*      pFFmpegName;
+
+    uint32_t         planeCount;
+    PixelPlaneLayout planes[kPixelFormatMaxPlanes];
+
+    // Single plane formats can back a shared image, planar ones are only produced by conversion.
+    constexpr bool IsShareable() const { return planeCount == 1u; }
+};
+
+constexpr PixelFormatTraits kPixelFormatTraits[] =
+{
+    { PixelFormat::RGBA8,   "rgba8",   VK_FORMAT_R8G8B8A8_UNORM,           28u,  "rgba",      1u, { { 4u, 1u, 1u } } },
+    { PixelFormat::BGRA8,   "bgra8",   VK_FORMAT_B8G8R8A8_UNORM,           87u,  "bgra",      1u, { { 4u, 1u, 1u } } },
+    { PixelFormat::RGB10A2, "rgb10a2", VK_FORMAT_A2B10G10R10_UNORM_PACK32, 24u,  "x2bgr10le", 1u, { { 4u, 1u, 1u } } },
+    { PixelFormat::RGBA16F, "rgba16f", VK_FORMAT_R16G16B16A16_SFLOAT,      10u,  "rgbaf16le", 1u, { { 8u, 1u, 1u } } },
+    { PixelFormat::NV12,    "nv12",    VK_FORMAT_G8_B8R8_2PLANE_420_UNORM, 103u, "nv12",      2u, { { 1u, 1u, 1u }, { 2u, 2u, 2u } } },
+};
+
+constexpr bool IsPixelFormatTableOrdered()
+{
+    for (uint32_t formatIndex = 0u; formatIndex < (uint32_t)PixelFormat::Count; formatIndex++)
+    {
+        if (kPixelFormatTraits[formatIndex].format != (PixelFormat)formatIndex)
+            return false;
+    }
+
+    return true;
+}
+
+static_assert(sizeof(kPixelFormatTraits) / sizeof(kPixelFormatTraits[0]) == (size_t)PixelFormat::Count, "Every pixel format needs traits.");
+static_assert(IsPixelFormatTableOrdered(), "kPixelFormatTraits must be indexed by PixelFormat.");
+
+constexpr const PixelFormatTraits& GetPixelFormatTraits(PixelFormat format)
+{
+    return kPixelFormatTraits[(uint32_t)format];
+}
+
+constexpr const PixelFormatTraits* FindPixelFormatTraits(VkFormat vkFormat)
+{
+    for (const auto& traits : kPixelFormatTraits)
+    {
+        if (traits.vkFormat == vkFormat)
+            return &traits;
+    }
+
+    return nullptr;
+}
+
+inline const PixelFormatTraits* FindPixelFormatTraits(const char* pName)
+{
+    for (const auto& traits : kPixelFormatTraits)
+    {
+        if (!strcmp(traits.pName, pName))
+            return &traits;
+    }
+
+    return nullptr;
+}
+
+// Tightly packed layout of width x height pixels.
+constexpr uint32_t GetPixelPlaneRowPitch(const PixelFormatTraits& traits, uint32_t plane, uint32_t width)
+{
+    const PixelPlaneLayout& layout = traits.planes[plane];
+
+    return (width + layout.blockWidth - 1u) / layout.blockWidth * layout.bytesPerBlock;
+}
+
+constexpr uint64_t GetPixelPlaneSize(const PixelFormatTraits& traits, uint32_t plane, uint32_t width, uint32_t height)
+{
+    const PixelPlaneLayout& layout = traits.planes[plane];
+
+    return (uint64_t)GetPixelPlaneRowPitch(traits, plane, width) * ((height + layout.blockHeight - 1u) / layout.blockHeight);
+}
+
+constexpr uint64_t GetPixelImageSize(const PixelFormatTraits& traits, uint32_t width, uint32_t height)
+{
+    uint64_t imageSize = 0u;
+
+    for (uint32_t plane = 0u; plane < traits.planeCount; plane++)
+        imageSize += GetPixelPlaneSize(traits, plane, width, height);
+
+    return imageSize;
+}
+
+static_assert(GetPixelImageSize(GetPixelFormatTraits(PixelFormat::NV12), 1920u, 1080u) == 1920u * 1080u * 3u / 2u);
+static_assert(GetPixelImageSize(GetPixelFormatTraits(PixelFormat::RGBA16F), 3u, 3u) == 72u);
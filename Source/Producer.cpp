@@ -0,0 +1,228 @@
+#include <chrono>
+
+#include <spdlog/spdlog.h>
+
+#include "CommandLine.h"
+#include "ExternalImage.h"
+#include "SharedFrameRing.h"
+
+// Renders frames into a ring of exported images and publishes them to a consumer process.
+// The consumer may attach, detach or fall behind at any time without slowing the producer down.
+
+struct ProducerSlot
+{
+    VkImage              vkImage         = VK_NULL_HANDLE;
+    VkDeviceMemory       vkImageMemory   = VK_NULL_HANDLE;
+    ExternalMemoryHandle memoryHandle    = kInvalidExternalMemoryHandle;
+    VkCommandBuffer      vkCommandBuffer = VK_NULL_HANDLE;
+    VkFence              vkFence         = VK_NULL_HANDLE;
+};
+
+int main(int argc, char** argv)
+{
+    const char* pRingName  = kSharedFrameRingDefaultName;
+    uint32_t    slotCount  = kSharedFrameRingDefaultSlots;
+    uint32_t    frameCount = 1000u;
+    uint32_t    width      = 1920u;
+    uint32_t    height     = 1080u;
+
+    for (int argIndex = 1; argIndex < argc; argIndex++)
+    {
+        const char* pArgument = argv[argIndex];
+
+        if (ParseStringArgument(pArgument, "--name=",   pRingName)  ||
+            ParseUIntArgument  (pArgument, "--slots=",  slotCount)  ||
+            ParseUIntArgument  (pArgument, "--frames=", frameCount) ||
+            ParseUIntArgument  (pArgument, "--width=",  width)      ||
+            ParseUIntArgument  (pArgument, "--height=", height))
+            continue;
+
+        spdlog::critical("Unknown argument: {} (usage: --name=<ring> --slots=N --frames=N --width=W --height=H)", pArgument);
+        return 1;
+    }
+
+    VkInstance vkInstance;
+    if (!CreateVulkanInstance(vkInstance))
+    {
+        spdlog::critical("Failed to create the Vulkan Instance.");
+        return 1;
+    }
+
+    const std::vector<const char*> requiredDeviceExtensions = { kVulkanExternalMemoryExtensionName, kVulkanExternalSemaphoreExtensionName };
+
+    VkPhysicalDevice vkPhysicalDevice;
+    if (!SelectVulkanPhysicalDevice(vkInstance, requiredDeviceExtensions, nullptr, vkPhysicalDevice))
+    {
+        spdlog::critical("Failed to select a Vulkan Physical Device that can export memory.");
+        return 1;
+    }
+
+    VulkanDevice device;
+    if (!CreateVulkanDevice(vkPhysicalDevice, requiredDeviceExtensions, device))
+        return 1;
+
+    // Allocate the exported image pool.
+    // ------------------------------------------------
+
+    SharedFrameRingDesc ringDesc;
+    ringDesc.slotCount        = slotCount;
+    ringDesc.imageDesc.width  = width;
+    ringDesc.imageDesc.height = height;
+    ringDesc.imageDesc.format = VK_FORMAT_R8G8B8A8_UNORM;
+
+    VkPhysicalDeviceIDProperties vkIDProperties;
+    GetVulkanPhysicalDeviceIDProperties(vkPhysicalDevice, vkIDProperties);
+    memcpy(ringDesc.deviceUUID, vkIDProperties.deviceUUID, VK_UUID_SIZE);
+
+    if (slotCount < 2u || slotCount > kSharedFrameRingMaxSlots)
+    {
+        spdlog::critical("Slot count must be within [2, {}].", kSharedFrameRingMaxSlots);
+        return 1;
+    }
+
+    VkCommandPoolCreateInfo vkCommandPoolCreateInfo = { VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO };
+    vkCommandPoolCreateInfo.flags            = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    vkCommandPoolCreateInfo.queueFamilyIndex = device.graphicsQueueIndex;
+
+    VkCommandPool vkCommandPool;
+    if (vkCreateCommandPool(device.vkLogicalDevice, &vkCommandPoolCreateInfo, nullptr, &vkCommandPool) != VK_SUCCESS)
+        return 1;
+
+    ProducerSlot         slots[kSharedFrameRingMaxSlots];
+    ExternalMemoryHandle memoryHandles[kSharedFrameRingMaxSlots];
+
+    for (uint32_t slotIndex = 0u; slotIndex < slotCount; slotIndex++)
+    {
+        auto& slot = slots[slotIndex];
+
+        VkDeviceSize allocationSize;
+        if (!CreateVulkanImage2D(device, ringDesc.imageDesc, kVulkanExternalMemoryHandleType, slot.vkImage) ||
+            !AllocateVulkanImageMemory(device, slot.vkImage, kVulkanExternalMemoryHandleType, slot.vkImageMemory, allocationSize) ||
+            !ExportVulkanMemoryHandle(device, slot.vkImageMemory, slot.memoryHandle))
+        {
+            spdlog::critical("Failed to create exported image for slot {}.", slotIndex);
+            return 1;
+        }
+
+        // Every slot has the same description, so they share one allocation size.
+        ringDesc.allocationSize  = allocationSize;
+        memoryHandles[slotIndex] = slot.memoryHandle;
+
+        VkCommandBufferAllocateInfo vkCommandAllocateInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
+        vkCommandAllocateInfo.commandBufferCount = 1u;
+        vkCommandAllocateInfo.commandPool        = vkCommandPool;
+        vkCommandAllocateInfo.level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+
+        // Created signaled: the fence only guards reuse of the command buffer and image by the producer itself.
+        VkFenceCreateInfo vkFenceCreateInfo = { VK_STRUCTURE_TYPE_FENCE_CREATE_INFO };
+        vkFenceCreateInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+        if (vkAllocateCommandBuffers(device.vkLogicalDevice, &vkCommandAllocateInfo, &slot.vkCommandBuffer) != VK_SUCCESS ||
+            vkCreateFence(device.vkLogicalDevice, &vkFenceCreateInfo, nullptr, &slot.vkFence) != VK_SUCCESS)
+            return 1;
+    }
+
+    // The frame timeline reaches a frame's sequence once it is rendered, consumers wait for it on their GPU.
+    VkSemaphore             vkFrameTimeline;
+    ExternalSemaphoreHandle frameTimelineHandle;
+    if (!CreateVulkanTimelineSemaphore(device, kVulkanExternalSemaphoreHandleType, vkFrameTimeline) ||
+        !ExportVulkanSemaphoreHandle(device, vkFrameTimeline, frameTimelineHandle))
+    {
+        spdlog::critical("Failed to create the exported frame timeline semaphore.");
+        return 1;
+    }
+
+    SharedFrameRing ring;
+    if (!ring.Create(pRingName, ringDesc))
+    {
+        spdlog::critical("Failed to create the shared frame ring.");
+        return 1;
+    }
+
+    spdlog::info("Producing {} frames of {}x{} into {} slots of ring '{}'.", frameCount, width, height, slotCount, pRingName);
+
+    // Produce frames.
+    // ------------------------------------------------
+
+    const auto produceStart = std::chrono::steady_clock::now();
+
+    for (uint64_t frameSequence = 1u; frameSequence <= frameCount; frameSequence++)
+    {
+        if (!ring.ServeMemoryHandles(memoryHandles, frameTimelineHandle))
+            spdlog::warn("Failed to hand the memory handles to a consumer.");
+
+        const uint32_t slotIndex = ring.AcquireWriteSlot();
+        auto&          slot      = slots[slotIndex];
+
+        // A recycled slot may still be rendering its previous frame.
+        vkWaitForFences(device.vkLogicalDevice, 1u, &slot.vkFence, VK_TRUE, UINT64_MAX);
+        vkResetFences(device.vkLogicalDevice, 1u, &slot.vkFence);
+
+        VkCommandBufferBeginInfo vkCommandBeginInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+        vkCommandBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+        vkResetCommandBuffer(slot.vkCommandBuffer, 0u);
+        vkBeginCommandBuffer(slot.vkCommandBuffer, &vkCommandBeginInfo);
+
+        RecordVulkanImageBarrier(slot.vkCommandBuffer, slot.vkImage, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL, 0u, VK_ACCESS_TRANSFER_WRITE_BIT);
+
+        VkImageSubresourceRange vkImageClearRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0u, 1u, 0u, 1u };
+
+        // Encode the low byte of the sequence in the red channel so the consumer can detect torn frames.
+        VkClearColorValue clearColor = { { (float)(frameSequence & 0xFFu) / 255.0f, 0.5f, 1.0f, 1.0f } };
+        vkCmdClearColorImage(slot.vkCommandBuffer, slot.vkImage, VK_IMAGE_LAYOUT_GENERAL, &clearColor, 1u, &vkImageClearRange);
+
+        // Release the image to the consumer process.
+        RecordVulkanImageBarrier(slot.vkCommandBuffer, slot.vkImage, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL, VK_ACCESS_TRANSFER_WRITE_BIT, 0u, device.graphicsQueueIndex, VK_QUEUE_FAMILY_EXTERNAL);
+
+        vkEndCommandBuffer(slot.vkCommandBuffer);
+
+        VulkanTimelineSubmit timelineSubmit;
+        timelineSubmit.vkSignalSemaphore = vkFrameTimeline;
+        timelineSubmit.signalValue       = frameSequence;
+
+        if (!SubmitVulkanCommandBuffer(device.vkGraphicsQueue, slot.vkCommandBuffer, timelineSubmit, slot.vkFence))
+        {
+            spdlog::critical("Failed to submit frame {}.", frameSequence);
+            return 1;
+        }
+
+        // Published while the GPU is still rendering, the consumer's queue waits for the frame timeline.
+        ring.PublishWriteSlot(slotIndex, frameSequence);
+    }
+
+    const double produceSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - produceStart).count();
+
+    spdlog::info("Produced {} frames in {:.3f} s ({:.1f} fps), {} frames recycled before the consumer read them.",
+        frameCount,
+        produceSeconds,
+        frameCount / produceSeconds,
+        ring.GetHeader().recycledFrames.load(std::memory_order_relaxed)
+    );
+
+    // Release Vulkan Primitives.
+    ring.Close();
+
+    vkDeviceWaitIdle(device.vkLogicalDevice);
+
+    CloseExternalMemoryHandle(frameTimelineHandle);
+    vkDestroySemaphore(device.vkLogicalDevice, vkFrameTimeline, nullptr);
+
+    for (uint32_t slotIndex = 0u; slotIndex < slotCount; slotIndex++)
+    {
+        auto& slot = slots[slotIndex];
+
+        CloseExternalMemoryHandle(slot.memoryHandle);
+
+        vkDestroyFence (device.vkLogicalDevice, slot.vkFence,       nullptr);
+        vkDestroyImage (device.vkLogicalDevice, slot.vkImage,       nullptr);
+        vkFreeMemory   (device.vkLogicalDevice, slot.vkImageMemory, nullptr);
+    }
+
+    vkDestroyCommandPool(device.vkLogicalDevice, vkCommandPool, nullptr);
+
+    DestroyVulkanDevice(device);
+    vkDestroyInstance(vkInstance, nullptr);
+
+    return 0;
+}
@@ -0,0 +1,286 @@
+#include "ReadbackCompute.h"
+
+#include <spdlog/spdlog.h>
+
+#if defined(INTEROP_READBACK_COMPUTE)
+// SPIR-V words of Shaders/ReadbackNV12.comp, compiled by glslc into the build directory.
+static const uint32_t kReadbackNV12Spirv[] =
+{
+#include "ReadbackNV12.comp.spv.inc"
+};
+
+constexpr bool kReadbackComputeBuilt = true;
+#else
+// Built without glslc, Create always fails.
+static const uint32_t kReadbackNV12Spirv[] = { 0u };
+
+constexpr bool kReadbackComputeBuilt = false;
+#endif
+
+// Push constant block of ReadbackNV12.comp.
+struct ReadbackComputePushConstants
+{
+    uint32_t width;
+    uint32_t height;
+    uint32_t downscale;
+    uint32_t toneMap;
+};
+
+// Invocations of a workgroup in each dimension (local_size_x and local_size_y), each converting 4x2 output pixels.
+constexpr uint32_t kReadbackComputeGroupSize = 8u;
+
+bool ReadbackComputePipeline::Create(const VulkanDevice& device)
+{
+    if (!kReadbackComputeBuilt)
+    {
+        spdlog::error("The readback compute stage was not built, glslc was not found when configuring.");
+        return false;
+    }
+
+    m_device = device;
+
+    // texelFetch ignores the sampler state, but sampled images are bound with one.
+    VkSamplerCreateInfo vkSamplerCreateInfo = { VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO };
+    vkSamplerCreateInfo.magFilter    = VK_FILTER_NEAREST;
+    vkSamplerCreateInfo.minFilter    = VK_FILTER_NEAREST;
+    vkSamplerCreateInfo.mipmapMode   = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    vkSamplerCreateInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    vkSamplerCreateInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    vkSamplerCreateInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+
+    VkDescriptorSetLayoutBinding vkBindings[2] = {};
+    vkBindings[0].binding            = 0u;
+    vkBindings[0].descriptorType     = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    vkBindings[0].descriptorCount    = 1u;
+    vkBindings[0].stageFlags         = VK_SHADER_STAGE_COMPUTE_BIT;
+    vkBindings[0].pImmutableSamplers = &m_vkSampler;
+    vkBindings[1].binding            = 1u;
+    vkBindings[1].descriptorType     = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    vkBindings[1].descriptorCount    = 1u;
+    vkBindings[1].stageFlags         = VK_SHADER_STAGE_COMPUTE_BIT;
+
+    VkDescriptorSetLayoutCreateInfo vkDescriptorSetLayoutCreateInfo = { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO };
+    vkDescriptorSetLayoutCreateInfo.bindingCount = 2u;
+    vkDescriptorSetLayoutCreateInfo.pBindings    = vkBindings;
+
+    VkPushConstantRange vkPushConstantRange = {};
+    vkPushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    vkPushConstantRange.size       = sizeof(ReadbackComputePushConstants);
+
+    VkPipelineLayoutCreateInfo vkPipelineLayoutCreateInfo = { VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
+    vkPipelineLayoutCreateInfo.setLayoutCount         = 1u;
+    vkPipelineLayoutCreateInfo.pSetLayouts            = &m_vkDescriptorSetLayout;
+    vkPipelineLayoutCreateInfo.pushConstantRangeCount = 1u;
+    vkPipelineLayoutCreateInfo.pPushConstantRanges    = &vkPushConstantRange;
+
+    VkShaderModuleCreateInfo vkShaderModuleCreateInfo = { VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO };
+    vkShaderModuleCreateInfo.codeSize = sizeof(kReadbackNV12Spirv);
+    vkShaderModuleCreateInfo.pCode    = kReadbackNV12Spirv;
+
+    VkShaderModule vkShaderModule = VK_NULL_HANDLE;
+
+    bool created = vkCreateSampler(device.vkLogicalDevice, &vkSamplerCreateInfo, nullptr, &m_vkSampler) == VK_SUCCESS &&
+                   vkCreateDescriptorSetLayout(device.vkLogicalDevice, &vkDescriptorSetLayoutCreateInfo, nullptr, &m_vkDescriptorSetLayout) == VK_SUCCESS &&
+                   vkCreatePipelineLayout(device.vkLogicalDevice, &vkPipelineLayoutCreateInfo, nullptr, &m_vkPipelineLayout) == VK_SUCCESS &&
+                   vkCreateShaderModule(device.vkLogicalDevice, &vkShaderModuleCreateInfo, nullptr, &vkShaderModule) == VK_SUCCESS;
+
+    if (created)
+    {
+        VkComputePipelineCreateInfo vkPipelineCreateInfo = { VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO };
+        vkPipelineCreateInfo.stage.sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        vkPipelineCreateInfo.stage.stage  = VK_SHADER_STAGE_COMPUTE_BIT;
+        vkPipelineCreateInfo.stage.module = vkShaderModule;
+        vkPipelineCreateInfo.stage.pName  = "main";
+        vkPipelineCreateInfo.layout       = m_vkPipelineLayout;
+
+        created = vkCreateComputePipelines(device.vkLogicalDevice, device.vkPipelineCache, 1u, &vkPipelineCreateInfo, nullptr, &m_vkPipeline) == VK_SUCCESS;
+    }
+
+    vkDestroyShaderModule(device.vkLogicalDevice, vkShaderModule, nullptr);
+
+    if (!created)
+    {
+        spdlog::error("Failed to create the readback compute pipeline.");
+
+        Destroy();
+        return false;
+    }
+
+    return true;
+}
+
+void ReadbackComputePipeline::Destroy()
+{
+    if (m_device.vkLogicalDevice == VK_NULL_HANDLE)
+        return;
+
+    vkDestroyPipeline(m_device.vkLogicalDevice, m_vkPipeline, nullptr);
+    vkDestroyPipelineLayout(m_device.vkLogicalDevice, m_vkPipelineLayout, nullptr);
+    vkDestroyDescriptorSetLayout(m_device.vkLogicalDevice, m_vkDescriptorSetLayout, nullptr);
+    vkDestroySampler(m_device.vkLogicalDevice, m_vkSampler, nullptr);
+
+    m_vkPipeline            = VK_NULL_HANDLE;
+    m_vkPipelineLayout      = VK_NULL_HANDLE;
+    m_vkDescriptorSetLayout = VK_NULL_HANDLE;
+    m_vkSampler             = VK_NULL_HANDLE;
+
+    m_device = {};
+}
+
+bool ReadbackComputePipeline::CreateTarget(VkImage vkImage, const SharedImageDesc& imageDesc, const ReadbackComputeDesc& computeDesc, ReadbackComputeTarget& target)
+{
+    target.desc    = computeDesc;
+    target.toneMap = GetSharedImageFormatTraits(imageDesc).format == PixelFormat::RGBA16F;
+
+    if (!GetReadbackComputeExtent(imageDesc, computeDesc, target.width, target.height))
+    {
+        spdlog::error("A {}x{} image cannot be read back downscaled by {}.", imageDesc.width, imageDesc.height, computeDesc.downscale);
+        return false;
+    }
+
+    target.outputSize = GetPixelImageSize(GetPixelFormatTraits(PixelFormat::NV12), target.width, target.height);
+
+    const VkDevice vkDevice = m_device.vkLogicalDevice;
+
+    VkImageViewCreateInfo vkImageViewCreateInfo = { VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO };
+    vkImageViewCreateInfo.image            = vkImage;
+    vkImageViewCreateInfo.viewType         = VK_IMAGE_VIEW_TYPE_2D;
+    vkImageViewCreateInfo.format           = imageDesc.format;
+    vkImageViewCreateInfo.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0u, 1u, 0u, 1u };
+
+    VkBufferCreateInfo vkBufferCreateInfo = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+    vkBufferCreateInfo.size        = target.outputSize;
+    vkBufferCreateInfo.usage       = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    vkBufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    if (vkCreateImageView(vkDevice, &vkImageViewCreateInfo, nullptr, &target.vkImageView) != VK_SUCCESS ||
+        vkCreateBuffer(vkDevice, &vkBufferCreateInfo, nullptr, &target.vkOutputBuffer) != VK_SUCCESS)
+    {
+        DestroyTarget(target);
+        return false;
+    }
+
+    // The frame only leaves the GPU through the copy into the readback buffer, so it stays in device-local memory.
+    VkMemoryRequirements vkMemoryRequirements;
+    vkGetBufferMemoryRequirements(vkDevice, target.vkOutputBuffer, &vkMemoryRequirements);
+
+    VkMemoryAllocateInfo vkAllocateInfo = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
+    vkAllocateInfo.allocationSize = vkMemoryRequirements.size;
+
+    if (!FindVulkanMemoryTypeIndex(m_device.vkPhysicalDevice, vkMemoryRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, vkAllocateInfo.memoryTypeIndex) ||
+        vkAllocateMemory(vkDevice, &vkAllocateInfo, nullptr, &target.vkOutputMemory) != VK_SUCCESS ||
+        vkBindBufferMemory(vkDevice, target.vkOutputBuffer, target.vkOutputMemory, 0u) != VK_SUCCESS)
+    {
+        spdlog::error("Failed to allocate the {} byte readback compute buffer.", target.outputSize);
+
+        DestroyTarget(target);
+        return false;
+    }
+
+    VkDescriptorPoolSize vkPoolSizes[2] = {};
+    vkPoolSizes[0] = { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1u };
+    vkPoolSizes[1] = { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,         1u };
+
+    VkDescriptorPoolCreateInfo vkDescriptorPoolCreateInfo = { VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
+    vkDescriptorPoolCreateInfo.maxSets       = 1u;
+    vkDescriptorPoolCreateInfo.poolSizeCount = 2u;
+    vkDescriptorPoolCreateInfo.pPoolSizes    = vkPoolSizes;
+
+    if (vkCreateDescriptorPool(vkDevice, &vkDescriptorPoolCreateInfo, nullptr, &target.vkDescriptorPool) != VK_SUCCESS)
+    {
+        DestroyTarget(target);
+        return false;
+    }
+
+    VkDescriptorSetAllocateInfo vkDescriptorSetAllocateInfo = { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
+    vkDescriptorSetAllocateInfo.descriptorPool     = target.vkDescriptorPool;
+    vkDescriptorSetAllocateInfo.descriptorSetCount = 1u;
+    vkDescriptorSetAllocateInfo.pSetLayouts        = &m_vkDescriptorSetLayout;
+
+    if (vkAllocateDescriptorSets(vkDevice, &vkDescriptorSetAllocateInfo, &target.vkDescriptorSet) != VK_SUCCESS)
+    {
+        DestroyTarget(target);
+        return false;
+    }
+
+    VkDescriptorImageInfo vkImageInfo = {};
+    vkImageInfo.imageView   = target.vkImageView;
+    vkImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+    VkDescriptorBufferInfo vkBufferInfo = {};
+    vkBufferInfo.buffer = target.vkOutputBuffer;
+    vkBufferInfo.range  = target.outputSize;
+
+    VkWriteDescriptorSet vkWrites[2] = {};
+    vkWrites[0].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    vkWrites[0].dstSet          = target.vkDescriptorSet;
+    vkWrites[0].dstBinding      = 0u;
+    vkWrites[0].descriptorCount = 1u;
+    vkWrites[0].descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    vkWrites[0].pImageInfo      = &vkImageInfo;
+    vkWrites[1].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    vkWrites[1].dstSet          = target.vkDescriptorSet;
+    vkWrites[1].dstBinding      = 1u;
+    vkWrites[1].descriptorCount = 1u;
+    vkWrites[1].descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    vkWrites[1].pBufferInfo     = &vkBufferInfo;
+
+    vkUpdateDescriptorSets(vkDevice, 2u, vkWrites, 0u, nullptr);
+
+    return true;
+}
+
+void ReadbackComputePipeline::DestroyTarget(ReadbackComputeTarget& target)
+{
+    const VkDevice vkDevice = m_device.vkLogicalDevice;
+
+    // Targets are only ever created once the pipeline was.
+    if (vkDevice == VK_NULL_HANDLE)
+    {
+        target = {};
+        return;
+    }
+
+    // Destroying the pool frees the descriptor set.
+    vkDestroyDescriptorPool(vkDevice, target.vkDescriptorPool, nullptr);
+    vkDestroyBuffer        (vkDevice, target.vkOutputBuffer,   nullptr);
+    vkFreeMemory           (vkDevice, target.vkOutputMemory,   nullptr);
+    vkDestroyImageView     (vkDevice, target.vkImageView,      nullptr);
+
+    target = {};
+}
+
+void ReadbackComputePipeline::RecordDispatch(VkCommandBuffer vkCommandBuffer, const ReadbackComputeTarget& target, VkBuffer vkDestinationBuffer, VkDeviceSize destinationOffset) const
+{
+    ReadbackComputePushConstants pushConstants;
+    pushConstants.width     = target.width;
+    pushConstants.height    = target.height;
+    pushConstants.downscale = target.desc.downscale;
+    pushConstants.toneMap   = target.toneMap ? 1u : 0u;
+
+    vkCmdBindPipeline(vkCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_vkPipeline);
+    vkCmdBindDescriptorSets(vkCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_vkPipelineLayout, 0u, 1u, &target.vkDescriptorSet, 0u, nullptr);
+    vkCmdPushConstants(vkCommandBuffer, m_vkPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0u, sizeof(pushConstants), &pushConstants);
+
+    // One invocation per 4x2 output pixels.
+    const uint32_t groupWidth  = kReadbackComputeGroupSize * 4u;
+    const uint32_t groupHeight = kReadbackComputeGroupSize * 2u;
+
+    vkCmdDispatch(vkCommandBuffer, (target.width + groupWidth - 1u) / groupWidth, (target.height + groupHeight - 1u) / groupHeight, 1u);
+
+    VkBufferMemoryBarrier vkBufferBarrier = { VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER };
+    vkBufferBarrier.srcAccessMask       = VK_ACCESS_SHADER_WRITE_BIT;
+    vkBufferBarrier.dstAccessMask       = VK_ACCESS_TRANSFER_READ_BIT;
+    vkBufferBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    vkBufferBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    vkBufferBarrier.buffer              = target.vkOutputBuffer;
+    vkBufferBarrier.size                = VK_WHOLE_SIZE;
+
+    vkCmdPipelineBarrier(vkCommandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0u, 0u, nullptr, 1u, &vkBufferBarrier, 0u, nullptr);
+
+    VkBufferCopy vkCopyRegion = {};
+    vkCopyRegion.dstOffset = destinationOffset;
+    vkCopyRegion.size      = target.outputSize;
+
+    vkCmdCopyBuffer(vkCommandBuffer, target.vkOutputBuffer, vkDestinationBuffer, 1u, &vkCopyRegion);
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "InteropBackend.h"
+
+// Resources of the readback compute stage for one image: a view the shader samples, the device-local buffer it
+// writes the NV12 frame to, and the descriptor set binding both.
+struct ReadbackComputeTarget
+{
+    ReadbackComputeDesc desc;
+
+    // NV12 frame size, see GetReadbackComputeExtent.
+    uint32_t         width      = 0u;
+    uint32_t         height     = 0u;
+    VkDeviceSize     outputSize = 0u;
+
+    bool             toneMap    = false;
+
+    VkImageView      vkImageView      = VK_NULL_HANDLE;
+    VkBuffer         vkOutputBuffer   = VK_NULL_HANDLE;
+    VkDeviceMemory   vkOutputMemory   = VK_NULL_HANDLE;
+    VkDescriptorPool vkDescriptorPool = VK_NULL_HANDLE;
+    VkDescriptorSet  vkDescriptorSet  = VK_NULL_HANDLE;
+
+    bool IsCreated() const { return vkDescriptorSet != VK_NULL_HANDLE; }
+};
+
+// Compute pipeline of Shaders/ReadbackNV12.comp, embedded as SPIR-V at build time, on the device that reads shared
+// images back. Recorded commands must be submitted to a queue of the device's compute family. Create fails in
+// builds configured without glslc.
+class ReadbackComputePipeline
+{
+public:
+    ~ReadbackComputePipeline() { Destroy(); }
+
+    bool Create(const VulkanDevice& device);
+
+    bool IsCreated() const { return m_vkPipeline != VK_NULL_HANDLE; }
+
+    void Destroy();
+
+    // vkImage must have been created by CreateVulkanImage2D for imageDesc.
+    bool CreateTarget(VkImage vkImage, const SharedImageDesc& imageDesc, const ReadbackComputeDesc& computeDesc, ReadbackComputeTarget& target);
+
+    // The target must not be in use by the GPU.
+    void DestroyTarget(ReadbackComputeTarget& target);
+
+    // Converts the image, in VK_IMAGE_LAYOUT_GENERAL and visible to compute shader reads, and copies the frame to
+    // vkDestinationBuffer at destinationOffset, which must be followed by target.outputSize bytes.
+    void RecordDispatch(VkCommandBuffer vkCommandBuffer, const ReadbackComputeTarget& target, VkBuffer vkDestinationBuffer, VkDeviceSize destinationOffset = 0u) const;
+
+private:
+    VulkanDevice          m_device;
+
+    VkSampler             m_vkSampler             = VK_NULL_HANDLE;
+    VkDescriptorSetLayout m_vkDescriptorSetLayout = VK_NULL_HANDLE;
+    VkPipelineLayout      m_vkPipelineLayout      = VK_NULL_HANDLE;
+    VkPipeline            m_vkPipeline            = VK_NULL_HANDLE;
+};
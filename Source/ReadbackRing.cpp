@@ -0,0 +1,95 @@
+#include "ReadbackRing.h"
+
+#include <spdlog/spdlog.h>
+
+#include "Trace.h"
+
+bool ReadbackRing::Create(InteropBackend* pBackend, const SharedImage& sharedImage, uint32_t depth, ReadbackCallback callback)
+{
+    if (depth == 0u || depth > kReadbackRingMaxDepth)
+    {
+        spdlog::error("Readback depth must be within [1, {}].", kReadbackRingMaxDepth);
+        return false;
+    }
+
+    if (!pBackend->CreateReadbackSlots(sharedImage, depth))
+    {
+        spdlog::error("Failed to create {} readback slots with the {} interop backend.", depth, pBackend->GetName());
+        return false;
+    }
+
+    m_pBackend      = pBackend;
+    m_pSharedImage  = &sharedImage;
+    m_callback      = std::move(callback);
+    m_depth         = depth;
+    m_oldestSlot    = 0u;
+    m_inFlightCount = 0u;
+
+    return true;
+}
+
+bool ReadbackRing::Submit(uint64_t frameIndex, const DirtyTileMap* pDirtyTiles, uint64_t hostOffset)
+{
+    TRACE_ZONE("Submit readback");
+
+    if (m_inFlightCount == m_depth && !CompleteOldest())
+        return false;
+
+    const uint32_t slotIndex = (m_oldestSlot + m_inFlightCount) % m_depth;
+
+    if (!m_pBackend->SubmitReadback(*m_pSharedImage, frameIndex, slotIndex, pDirtyTiles, hostOffset))
+        return false;
+
+    m_frameIndices[slotIndex] = frameIndex;
+    m_inFlightCount++;
+
+    return true;
+}
+
+bool ReadbackRing::Poll()
+{
+    // Deliver in order: a later copy that finished early waits behind the oldest.
+    while (m_inFlightCount > 0u && m_pBackend->IsReadbackComplete(*m_pSharedImage, m_oldestSlot))
+    {
+        if (!CompleteOldest())
+            return false;
+    }
+
+    return true;
+}
+
+bool ReadbackRing::Flush()
+{
+    while (m_inFlightCount > 0u)
+    {
+        if (!CompleteOldest())
+            return false;
+    }
+
+    return true;
+}
+
+bool ReadbackRing::CompleteOldest()
+{
+    TRACE_FRAME(m_frameIndices[m_oldestSlot]);
+
+    MappedImage mappedImage;
+    {
+        TRACE_ZONE("Map readback");
+
+        if (!m_pBackend->MapReadback(*m_pSharedImage, m_oldestSlot, mappedImage))
+        {
+            spdlog::error("Failed to map the readback of frame {}.", m_frameIndices[m_oldestSlot]);
+            return false;
+        }
+    }
+
+    m_callback(m_frameIndices[m_oldestSlot], mappedImage);
+
+    m_pBackend->UnmapReadback(*m_pSharedImage, m_oldestSlot);
+
+    m_oldestSlot = (m_oldestSlot + 1u) % m_depth;
+    m_inFlightCount--;
+
+    return true;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <functional>
+
+#include "InteropBackend.h"
+
+constexpr uint32_t kReadbackRingMaxDepth = 8u;
+
+// Receives each frame's pixels once its copy completed. The pointer is only valid during the call.
+using ReadbackCallback = std::function<void(uint64_t frameIndex, const MappedImage& mappedImage)>;
+
+// Keeps up to depth readbacks of a shared image in flight, one per exporter-side readback slot, so that
+// frame N is mapped and consumed while the copies of frames N+1..N+depth-1 are still running.
+// Frames must be submitted in increasing order and are delivered in the same order.
+class ReadbackRing
+{
+public:
+    bool Create(InteropBackend* pBackend, const SharedImage& sharedImage, uint32_t depth, ReadbackCallback callback);
+
+    // Queues the readback of frameIndex, of its dirty tiles only with pDirtyTiles, into imported host memory with a
+    // hostOffset (see InteropBackend::SubmitReadback). When every slot is in flight the oldest readback is completed first.
+    bool Submit(uint64_t frameIndex, const DirtyTileMap* pDirtyTiles = nullptr, uint64_t hostOffset = kReadbackToSlot);
+
+    // Delivers the readbacks that already completed. Never blocks on the GPU.
+    bool Poll();
+
+    // Blocks until every queued readback was delivered.
+    bool Flush();
+
+    uint32_t GetInFlightCount() const { return m_inFlightCount; }
+
+private:
+    // Maps the oldest readback, waiting for it if needed, and hands it to the callback.
+    bool CompleteOldest();
+
+    InteropBackend*    m_pBackend     = nullptr;
+    const SharedImage* m_pSharedImage = nullptr;
+    ReadbackCallback   m_callback;
+
+    uint32_t m_depth         = 0u;
+    uint32_t m_oldestSlot    = 0u;
+    uint32_t m_inFlightCount = 0u;
+
+    uint64_t m_frameIndices[kReadbackRingMaxDepth] = {};
+};
@@ -0,0 +1,416 @@
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <new>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <spdlog/spdlog.h>
+
+#include "SharedFrameRing.h"
+
+constexpr uint32_t kSharedFrameRingMagic   = 0x53465231u; // 'SFR1'
+constexpr uint32_t kSharedFrameRingVersion = 1u;
+
+uint64_t GetMonotonicTimeNs()
+{
+    timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+
+    return (uint64_t)time.tv_sec * 1000000000ull + (uint64_t)time.tv_nsec;
+}
+
+static bool FillSocketAddress(const char* pSocketPath, sockaddr_un& address)
+{
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+
+    if (strlen(pSocketPath) >= sizeof(address.sun_path))
+        return false;
+
+    strcpy(address.sun_path, pSocketPath);
+
+    return true;
+}
+
+SharedFrameRing::~SharedFrameRing()
+{
+    Close();
+}
+
+bool SharedFrameRing::Create(const char* pName, const SharedFrameRingDesc& desc)
+{
+    if (desc.slotCount < 2u || desc.slotCount > kSharedFrameRingMaxSlots)
+    {
+        spdlog::error("Shared frame ring slot count must be within [2, {}].", kSharedFrameRingMaxSlots);
+        return false;
+    }
+
+    m_isProducer = true;
+
+    snprintf(m_sharedMemoryName, sizeof(m_sharedMemoryName), "/%s", pName);
+    snprintf(m_socketPath,       sizeof(m_socketPath),       "/tmp/%s.sock", pName);
+
+    // Remove leftovers of a producer that did not shut down cleanly.
+    shm_unlink(m_sharedMemoryName);
+
+    m_sharedMemoryFd = shm_open(m_sharedMemoryName, O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (m_sharedMemoryFd < 0 || ftruncate(m_sharedMemoryFd, sizeof(SharedFrameRingHeader)) != 0)
+    {
+        spdlog::error("Failed to create shared memory object {}: {}", m_sharedMemoryName, strerror(errno));
+        return false;
+    }
+
+    void* pMapped = mmap(nullptr, sizeof(SharedFrameRingHeader), PROT_READ | PROT_WRITE, MAP_SHARED, m_sharedMemoryFd, 0);
+    if (pMapped == MAP_FAILED)
+        return false;
+
+    m_pHeader = new (pMapped) SharedFrameRingHeader();
+
+    m_pHeader->magic          = kSharedFrameRingMagic;
+    m_pHeader->version        = kSharedFrameRingVersion;
+    m_pHeader->slotCount      = desc.slotCount;
+    m_pHeader->width          = desc.imageDesc.width;
+    m_pHeader->height         = desc.imageDesc.height;
+    m_pHeader->format         = desc.imageDesc.format;
+    m_pHeader->allocationSize = desc.allocationSize;
+    memcpy(m_pHeader->deviceUUID, desc.deviceUUID, VK_UUID_SIZE);
+
+    for (uint32_t slotIndex = 0u; slotIndex < desc.slotCount; slotIndex++)
+        m_pHeader->slots[slotIndex].state.store(kSharedFrameSlotFree, std::memory_order_relaxed);
+
+    // Memory handles cannot travel through shared memory, consumers fetch them over a Unix socket.
+    sockaddr_un address;
+    if (!FillSocketAddress(m_socketPath, address))
+        return false;
+
+    unlink(m_socketPath);
+
+    m_socketFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (m_socketFd < 0 || bind(m_socketFd, (const sockaddr*)&address, sizeof(address)) != 0 || listen(m_socketFd, 4) != 0)
+    {
+        spdlog::error("Failed to listen on {}: {}", m_socketPath, strerror(errno));
+        return false;
+    }
+
+    m_pHeader->initialized.store(1u, std::memory_order_release);
+
+    return true;
+}
+
+bool SharedFrameRing::Open(const char* pName, uint32_t timeoutMs)
+{
+    m_isProducer = false;
+
+    snprintf(m_sharedMemoryName, sizeof(m_sharedMemoryName), "/%s", pName);
+    snprintf(m_socketPath,       sizeof(m_socketPath),       "/tmp/%s.sock", pName);
+
+    const uint64_t deadline = GetMonotonicTimeNs() + (uint64_t)timeoutMs * 1000000ull;
+
+    while (m_pHeader == nullptr)
+    {
+        m_sharedMemoryFd = shm_open(m_sharedMemoryName, O_RDWR, 0600);
+
+        // The producer may still be sizing the object.
+        struct stat sharedMemoryStat;
+        if (m_sharedMemoryFd >= 0 && fstat(m_sharedMemoryFd, &sharedMemoryStat) == 0 && sharedMemoryStat.st_size >= (off_t)sizeof(SharedFrameRingHeader))
+        {
+            void* pMapped = mmap(nullptr, sizeof(SharedFrameRingHeader), PROT_READ | PROT_WRITE, MAP_SHARED, m_sharedMemoryFd, 0);
+
+            if (pMapped != MAP_FAILED)
+                m_pHeader = (SharedFrameRingHeader*)pMapped;
+        }
+
+        if (m_pHeader == nullptr && m_sharedMemoryFd >= 0)
+        {
+            close(m_sharedMemoryFd);
+            m_sharedMemoryFd = -1;
+        }
+
+        if (m_pHeader == nullptr)
+        {
+            if (GetMonotonicTimeNs() > deadline)
+            {
+                spdlog::error("Timed out waiting for shared frame ring {}.", m_sharedMemoryName);
+                return false;
+            }
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+
+    while (!m_pHeader->initialized.load(std::memory_order_acquire))
+    {
+        if (GetMonotonicTimeNs() > deadline)
+            return false;
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    if (m_pHeader->magic != kSharedFrameRingMagic || m_pHeader->version != kSharedFrameRingVersion)
+    {
+        spdlog::error("Shared frame ring {} has an incompatible layout.", m_sharedMemoryName);
+        return false;
+    }
+
+    // The slot count indexes the fixed slot array, so it is not trusted any more than the rest of the header.
+    if (m_pHeader->slotCount < 2u || m_pHeader->slotCount > kSharedFrameRingMaxSlots)
+    {
+        spdlog::error("Shared frame ring {} has {} slots, not within [2, {}].", m_sharedMemoryName, m_pHeader->slotCount, kSharedFrameRingMaxSlots);
+        return false;
+    }
+
+    // Only frames published after attaching are of interest.
+    m_lastAcquiredSequence = m_pHeader->consumedSequence.load(std::memory_order_acquire);
+
+    return true;
+}
+
+void SharedFrameRing::Close()
+{
+    if (m_pHeader != nullptr)
+        munmap(m_pHeader, sizeof(SharedFrameRingHeader));
+
+    if (m_sharedMemoryFd >= 0)
+        close(m_sharedMemoryFd);
+
+    if (m_socketFd >= 0)
+        close(m_socketFd);
+
+    if (m_isProducer && m_pHeader != nullptr)
+    {
+        shm_unlink(m_sharedMemoryName);
+        unlink(m_socketPath);
+    }
+
+    m_pHeader        = nullptr;
+    m_sharedMemoryFd = -1;
+    m_socketFd       = -1;
+}
+
+uint32_t SharedFrameRing::AcquireWriteSlot()
+{
+    const uint32_t slotCount = m_pHeader->slotCount;
+
+    // The consumer holds at most one slot, so with two or more slots one of the passes below always succeeds
+    // after a bounded number of lost races.
+    for (;;)
+    {
+        for (uint32_t slotIndex = 0u; slotIndex < slotCount; slotIndex++)
+        {
+            uint32_t expectedState = kSharedFrameSlotFree;
+            if (m_pHeader->slots[slotIndex].state.compare_exchange_strong(expectedState, kSharedFrameSlotWriting, std::memory_order_acquire))
+                return slotIndex;
+        }
+
+        // No free slot: recycle the oldest frame the consumer has not picked up yet.
+        uint32_t oldestSlotIndex = UINT_MAX;
+        uint64_t oldestSequence  = UINT64_MAX;
+
+        for (uint32_t slotIndex = 0u; slotIndex < slotCount; slotIndex++)
+        {
+            const auto& slot = m_pHeader->slots[slotIndex];
+
+            if (slot.state.load(std::memory_order_relaxed) != kSharedFrameSlotReady)
+                continue;
+
+            const uint64_t frameSequence = slot.frameSequence.load(std::memory_order_relaxed);
+            if (frameSequence >= oldestSequence)
+                continue;
+
+            oldestSequence  = frameSequence;
+            oldestSlotIndex = slotIndex;
+        }
+
+        if (oldestSlotIndex == UINT_MAX)
+            continue;
+
+        uint32_t expectedState = kSharedFrameSlotReady;
+        if (m_pHeader->slots[oldestSlotIndex].state.compare_exchange_strong(expectedState, kSharedFrameSlotWriting, std::memory_order_acquire))
+        {
+            m_pHeader->recycledFrames.fetch_add(1u, std::memory_order_relaxed);
+            return oldestSlotIndex;
+        }
+    }
+}
+
+void SharedFrameRing::PublishWriteSlot(uint32_t slotIndex, uint64_t frameSequence)
+{
+    auto& slot = m_pHeader->slots[slotIndex];
+
+    slot.frameSequence.store(frameSequence, std::memory_order_relaxed);
+    slot.publishTimeNs.store(GetMonotonicTimeNs(), std::memory_order_relaxed);
+
+    slot.state.store(kSharedFrameSlotReady, std::memory_order_release);
+
+    m_pHeader->publishedSequence.store(frameSequence, std::memory_order_release);
+}
+
+bool SharedFrameRing::AcquireReadSlot(uint32_t& slotIndex, uint64_t& frameSequence, uint64_t& publishTimeNs)
+{
+    if (m_pHeader->publishedSequence.load(std::memory_order_acquire) <= m_lastAcquiredSequence)
+        return false;
+
+    const uint32_t slotCount = m_pHeader->slotCount;
+
+    for (;;)
+    {
+        uint32_t newestSlotIndex = UINT_MAX;
+        uint64_t newestSequence  = m_lastAcquiredSequence;
+
+        for (uint32_t candidateIndex = 0u; candidateIndex < slotCount; candidateIndex++)
+        {
+            const auto& slot = m_pHeader->slots[candidateIndex];
+
+            if (slot.state.load(std::memory_order_relaxed) != kSharedFrameSlotReady)
+                continue;
+
+            const uint64_t candidateSequence = slot.frameSequence.load(std::memory_order_relaxed);
+            if (candidateSequence <= newestSequence)
+                continue;
+
+            newestSequence  = candidateSequence;
+            newestSlotIndex = candidateIndex;
+        }
+
+        if (newestSlotIndex == UINT_MAX)
+            return false;
+
+        auto& slot = m_pHeader->slots[newestSlotIndex];
+
+        uint32_t expectedState = kSharedFrameSlotReady;
+        if (!slot.state.compare_exchange_strong(expectedState, kSharedFrameSlotReading, std::memory_order_acquire))
+            continue;
+
+        // The producer may have recycled and republished the slot between the scan and the exchange, so
+        // read the frame fields again now that the slot can no longer change.
+        slotIndex     = newestSlotIndex;
+        frameSequence = slot.frameSequence.load(std::memory_order_relaxed);
+        publishTimeNs = slot.publishTimeNs.load(std::memory_order_relaxed);
+
+        m_lastAcquiredSequence = frameSequence;
+        m_pHeader->consumedSequence.store(frameSequence, std::memory_order_release);
+
+        return true;
+    }
+}
+
+void SharedFrameRing::ReleaseReadSlot(uint32_t slotIndex)
+{
+    m_pHeader->slots[slotIndex].state.store(kSharedFrameSlotFree, std::memory_order_release);
+}
+
+bool SharedFrameRing::ServeMemoryHandles(const ExternalMemoryHandle* pMemoryHandles, ExternalSemaphoreHandle semaphoreHandle)
+{
+    const int clientFd = accept4(m_socketFd, nullptr, nullptr, SOCK_CLOEXEC);
+    if (clientFd < 0)
+        return errno == EAGAIN || errno == EWOULDBLOCK;
+
+    const uint32_t slotCount = m_pHeader->slotCount;
+
+    // One descriptor per slot followed by the timeline semaphore.
+    int handles[kSharedFrameRingMaxSlots + 1u];
+    memcpy(handles, pMemoryHandles, sizeof(int) * slotCount);
+    handles[slotCount] = semaphoreHandle;
+
+    char controlBuffer[CMSG_SPACE(sizeof(int) * (kSharedFrameRingMaxSlots + 1u))] = {};
+
+    uint32_t payload = slotCount;
+    iovec    payloadVector = { &payload, sizeof(payload) };
+
+    msghdr message = {};
+    message.msg_iov        = &payloadVector;
+    message.msg_iovlen     = 1;
+    message.msg_control    = controlBuffer;
+    message.msg_controllen = CMSG_SPACE(sizeof(int) * (slotCount + 1u));
+
+    cmsghdr* pControlMessage = CMSG_FIRSTHDR(&message);
+    pControlMessage->cmsg_level = SOL_SOCKET;
+    pControlMessage->cmsg_type  = SCM_RIGHTS;
+    pControlMessage->cmsg_len   = CMSG_LEN(sizeof(int) * (slotCount + 1u));
+    memcpy(CMSG_DATA(pControlMessage), handles, sizeof(int) * (slotCount + 1u));
+
+    const bool sent = sendmsg(clientFd, &message, MSG_NOSIGNAL) == (ssize_t)sizeof(payload);
+
+    close(clientFd);
+
+    if (sent)
+        spdlog::info("Sent {} memory handles and the frame timeline to a consumer.", slotCount);
+
+    return sent;
+}
+
+// Closes the descriptors every SCM_RIGHTS message of a received message carries.
+static void CloseReceivedDescriptors(msghdr& message)
+{
+    for (cmsghdr* pControlMessage = CMSG_FIRSTHDR(&message); pControlMessage != nullptr; pControlMessage = CMSG_NXTHDR(&message, pControlMessage))
+    {
+        if (pControlMessage->cmsg_level != SOL_SOCKET || pControlMessage->cmsg_type != SCM_RIGHTS || pControlMessage->cmsg_len < CMSG_LEN(0))
+            continue;
+
+        const size_t descriptorCount = (pControlMessage->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+
+        for (size_t descriptorIndex = 0u; descriptorIndex < descriptorCount; descriptorIndex++)
+        {
+            int descriptor;
+            memcpy(&descriptor, CMSG_DATA(pControlMessage) + sizeof(int) * descriptorIndex, sizeof(int));
+            close(descriptor);
+        }
+    }
+}
+
+bool SharedFrameRing::ReceiveMemoryHandles(ExternalMemoryHandle* pMemoryHandles, ExternalSemaphoreHandle& semaphoreHandle)
+{
+    sockaddr_un address;
+    if (!FillSocketAddress(m_socketPath, address))
+        return false;
+
+    const int socketFd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (socketFd < 0)
+        return false;
+
+    if (connect(socketFd, (const sockaddr*)&address, sizeof(address)) != 0)
+    {
+        spdlog::error("Failed to connect to {}: {}", m_socketPath, strerror(errno));
+        close(socketFd);
+        return false;
+    }
+
+    char controlBuffer[CMSG_SPACE(sizeof(int) * (kSharedFrameRingMaxSlots + 1u))] = {};
+
+    uint32_t payload = 0u;
+    iovec    payloadVector = { &payload, sizeof(payload) };
+
+    msghdr message = {};
+    message.msg_iov        = &payloadVector;
+    message.msg_iovlen     = 1;
+    message.msg_control    = controlBuffer;
+    message.msg_controllen = sizeof(controlBuffer);
+
+    const ssize_t receivedSize = recvmsg(socketFd, &message, MSG_CMSG_CLOEXEC);
+
+    close(socketFd);
+
+    // Descriptors of a rejected handshake are already open in this process.
+    cmsghdr* pControlMessage = CMSG_FIRSTHDR(&message);
+    if (receivedSize != (ssize_t)sizeof(payload) || pControlMessage == nullptr || pControlMessage->cmsg_type != SCM_RIGHTS || payload != m_pHeader->slotCount ||
+        pControlMessage->cmsg_len != CMSG_LEN(sizeof(int) * (payload + 1u)))
+    {
+        if (receivedSize >= 0)
+            CloseReceivedDescriptors(message);
+
+        return false;
+    }
+
+    memcpy(pMemoryHandles,   CMSG_DATA(pControlMessage), sizeof(int) * payload);
+    memcpy(&semaphoreHandle, CMSG_DATA(pControlMessage) + sizeof(int) * payload, sizeof(int));
+
+    return true;
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "InteropBackend.h"
+
+constexpr uint32_t kSharedFrameRingMaxSlots     = 8u;
+constexpr uint32_t kSharedFrameRingDefaultSlots = 3u;
+
+constexpr const char* kSharedFrameRingDefaultName = "SharedMemory-Vulkan-FrameRing";
+
+enum SharedFrameSlotState : uint32_t
+{
+    kSharedFrameSlotFree    = 0u,
+    kSharedFrameSlotWriting = 1u,
+    kSharedFrameSlotReady   = 2u,
+    kSharedFrameSlotReading = 3u,
+};
+
+// One exported image of the ring. Ownership moves through the state with compare-exchange only:
+// Free -> Writing -> Ready -> Reading -> Free, or Ready -> Writing when the producer recycles a frame the
+// consumer never picked up. The frame fields are written by whoever holds the slot in Writing.
+struct alignas(64) SharedFrameSlot
+{
+    std::atomic<uint32_t> state;
+    std::atomic<uint64_t> frameSequence;
+    std::atomic<uint64_t> publishTimeNs;
+};
+
+// Control block placed in POSIX shared memory by the producer.
+struct SharedFrameRingHeader
+{
+    uint32_t magic;
+    uint32_t version;
+
+    // Set last by the producer once every field below and the handle socket are valid.
+    std::atomic<uint32_t> initialized;
+
+    uint32_t     slotCount;
+    uint32_t     width;
+    uint32_t     height;
+    VkFormat     format;
+    VkDeviceSize allocationSize;
+    uint8_t      deviceUUID[VK_UUID_SIZE];
+
+    alignas(64) std::atomic<uint64_t> publishedSequence;
+    alignas(64) std::atomic<uint64_t> consumedSequence;
+    alignas(64) std::atomic<uint64_t> recycledFrames;
+
+    SharedFrameSlot slots[kSharedFrameRingMaxSlots];
+};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free && std::atomic<uint64_t>::is_always_lock_free, "Shared frame ring requires address-free atomics.");
+
+struct SharedFrameRingDesc
+{
+    uint32_t        slotCount      = kSharedFrameRingDefaultSlots;
+    SharedImageDesc imageDesc;
+    VkDeviceSize    allocationSize = 0u;
+    uint8_t         deviceUUID[VK_UUID_SIZE] = {};
+};
+
+// Lock-free single producer / single consumer handoff of exported images between two processes.
+// The producer never waits for the consumer: when no slot is free it recycles the oldest unread frame.
+class SharedFrameRing
+{
+public:
+    ~SharedFrameRing();
+
+    // Producer: creates the shared control block and starts listening for consumers that need the image handles.
+    bool Create(const char* pName, const SharedFrameRingDesc& desc);
+
+    // Consumer: attaches to a ring created by a producer, waiting up to timeoutMs for it to appear.
+    bool Open(const char* pName, uint32_t timeoutMs);
+
+    void Close();
+
+    const SharedFrameRingHeader& GetHeader() const { return *m_pHeader; }
+
+    // Producer: returns a slot the producer may render into. Never blocks.
+    uint32_t AcquireWriteSlot();
+
+    void PublishWriteSlot(uint32_t slotIndex, uint64_t frameSequence);
+
+    // Consumer: takes the newest published frame not seen before. Returns false when there is none.
+    bool AcquireReadSlot(uint32_t& slotIndex, uint64_t& frameSequence, uint64_t& publishTimeNs);
+
+    void ReleaseReadSlot(uint32_t slotIndex);
+
+    // Producer: hands the slot memory handles and the frame timeline semaphore to a consumer that connected
+    // since the last call. The timeline reaches a frame's sequence once its rendering completed. Never blocks.
+    bool ServeMemoryHandles(const ExternalMemoryHandle* pMemoryHandles, ExternalSemaphoreHandle semaphoreHandle);
+
+    // Consumer: receives one memory handle per slot and the frame timeline from the producer. The caller owns the handles.
+    bool ReceiveMemoryHandles(ExternalMemoryHandle* pMemoryHandles, ExternalSemaphoreHandle& semaphoreHandle);
+
+private:
+    SharedFrameRingHeader* m_pHeader = nullptr;
+
+    bool m_isProducer     = false;
+    int  m_sharedMemoryFd = -1;
+    int  m_socketFd       = -1;
+
+    char m_sharedMemoryName[128] = {};
+    char m_socketPath[128]       = {};
+
+    uint64_t m_lastAcquiredSequence = 0u;
+};
+
+uint64_t GetMonotonicTimeNs();
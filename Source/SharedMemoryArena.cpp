@@ -0,0 +1,255 @@
+#include "SharedMemoryArena.h"
+
+#include <algorithm>
+
+#include <spdlog/spdlog.h>
+
+#include "ExternalImage.h"
+
+// Range Allocator
+// ---------------------------------
+
+void RangeAllocator::Reset(VkDeviceSize size)
+{
+    m_size      = size;
+    m_freeBytes = size;
+
+    m_freeRanges.clear();
+
+    if (size > 0u)
+        m_freeRanges[0u] = size;
+}
+
+bool RangeAllocator::Allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset)
+{
+    if (size == 0u || size > m_freeBytes)
+        return false;
+
+    alignment = std::max<VkDeviceSize>(alignment, 1u);
+
+    auto bestRange = m_freeRanges.end();
+
+    for (auto range = m_freeRanges.begin(); range != m_freeRanges.end(); range++)
+    {
+        const VkDeviceSize alignedOffset = (range->first + alignment - 1u) / alignment * alignment;
+        const VkDeviceSize padding       = alignedOffset - range->first;
+
+        if (padding + size > range->second)
+            continue;
+
+        if (bestRange == m_freeRanges.end() || range->second < bestRange->second)
+            bestRange = range;
+    }
+
+    if (bestRange == m_freeRanges.end())
+        return false;
+
+    const VkDeviceSize rangeOffset = bestRange->first;
+    const VkDeviceSize rangeSize   = bestRange->second;
+
+    offset = (rangeOffset + alignment - 1u) / alignment * alignment;
+
+    m_freeRanges.erase(bestRange);
+
+    if (offset > rangeOffset)
+        m_freeRanges[rangeOffset] = offset - rangeOffset;
+
+    if (offset + size < rangeOffset + rangeSize)
+        m_freeRanges[offset + size] = rangeOffset + rangeSize - (offset + size);
+
+    m_freeBytes -= size;
+
+    return true;
+}
+
+void RangeAllocator::Free(VkDeviceSize offset, VkDeviceSize size)
+{
+    auto range = m_freeRanges.emplace(offset, size).first;
+
+    m_freeBytes += size;
+
+    // Merge with the following range, then with the preceding one.
+    auto nextRange = std::next(range);
+    if (nextRange != m_freeRanges.end() && range->first + range->second == nextRange->first)
+    {
+        range->second += nextRange->second;
+        m_freeRanges.erase(nextRange);
+    }
+
+    if (range != m_freeRanges.begin())
+    {
+        auto previousRange = std::prev(range);
+        if (previousRange->first + previousRange->second == range->first)
+        {
+            previousRange->second += range->second;
+            m_freeRanges.erase(range);
+        }
+    }
+}
+
+VkDeviceSize RangeAllocator::GetLargestFreeRange() const
+{
+    VkDeviceSize largestFreeRange = 0u;
+
+    for (const auto& range : m_freeRanges)
+        largestFreeRange = std::max(largestFreeRange, range.second);
+
+    return largestFreeRange;
+}
+
+// Shared Memory Arena
+// ---------------------------------
+
+void SharedMemoryArena::Create(const VulkanDevice& exporter, const VulkanDevice& importer, VkExternalMemoryHandleTypeFlagBits handleType, VkDeviceSize blockSize)
+{
+    m_exporter   = exporter;
+    m_importer   = importer;
+    m_handleType = handleType;
+    m_blockSize  = blockSize;
+}
+
+bool SharedMemoryArena::CreateBlock(uint32_t memoryTypeIndex, VkDeviceSize size, uint32_t& blockIndex)
+{
+    Block block;
+    block.memoryTypeIndex = memoryTypeIndex;
+
+    if (!AllocateVulkanExportableMemory(m_exporter, size, memoryTypeIndex, m_handleType, block.vkExporterMemory))
+    {
+        spdlog::error("Failed to allocate a {} MiB shared memory arena block.", size >> 20);
+        return false;
+    }
+
+    // Both devices run on the same physical device, so the import uses the exporter's memory type.
+    ExternalMemoryHandle memoryHandle;
+    if (!ExportVulkanMemoryHandle(m_exporter, block.vkExporterMemory, memoryHandle) ||
+        !ImportVulkanMemory(m_importer, memoryHandle, size, memoryTypeIndex, block.vkImporterMemory))
+    {
+        spdlog::error("Failed to import a shared memory arena block into the importer device.");
+
+        DestroyBlock(block);
+        return false;
+    }
+
+    block.ranges.Reset(size);
+
+    blockIndex = 0u;
+    while (blockIndex < m_blocks.size() && m_blocks[blockIndex].vkExporterMemory != VK_NULL_HANDLE)
+        blockIndex++;
+
+    if (blockIndex == m_blocks.size())
+        m_blocks.emplace_back();
+
+    m_blocks[blockIndex] = std::move(block);
+
+    return true;
+}
+
+void SharedMemoryArena::DestroyBlock(Block& block)
+{
+    vkFreeMemory(m_importer.vkLogicalDevice, block.vkImporterMemory, nullptr);
+    vkFreeMemory(m_exporter.vkLogicalDevice, block.vkExporterMemory, nullptr);
+
+    block = {};
+}
+
+bool SharedMemoryArena::Allocate(const VkMemoryRequirements& requirements, SharedMemoryArenaAllocation& allocation)
+{
+    uint32_t memoryTypeIndex;
+    if (!FindVulkanMemoryTypeIndex(m_exporter.vkPhysicalDevice, requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, memoryTypeIndex))
+        return false;
+
+    VkDeviceSize offset     = 0u;
+    uint32_t     blockIndex = 0u;
+
+    while (blockIndex < m_blocks.size())
+    {
+        Block& block = m_blocks[blockIndex];
+
+        if (block.vkExporterMemory != VK_NULL_HANDLE && block.memoryTypeIndex == memoryTypeIndex &&
+            block.ranges.Allocate(requirements.size, requirements.alignment, offset))
+            break;
+
+        blockIndex++;
+    }
+
+    if (blockIndex == m_blocks.size())
+    {
+        if (!CreateBlock(memoryTypeIndex, std::max(m_blockSize, requirements.size), blockIndex))
+            return false;
+
+        // Blocks start at offset 0, which satisfies any alignment.
+        m_blocks[blockIndex].ranges.Allocate(requirements.size, requirements.alignment, offset);
+    }
+
+    Block& block = m_blocks[blockIndex];
+    block.allocationCount++;
+
+    allocation.blockIndex       = blockIndex;
+    allocation.offset           = offset;
+    allocation.size             = requirements.size;
+    allocation.vkExporterMemory = block.vkExporterMemory;
+    allocation.vkImporterMemory = block.vkImporterMemory;
+
+    return true;
+}
+
+void SharedMemoryArena::Free(SharedMemoryArenaAllocation& allocation)
+{
+    if (allocation.blockIndex >= m_blocks.size())
+        return;
+
+    Block& block = m_blocks[allocation.blockIndex];
+
+    block.ranges.Free(allocation.offset, allocation.size);
+
+    if (--block.allocationCount == 0u)
+        DestroyBlock(block);
+
+    allocation = {};
+}
+
+void SharedMemoryArena::Destroy()
+{
+    for (Block& block : m_blocks)
+    {
+        if (block.vkExporterMemory != VK_NULL_HANDLE)
+            DestroyBlock(block);
+    }
+
+    m_blocks.clear();
+
+    m_exporter = {};
+    m_importer = {};
+}
+
+SharedMemoryArenaStats SharedMemoryArena::GetStats() const
+{
+    SharedMemoryArenaStats stats;
+
+    VkDeviceSize freeBytes         = 0u;
+    VkDeviceSize largestRangeBytes = 0u;
+
+    for (const Block& block : m_blocks)
+    {
+        if (block.vkExporterMemory == VK_NULL_HANDLE)
+            continue;
+
+        stats.blockCount++;
+        stats.allocationCount += block.allocationCount;
+        stats.reservedBytes   += block.ranges.GetSize();
+        stats.usedBytes       += block.ranges.GetSize() - block.ranges.GetFreeBytes();
+        stats.freeRangeCount  += block.ranges.GetFreeRangeCount();
+
+        const VkDeviceSize largestFreeRange = block.ranges.GetLargestFreeRange();
+
+        stats.largestFreeRange = std::max(stats.largestFreeRange, largestFreeRange);
+
+        freeBytes         += block.ranges.GetFreeBytes();
+        largestRangeBytes += largestFreeRange;
+    }
+
+    stats.deviceMemoryCount = 2u * stats.blockCount;
+    stats.fragmentation     = freeBytes > 0u ? 1.0 - (double)largestRangeBytes / (double)freeBytes : 0.0;
+
+    return stats;
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <map>
+#include <vector>
+
+#include "Vulkan.h"
+
+// Size of the exportable allocations the arena suballocates from. Resources above half of it are not worth
+// suballocating and keep a dedicated allocation.
+constexpr VkDeviceSize kSharedMemoryArenaBlockSize = 64ull << 20;
+
+// Free ranges of a block of memory, kept sorted by offset so that a freed range merges with its neighbors.
+// Allocations take the smallest free range that fits them once aligned; the alignment padding stays free.
+class RangeAllocator
+{
+public:
+    void Reset(VkDeviceSize size);
+
+    bool Allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset);
+
+    // offset and size must be those of an allocation.
+    void Free(VkDeviceSize offset, VkDeviceSize size);
+
+    VkDeviceSize GetSize()      const { return m_size; }
+    VkDeviceSize GetFreeBytes() const { return m_freeBytes; }
+
+    uint32_t GetFreeRangeCount() const { return (uint32_t)m_freeRanges.size(); }
+
+    VkDeviceSize GetLargestFreeRange() const;
+
+private:
+    VkDeviceSize                         m_size      = 0u;
+    VkDeviceSize                         m_freeBytes = 0u;
+
+    // Offset to size.
+    std::map<VkDeviceSize, VkDeviceSize> m_freeRanges;
+};
+
+struct SharedMemoryArenaAllocation
+{
+    uint32_t       blockIndex       = UINT32_MAX;
+    VkDeviceSize   offset           = 0u;
+    VkDeviceSize   size             = 0u;
+
+    // Memory of the block on each side, to bind the resources at offset. Owned by the arena.
+    VkDeviceMemory vkExporterMemory = VK_NULL_HANDLE;
+    VkDeviceMemory vkImporterMemory = VK_NULL_HANDLE;
+};
+
+struct SharedMemoryArenaStats
+{
+    // Device memory objects on both sides of the interop: an export and an import per arena block, and the same
+    // for every resource with a dedicated allocation (filled in by the backend).
+    uint32_t     deviceMemoryCount = 0u;
+    uint32_t     blockCount        = 0u;
+    uint32_t     dedicatedCount    = 0u;
+
+    uint32_t     allocationCount   = 0u;
+    VkDeviceSize reservedBytes     = 0u;
+    VkDeviceSize usedBytes         = 0u;
+
+    uint32_t     freeRangeCount    = 0u;
+    VkDeviceSize largestFreeRange  = 0u;
+
+    // Share of the free bytes outside of the largest free range of their block: 0 while the free space of every
+    // block is in one piece, close to 1 when it is scattered in small holes.
+    double       fragmentation     = 0.0;
+};
+
+// A few large allocations of the exporter, each exported and imported into the importer once, from which many
+// small shared resources are suballocated: both sides bind their resource at the same offset of the same block,
+// instead of exporting, importing and allocating twice per resource.
+//
+// The arena serves a single importer device and holds shared images only. They are all optimally tiled, so
+// bufferImageGranularity never applies between neighbors. Blocks are released as soon as their last allocation is
+// freed.
+class SharedMemoryArena
+{
+public:
+    ~SharedMemoryArena() { Destroy(); }
+
+    void Create(const VulkanDevice& exporter, const VulkanDevice& importer, VkExternalMemoryHandleTypeFlagBits handleType, VkDeviceSize blockSize = kSharedMemoryArenaBlockSize);
+
+    bool IsCreated() const { return m_exporter.vkLogicalDevice != VK_NULL_HANDLE; }
+
+    const VulkanDevice& GetImporter() const { return m_importer; }
+
+    VkDeviceSize GetBlockSize() const { return m_blockSize; }
+
+    // requirements must hold for both sides: memory type bits of both, the larger size and alignment.
+    bool Allocate(const VkMemoryRequirements& requirements, SharedMemoryArenaAllocation& allocation);
+
+    // The resources bound to the allocation must have been destroyed on both sides.
+    void Free(SharedMemoryArenaAllocation& allocation);
+
+    // Frees every block, allocations included. The arena must be created again before further use.
+    void Destroy();
+
+    SharedMemoryArenaStats GetStats() const;
+
+private:
+    struct Block
+    {
+        VkDeviceMemory vkExporterMemory = VK_NULL_HANDLE;
+        VkDeviceMemory vkImporterMemory = VK_NULL_HANDLE;
+        uint32_t       memoryTypeIndex  = UINT32_MAX;
+        uint32_t       allocationCount  = 0u;
+        RangeAllocator ranges;
+    };
+
+    bool CreateBlock(uint32_t memoryTypeIndex, VkDeviceSize size, uint32_t& blockIndex);
+
+    void DestroyBlock(Block& block);
+
+    VulkanDevice                        m_exporter;
+    VulkanDevice                        m_importer;
+    VkExternalMemoryHandleTypeFlagBits  m_handleType = {};
+    VkDeviceSize                        m_blockSize  = kSharedMemoryArenaBlockSize;
+
+    // Released blocks leave holes, so that block indices of live allocations stay valid.
+    std::vector<Block>                  m_blocks;
+};
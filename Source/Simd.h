@@ -0,0 +1,391 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+// Minimal 4-wide float vector used by the CPU image kernels. Maps to SSE2 on x86-64, NEON on ARM64 and
+// to plain scalar code elsewhere, so every kernel keeps a single source.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SIMD_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+
+struct Float4
+{
+#if defined(SIMD_SSE2)
+    __m128 v;
+#elif defined(SIMD_NEON)
+    float32x4_t v;
+#else
+    float v[4];
+#endif
+
+    static Float4 Load(const float* pValues)
+    {
+        Float4 result;
+#if defined(SIMD_SSE2)
+        result.v = _mm_loadu_ps(pValues);
+#elif defined(SIMD_NEON)
+        result.v = vld1q_f32(pValues);
+#else
+        memcpy(result.v, pValues, sizeof(result.v));
+#endif
+        return result;
+    }
+
+    static Float4 Set1(float value)
+    {
+        Float4 result;
+#if defined(SIMD_SSE2)
+        result.v = _mm_set1_ps(value);
+#elif defined(SIMD_NEON)
+        result.v = vdupq_n_f32(value);
+#else
+        result.v[0] = result.v[1] = result.v[2] = result.v[3] = value;
+#endif
+        return result;
+    }
+
+    void Store(float* pValues) const
+    {
+#if defined(SIMD_SSE2)
+        _mm_storeu_ps(pValues, v);
+#elif defined(SIMD_NEON)
+        vst1q_f32(pValues, v);
+#else
+        memcpy(pValues, v, sizeof(v));
+#endif
+    }
+
+    // Rounds to the nearest integer (ties to even).
+    void StoreRoundedInt32(int32_t* pValues) const
+    {
+#if defined(SIMD_SSE2)
+        _mm_storeu_si128((__m128i*)pValues, _mm_cvtps_epi32(v));
+#elif defined(SIMD_NEON)
+        vst1q_s32(pValues, vcvtnq_s32_f32(v));
+#else
+        for (int lane = 0; lane < 4; lane++)
+            pValues[lane] = (int32_t)std::nearbyint(v[lane]);
+#endif
+    }
+
+    // Rounds to the nearest integer (ties to even), saturates to [0, 255] and stores 4 bytes.
+    void StoreRoundedUInt8(uint8_t* pValues) const
+    {
+#if defined(SIMD_SSE2)
+        const __m128i words = _mm_packs_epi32(_mm_cvtps_epi32(v), _mm_setzero_si128());
+        const int32_t bytes = _mm_cvtsi128_si32(_mm_packus_epi16(words, words));
+        memcpy(pValues, &bytes, sizeof(bytes));
+#elif defined(SIMD_NEON)
+        const uint16x4_t words = vqmovun_s32(vcvtnq_s32_f32(v));
+        const uint8x8_t  bytes = vqmovn_u16(vcombine_u16(words, words));
+        vst1_lane_u32((uint32_t*)pValues, vreinterpret_u32_u8(bytes), 0);
+#else
+        for (int lane = 0; lane < 4; lane++)
+        {
+            const float value = std::nearbyint(v[lane]);
+            pValues[lane] = (uint8_t)(value < 0.0f ? 0.0f : (value > 255.0f ? 255.0f : value));
+        }
+#endif
+    }
+};
+
+inline Float4 operator+(Float4 a, Float4 b)
+{
+#if defined(SIMD_SSE2)
+    a.v = _mm_add_ps(a.v, b.v);
+#elif defined(SIMD_NEON)
+    a.v = vaddq_f32(a.v, b.v);
+#else
+    for (int lane = 0; lane < 4; lane++) a.v[lane] += b.v[lane];
+#endif
+    return a;
+}
+
+inline Float4 operator-(Float4 a, Float4 b)
+{
+#if defined(SIMD_SSE2)
+    a.v = _mm_sub_ps(a.v, b.v);
+#elif defined(SIMD_NEON)
+    a.v = vsubq_f32(a.v, b.v);
+#else
+    for (int lane = 0; lane < 4; lane++) a.v[lane] -= b.v[lane];
+#endif
+    return a;
+}
+
+inline Float4 operator*(Float4 a, Float4 b)
+{
+#if defined(SIMD_SSE2)
+    a.v = _mm_mul_ps(a.v, b.v);
+#elif defined(SIMD_NEON)
+    a.v = vmulq_f32(a.v, b.v);
+#else
+    for (int lane = 0; lane < 4; lane++) a.v[lane] *= b.v[lane];
+#endif
+    return a;
+}
+
+inline Float4 operator/(Float4 a, Float4 b)
+{
+#if defined(SIMD_SSE2)
+    a.v = _mm_div_ps(a.v, b.v);
+#elif defined(SIMD_NEON)
+    a.v = vdivq_f32(a.v, b.v);
+#else
+    for (int lane = 0; lane < 4; lane++) a.v[lane] /= b.v[lane];
+#endif
+    return a;
+}
+
+inline Float4 operator*(Float4 a, float b) { return a * Float4::Set1(b); }
+inline Float4 operator+(Float4 a, float b) { return a + Float4::Set1(b); }
+
+inline Float4 Min(Float4 a, Float4 b)
+{
+#if defined(SIMD_SSE2)
+    a.v = _mm_min_ps(a.v, b.v);
+#elif defined(SIMD_NEON)
+    a.v = vminq_f32(a.v, b.v);
+#else
+    for (int lane = 0; lane < 4; lane++) a.v[lane] = b.v[lane] < a.v[lane] ? b.v[lane] : a.v[lane];
+#endif
+    return a;
+}
+
+inline Float4 Max(Float4 a, Float4 b)
+{
+#if defined(SIMD_SSE2)
+    a.v = _mm_max_ps(a.v, b.v);
+#elif defined(SIMD_NEON)
+    a.v = vmaxq_f32(a.v, b.v);
+#else
+    for (int lane = 0; lane < 4; lane++) a.v[lane] = b.v[lane] > a.v[lane] ? b.v[lane] : a.v[lane];
+#endif
+    return a;
+}
+
+inline Float4 Sqrt(Float4 a)
+{
+#if defined(SIMD_SSE2)
+    a.v = _mm_sqrt_ps(a.v);
+#elif defined(SIMD_NEON)
+    a.v = vsqrtq_f32(a.v);
+#else
+    for (int lane = 0; lane < 4; lane++) a.v[lane] = std::sqrt(a.v[lane]);
+#endif
+    return a;
+}
+
+// Sums adjacent lanes: (a0 + a1, a2 + a3, b0 + b1, b2 + b3).
+inline Float4 PairwiseAdd(Float4 a, Float4 b)
+{
+#if defined(SIMD_SSE2)
+    a.v = _mm_add_ps(_mm_shuffle_ps(a.v, b.v, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(a.v, b.v, _MM_SHUFFLE(3, 1, 3, 1)));
+#elif defined(SIMD_NEON)
+    a.v = vpaddq_f32(a.v, b.v);
+#else
+    const float sums[4] = { a.v[0] + a.v[1], a.v[2] + a.v[3], b.v[0] + b.v[1], b.v[2] + b.v[3] };
+    memcpy(a.v, sums, sizeof(sums));
+#endif
+    return a;
+}
+
+// Transposes the 4x4 matrix whose rows are r0..r3.
+inline void Transpose4(Float4& r0, Float4& r1, Float4& r2, Float4& r3)
+{
+#if defined(SIMD_SSE2)
+    _MM_TRANSPOSE4_PS(r0.v, r1.v, r2.v, r3.v);
+#elif defined(SIMD_NEON)
+    const float32x4x2_t t01 = vtrnq_f32(r0.v, r1.v);
+    const float32x4x2_t t23 = vtrnq_f32(r2.v, r3.v);
+
+    r0.v = vcombine_f32(vget_low_f32 (t01.val[0]), vget_low_f32 (t23.val[0]));
+    r1.v = vcombine_f32(vget_low_f32 (t01.val[1]), vget_low_f32 (t23.val[1]));
+    r2.v = vcombine_f32(vget_high_f32(t01.val[0]), vget_high_f32(t23.val[0]));
+    r3.v = vcombine_f32(vget_high_f32(t01.val[1]), vget_high_f32(t23.val[1]));
+#else
+    Float4* rows[4] = { &r0, &r1, &r2, &r3 };
+    for (int row = 0; row < 4; row++)
+    {
+        for (int column = row + 1; column < 4; column++)
+        {
+            const float value = rows[row]->v[column];
+            rows[row]->v[column] = rows[column]->v[row];
+            rows[column]->v[row] = value;
+        }
+    }
+#endif
+}
+
+// Unpacks four 4-byte RGBA pixels into one vector per color channel (alpha is dropped).
+inline void LoadRGBA8(const uint8_t* pPixels, Float4& red, Float4& green, Float4& blue)
+{
+#if defined(SIMD_SSE2)
+    const __m128i pixels   = _mm_loadu_si128((const __m128i*)pPixels);
+    const __m128i byteMask = _mm_set1_epi32(0xFF);
+
+    red.v   = _mm_cvtepi32_ps(_mm_and_si128(pixels, byteMask));
+    green.v = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(pixels, 8), byteMask));
+    blue.v  = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(pixels, 16), byteMask));
+#elif defined(SIMD_NEON)
+    const uint32x4_t pixels   = vreinterpretq_u32_u8(vld1q_u8(pPixels));
+    const uint32x4_t byteMask = vdupq_n_u32(0xFFu);
+
+    red.v   = vcvtq_f32_u32(vandq_u32(pixels, byteMask));
+    green.v = vcvtq_f32_u32(vandq_u32(vshrq_n_u32(pixels, 8), byteMask));
+    blue.v  = vcvtq_f32_u32(vandq_u32(vshrq_n_u32(pixels, 16), byteMask));
+#else
+    for (int lane = 0; lane < 4; lane++)
+    {
+        red.v[lane]   = pPixels[lane * 4 + 0];
+        green.v[lane] = pPixels[lane * 4 + 1];
+        blue.v[lane]  = pPixels[lane * 4 + 2];
+    }
+#endif
+}
+
+inline void LoadRGBA8(const uint8_t* pPixels, Float4& red, Float4& green, Float4& blue, Float4& alpha)
+{
+    LoadRGBA8(pPixels, red, green, blue);
+
+#if defined(SIMD_SSE2)
+    alpha.v = _mm_cvtepi32_ps(_mm_srli_epi32(_mm_loadu_si128((const __m128i*)pPixels), 24));
+#elif defined(SIMD_NEON)
+    alpha.v = vcvtq_f32_u32(vshrq_n_u32(vreinterpretq_u32_u8(vld1q_u8(pPixels)), 24));
+#else
+    for (int lane = 0; lane < 4; lane++)
+        alpha.v[lane] = pPixels[lane * 4 + 3];
+#endif
+}
+
+// Packs one vector per channel, in [0, 255], back into four 4-byte RGBA pixels.
+inline void StoreRGBA8(uint8_t* pPixels, Float4 red, Float4 green, Float4 blue, Float4 alpha)
+{
+    Transpose4(red, green, blue, alpha);
+
+    red  .StoreRoundedUInt8(pPixels + 0);
+    green.StoreRoundedUInt8(pPixels + 4);
+    blue .StoreRoundedUInt8(pPixels + 8);
+    alpha.StoreRoundedUInt8(pPixels + 12);
+}
+
+// Unpacks four 32-bit pixels with 10-bit red, green, blue in the low bits and 2-bit alpha in the high bits
+// (VK_FORMAT_A2B10G10R10_UNORM_PACK32, DXGI_FORMAT_R10G10B10A2_UNORM). Channels stay in [0, 1023] and [0, 3].
+inline void LoadRGB10A2(const uint8_t* pPixels, Float4& red, Float4& green, Float4& blue, Float4& alpha)
+{
+#if defined(SIMD_SSE2)
+    const __m128i pixels = _mm_loadu_si128((const __m128i*)pPixels);
+    const __m128i mask   = _mm_set1_epi32(0x3FF);
+
+    red.v   = _mm_cvtepi32_ps(_mm_and_si128(pixels, mask));
+    green.v = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(pixels, 10), mask));
+    blue.v  = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(pixels, 20), mask));
+    alpha.v = _mm_cvtepi32_ps(_mm_srli_epi32(pixels, 30));
+#elif defined(SIMD_NEON)
+    const uint32x4_t pixels = vreinterpretq_u32_u8(vld1q_u8(pPixels));
+    const uint32x4_t mask   = vdupq_n_u32(0x3FFu);
+
+    red.v   = vcvtq_f32_u32(vandq_u32(pixels, mask));
+    green.v = vcvtq_f32_u32(vandq_u32(vshrq_n_u32(pixels, 10), mask));
+    blue.v  = vcvtq_f32_u32(vandq_u32(vshrq_n_u32(pixels, 20), mask));
+    alpha.v = vcvtq_f32_u32(vshrq_n_u32(pixels, 30));
+#else
+    for (int lane = 0; lane < 4; lane++)
+    {
+        uint32_t pixel;
+        memcpy(&pixel, pPixels + lane * 4, sizeof(pixel));
+
+        red.v[lane]   = (float)(pixel & 0x3FFu);
+        green.v[lane] = (float)((pixel >> 10) & 0x3FFu);
+        blue.v[lane]  = (float)((pixel >> 20) & 0x3FFu);
+        alpha.v[lane] = (float)(pixel >> 30);
+    }
+#endif
+}
+
+// Converts four IEEE half floats. Infinities and NaNs come out as large finite values.
+inline Float4 LoadHalf4(const uint16_t* pValues)
+{
+    Float4 result;
+#if defined(SIMD_SSE2)
+    const __m128i halves    = _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i*)pValues), _mm_setzero_si128());
+    const __m128i sign      = _mm_slli_epi32(_mm_and_si128(halves, _mm_set1_epi32(0x8000)), 16);
+    const __m128i magnitude = _mm_slli_epi32(_mm_and_si128(halves, _mm_set1_epi32(0x7FFF)), 13);
+
+    // Rebias the exponent from 15 to 127, which also normalizes half denormals.
+    const __m128 value = _mm_mul_ps(_mm_castsi128_ps(magnitude), _mm_castsi128_ps(_mm_set1_epi32(0x77800000)));
+
+    result.v = _mm_or_ps(value, _mm_castsi128_ps(sign));
+#elif defined(SIMD_NEON)
+    result.v = vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(pValues)));
+#else
+    for (int lane = 0; lane < 4; lane++)
+    {
+        const uint32_t sign      = (uint32_t)(pValues[lane] & 0x8000u) << 16;
+        const uint32_t magnitude = (uint32_t)(pValues[lane] & 0x7FFFu) << 13;
+
+        float value;
+        memcpy(&value, &magnitude, sizeof(value));
+        value *= 5.192296858534828e33f; // 2^112
+
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        bits |= sign;
+        memcpy(&result.v[lane], &bits, sizeof(bits));
+    }
+#endif
+    return result;
+}
+
+// Swaps the first and third byte of four 4-byte pixels (RGBA <-> BGRA).
+inline void SwapRedBlue4(const uint8_t* pSource, uint8_t* pDestination)
+{
+#if defined(SIMD_SSE2)
+    const __m128i pixels     = _mm_loadu_si128((const __m128i*)pSource);
+    const __m128i redBlue    = _mm_and_si128(pixels, _mm_set1_epi32(0x00FF00FF));
+    const __m128i greenAlpha = _mm_and_si128(pixels, _mm_set1_epi32((int)0xFF00FF00));
+
+    _mm_storeu_si128((__m128i*)pDestination, _mm_or_si128(greenAlpha, _mm_or_si128(_mm_slli_epi32(redBlue, 16), _mm_srli_epi32(redBlue, 16))));
+#elif defined(SIMD_NEON)
+    const uint32x4_t pixels     = vreinterpretq_u32_u8(vld1q_u8(pSource));
+    const uint32x4_t redBlue    = vandq_u32(pixels, vdupq_n_u32(0x00FF00FFu));
+    const uint32x4_t greenAlpha = vandq_u32(pixels, vdupq_n_u32(0xFF00FF00u));
+
+    vst1q_u8(pDestination, vreinterpretq_u8_u32(vorrq_u32(greenAlpha, vorrq_u32(vshlq_n_u32(redBlue, 16), vshrq_n_u32(redBlue, 16)))));
+#else
+    for (int pixel = 0; pixel < 4; pixel++)
+    {
+        const uint8_t red = pSource[pixel * 4 + 0];
+
+        pDestination[pixel * 4 + 0] = pSource[pixel * 4 + 2];
+        pDestination[pixel * 4 + 1] = pSource[pixel * 4 + 1];
+        pDestination[pixel * 4 + 2] = red;
+        pDestination[pixel * 4 + 3] = pSource[pixel * 4 + 3];
+    }
+#endif
+}
+
+// XORs 16 bytes of a with 16 bytes of b. pDestination may alias either source.
+inline void XorBytes16(const uint8_t* pA, const uint8_t* pB, uint8_t* pDestination)
+{
+#if defined(SIMD_SSE2)
+    _mm_storeu_si128((__m128i*)pDestination, _mm_xor_si128(_mm_loadu_si128((const __m128i*)pA), _mm_loadu_si128((const __m128i*)pB)));
+#elif defined(SIMD_NEON)
+    vst1q_u8(pDestination, veorq_u8(vld1q_u8(pA), vld1q_u8(pB)));
+#else
+    uint64_t a[2], b[2];
+    memcpy(a, pA, sizeof(a));
+    memcpy(b, pB, sizeof(b));
+
+    a[0] ^= b[0];
+    a[1] ^= b[1];
+
+    memcpy(pDestination, a, sizeof(a));
+#endif
+}
@@ -0,0 +1,56 @@
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+#include <spdlog/spdlog.h>
+
+#include "Statistics.h"
+
+static double GetPercentile(const std::vector<double>& sortedSamples, double percentile)
+{
+    const size_t rank = (size_t)std::ceil(percentile / 100.0 * (double)sortedSamples.size());
+
+    return sortedSamples[std::clamp<size_t>(rank, 1u, sortedSamples.size()) - 1u];
+}
+
+SampleSummary SummarizeSamples(std::vector<double>& samples)
+{
+    SampleSummary summary;
+
+    if (samples.empty())
+        return summary;
+
+    std::sort(samples.begin(), samples.end());
+
+    summary.count = samples.size();
+    summary.mean  = std::accumulate(samples.begin(), samples.end(), 0.0) / (double)samples.size();
+    summary.min   = samples.front();
+    summary.p50   = GetPercentile(samples, 50.0);
+    summary.p95   = GetPercentile(samples, 95.0);
+    summary.p99   = GetPercentile(samples, 99.0);
+    summary.max   = samples.back();
+
+    return summary;
+}
+
+void PhaseTimer::EndPhase(const char* pName)
+{
+    const auto now = std::chrono::steady_clock::now();
+
+    m_phases.emplace_back(pName, std::chrono::duration<double, std::milli>(now - m_phaseStart).count());
+
+    m_phaseStart = now;
+}
+
+void PhaseTimer::Log(const char* pTitle) const
+{
+    double totalMs = 0.0;
+
+    for (const auto& [pName, phaseMs] : m_phases)
+    {
+        spdlog::info("{} | {:<20} {:9.3f} ms", pTitle, pName, phaseMs);
+        totalMs += phaseMs;
+    }
+
+    spdlog::info("{} | {:<20} {:9.3f} ms", pTitle, "total", totalMs);
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <chrono>
+#include <utility>
+#include <vector>
+
+// Summary of a set of timing samples (all values share the unit of the samples).
+struct SampleSummary
+{
+    size_t count = 0u;
+    double mean  = 0.0;
+    double min   = 0.0;
+    double p50   = 0.0;
+    double p95   = 0.0;
+    double p99   = 0.0;
+    double max   = 0.0;
+};
+
+// Sorts the samples in place and computes nearest-rank percentiles.
+SampleSummary SummarizeSamples(std::vector<double>& samples);
+
+inline double GetElapsedMilliseconds(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Wall-clock durations of consecutive named phases, e.g. of startup.
+class PhaseTimer
+{
+public:
+    PhaseTimer() : m_start(std::chrono::steady_clock::now()), m_phaseStart(m_start) {}
+
+    // Ends the current phase, recording it as pName, and starts the next one.
+    void EndPhase(const char* pName);
+
+    double GetTotalMilliseconds() const { return GetElapsedMilliseconds(m_start); }
+
+    // Logs every phase and the total up to the last one.
+    void Log(const char* pTitle) const;
+
+private:
+    std::chrono::steady_clock::time_point m_start;
+    std::chrono::steady_clock::time_point m_phaseStart;
+
+    std::vector<std::pair<const char*, double>> m_phases;
+};
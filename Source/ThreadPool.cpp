@@ -0,0 +1,98 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+#include "Trace.h"
+
+ThreadPool::ThreadPool(uint32_t threadCount)
+{
+    if (threadCount == 0u)
+        threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+
+    for (uint32_t workerIndex = 1u; workerIndex < threadCount; workerIndex++)
+        m_workers.emplace_back(&ThreadPool::WorkerLoop, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+
+    m_wakeCondition.notify_all();
+
+    for (auto& worker : m_workers)
+        worker.join();
+}
+
+void ThreadPool::ParallelFor(uint32_t taskCount, const std::function<void(uint32_t)>& taskFunc)
+{
+    if (taskCount == 0u)
+        return;
+
+    // Not worth waking anyone up for.
+    if (taskCount == 1u || m_workers.empty())
+    {
+        for (uint32_t taskIndex = 0u; taskIndex < taskCount; taskIndex++)
+            taskFunc(taskIndex);
+
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        m_pTaskFunc = &taskFunc;
+        m_taskCount = taskCount;
+        m_nextTask.store(0u, std::memory_order_relaxed);
+        m_generation++;
+    }
+
+    m_wakeCondition.notify_all();
+
+    RunTasks();
+
+    // Every task has been claimed, wait for the workers still running one.
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_doneCondition.wait(lock, [this]() { return m_busyWorkers == 0u; });
+
+    m_pTaskFunc = nullptr;
+}
+
+void ThreadPool::WorkerLoop()
+{
+    TRACE_THREAD_NAME("Thread pool worker");
+
+    uint64_t seenGeneration = 0u;
+
+    for (;;)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_wakeCondition.wait(lock, [&]() { return m_stopping || m_generation != seenGeneration; });
+
+        if (m_stopping)
+            return;
+
+        seenGeneration = m_generation;
+
+        // Woke up after the caller already finished the whole batch.
+        if (m_pTaskFunc == nullptr)
+            continue;
+
+        m_busyWorkers++;
+
+        lock.unlock();
+        RunTasks();
+        lock.lock();
+
+        if (--m_busyWorkers == 0u)
+            m_doneCondition.notify_all();
+    }
+}
+
+void ThreadPool::RunTasks()
+{
+    for (uint32_t taskIndex = m_nextTask.fetch_add(1u); taskIndex < m_taskCount; taskIndex = m_nextTask.fetch_add(1u))
+        (*m_pTaskFunc)(taskIndex);
+}
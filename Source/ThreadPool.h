@@ -0,0 +1,46 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads that split indexed tasks with the calling thread.
+class ThreadPool
+{
+public:
+    // threadCount includes the calling thread; 0 uses every hardware thread.
+    explicit ThreadPool(uint32_t threadCount = 0u);
+
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&)            = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    uint32_t GetThreadCount() const { return (uint32_t)m_workers.size() + 1u; }
+
+    // Runs taskFunc(taskIndex) for every index in [0, taskCount) and returns once all of them finished.
+    // Not reentrant: tasks must not call ParallelFor on the same pool.
+    void ParallelFor(uint32_t taskCount, const std::function<void(uint32_t)>& taskFunc);
+
+private:
+    void WorkerLoop();
+
+    void RunTasks();
+
+    std::vector<std::thread> m_workers;
+
+    std::mutex              m_mutex;
+    std::condition_variable m_wakeCondition;
+    std::condition_variable m_doneCondition;
+
+    const std::function<void(uint32_t)>* m_pTaskFunc   = nullptr;
+    uint32_t                             m_taskCount   = 0u;
+    std::atomic<uint32_t>                m_nextTask    = 0u;
+    uint32_t                             m_busyWorkers = 0u;
+    uint64_t                             m_generation  = 0u;
+    bool                                 m_stopping    = false;
+};
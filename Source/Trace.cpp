@@ -0,0 +1,371 @@
+#include "Trace.h"
+
+#if defined(INTEROP_TRACING)
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+
+#include <spdlog/spdlog.h>
+
+#include "DeviceCache.h"
+
+// CPU Zones
+// ---------------------------------
+
+// Events of one thread. Only the owning thread appends, publishing each event with the release store of
+// eventCount, so that an export on another thread reads the first eventCount events without locking.
+struct TraceThreadBuffer
+{
+    uint32_t                      threadId     = 0u;
+    std::string                   name;
+    std::unique_ptr<TraceEvent[]> pEvents      = std::make_unique<TraceEvent[]>(kTraceThreadEventCapacity);
+    std::atomic<uint32_t>         eventCount   = 0u;
+    std::atomic<uint32_t>         droppedCount = 0u;
+};
+
+// Buffers outlive their threads, so that zones of finished workers are still exported.
+static std::mutex                                      s_registryMutex;
+static std::vector<std::unique_ptr<TraceThreadBuffer>> s_threadBuffers;
+static std::vector<VulkanTraceQueries*>                s_traceQueries;
+
+static thread_local TraceThreadBuffer* t_pThreadBuffer = nullptr;
+static thread_local uint64_t           t_frameIndex    = kTraceNoFrame;
+
+static TraceThreadBuffer& GetThreadBuffer()
+{
+    if (t_pThreadBuffer != nullptr)
+        return *t_pThreadBuffer;
+
+    std::lock_guard<std::mutex> lock(s_registryMutex);
+
+    auto pThreadBuffer = std::make_unique<TraceThreadBuffer>();
+    pThreadBuffer->threadId = (uint32_t)s_threadBuffers.size() + 1u;
+    pThreadBuffer->name     = "Thread " + std::to_string(pThreadBuffer->threadId);
+
+    t_pThreadBuffer = pThreadBuffer.get();
+    s_threadBuffers.push_back(std::move(pThreadBuffer));
+
+    return *t_pThreadBuffer;
+}
+
+uint64_t GetTraceTimeNs()
+{
+    static const auto s_start = std::chrono::steady_clock::now();
+
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - s_start).count();
+}
+
+void RecordTraceEvent(const char* pName, uint64_t startNs, uint64_t endNs)
+{
+    TraceThreadBuffer& threadBuffer = GetThreadBuffer();
+
+    const uint32_t eventIndex = threadBuffer.eventCount.load(std::memory_order_relaxed);
+    if (eventIndex == kTraceThreadEventCapacity)
+    {
+        threadBuffer.droppedCount.fetch_add(1u, std::memory_order_relaxed);
+        return;
+    }
+
+    TraceEvent& event = threadBuffer.pEvents[eventIndex];
+    event.pName      = pName;
+    event.startNs    = startNs;
+    event.durationNs = endNs - startNs;
+    event.frameIndex = t_frameIndex;
+
+    threadBuffer.eventCount.store(eventIndex + 1u, std::memory_order_release);
+}
+
+void SetTraceThreadName(const char* pName)
+{
+    TraceThreadBuffer& threadBuffer = GetThreadBuffer();
+
+    std::lock_guard<std::mutex> lock(s_registryMutex);
+    threadBuffer.name = pName;
+}
+
+uint64_t GetTraceFrame()
+{
+    return t_frameIndex;
+}
+
+void SetTraceFrame(uint64_t frameIndex)
+{
+    t_frameIndex = frameIndex;
+}
+
+// GPU Zones
+// ---------------------------------
+
+bool VulkanTraceQueries::Create(const VulkanDevice& device, VulkanQueueType queueType, const char* pTrackName)
+{
+    uint32_t queueFamilyIndex;
+    VkQueue  vkQueue;
+    GetVulkanQueue(device, queueType, queueFamilyIndex, vkQueue);
+
+    const uint32_t timestampValidBits = GetVulkanDeviceCapabilities(device.vkPhysicalDevice).queueFamilies[queueFamilyIndex].timestampValidBits;
+    if (timestampValidBits == 0u)
+    {
+        spdlog::warn("Queue family {} has no timestamps, {} is not traced.", queueFamilyIndex, pTrackName);
+        return false;
+    }
+
+    VkQueryPoolCreateInfo vkQueryPoolCreateInfo = { VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO };
+    vkQueryPoolCreateInfo.queryType  = VK_QUERY_TYPE_TIMESTAMP;
+    vkQueryPoolCreateInfo.queryCount = 2u * kTraceGpuZoneCapacity;
+
+    if (vkCreateQueryPool(device.vkLogicalDevice, &vkQueryPoolCreateInfo, nullptr, &m_vkQueryPool) != VK_SUCCESS)
+    {
+        spdlog::error("Failed to create a timestamp query pool for {}.", pTrackName);
+        return false;
+    }
+
+    m_vkDevice      = device.vkLogicalDevice;
+    m_pTrackName    = pTrackName;
+    m_timestampMask = timestampValidBits < 64u ? (1ull << timestampValidBits) - 1u : UINT64_MAX;
+    m_zones         = std::vector<Zone>(kTraceGpuZoneCapacity);
+
+    VkPhysicalDeviceProperties physicalDeviceProperties;
+    vkGetPhysicalDeviceProperties(device.vkPhysicalDevice, &physicalDeviceProperties);
+
+    m_nsPerTick = physicalDeviceProperties.limits.timestampPeriod;
+
+    // Zones write into queries reset from the host, the first query pair calibrates the clock beforehand.
+    vkResetQueryPool(m_vkDevice, m_vkQueryPool, 0u, vkQueryPoolCreateInfo.queryCount);
+
+    const uint64_t submitNs = GetTraceTimeNs();
+
+    if (!SubmitVulkanCommandsImmediate(device, [&](VkCommandBuffer vkCommandBuffer)
+    {
+        vkCmdWriteTimestamp(vkCommandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_vkQueryPool, 0u);
+    }, {}, queueType))
+    {
+        Destroy();
+        return false;
+    }
+
+    const uint64_t completeNs = GetTraceTimeNs();
+
+    uint64_t calibrationTicks;
+    if (vkGetQueryPoolResults(m_vkDevice, m_vkQueryPool, 0u, 1u, sizeof(calibrationTicks), &calibrationTicks, sizeof(calibrationTicks), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT) != VK_SUCCESS)
+    {
+        Destroy();
+        return false;
+    }
+
+    // The timestamp was taken somewhere between the submit and the wait returning.
+    m_offsetNs = 0.5 * (double)(submitNs + completeNs) - (double)(calibrationTicks & m_timestampMask) * m_nsPerTick;
+
+    vkResetQueryPool(m_vkDevice, m_vkQueryPool, 0u, 1u);
+
+    return true;
+}
+
+void VulkanTraceQueries::Destroy()
+{
+    if (m_vkQueryPool != VK_NULL_HANDLE)
+        vkDestroyQueryPool(m_vkDevice, m_vkQueryPool, nullptr);
+
+    m_vkQueryPool = VK_NULL_HANDLE;
+    m_zones.clear();
+}
+
+uint32_t VulkanTraceQueries::BeginZone(VkCommandBuffer vkCommandBuffer, const char* pName)
+{
+    const uint32_t zoneIndex = m_nextZone.fetch_add(1u, std::memory_order_relaxed) % kTraceGpuZoneCapacity;
+    Zone&          zone      = m_zones[zoneIndex];
+
+    // The ring wrapped around onto a zone that was not collected yet.
+    uint32_t freeState = kZoneFree;
+    if (!zone.state.compare_exchange_strong(freeState, kZoneRecording, std::memory_order_acquire))
+    {
+        m_droppedZones.fetch_add(1u, std::memory_order_relaxed);
+        return UINT32_MAX;
+    }
+
+    zone.pName      = pName;
+    zone.frameIndex = GetTraceFrame();
+
+    vkCmdWriteTimestamp(vkCommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_vkQueryPool, 2u * zoneIndex);
+
+    return zoneIndex;
+}
+
+void VulkanTraceQueries::EndZone(VkCommandBuffer vkCommandBuffer, uint32_t zoneIndex)
+{
+    vkCmdWriteTimestamp(vkCommandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_vkQueryPool, 2u * zoneIndex + 1u);
+
+    m_zones[zoneIndex].state.store(kZoneRecorded, std::memory_order_release);
+}
+
+void VulkanTraceQueries::Collect()
+{
+    std::lock_guard<std::mutex> lock(m_eventsMutex);
+
+    for (uint32_t zoneIndex = 0u; zoneIndex < (uint32_t)m_zones.size(); zoneIndex++)
+    {
+        Zone& zone = m_zones[zoneIndex];
+
+        if (zone.state.load(std::memory_order_acquire) != kZoneRecorded)
+            continue;
+
+        // Begin and end timestamps, each followed by its availability.
+        uint64_t results[4];
+        const VkResult vkResult = vkGetQueryPoolResults(m_vkDevice, m_vkQueryPool, 2u * zoneIndex, 2u, sizeof(results), results, 2u * sizeof(uint64_t),
+                                                        VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+
+        if ((vkResult != VK_SUCCESS && vkResult != VK_NOT_READY) || results[1] == 0u || results[3] == 0u)
+            continue;
+
+        const uint64_t beginTicks = results[0] & m_timestampMask;
+        const uint64_t endTicks   = results[2] & m_timestampMask;
+        const double   startNs    = (double)beginTicks * m_nsPerTick + m_offsetNs;
+
+        TraceEvent event;
+        event.pName      = zone.pName;
+        event.startNs    = startNs > 0.0 ? (uint64_t)startNs : 0u;
+        event.durationNs = endTicks > beginTicks ? (uint64_t)((double)(endTicks - beginTicks) * m_nsPerTick) : 0u;
+        event.frameIndex = zone.frameIndex;
+
+        m_events.push_back(event);
+
+        // The commands executed, so the queries can be reset from the host before the zone is reused.
+        vkResetQueryPool(m_vkDevice, m_vkQueryPool, 2u * zoneIndex, 2u);
+
+        zone.state.store(kZoneFree, std::memory_order_release);
+    }
+}
+
+void VulkanTraceQueries::GetEvents(std::vector<TraceEvent>& events, uint32_t& droppedZoneCount)
+{
+    std::lock_guard<std::mutex> lock(m_eventsMutex);
+
+    events           = m_events;
+    droppedZoneCount = m_droppedZones.load(std::memory_order_relaxed);
+}
+
+VulkanTraceQueries* CreateVulkanTraceQueries(const VulkanDevice& device, VulkanQueueType queueType, const char* pTrackName)
+{
+    auto pQueries = std::make_unique<VulkanTraceQueries>();
+    if (!pQueries->Create(device, queueType, pTrackName))
+        return nullptr;
+
+    std::lock_guard<std::mutex> lock(s_registryMutex);
+    s_traceQueries.push_back(pQueries.get());
+
+    return pQueries.release();
+}
+
+void DestroyVulkanTraceQueries(VulkanTraceQueries* pQueries)
+{
+    if (pQueries == nullptr)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(s_registryMutex);
+        std::erase(s_traceQueries, pQueries);
+    }
+
+    delete pQueries;
+}
+
+void CollectVulkanTraceQueries()
+{
+    std::lock_guard<std::mutex> lock(s_registryMutex);
+
+    for (VulkanTraceQueries* pQueries : s_traceQueries)
+        pQueries->Collect();
+}
+
+// Export
+// ---------------------------------
+
+// Chrome trace process ids of the two kinds of tracks.
+constexpr uint32_t kTraceCpuProcessId = 1u;
+constexpr uint32_t kTraceGpuProcessId = 2u;
+
+static void WriteTraceMetadata(FILE* pFile, const char* pKind, uint32_t processId, uint32_t threadId, const char* pName, bool& first)
+{
+    fprintf(pFile, "%s{\"name\":\"%s\",\"ph\":\"M\",\"pid\":%u,\"tid\":%u,\"args\":{\"name\":\"%s\"}}", first ? "" : ",\n", pKind, processId, threadId, pName);
+    first = false;
+}
+
+static void WriteTraceEvent(FILE* pFile, uint32_t processId, uint32_t threadId, const TraceEvent& event, bool& first)
+{
+    // Timestamps are in microseconds.
+    fprintf(pFile, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%u,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f", first ? "" : ",\n",
+            event.pName, processId, threadId, event.startNs / 1000.0, event.durationNs / 1000.0);
+
+    if (event.frameIndex != kTraceNoFrame)
+        fprintf(pFile, ",\"args\":{\"frame\":%llu}", (unsigned long long)event.frameIndex);
+
+    fputc('}', pFile);
+    first = false;
+}
+
+bool WriteChromeTrace(const char* pFileName)
+{
+    CollectVulkanTraceQueries();
+
+    FILE* pFile = fopen(pFileName, "wb");
+    if (pFile == nullptr)
+    {
+        spdlog::error("Failed to open {} for writing.", pFileName);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(s_registryMutex);
+
+    bool     first         = true;
+    uint64_t eventCount    = 0u;
+    uint64_t droppedCount  = 0u;
+
+    fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", pFile);
+
+    WriteTraceMetadata(pFile, "process_name", kTraceCpuProcessId, 0u, "CPU", first);
+    WriteTraceMetadata(pFile, "process_name", kTraceGpuProcessId, 0u, "GPU", first);
+
+    for (const auto& pThreadBuffer : s_threadBuffers)
+    {
+        WriteTraceMetadata(pFile, "thread_name", kTraceCpuProcessId, pThreadBuffer->threadId, pThreadBuffer->name.c_str(), first);
+
+        const uint32_t threadEventCount = pThreadBuffer->eventCount.load(std::memory_order_acquire);
+
+        for (uint32_t eventIndex = 0u; eventIndex < threadEventCount; eventIndex++)
+            WriteTraceEvent(pFile, kTraceCpuProcessId, pThreadBuffer->threadId, pThreadBuffer->pEvents[eventIndex], first);
+
+        eventCount   += threadEventCount;
+        droppedCount += pThreadBuffer->droppedCount.load(std::memory_order_relaxed);
+    }
+
+    std::vector<TraceEvent> gpuEvents;
+
+    for (uint32_t trackIndex = 0u; trackIndex < (uint32_t)s_traceQueries.size(); trackIndex++)
+    {
+        uint32_t droppedZoneCount;
+        s_traceQueries[trackIndex]->GetEvents(gpuEvents, droppedZoneCount);
+
+        WriteTraceMetadata(pFile, "thread_name", kTraceGpuProcessId, trackIndex + 1u, s_traceQueries[trackIndex]->GetTrackName(), first);
+
+        for (const TraceEvent& event : gpuEvents)
+            WriteTraceEvent(pFile, kTraceGpuProcessId, trackIndex + 1u, event, first);
+
+        eventCount   += gpuEvents.size();
+        droppedCount += droppedZoneCount;
+    }
+
+    fputs("\n]}\n", pFile);
+
+    if (fclose(pFile) != 0)
+    {
+        spdlog::error("Failed to write {}.", pFileName);
+        return false;
+    }
+
+    spdlog::info("Wrote {} trace events to {} ({} dropped).", eventCount, pFileName, droppedCount);
+
+    return true;
+}
+
+#endif
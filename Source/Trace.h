@@ -0,0 +1,196 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "Vulkan.h"
+
+// Instrumentation of the frame path, exported as Chrome trace JSON (chrome://tracing, ui.perfetto.dev).
+//
+// CPU zones are scopes recorded into a buffer per thread that only its thread writes, so recording takes no lock.
+// GPU zones are timestamp queries written around commands, collected once the commands executed. Both carry the
+// frame index of the innermost TRACE_FRAME scope of the recording thread, which is how the readback of frame N
+// on the exporter lines up with its clear on the importer.
+//
+// Only the TRACE_* macros should be used: unless INTEROP_TRACING is defined (CMake option INTEROP_ENABLE_TRACING,
+// never in Release builds) they expand to nothing and TRACE_GPU_CREATE to a null pointer.
+
+class VulkanTraceQueries;
+
+#if defined(INTEROP_TRACING)
+
+constexpr bool kTracingEnabled = true;
+
+// Events a thread records before further ones are dropped (and counted).
+constexpr uint32_t kTraceThreadEventCapacity = 1u << 16;
+
+// Zones in flight per VulkanTraceQueries, further ones are dropped until earlier ones are collected.
+constexpr uint32_t kTraceGpuZoneCapacity = 1024u;
+
+constexpr uint64_t kTraceNoFrame = UINT64_MAX;
+
+struct TraceEvent
+{
+    // Static strings only, events outlive their zones.
+    const char* pName      = nullptr;
+    uint64_t    startNs    = 0u;
+    uint64_t    durationNs = 0u;
+    uint64_t    frameIndex = kTraceNoFrame;
+};
+
+// Nanoseconds since the first call in the process, on the steady clock.
+uint64_t GetTraceTimeNs();
+
+void RecordTraceEvent(const char* pName, uint64_t startNs, uint64_t endNs);
+
+// Names the track of the calling thread in the trace.
+void SetTraceThreadName(const char* pName);
+
+uint64_t GetTraceFrame();
+
+void SetTraceFrame(uint64_t frameIndex);
+
+class TraceZone
+{
+public:
+    explicit TraceZone(const char* pName) : m_pName(pName), m_startNs(GetTraceTimeNs()) {}
+
+    ~TraceZone() { RecordTraceEvent(m_pName, m_startNs, GetTraceTimeNs()); }
+
+private:
+    const char* m_pName;
+    uint64_t    m_startNs;
+};
+
+// Attributes the zones of the calling thread to frameIndex until the end of the scope.
+class TraceFrameScope
+{
+public:
+    explicit TraceFrameScope(uint64_t frameIndex) : m_previousFrame(GetTraceFrame()) { SetTraceFrame(frameIndex); }
+
+    ~TraceFrameScope() { SetTraceFrame(m_previousFrame); }
+
+private:
+    uint64_t m_previousFrame;
+};
+
+// Timestamp query pairs of one device, shown as one GPU track. Zones may be recorded from any thread, in command
+// buffers submitted to the queue family the queries were created for. Command buffers replayed without
+// re-recording must not contain zones: their queries would be written again before being collected.
+class VulkanTraceQueries
+{
+public:
+    ~VulkanTraceQueries() { Destroy(); }
+
+    // Fails on queue families without timestamp support. The GPU clock is calibrated against the trace clock with
+    // a single timestamp submitted to the queue, the error is at most half the duration of that submission.
+    bool Create(const VulkanDevice& device, VulkanQueueType queueType, const char* pTrackName);
+
+    // Zones still in flight are lost.
+    void Destroy();
+
+    // Returns the zone index to end, or UINT32_MAX if every query pair is in flight.
+    uint32_t BeginZone(VkCommandBuffer vkCommandBuffer, const char* pName);
+
+    void EndZone(VkCommandBuffer vkCommandBuffer, uint32_t zoneIndex);
+
+    // Turns the zones whose commands executed into events and resets their queries from the host.
+    void Collect();
+
+    const char* GetTrackName() const { return m_pTrackName; }
+
+    // Copies the collected events.
+    void GetEvents(std::vector<TraceEvent>& events, uint32_t& droppedZoneCount);
+
+private:
+    enum ZoneState : uint32_t
+    {
+        kZoneFree,
+        kZoneRecording,
+        kZoneRecorded,
+    };
+
+    struct Zone
+    {
+        std::atomic<uint32_t> state      = kZoneFree;
+        const char*           pName      = nullptr;
+        uint64_t              frameIndex = kTraceNoFrame;
+    };
+
+    VkDevice                m_vkDevice        = VK_NULL_HANDLE;
+    VkQueryPool             m_vkQueryPool     = VK_NULL_HANDLE;
+    const char*             m_pTrackName      = nullptr;
+
+    // GPU ticks to trace clock nanoseconds.
+    double                  m_nsPerTick       = 1.0;
+    double                  m_offsetNs        = 0.0;
+    uint64_t                m_timestampMask   = UINT64_MAX;
+
+    std::vector<Zone>       m_zones;
+    std::atomic<uint32_t>   m_nextZone        = 0u;
+    std::atomic<uint32_t>   m_droppedZones    = 0u;
+
+    std::mutex              m_eventsMutex;
+    std::vector<TraceEvent> m_events;
+};
+
+class VulkanTraceZone
+{
+public:
+    VulkanTraceZone(VulkanTraceQueries* pQueries, VkCommandBuffer vkCommandBuffer, const char* pName) :
+        m_pQueries(pQueries),
+        m_vkCommandBuffer(vkCommandBuffer),
+        m_zoneIndex(pQueries != nullptr ? pQueries->BeginZone(vkCommandBuffer, pName) : UINT32_MAX)
+    {}
+
+    ~VulkanTraceZone()
+    {
+        if (m_zoneIndex != UINT32_MAX)
+            m_pQueries->EndZone(m_vkCommandBuffer, m_zoneIndex);
+    }
+
+private:
+    VulkanTraceQueries* m_pQueries;
+    VkCommandBuffer     m_vkCommandBuffer;
+    uint32_t            m_zoneIndex;
+};
+
+// Registered queries are collected and exported with the CPU zones. Returns null on failure, which leaves the
+// queue untraced.
+VulkanTraceQueries* CreateVulkanTraceQueries(const VulkanDevice& device, VulkanQueueType queueType, const char* pTrackName);
+
+void DestroyVulkanTraceQueries(VulkanTraceQueries* pQueries);
+
+void CollectVulkanTraceQueries();
+
+// Collects the GPU zones, then writes every zone recorded so far.
+bool WriteChromeTrace(const char* pFileName);
+
+#define INTEROP_TRACE_CONCAT_(a, b) a##b
+#define INTEROP_TRACE_CONCAT(a, b)  INTEROP_TRACE_CONCAT_(a, b)
+
+#define TRACE_ZONE(pName)                                    TraceZone       INTEROP_TRACE_CONCAT(traceZone_,  __LINE__)(pName)
+#define TRACE_FRAME(frameIndex)                              TraceFrameScope INTEROP_TRACE_CONCAT(traceFrame_, __LINE__)(frameIndex)
+#define TRACE_THREAD_NAME(pName)                             SetTraceThreadName(pName)
+#define TRACE_GPU_CREATE(device, queueType, pTrackName)      CreateVulkanTraceQueries(device, queueType, pTrackName)
+#define TRACE_GPU_DESTROY(pQueries)                          DestroyVulkanTraceQueries(pQueries)
+#define TRACE_GPU_ZONE(pQueries, vkCommandBuffer, pName)     VulkanTraceZone INTEROP_TRACE_CONCAT(traceGpuZone_, __LINE__)(pQueries, vkCommandBuffer, pName)
+#define TRACE_GPU_COLLECT()                                  CollectVulkanTraceQueries()
+#define TRACE_WRITE(pFileName)                               WriteChromeTrace(pFileName)
+
+#else
+
+constexpr bool kTracingEnabled = false;
+
+#define TRACE_ZONE(pName)
+#define TRACE_FRAME(frameIndex)
+#define TRACE_THREAD_NAME(pName)
+#define TRACE_GPU_CREATE(device, queueType, pTrackName)      nullptr
+#define TRACE_GPU_DESTROY(pQueries)
+#define TRACE_GPU_ZONE(pQueries, vkCommandBuffer, pName)
+#define TRACE_GPU_COLLECT()
+#define TRACE_WRITE(pFileName)                               ((void)0)
+
+#endif
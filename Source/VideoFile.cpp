@@ -0,0 +1,215 @@
+#include "VideoFile.h"
+
+#include <cerrno>
+#include <cstring>
+
+#include <spdlog/spdlog.h>
+
+#include "PixelConversion.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+static uint64_t AlignUp(uint64_t value, uint64_t alignment)
+{
+    return (value + alignment - 1u) / alignment * alignment;
+}
+
+MappedVideoFile::~MappedVideoFile()
+{
+    Close();
+}
+
+bool MappedVideoFile::Create(const char* pFileName, const SharedImageDesc& desc, PixelFormat fileFormat, uint32_t frameCapacity)
+{
+    m_sourceFormat = GetSharedImageFormatTraits(desc).format;
+    m_fileFormat   = fileFormat;
+
+    if (!IsPixelConversionSupported(m_sourceFormat, m_fileFormat))
+    {
+        spdlog::error("Frames cannot be stored as {}.", GetPixelFormatTraits(m_fileFormat).pName);
+        return false;
+    }
+
+    const uint64_t frameSize   = GetPixelImageSize(GetPixelFormatTraits(fileFormat), desc.width, desc.height);
+    const uint64_t indexOffset = sizeof(VideoFileHeader);
+    const uint64_t dataOffset  = AlignUp(indexOffset + sizeof(VideoFrameIndexEntry) * frameCapacity, kVideoFileDataAlignment);
+
+    // Padded so that the frame data can be imported as host memory in whole pages.
+    m_mappingSize = AlignUp(dataOffset + frameSize * frameCapacity, kVideoFileDataAlignment);
+
+#if defined(_WIN32)
+    m_fileHandle = CreateFileA(pFileName, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (m_fileHandle == INVALID_HANDLE_VALUE)
+    {
+        m_fileHandle = nullptr;
+        spdlog::error("Failed to create {}.", pFileName);
+        return false;
+    }
+
+    // Creating the mapping extends the file to its full size.
+    m_mappingHandle = CreateFileMappingA(m_fileHandle, nullptr, PAGE_READWRITE, (DWORD)(m_mappingSize >> 32), (DWORD)m_mappingSize, nullptr);
+    if (m_mappingHandle == nullptr)
+    {
+        spdlog::error("Failed to preallocate {} bytes for {}.", m_mappingSize, pFileName);
+        return false;
+    }
+
+    m_pMapping = (uint8_t*)MapViewOfFile(m_mappingHandle, FILE_MAP_WRITE, 0u, 0u, 0u);
+#else
+    m_fileDescriptor = open(pFileName, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (m_fileDescriptor < 0)
+    {
+        spdlog::error("Failed to create {}: {}", pFileName, strerror(errno));
+        return false;
+    }
+
+    // Reserve the blocks now rather than on the first write fault of every page.
+    if (posix_fallocate(m_fileDescriptor, 0, (off_t)m_mappingSize) != 0 && ftruncate(m_fileDescriptor, (off_t)m_mappingSize) != 0)
+    {
+        spdlog::error("Failed to preallocate {} bytes for {}.", m_mappingSize, pFileName);
+        return false;
+    }
+
+    void* pMapping = mmap(nullptr, m_mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, m_fileDescriptor, 0);
+    m_pMapping = pMapping == MAP_FAILED ? nullptr : (uint8_t*)pMapping;
+
+    if (m_pMapping != nullptr)
+        madvise(m_pMapping, m_mappingSize, MADV_SEQUENTIAL);
+#endif
+
+    if (m_pMapping == nullptr)
+    {
+        spdlog::error("Failed to map {}.", pFileName);
+        return false;
+    }
+
+    m_pHeader = (VideoFileHeader*)m_pMapping;
+
+    memcpy(m_pHeader->magic, kVideoFileMagic, sizeof(kVideoFileMagic));
+    m_pHeader->version       = kVideoFileVersion;
+    m_pHeader->width         = desc.width;
+    m_pHeader->height        = desc.height;
+    m_pHeader->format        = GetPixelFormatTraits(fileFormat).vkFormat;
+    m_pHeader->frameCount    = 0u;
+    m_pHeader->frameCapacity = frameCapacity;
+    m_pHeader->frameSize     = frameSize;
+    m_pHeader->indexOffset   = indexOffset;
+    m_pHeader->dataOffset    = dataOffset;
+
+    return true;
+}
+
+void MappedVideoFile::Close()
+{
+    if (m_pMapping == nullptr)
+    {
+#if defined(_WIN32)
+        if (m_mappingHandle != nullptr)
+            CloseHandle(m_mappingHandle);
+
+        if (m_fileHandle != nullptr)
+            CloseHandle(m_fileHandle);
+
+        m_mappingHandle = nullptr;
+        m_fileHandle    = nullptr;
+#else
+        if (m_fileDescriptor >= 0)
+            close(m_fileDescriptor);
+
+        m_fileDescriptor = -1;
+#endif
+        return;
+    }
+
+    const uint64_t usedSize = m_pHeader->dataOffset + m_pHeader->frameSize * m_pHeader->frameCount;
+
+#if defined(_WIN32)
+    FlushViewOfFile(m_pMapping, 0u);
+    UnmapViewOfFile(m_pMapping);
+    CloseHandle(m_mappingHandle);
+
+    // The file can only shrink once no mapping references it.
+    LARGE_INTEGER fileSize;
+    fileSize.QuadPart = (LONGLONG)usedSize;
+
+    if (!SetFilePointerEx(m_fileHandle, fileSize, nullptr, FILE_BEGIN) || !SetEndOfFile(m_fileHandle))
+        spdlog::warn("Failed to trim the video file to {} bytes.", usedSize);
+
+    CloseHandle(m_fileHandle);
+
+    m_mappingHandle = nullptr;
+    m_fileHandle    = nullptr;
+#else
+    // Write back asynchronously, the kernel keeps the dirty pages after the unmap.
+    msync(m_pMapping, m_mappingSize, MS_ASYNC);
+    munmap(m_pMapping, m_mappingSize);
+
+    if (ftruncate(m_fileDescriptor, (off_t)usedSize) != 0)
+        spdlog::warn("Failed to trim the video file to {} bytes.", usedSize);
+
+    close(m_fileDescriptor);
+
+    m_fileDescriptor = -1;
+#endif
+
+    m_pMapping    = nullptr;
+    m_pHeader     = nullptr;
+    m_mappingSize = 0u;
+}
+
+bool MappedVideoFile::AppendFrame(const MappedImage& mappedImage, uint64_t frameIndex, uint64_t timestampNs)
+{
+    if (IsFull())
+        return false;
+
+    const uint32_t slot         = m_pHeader->frameCount;
+    const uint32_t packedPitch  = GetPixelPlaneRowPitch(GetPixelFormatTraits(m_fileFormat), 0u, m_pHeader->width);
+    uint8_t*       pDestination = m_pMapping + m_pHeader->dataOffset + m_pHeader->frameSize * slot;
+
+    if (m_sourceFormat != m_fileFormat)
+    {
+        if (!ConvertPixels(m_sourceFormat, mappedImage.pData, mappedImage.rowPitch, m_fileFormat, pDestination, packedPitch, m_pHeader->width, m_pHeader->height))
+            return false;
+    }
+    else if (mappedImage.rowPitch == packedPitch)
+    {
+        memcpy(pDestination, mappedImage.pData, m_pHeader->frameSize);
+    }
+    else
+    {
+        for (uint32_t row = 0u; row < m_pHeader->height; row++)
+            memcpy(pDestination + (size_t)row * packedPitch, (const uint8_t*)mappedImage.pData + (size_t)row * mappedImage.rowPitch, packedPitch);
+    }
+
+    return CommitFrame(frameIndex, timestampNs);
+}
+
+void* MappedVideoFile::GetFrameStorage(uint64_t& size) const
+{
+    size = m_mappingSize - m_pHeader->dataOffset;
+
+    return m_pMapping + m_pHeader->dataOffset;
+}
+
+bool MappedVideoFile::CommitFrame(uint64_t frameIndex, uint64_t timestampNs)
+{
+    if (IsFull())
+        return false;
+
+    const uint32_t slot = m_pHeader->frameCount;
+
+    auto* pIndex = (VideoFrameIndexEntry*)(m_pMapping + m_pHeader->indexOffset);
+    pIndex[slot].frameIndex  = frameIndex;
+    pIndex[slot].timestampNs = timestampNs;
+
+    m_pHeader->frameCount = slot + 1u;
+
+    return true;
+}
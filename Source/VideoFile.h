@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+
+#include "InteropBackend.h"
+#include "PixelFormat.h"
+
+// Raw indexed video container: a header, one index entry per frame and tightly packed frames aligned to
+// kVideoFileDataAlignment. Frames of frameSize bytes in the header format follow each other, so the data can be
+// played back with: ffmpeg -f rawvideo -pixel_format <pFFmpegName> -video_size WxH -skip_initial_bytes <dataOffset> -i <file>
+constexpr char     kVideoFileMagic[8]      = { 'R', 'A', 'W', 'V', 'I', 'D', 'E', 'O' };
+constexpr uint32_t kVideoFileVersion       = 1u;
+constexpr uint64_t kVideoFileDataAlignment = 4096u;
+
+struct VideoFileHeader
+{
+    char     magic[8];
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    VkFormat format;
+
+    // Updated after each committed frame, so a truncated capture stays readable.
+    uint32_t frameCount;
+    uint32_t frameCapacity;
+
+    uint64_t frameSize;
+    uint64_t indexOffset;
+    uint64_t dataOffset;
+};
+
+struct VideoFrameIndexEntry
+{
+    uint64_t frameIndex;
+    uint64_t timestampNs;
+};
+
+// Preallocates the whole capture up front and maps it, frames are written with plain stores into the mapping.
+class MappedVideoFile
+{
+public:
+    ~MappedVideoFile();
+
+    // Frames appended from images described by desc are stored in fileFormat, converted if needed.
+    bool Create(const char* pFileName, const SharedImageDesc& desc, PixelFormat fileFormat, uint32_t frameCapacity);
+
+    // Flushes the mapping and trims the file to the frames actually written.
+    void Close();
+
+    bool IsFull() const { return m_pHeader->frameCount == m_pHeader->frameCapacity; }
+
+    uint32_t GetFrameCount() const { return m_pHeader->frameCount; }
+
+    uint32_t GetFrameCapacity() const { return m_pHeader->frameCapacity; }
+
+    uint64_t GetDataOffset() const { return m_pHeader->dataOffset; }
+
+    uint64_t GetFrameSize() const { return m_pHeader->frameSize; }
+
+    // Whether frames are stored as the images deliver them, without conversion.
+    bool IsPassthrough() const { return m_sourceFormat == m_fileFormat; }
+
+    // Copies a frame into the next slot, in a single copy when the source rows are tightly packed and
+    // no conversion is needed.
+    bool AppendFrame(const MappedImage& mappedImage, uint64_t frameIndex, uint64_t timestampNs);
+
+    // Storage of every slot, frame N at N * GetFrameSize(). Starts and ends on kVideoFileDataAlignment, so that
+    // a readback can write frames in place (see InteropBackend::ImportReadbackHostMemory).
+    void* GetFrameStorage(uint64_t& size) const;
+
+    // Adds the next frame after its pixels were written in place to its slot of the frame storage.
+    bool CommitFrame(uint64_t frameIndex, uint64_t timestampNs);
+
+private:
+    VideoFileHeader* m_pHeader     = nullptr;
+    uint8_t*         m_pMapping    = nullptr;
+    uint64_t         m_mappingSize = 0u;
+
+    PixelFormat      m_sourceFormat = PixelFormat::RGBA8;
+    PixelFormat      m_fileFormat   = PixelFormat::RGBA8;
+
+#if defined(_WIN32)
+    void* m_fileHandle    = nullptr;
+    void* m_mappingHandle = nullptr;
+#else
+    int   m_fileDescriptor = -1;
+#endif
+};
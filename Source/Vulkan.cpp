@@ -0,0 +1,389 @@
+#define VOLK_IMPLEMENTATION
+#include "Vulkan.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <spdlog/spdlog.h>
+
+#include "DeviceCache.h"
+
+bool CreateVulkanInstance(VkInstance& vkInstance)
+{
+    if (volkInitialize() != VK_SUCCESS)
+    {
+        spdlog::error("Failed to initialize Volk.");
+        return false;
+    }
+
+    VkApplicationInfo vkApplicationInfo = { VK_STRUCTURE_TYPE_APPLICATION_INFO };
+    vkApplicationInfo.pApplicationName   = "SharedMemory-Vulkan-D3D11";
+    vkApplicationInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
+    vkApplicationInfo.pEngineName        = "No Engine";
+    vkApplicationInfo.engineVersion      = VK_MAKE_VERSION(0, 0, 0);
+    vkApplicationInfo.apiVersion         = VK_API_VERSION_1_3;
+
+    std::vector<const char*> requiredInstanceLayers;
+#ifdef _DEBUG
+    requiredInstanceLayers.push_back("VK_LAYER_KHRONOS_validation");
+#endif
+
+    VkInstanceCreateInfo vkInstanceCreateInfo = { VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO };
+    vkInstanceCreateInfo.pApplicationInfo     = &vkApplicationInfo;
+    vkInstanceCreateInfo.enabledLayerCount    = (uint32_t)requiredInstanceLayers.size();
+    vkInstanceCreateInfo.ppEnabledLayerNames  = requiredInstanceLayers.data();
+
+    if (vkCreateInstance(&vkInstanceCreateInfo, nullptr, &vkInstance) != VK_SUCCESS)
+        return false;
+
+    // Load device entry points through the loader trampolines (no volkLoadDevice), so that
+    // several logical devices (e.g. an exporter and an importer) can be driven from one process.
+    volkLoadInstance(vkInstance);
+
+    return true;
+}
+
+bool CheckVulkanDeviceExtensions(const VkPhysicalDevice& vkPhysicalDevice, const std::vector<const char*>& requiredExtensions)
+{
+    const auto& supportedDeviceExtensions = GetVulkanDeviceCapabilities(vkPhysicalDevice).extensionNames;
+
+    auto CheckExtension = [&](const char* extensionName)
+    {
+        return std::binary_search(supportedDeviceExtensions.begin(), supportedDeviceExtensions.end(), extensionName);
+    };
+
+    for (const auto& requiredExtension : requiredExtensions)
+    {
+        if (CheckExtension(requiredExtension))
+            continue;
+
+        spdlog::error("The selected Vulkan physical device does not support required Vulkan Extension: {}", requiredExtension);
+        return false;
+    }
+
+    return true;
+}
+
+void GetVulkanPhysicalDeviceIDProperties(const VkPhysicalDevice& vkPhysicalDevice, VkPhysicalDeviceIDProperties& vkIDProperties)
+{
+    vkIDProperties = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES };
+
+    VkPhysicalDeviceProperties2 vkProperties = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2 };
+    vkProperties.pNext = &vkIDProperties;
+
+    vkGetPhysicalDeviceProperties2(vkPhysicalDevice, &vkProperties);
+}
+
+bool SelectVulkanPhysicalDevice(const VkInstance& vkInstance, const std::vector<const char*>& requiredExtensions, const uint8_t* pDeviceUUID, VkPhysicalDevice& vkPhysicalDevice)
+{
+    uint32_t deviceCount = 0u;
+    vkEnumeratePhysicalDevices(vkInstance, &deviceCount, nullptr);
+
+    std::vector<VkPhysicalDevice> vkPhysicalDevices(deviceCount);
+    vkEnumeratePhysicalDevices(vkInstance, &deviceCount, vkPhysicalDevices.data());
+
+    vkPhysicalDevice = VK_NULL_HANDLE;
+
+    for (const auto& physicalDevice : vkPhysicalDevices)
+    {
+        if (pDeviceUUID != nullptr)
+        {
+            VkPhysicalDeviceIDProperties vkIDProperties;
+            GetVulkanPhysicalDeviceIDProperties(physicalDevice, vkIDProperties);
+
+            if (memcmp(vkIDProperties.deviceUUID, pDeviceUUID, VK_UUID_SIZE))
+                continue;
+        }
+
+        if (!CheckVulkanDeviceExtensions(physicalDevice, requiredExtensions))
+            continue;
+
+        vkPhysicalDevice = physicalDevice;
+
+        break;
+    }
+
+    return vkPhysicalDevice != VK_NULL_HANDLE;
+}
+
+bool GetVulkanQueueFamilies(const VkPhysicalDevice& vkPhysicalDevice, VulkanQueueFamilies& queueFamilies)
+{
+    queueFamilies = {};
+
+    const auto&    queueFamilyProperties = GetVulkanDeviceCapabilities(vkPhysicalDevice).queueFamilies;
+    const uint32_t queueFamilyCount      = (uint32_t)queueFamilyProperties.size();
+
+    for (uint32_t queueFamilyIndex = 0; queueFamilyIndex < queueFamilyCount; queueFamilyIndex++)
+    {
+        const VkQueueFlags queueFlags = queueFamilyProperties[queueFamilyIndex].queueFlags;
+
+        // Choose the first family of each kind we find.
+        if ((queueFlags & VK_QUEUE_GRAPHICS_BIT) && queueFamilies.graphics == UINT_MAX)
+            queueFamilies.graphics = queueFamilyIndex;
+
+        if ((queueFlags & VK_QUEUE_COMPUTE_BIT) && !(queueFlags & VK_QUEUE_GRAPHICS_BIT) && queueFamilies.compute == UINT_MAX)
+            queueFamilies.compute = queueFamilyIndex;
+
+        if ((queueFlags & VK_QUEUE_TRANSFER_BIT) && !(queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)) && queueFamilies.transfer == UINT_MAX)
+            queueFamilies.transfer = queueFamilyIndex;
+    }
+
+    return queueFamilies.graphics != UINT_MAX;
+}
+
+bool GetVulkanGraphicsQueueIndexFromDevice(const VkPhysicalDevice& vkPhysicalDevice, uint32_t& graphicsQueueIndex)
+{
+    VulkanQueueFamilies queueFamilies;
+    const bool found = GetVulkanQueueFamilies(vkPhysicalDevice, queueFamilies);
+
+    graphicsQueueIndex = queueFamilies.graphics;
+
+    return found;
+}
+
+bool CreateVulkanLogicalDevice(const VkPhysicalDevice& vkPhysicalDevice, const std::vector<const char*>& requiredExtensions, const VulkanQueueFamilies& queueFamilies, VkDevice& vkLogicalDevice)
+{
+    float queuePriority = 1.0;
+
+    // Timeline semaphores synchronize the importing and exporting sides of every shared image.
+    VkPhysicalDeviceTimelineSemaphoreFeatures vkTimelineSemaphoreFeatures = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES };
+    vkTimelineSemaphoreFeatures.timelineSemaphore = VK_TRUE;
+
+#if defined(INTEROP_TRACING)
+    // Trace timestamp queries are reset from the host once collected.
+    VkPhysicalDeviceHostQueryResetFeatures vkHostQueryResetFeatures = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_HOST_QUERY_RESET_FEATURES };
+    vkHostQueryResetFeatures.hostQueryReset = VK_TRUE;
+
+    vkTimelineSemaphoreFeatures.pNext = &vkHostQueryResetFeatures;
+#endif
+
+    std::vector<VkDeviceQueueCreateInfo> vkQueueCreateInfos;
+
+    for (uint32_t queueFamilyIndex : { queueFamilies.graphics, queueFamilies.compute, queueFamilies.transfer })
+    {
+        if (queueFamilyIndex == UINT_MAX)
+            continue;
+
+        VkDeviceQueueCreateInfo vkQueueCreateInfo = { VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO };
+        vkQueueCreateInfo.queueFamilyIndex = queueFamilyIndex;
+        vkQueueCreateInfo.queueCount       = 1u;
+        vkQueueCreateInfo.pQueuePriorities = &queuePriority;
+
+        vkQueueCreateInfos.push_back(vkQueueCreateInfo);
+    }
+
+    VkDeviceCreateInfo vkLogicalDeviceCreateInfo = { VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO };
+    vkLogicalDeviceCreateInfo.pNext                   = &vkTimelineSemaphoreFeatures;
+    vkLogicalDeviceCreateInfo.pQueueCreateInfos       = vkQueueCreateInfos.data();
+    vkLogicalDeviceCreateInfo.queueCreateInfoCount    = (uint32_t)vkQueueCreateInfos.size();
+    vkLogicalDeviceCreateInfo.enabledExtensionCount   = (uint32_t)requiredExtensions.size();
+    vkLogicalDeviceCreateInfo.ppEnabledExtensionNames = requiredExtensions.data();
+
+    return vkCreateDevice(vkPhysicalDevice, &vkLogicalDeviceCreateInfo, nullptr, &vkLogicalDevice) == VK_SUCCESS;
+}
+
+bool CreateVulkanDevice(const VkPhysicalDevice& vkPhysicalDevice, const std::vector<const char*>& requiredExtensions, VulkanDevice& device)
+{
+    device.vkPhysicalDevice = vkPhysicalDevice;
+
+    VulkanQueueFamilies queueFamilies;
+    if (!GetVulkanQueueFamilies(vkPhysicalDevice, queueFamilies))
+    {
+        spdlog::error("Failed to get the graphics queue from the selected Vulkan Physical Device.");
+        return false;
+    }
+
+    if (!CreateVulkanLogicalDevice(vkPhysicalDevice, requiredExtensions, queueFamilies, device.vkLogicalDevice))
+    {
+        spdlog::error("Failed to create the Vulkan Logical Device");
+        return false;
+    }
+
+    // Graphics queues can do anything the other kinds can.
+    device.graphicsQueueIndex = queueFamilies.graphics;
+    device.computeQueueIndex  = queueFamilies.compute  != UINT_MAX ? queueFamilies.compute  : queueFamilies.graphics;
+    device.transferQueueIndex = queueFamilies.transfer != UINT_MAX ? queueFamilies.transfer : queueFamilies.graphics;
+
+    vkGetDeviceQueue(device.vkLogicalDevice, device.graphicsQueueIndex, 0u, &device.vkGraphicsQueue);
+    vkGetDeviceQueue(device.vkLogicalDevice, device.computeQueueIndex,  0u, &device.vkComputeQueue);
+    vkGetDeviceQueue(device.vkLogicalDevice, device.transferQueueIndex, 0u, &device.vkTransferQueue);
+
+    return true;
+}
+
+void GetVulkanQueue(const VulkanDevice& device, VulkanQueueType queueType, uint32_t& queueFamilyIndex, VkQueue& vkQueue)
+{
+    switch (queueType)
+    {
+        case VulkanQueueType::Compute:  queueFamilyIndex = device.computeQueueIndex;  vkQueue = device.vkComputeQueue;  break;
+        case VulkanQueueType::Transfer: queueFamilyIndex = device.transferQueueIndex; vkQueue = device.vkTransferQueue; break;
+        default:                        queueFamilyIndex = device.graphicsQueueIndex; vkQueue = device.vkGraphicsQueue; break;
+    }
+}
+
+void DestroyVulkanDevice(VulkanDevice& device)
+{
+    if (device.vkPipelineCache != VK_NULL_HANDLE)
+        vkDestroyPipelineCache(device.vkLogicalDevice, device.vkPipelineCache, nullptr);
+
+    if (device.vkLogicalDevice != VK_NULL_HANDLE)
+        vkDestroyDevice(device.vkLogicalDevice, nullptr);
+
+    device = {};
+}
+
+bool SubmitVulkanCommandBuffer(VkQueue vkQueue, VkCommandBuffer vkCommandBuffer, const VulkanTimelineSubmit& timelineSubmit, VkFence vkFence)
+{
+    const VkPipelineStageFlags waitStageMask = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+
+    VkTimelineSemaphoreSubmitInfo vkTimelineSubmitInfo = { VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO };
+    {
+        vkTimelineSubmitInfo.waitSemaphoreValueCount   = timelineSubmit.vkWaitSemaphore   != VK_NULL_HANDLE ? 1u : 0u;
+        vkTimelineSubmitInfo.pWaitSemaphoreValues      = &timelineSubmit.waitValue;
+        vkTimelineSubmitInfo.signalSemaphoreValueCount = timelineSubmit.vkSignalSemaphore != VK_NULL_HANDLE ? 1u : 0u;
+        vkTimelineSubmitInfo.pSignalSemaphoreValues    = &timelineSubmit.signalValue;
+    }
+
+    VkSubmitInfo vkSubmitInfo = { VK_STRUCTURE_TYPE_SUBMIT_INFO };
+    {
+        vkSubmitInfo.pNext                = &vkTimelineSubmitInfo;
+        vkSubmitInfo.commandBufferCount   = vkCommandBuffer != VK_NULL_HANDLE ? 1u : 0u;
+        vkSubmitInfo.pCommandBuffers      = &vkCommandBuffer;
+        vkSubmitInfo.waitSemaphoreCount   = vkTimelineSubmitInfo.waitSemaphoreValueCount;
+        vkSubmitInfo.pWaitSemaphores      = &timelineSubmit.vkWaitSemaphore;
+        vkSubmitInfo.pWaitDstStageMask    = &waitStageMask;
+        vkSubmitInfo.signalSemaphoreCount = vkTimelineSubmitInfo.signalSemaphoreValueCount;
+        vkSubmitInfo.pSignalSemaphores    = &timelineSubmit.vkSignalSemaphore;
+    }
+
+    return vkQueueSubmit(vkQueue, 1u, &vkSubmitInfo, vkFence) == VK_SUCCESS;
+}
+
+bool WaitVulkanTimelineSemaphore(const VulkanDevice& device, VkSemaphore vkSemaphore, uint64_t value, uint64_t timeoutNs)
+{
+    VkSemaphoreWaitInfo vkWaitInfo = { VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO };
+    vkWaitInfo.semaphoreCount = 1u;
+    vkWaitInfo.pSemaphores    = &vkSemaphore;
+    vkWaitInfo.pValues        = &value;
+
+    return vkWaitSemaphores(device.vkLogicalDevice, &vkWaitInfo, timeoutNs) == VK_SUCCESS;
+}
+
+bool FindVulkanMemoryTypeIndex(const VkPhysicalDevice& vkPhysicalDevice, uint32_t memoryTypeBits, VkMemoryPropertyFlags requiredProperties, uint32_t& memoryTypeIndex)
+{
+    VkPhysicalDeviceMemoryProperties vkMemoryProperties;
+    vkGetPhysicalDeviceMemoryProperties(vkPhysicalDevice, &vkMemoryProperties);
+
+    for (uint32_t typeIndex = 0u; typeIndex < vkMemoryProperties.memoryTypeCount; typeIndex++)
+    {
+        if (!(memoryTypeBits & (1u << typeIndex)))
+            continue;
+
+        if ((vkMemoryProperties.memoryTypes[typeIndex].propertyFlags & requiredProperties) != requiredProperties)
+            continue;
+
+        memoryTypeIndex = typeIndex;
+
+        return true;
+    }
+
+    return false;
+}
+
+bool CreateVulkanStagingBuffer(const VulkanDevice& device, VkDeviceSize size, VkBufferUsageFlags usage, VulkanStagingBuffer& stagingBuffer)
+{
+    VkBufferCreateInfo vkBufferCreateInfo = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+    vkBufferCreateInfo.size        = size;
+    vkBufferCreateInfo.usage       = usage;
+    vkBufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    if (vkCreateBuffer(device.vkLogicalDevice, &vkBufferCreateInfo, nullptr, &stagingBuffer.vkBuffer) != VK_SUCCESS)
+        return false;
+
+    VkMemoryRequirements vkMemoryRequirements;
+    vkGetBufferMemoryRequirements(device.vkLogicalDevice, stagingBuffer.vkBuffer, &vkMemoryRequirements);
+
+    // Prefer cached memory for readback, fall back to any coherent host-visible memory.
+    uint32_t memoryTypeIndex;
+    if (!FindVulkanMemoryTypeIndex(device.vkPhysicalDevice, vkMemoryRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT, memoryTypeIndex) &&
+        !FindVulkanMemoryTypeIndex(device.vkPhysicalDevice, vkMemoryRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, memoryTypeIndex))
+        return false;
+
+    VkMemoryAllocateInfo vkAllocateInfo = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
+    vkAllocateInfo.allocationSize  = vkMemoryRequirements.size;
+    vkAllocateInfo.memoryTypeIndex = memoryTypeIndex;
+
+    if (vkAllocateMemory(device.vkLogicalDevice, &vkAllocateInfo, nullptr, &stagingBuffer.vkBufferMemory) != VK_SUCCESS)
+        return false;
+
+    vkBindBufferMemory(device.vkLogicalDevice, stagingBuffer.vkBuffer, stagingBuffer.vkBufferMemory, 0u);
+
+    if (vkMapMemory(device.vkLogicalDevice, stagingBuffer.vkBufferMemory, 0u, VK_WHOLE_SIZE, 0u, &stagingBuffer.pMappedData) != VK_SUCCESS)
+        return false;
+
+    stagingBuffer.size = size;
+
+    return true;
+}
+
+void DestroyVulkanStagingBuffer(const VulkanDevice& device, VulkanStagingBuffer& stagingBuffer)
+{
+    if (stagingBuffer.vkBufferMemory != VK_NULL_HANDLE)
+        vkFreeMemory(device.vkLogicalDevice, stagingBuffer.vkBufferMemory, nullptr);
+
+    if (stagingBuffer.vkBuffer != VK_NULL_HANDLE)
+        vkDestroyBuffer(device.vkLogicalDevice, stagingBuffer.vkBuffer, nullptr);
+
+    stagingBuffer = {};
+}
+
+bool BeginVulkanImmediateCommands(const VulkanDevice& device, uint32_t queueFamilyIndex, VkCommandPool& vkCommandPool, VkCommandBuffer& vkCommandBuffer)
+{
+    VkCommandPoolCreateInfo vkCommandPoolCreateInfo = { VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO };
+    {
+        vkCommandPoolCreateInfo.flags            = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+        vkCommandPoolCreateInfo.queueFamilyIndex = queueFamilyIndex;
+    }
+
+    if (vkCreateCommandPool(device.vkLogicalDevice, &vkCommandPoolCreateInfo, nullptr, &vkCommandPool) != VK_SUCCESS)
+        return false;
+
+    VkCommandBufferAllocateInfo vkCommandAllocateInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
+    {
+        vkCommandAllocateInfo.commandBufferCount = 1u;
+        vkCommandAllocateInfo.commandPool        = vkCommandPool;
+        vkCommandAllocateInfo.level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    }
+
+    if (vkAllocateCommandBuffers(device.vkLogicalDevice, &vkCommandAllocateInfo, &vkCommandBuffer) != VK_SUCCESS)
+    {
+        vkDestroyCommandPool(device.vkLogicalDevice, vkCommandPool, nullptr);
+        return false;
+    }
+
+    VkCommandBufferBeginInfo vkCommandBeginInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+    vkCommandBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    if (vkBeginCommandBuffer(vkCommandBuffer, &vkCommandBeginInfo) != VK_SUCCESS)
+    {
+        vkDestroyCommandPool(device.vkLogicalDevice, vkCommandPool, nullptr);
+        return false;
+    }
+
+    return true;
+}
+
+bool EndVulkanImmediateCommands(const VulkanDevice& device, VkQueue vkQueue, VkCommandPool vkCommandPool, VkCommandBuffer vkCommandBuffer, const VulkanTimelineSubmit& timelineSubmit)
+{
+    vkEndCommandBuffer(vkCommandBuffer);
+
+    bool result = SubmitVulkanCommandBuffer(vkQueue, vkCommandBuffer, timelineSubmit, VK_NULL_HANDLE);
+
+    // Pause execution until the queue has finished work.
+    if (result)
+        result = vkQueueWaitIdle(vkQueue) == VK_SUCCESS;
+
+    vkDestroyCommandPool(device.vkLogicalDevice, vkCommandPool, nullptr);
+
+    return result;
+}
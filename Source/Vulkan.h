@@ -0,0 +1,124 @@
+#pragma once
+
+#include <climits>
+#include <cstdint>
+#include <vector>
+
+#if defined(_WIN32)
+// Compile Vulkan for usage of extension:
+// VK_KHR_external_memory_win32
+#define VK_USE_PLATFORM_WIN32_KHR
+#endif
+
+#include <volk.h>
+
+// Handles to a Vulkan logical device and the queues used to drive it.
+struct VulkanDevice
+{
+    VkPhysicalDevice vkPhysicalDevice   = VK_NULL_HANDLE;
+    VkDevice         vkLogicalDevice    = VK_NULL_HANDLE;
+    uint32_t         graphicsQueueIndex = UINT_MAX;
+    VkQueue          vkGraphicsQueue    = VK_NULL_HANDLE;
+
+    // Async compute and transfer-only queues. Devices without such families alias the graphics queue.
+    uint32_t         computeQueueIndex  = UINT_MAX;
+    VkQueue          vkComputeQueue     = VK_NULL_HANDLE;
+    uint32_t         transferQueueIndex = UINT_MAX;
+    VkQueue          vkTransferQueue    = VK_NULL_HANDLE;
+
+    // Optional, see CreateVulkanPipelineCache.
+    VkPipelineCache  vkPipelineCache    = VK_NULL_HANDLE;
+
+    bool HasDedicatedTransferQueue() const { return transferQueueIndex != graphicsQueueIndex; }
+};
+
+// Queue families of a physical device: the first graphics family, the first compute family without graphics and
+// the first transfer family without graphics or compute (usually the copy engines). Missing families are UINT_MAX.
+struct VulkanQueueFamilies
+{
+    uint32_t graphics = UINT_MAX;
+    uint32_t compute  = UINT_MAX;
+    uint32_t transfer = UINT_MAX;
+};
+
+enum class VulkanQueueType
+{
+    Graphics,
+    Compute,
+    Transfer,
+};
+
+bool CreateVulkanInstance(VkInstance& vkInstance);
+
+bool CheckVulkanDeviceExtensions(const VkPhysicalDevice& vkPhysicalDevice, const std::vector<const char*>& requiredExtensions);
+
+void GetVulkanPhysicalDeviceIDProperties(const VkPhysicalDevice& vkPhysicalDevice, VkPhysicalDeviceIDProperties& vkIDProperties);
+
+// Selects the first physical device supporting the required extensions, optionally restricted to a device UUID.
+bool SelectVulkanPhysicalDevice(const VkInstance& vkInstance, const std::vector<const char*>& requiredExtensions, const uint8_t* pDeviceUUID, VkPhysicalDevice& vkPhysicalDevice);
+
+// Returns false if the device has no graphics family.
+bool GetVulkanQueueFamilies(const VkPhysicalDevice& vkPhysicalDevice, VulkanQueueFamilies& queueFamilies);
+
+bool GetVulkanGraphicsQueueIndexFromDevice(const VkPhysicalDevice& vkPhysicalDevice, uint32_t& graphicsQueueIndex);
+
+// Creates one queue in each of the families found.
+bool CreateVulkanLogicalDevice(const VkPhysicalDevice& vkPhysicalDevice, const std::vector<const char*>& requiredExtensions, const VulkanQueueFamilies& queueFamilies, VkDevice& vkLogicalDevice);
+
+// Convenience wrapper that discovers the queue families, creates the logical device and fetches the queues.
+bool CreateVulkanDevice(const VkPhysicalDevice& vkPhysicalDevice, const std::vector<const char*>& requiredExtensions, VulkanDevice& device);
+
+void GetVulkanQueue(const VulkanDevice& device, VulkanQueueType queueType, uint32_t& queueFamilyIndex, VkQueue& vkQueue);
+
+void DestroyVulkanDevice(VulkanDevice& device);
+
+// Timeline semaphore values a submission waits on and signals. Null semaphores are skipped.
+struct VulkanTimelineSubmit
+{
+    VkSemaphore vkWaitSemaphore   = VK_NULL_HANDLE;
+    uint64_t    waitValue         = 0u;
+    VkSemaphore vkSignalSemaphore = VK_NULL_HANDLE;
+    uint64_t    signalValue       = 0u;
+};
+
+bool SubmitVulkanCommandBuffer(VkQueue vkQueue, VkCommandBuffer vkCommandBuffer, const VulkanTimelineSubmit& timelineSubmit, VkFence vkFence);
+
+// Blocks the calling thread until the timeline semaphore reaches value.
+bool WaitVulkanTimelineSemaphore(const VulkanDevice& device, VkSemaphore vkSemaphore, uint64_t value, uint64_t timeoutNs = UINT64_MAX);
+
+bool FindVulkanMemoryTypeIndex(const VkPhysicalDevice& vkPhysicalDevice, uint32_t memoryTypeBits, VkMemoryPropertyFlags requiredProperties, uint32_t& memoryTypeIndex);
+
+// Host-visible buffer used to move pixels between a Vulkan device and the CPU.
+struct VulkanStagingBuffer
+{
+    VkBuffer       vkBuffer       = VK_NULL_HANDLE;
+    VkDeviceMemory vkBufferMemory = VK_NULL_HANDLE;
+    VkDeviceSize   size           = 0u;
+    void*          pMappedData    = nullptr;
+};
+
+bool CreateVulkanStagingBuffer(const VulkanDevice& device, VkDeviceSize size, VkBufferUsageFlags usage, VulkanStagingBuffer& stagingBuffer);
+
+void DestroyVulkanStagingBuffer(const VulkanDevice& device, VulkanStagingBuffer& stagingBuffer);
+
+bool BeginVulkanImmediateCommands(const VulkanDevice& device, uint32_t queueFamilyIndex, VkCommandPool& vkCommandPool, VkCommandBuffer& vkCommandBuffer);
+
+bool EndVulkanImmediateCommands(const VulkanDevice& device, VkQueue vkQueue, VkCommandPool vkCommandPool, VkCommandBuffer vkCommandBuffer, const VulkanTimelineSubmit& timelineSubmit = {});
+
+// Records commands into a transient command buffer, submits it to a queue of queueType and blocks until the queue finished it.
+template <typename RecordFunc>
+bool SubmitVulkanCommandsImmediate(const VulkanDevice& device, RecordFunc&& recordCommands, const VulkanTimelineSubmit& timelineSubmit = {}, VulkanQueueType queueType = VulkanQueueType::Graphics)
+{
+    uint32_t queueFamilyIndex;
+    VkQueue  vkQueue;
+    GetVulkanQueue(device, queueType, queueFamilyIndex, vkQueue);
+
+    VkCommandPool   vkCommandPool;
+    VkCommandBuffer vkCommandBuffer;
+    if (!BeginVulkanImmediateCommands(device, queueFamilyIndex, vkCommandPool, vkCommandBuffer))
+        return false;
+
+    recordCommands(vkCommandBuffer);
+
+    return EndVulkanImmediateCommands(device, vkQueue, vkCommandPool, vkCommandBuffer, timelineSubmit);
+}